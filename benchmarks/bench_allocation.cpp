@@ -0,0 +1,102 @@
+// Heap traffic and throughput of building scales and MOS with the default
+// heap, a monotonic arena and a pool.
+//
+//   cmake -S . -B build -DBUILD_BENCHMARKS=ON && cmake --build build
+//   ./build/bench_allocation [rounds]
+
+#include "allocation_counter.hpp"
+#include "scalatrix/memory.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/scale.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace scalatrix;
+
+namespace {
+
+const int N_NODES = 128;
+const int ROOT = 60;
+
+struct Result {
+    size_t allocations;
+    double ns_per_round;
+};
+
+template <class F>
+Result measure(int rounds, F&& round) {
+    size_t before = allocationCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        round(i);
+    }
+    auto end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return {allocationCount() - before, ns / rounds};
+}
+
+void report(const char* name, int rounds, const Result& r) {
+    std::printf("  %-12s %10.2f allocs/round %12.0f ns/round\n",
+                name, static_cast<double>(r.allocations) / rounds, r.ns_per_round);
+}
+
+double generatorFor(int i) {
+    return 0.55 + 0.05 * (i % 8) / 8.0;
+}
+
+// One round: a fresh scale is built and thrown away
+template <class Before>
+Result scaleRounds(int rounds, MemoryResource* resource, Before&& before) {
+    AffineTransform A = MOS(5, 2, 1, 1.0, 0.58).impliedAffine;
+    return measure(rounds, [&](int) {
+        before();
+        Scale scale(DEFAULT_12TET_C_PITCH, N_NODES, ROOT, resource);
+        scale.recalcWithAffine(A, N_NODES, ROOT);
+    });
+}
+
+// One round: a fresh MOS is built, adjusted to a second pattern and thrown away
+template <class Before>
+Result mosRounds(int rounds, MemoryResource* resource, Before&& before) {
+    return measure(rounds, [&](int i) {
+        before();
+        double g = generatorFor(i);
+        MOS mos(5, 2, 1, 1.0, g, resource);
+        mos.adjustParams(7, 5, 1, 1.0, g);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int rounds = argc > 1 ? std::atoi(argv[1]) : 20000;
+    if (rounds < 1) rounds = 1;
+
+    auto nothing = [] {};
+    // Arena storage, rewound before every round
+    alignas(std::max_align_t) static char buffer[64 * 1024];
+
+    std::printf("Scale, %d nodes, %d rounds\n", N_NODES, rounds);
+    report("default", rounds, scaleRounds(rounds, defaultMemoryResource(), nothing));
+    {
+        MonotonicResource arena(buffer, sizeof(buffer));
+        report("monotonic", rounds, scaleRounds(rounds, &arena, [&] { arena.release(); }));
+    }
+    {
+        PoolResource pool;
+        report("pool", rounds, scaleRounds(rounds, &pool, nothing));
+    }
+
+    std::printf("MOS 5L 2s -> 7L 5s, %d rounds\n", rounds);
+    report("default", rounds, mosRounds(rounds, defaultMemoryResource(), nothing));
+    {
+        MonotonicResource arena(buffer, sizeof(buffer));
+        report("monotonic", rounds, mosRounds(rounds, &arena, [&] { arena.release(); }));
+    }
+    {
+        PoolResource pool;
+        report("pool", rounds, mosRounds(rounds, &pool, nothing));
+    }
+    return 0;
+}
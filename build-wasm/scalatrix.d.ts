@@ -52,11 +52,21 @@ export interface AffineTransform extends ClassHandle {
   apply(_0: Vector2d): Vector2d;
 }
 
+export interface StripCacheStats {
+  hits: number;
+  misses: number;
+  hitRate: number;
+}
+
 export interface Scale extends ClassHandle {
   recalcWithAffine(_0: AffineTransform, _1: number, _2: number): void;
+  reset(_0: number, _1: number, _2: number): void;
   retuneWithAffine(_0: AffineTransform): void;
   print(_0: number, _1: number): void;
   getNodes(): VectorNode;
+  stripCacheStats(): StripCacheStats;
+  resetStripCache(): void;
+  clearStripCache(): void;
 }
 
 export interface MOS extends ClassHandle {
@@ -90,6 +100,8 @@ export interface MOS extends ClassHandle {
   gFromAngle(_0: number): number;
   retuneZeroPoint(): void;
   generateScaleFromMOS(_0: number, _1: number, _2: number): Scale;
+  generateScaleFromMOSInto(_0: Scale, _1: number, _2: number, _3: number): void;
+  generateMappedScaleInto(_0: Scale, _1: number, _2: number, _3: number, _4: number, _5: number): void;
   retuneScaleWithMOS(_0: Scale, _1: number): void;
   nodeLabelDigit(_0: Vector2i): string;
   nodeLabelLetter(_0: Vector2i): string;
@@ -105,6 +117,55 @@ export interface MOS extends ClassHandle {
   mapFromMOS(_0: MOS, _1: Vector2i): Vector2i;
 }
 
+// The typed arrays below are views over the WASM heap, not copies; see
+// "Typed-array views" in the package README for when they go stale.
+export interface ScaleColumns extends ClassHandle {
+  update(_0: Scale): void;
+  size(): number;
+  pitches(): Float64Array;
+  naturalCoords(): Int32Array;
+  tuningCoords(): Float64Array;
+}
+
+export interface Spectrum extends ClassHandle {
+}
+
+export interface ConsonanceCurve extends ClassHandle {
+  size(): number;
+  compute(_0: number): void;
+  computeGen3(_0: number): void;
+  peak(): number;
+  logBaseline(): number;
+  cents(): Float64Array;
+  pl(): Float64Array;
+  hull(): Float64Array;
+  spiky(): Float64Array;
+  consonance(): Float64Array;
+}
+
+export interface LabelStyleValue<T extends number> {
+  value: T;
+}
+export type LabelStyle = LabelStyleValue<0>|LabelStyleValue<1>|LabelStyleValue<2>|LabelStyleValue<3>;
+
+// Labels back to back in UTF-8: label i is
+// new TextDecoder().decode(text.subarray(offsets[i], offsets[i + 1]))
+export type LabelBatch = {
+  text: Uint8Array,
+  offsets: Uint32Array
+};
+
+export interface LabelTable extends ClassHandle {
+  rebuild(_0: MOS, _1: boolean): void;
+  matches(_0: MOS, _1: boolean): boolean;
+  degree(_0: Vector2i): number;
+  accidentals(_0: Vector2i): number;
+  octave(_0: Vector2i, _1: number): number;
+  label(_0: Vector2i, _1: LabelStyle, _2: boolean, _3: number): string;
+  labelRect(_0: Vector2i, _1: number, _2: number, _3: LabelStyle, _4: boolean, _5: number): LabelBatch;
+  labelCoords(_0: Int32Array | number[], _1: LabelStyle, _2: boolean, _3: number): LabelBatch;
+}
+
 export type Vector2d = {
   x: number,
   y: number
@@ -129,6 +190,20 @@ export interface VectorNode extends ClassHandle {
   set(_0: number, _1: Node): boolean;
 }
 
+export type MOSConvergent = {
+  depth: number,
+  a0: number,
+  b0: number
+};
+
+export interface VectorMOSConvergent extends ClassHandle {
+  push_back(_0: MOSConvergent): void;
+  resize(_0: number, _1: MOSConvergent): void;
+  size(): number;
+  get(_0: number): MOSConvergent | undefined;
+  set(_0: number, _1: MOSConvergent): boolean;
+}
+
 export type PseudoPrimeInt = {
   label: EmbindString,
   number: number,
@@ -170,11 +245,34 @@ interface EmbindModule {
   };
   MOS: {
     fromG(_0: number, _1: number, _2: number, _3: number, _4: number): MOS;
+    convergents(_0: number, _1: number): VectorMOSConvergent;
+    depthForSize(_0: number, _1: number): number;
     fromParams(_0: number, _1: number, _2: number, _3: number, _4: number): MOS;
   };
   VectorNode: {
     new(): VectorNode;
   };
+  VectorMOSConvergent: {
+    new(): VectorMOSConvergent;
+  };
+  ScaleColumns: {
+    new(): ScaleColumns;
+  };
+  Spectrum: {
+    new(): Spectrum;
+    harmonic(_0: number, _1: number): Spectrum;
+    oddHarmonic(_0: number, _1: number): Spectrum;
+    pseudoharmonic(_0: number, _1: number): Spectrum;
+  };
+  ConsonanceCurve: {
+    new(_0: Spectrum, _1: number, _2: number, _3: number, _4: number): ConsonanceCurve;
+  };
+  LabelStyle: {DIGIT: LabelStyleValue<0>, DIGIT_ZERO_BASED: LabelStyleValue<1>, LETTER: LabelStyleValue<2>, LETTER_WITH_OCTAVE: LabelStyleValue<3>};
+  LabelTable: {
+    new(): LabelTable;
+    new(_0: MOS, _1: boolean): LabelTable;
+  };
+  deviationLabels(_0: Scale, _1: number, _2: boolean): LabelBatch;
   affineFromThreeDots(_0: Vector2d, _1: Vector2d, _2: Vector2d, _3: Vector2d, _4: Vector2d, _5: Vector2d): AffineTransform;
   pseudoPrimeFromIndexNumber(_0: number): PseudoPrimeInt;
   PrimeList: {
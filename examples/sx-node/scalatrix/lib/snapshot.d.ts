@@ -0,0 +1,51 @@
+export declare const SNAPSHOT_MAGIC: number;
+export declare const SNAPSHOT_VERSION: number;
+export declare const SNAPSHOT_HEADER_SIZE: number;
+export declare const SNAPSHOT_FLOAT32: number;
+export declare const SNAPSHOT_DELTA: number;
+
+export interface SnapshotHeader {
+  version: number;
+  flags: number;
+  seq: number;
+  baseSeq: number;
+  nodeCount: number;
+  recordCount: number;
+  root: number;
+  a: number;
+  b: number;
+  mode: number;
+  repetitions: number;
+  depth: number;
+  baseFreq: number;
+  equave: number;
+  generator: number;
+}
+
+type Column = { [index: number]: number } | null;
+
+export declare class SnapshotError extends Error {}
+
+export declare class SnapshotView {
+  constructor(source: ArrayBufferLike | ArrayBufferView);
+  readonly header: SnapshotHeader;
+  readonly isDelta: boolean;
+  readonly isFloat32: boolean;
+  readonly byteLength: number;
+  readonly length: number;
+  index(i: number): number;
+  naturalX(i: number): number;
+  naturalY(i: number): number;
+  tuningX(i: number): number;
+  tuningY(i: number): number;
+  pitch(i: number): number;
+  applyTo(columns: {
+    pitch?: Column;
+    tuningX?: Column;
+    tuningY?: Column;
+    naturalX?: Column;
+    naturalY?: Column;
+  }): void;
+}
+
+export declare function parseSnapshot(source: ArrayBufferLike | ArrayBufferView): SnapshotView;
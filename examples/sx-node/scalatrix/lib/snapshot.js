@@ -0,0 +1,144 @@
+// Zero-copy reader for scalatrix binary tuning snapshots.
+//
+// The format is specified in include/scalatrix/snapshot.hpp: a fixed
+// little-endian header followed by one array per node field. parseSnapshot
+// checks the header and sizes once; the accessors then read single values
+// through a DataView on the original buffer, so a WebSocket or
+// SharedArrayBuffer payload is never copied.
+//
+//   const view = parseSnapshot(event.data);   // ArrayBuffer or typed array
+//   for (let i = 0; i < view.length; i++) {
+//     const node = view.index(i);
+//     pitches[node] = view.pitch(i);
+//   }
+
+export const SNAPSHOT_MAGIC = 0x4e535853; // "SXSN" read as little-endian u32
+export const SNAPSHOT_VERSION = 1;
+export const SNAPSHOT_HEADER_SIZE = 80;
+export const SNAPSHOT_FLOAT32 = 1;
+export const SNAPSHOT_DELTA = 2;
+
+// Not (n + 7) & ~7: bitwise operators truncate to 32 bits
+const pad8 = (n) => Math.ceil(n / 8) * 8;
+
+export class SnapshotError extends Error {}
+
+export class SnapshotView {
+  // source: ArrayBuffer, SharedArrayBuffer, or any ArrayBufferView
+  constructor(source) {
+    const dv = ArrayBuffer.isView(source)
+      ? new DataView(source.buffer, source.byteOffset, source.byteLength)
+      : new DataView(source);
+    if (dv.byteLength < SNAPSHOT_HEADER_SIZE) throw new SnapshotError('snapshot truncated');
+    if (dv.getUint32(0, true) !== SNAPSHOT_MAGIC) throw new SnapshotError('not a scalatrix snapshot');
+    const version = dv.getUint16(4, true);
+    if (version !== SNAPSHOT_VERSION) throw new SnapshotError(`unsupported snapshot version ${version}`);
+    const headerSize = dv.getUint32(8, true);
+    if (headerSize < SNAPSHOT_HEADER_SIZE || headerSize > dv.byteLength) {
+      throw new SnapshotError('snapshot truncated');
+    }
+
+    this.header = {
+      version,
+      flags: dv.getUint16(6, true),
+      seq: dv.getUint32(12, true),
+      baseSeq: dv.getUint32(16, true),
+      nodeCount: dv.getUint32(20, true),
+      recordCount: dv.getUint32(24, true),
+      root: dv.getInt32(28, true),
+      a: dv.getInt32(32, true),
+      b: dv.getInt32(36, true),
+      mode: dv.getInt32(40, true),
+      repetitions: dv.getInt32(44, true),
+      depth: dv.getInt32(48, true),
+      baseFreq: dv.getFloat64(56, true),
+      equave: dv.getFloat64(64, true),
+      generator: dv.getFloat64(72, true),
+    };
+    const h = this.header;
+    this.isDelta = (h.flags & SNAPSHOT_DELTA) !== 0;
+    this.isFloat32 = (h.flags & SNAPSHOT_FLOAT32) !== 0;
+    if (h.recordCount > h.nodeCount || (!this.isDelta && h.recordCount !== h.nodeCount)) {
+      throw new SnapshotError('inconsistent snapshot header');
+    }
+    // Every record takes at least 4 bytes; checked before the offsets are
+    // computed from a count no buffer could hold
+    if (h.recordCount > (dv.byteLength - headerSize) / 4) {
+      throw new SnapshotError('snapshot truncated');
+    }
+
+    const n = h.recordCount;
+    const ints = pad8(4 * n);
+    const reals = pad8((this.isFloat32 ? 4 : 8) * n);
+    this._index = headerSize;
+    this._naturalX = this._index + (this.isDelta ? ints : 0);
+    this._naturalY = this._naturalX + ints;
+    this._tuningX = this._naturalY + ints;
+    this._tuningY = this._tuningX + reals;
+    this._pitch = this._tuningY + reals;
+    this.byteLength = this._pitch + reals;
+    if (this.byteLength > dv.byteLength) throw new SnapshotError('snapshot truncated');
+    this._dv = dv;
+    if (this.isDelta) {
+      for (let i = 0; i < n; i++) {
+        if (dv.getUint32(this._index + 4 * i, true) >= h.nodeCount) {
+          throw new SnapshotError('inconsistent snapshot header');
+        }
+      }
+    }
+  }
+
+  // Number of records
+  get length() {
+    return this.header.recordCount;
+  }
+
+  // Scale index of record i
+  index(i) {
+    return this.isDelta ? this._dv.getUint32(this._index + 4 * i, true) : i;
+  }
+
+  naturalX(i) {
+    return this._dv.getInt32(this._naturalX + 4 * i, true);
+  }
+
+  naturalY(i) {
+    return this._dv.getInt32(this._naturalY + 4 * i, true);
+  }
+
+  _real(offset, i) {
+    return this.isFloat32
+      ? this._dv.getFloat32(offset + 4 * i, true)
+      : this._dv.getFloat64(offset + 8 * i, true);
+  }
+
+  tuningX(i) {
+    return this._real(this._tuningX, i);
+  }
+
+  tuningY(i) {
+    return this._real(this._tuningY, i);
+  }
+
+  // Frequency of record i in Hz
+  pitch(i) {
+    return this._real(this._pitch, i);
+  }
+
+  // Writes the records into column arrays of nodeCount entries, e.g. a
+  // Float64Array of pitches; pass null to skip a column. A delta updates
+  // only the nodes it carries, so the arrays must hold snapshot baseSeq.
+  applyTo({ pitch = null, tuningX = null, tuningY = null, naturalX = null, naturalY = null }) {
+    for (let i = 0; i < this.length; i++) {
+      const k = this.index(i);
+      if (pitch) pitch[k] = this.pitch(i);
+      if (tuningX) tuningX[k] = this.tuningX(i);
+      if (tuningY) tuningY[k] = this.tuningY(i);
+      if (naturalX) naturalX[k] = this.naturalX(i);
+      if (naturalY) naturalY[k] = this.naturalY(i);
+    }
+  }
+}
+
+// Throws SnapshotError if source is not a complete snapshot this reader knows
+export const parseSnapshot = (source) => new SnapshotView(source);
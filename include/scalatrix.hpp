@@ -19,13 +19,22 @@
 #include "scalatrix/affine_transform.hpp"
 #include "scalatrix/lattice.hpp"
 #include "scalatrix/node.hpp"
+#include "scalatrix/memory.hpp"
 #include "scalatrix/scale.hpp"
 #include "scalatrix/params.hpp"
 #include "scalatrix/mos.hpp"
+#include "scalatrix/mos_pattern.hpp"
+#include "scalatrix/mos_family.hpp"
 #include "scalatrix/pitchset.hpp"
+#include "scalatrix/monzo.hpp"
+#include "scalatrix/tempering.hpp"
+#include "scalatrix/temperament_search.hpp"
 #include "scalatrix/label_calculator.hpp"
 #include "scalatrix/spectrum.hpp"
 #include "scalatrix/consonance.hpp"
+#include "scalatrix/update_scheduler.hpp"
+#include "scalatrix/snapshot.hpp"
+#include "scalatrix/shared_tuning.hpp"
 
 
 #endif // SCALATRIX_HPP
@@ -1,43 +1,71 @@
 #ifndef SCALATRIX_AFFINE_TRANSFORM_HPP
 #define SCALATRIX_AFFINE_TRANSFORM_HPP
 
+#include <cassert>
 #include <utility>
 
 namespace scalatrix {
 
 struct Vector2i {
     int x, y;
-    Vector2i(int x_ = 0, int y_ = 0) noexcept : x(x_), y(y_) {}
-    Vector2i operator-(){ return {-x, -y}; }
-    void operator+=(const Vector2i& v) { x += v.x; y += v.y; }
-    void operator-=(const Vector2i& v) { x -= v.x; y -= v.y; }
-    Vector2i operator+(const Vector2i& v) { return {x + v.x, y + v.y}; }
-    Vector2i operator-(const Vector2i& v) { return {x - v.x, y - v.y}; }
-    Vector2i operator*(const int s) { return {x * s, y * s}; }
-    bool operator<(const Vector2i& v) const {
+    constexpr Vector2i(int x_ = 0, int y_ = 0) noexcept : x(x_), y(y_) {}
+    constexpr Vector2i operator-() const noexcept { return {-x, -y}; }
+    constexpr void operator+=(const Vector2i& v) noexcept { x += v.x; y += v.y; }
+    constexpr void operator-=(const Vector2i& v) noexcept { x -= v.x; y -= v.y; }
+    constexpr Vector2i operator+(const Vector2i& v) const noexcept { return {x + v.x, y + v.y}; }
+    constexpr Vector2i operator-(const Vector2i& v) const noexcept { return {x - v.x, y - v.y}; }
+    constexpr Vector2i operator*(const int s) const noexcept { return {x * s, y * s}; }
+    constexpr bool operator<(const Vector2i& v) const noexcept {
         return (x < v.x) || (x == v.x && y < v.y);
     };
-    bool operator==(const Vector2i& v) const { return x == v.x && y == v.y; }
+    constexpr bool operator==(const Vector2i& v) const noexcept { return x == v.x && y == v.y; }
+    constexpr bool operator!=(const Vector2i& v) const noexcept { return !(*this == v); }
 
 };
 
 // Commutative scalar multiplication for Vector2i
-inline Vector2i operator*(int s, const Vector2i& v) { return {s * v.x, s * v.y}; }
+constexpr Vector2i operator*(int s, const Vector2i& v) noexcept { return {s * v.x, s * v.y}; }
 
 class IntegerAffineTransform {
 public:
     int a, b, c, d;  // 2x2 matrix
     int tx, ty;      // Offset vector
 
-    IntegerAffineTransform(int a_ = 1, int b_ = 0, int c_ = 0, int d_ = 1,
-                          int tx_ = 0, int ty_ = 0);
-    IntegerAffineTransform operator*(int s) const;
-    Vector2i operator*(const Vector2i& v) const;
-    IntegerAffineTransform inverse() const;  // May need special handling if not invertible
-    Vector2i apply(const Vector2i& v) const;
-    IntegerAffineTransform applyAffine(const IntegerAffineTransform& M) const;
+    constexpr IntegerAffineTransform(int a_ = 1, int b_ = 0, int c_ = 0, int d_ = 1,
+                                     int tx_ = 0, int ty_ = 0) noexcept
+        : a(a_), b(b_), c(c_), d(d_), tx(tx_), ty(ty_) {}
 
-    static IntegerAffineTransform& linearFromTwoDots(
+    constexpr IntegerAffineTransform operator*(int s) const noexcept {
+        return {a * s, b * s, c * s, d * s, tx * s, ty * s};
+    }
+    constexpr Vector2i operator*(const Vector2i& v) const noexcept {
+        return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
+    }
+    constexpr Vector2i apply(const Vector2i& v) const noexcept { return *this * v; }
+    constexpr IntegerAffineTransform applyAffine(const IntegerAffineTransform& M) const noexcept {
+        return {a * M.a + b * M.c, a * M.b + b * M.d, c * M.a + d * M.c, c * M.b + d * M.d,
+                a * M.tx + b * M.ty + tx, c * M.tx + d * M.ty + ty};
+    }
+    constexpr int det() const noexcept { return a * d - b * c; }
+    // Exact only for det = +-1; asserts det != 0
+    constexpr IntegerAffineTransform inverse() const noexcept {
+        int det = a * d - b * c;
+        assert(det != 0);
+        return {d / det, -b / det, -c / det, a / det, -(d * tx - b * ty) / det, -(a * ty - c * tx) / det};
+    }
+    constexpr bool operator==(const IntegerAffineTransform& M) const noexcept {
+        return a == M.a && b == M.b && c == M.c && d == M.d && tx == M.tx && ty == M.ty;
+    }
+
+    // The linear map taking a1 to b1 and a2 to b2, solved exactly in
+    // integers. If a1, a2 are collinear or the map has non-integer entries,
+    // returns the identity and sets *exact to false (asserts if exact is null).
+    static IntegerAffineTransform linearMapFromTwoDots(
+        const Vector2i& a1, const Vector2i& a2,
+        const Vector2i& b1, const Vector2i& b2, bool* exact = nullptr);
+
+    // Same as linearMapFromTwoDots, kept for existing callers
+    static IntegerAffineTransform linearFromTwoDots(
         const Vector2i& a1, const Vector2i& a2,
         const Vector2i& b1, const Vector2i& b2);
 
@@ -45,36 +73,52 @@ public:
 
 struct Vector2d {
     double x, y;
-    Vector2d(double x_ = 0.0, double y_ = 0.0) noexcept : x(x_), y(y_) {}
-    Vector2d(Vector2i v) noexcept : x(v.x), y(v.y) {}
-    Vector2d operator-(){ return {-x, -y}; }
-    void operator+=(const Vector2d& v) { x += v.x; y += v.y; }
-    void operator-=(const Vector2d& v) { x -= v.x; y -= v.y; }
-    Vector2d operator+(const Vector2d& v) { return {x + v.x, y + v.y}; }
-    Vector2d operator-(const Vector2d& v) { return {x - v.x, y - v.y}; }
-    Vector2d operator*(double s) { return {x * s, y * s}; }
+    constexpr Vector2d(double x_ = 0.0, double y_ = 0.0) noexcept : x(x_), y(y_) {}
+    constexpr Vector2d(Vector2i v) noexcept : x(v.x), y(v.y) {}
+    constexpr Vector2d operator-() const noexcept { return {-x, -y}; }
+    constexpr void operator+=(const Vector2d& v) noexcept { x += v.x; y += v.y; }
+    constexpr void operator-=(const Vector2d& v) noexcept { x -= v.x; y -= v.y; }
+    constexpr Vector2d operator+(const Vector2d& v) const noexcept { return {x + v.x, y + v.y}; }
+    constexpr Vector2d operator-(const Vector2d& v) const noexcept { return {x - v.x, y - v.y}; }
+    constexpr Vector2d operator*(double s) const noexcept { return {x * s, y * s}; }
 };
 
 // Commutative scalar multiplication for Vector2d
-inline Vector2d operator*(double s, const Vector2d& v) { return {s * v.x, s * v.y}; }
+constexpr Vector2d operator*(double s, const Vector2d& v) noexcept { return {s * v.x, s * v.y}; }
 
 class AffineTransform {
 public:
     double a, b, c, d;  // 2x2 matrix
     double tx, ty;      // Offset vector
 
-    AffineTransform(double a_ = 1.0, double b_ = 0.0, double c_ = 0.0, double d_ = 1.0,
-                    double tx_ = 0.0, double ty_ = 0.0);
-    AffineTransform operator*(double s) const;
-    Vector2d operator*(const Vector2d& v) const;
-    Vector2d operator*(const Vector2i& v) const;
-    AffineTransform operator*(const AffineTransform& M) const;
-    AffineTransform inverse() const;
-    Vector2d apply(const Vector2d& v) const;
-    //Vector2d applyInt(const Vector2i& v) const;
-    AffineTransform applyAffine(const AffineTransform& M) const;
+    constexpr AffineTransform(double a_ = 1.0, double b_ = 0.0, double c_ = 0.0, double d_ = 1.0,
+                              double tx_ = 0.0, double ty_ = 0.0) noexcept
+        : a(a_), b(b_), c(c_), d(d_), tx(tx_), ty(ty_) {}
+
+    constexpr AffineTransform operator*(double s) const noexcept {
+        return {a * s, b * s, c * s, d * s, tx * s, ty * s};
+    }
+    constexpr Vector2d operator*(const Vector2d& v) const noexcept {
+        return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
+    }
+    constexpr Vector2d operator*(const Vector2i& v) const noexcept {
+        return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
+    }
+    constexpr AffineTransform operator*(const AffineTransform& M) const noexcept {
+        return {a * M.a + b * M.c, a * M.b + b * M.d, c * M.a + d * M.c, c * M.b + d * M.d,
+                a * M.tx + b * M.ty + tx, c * M.tx + d * M.ty + ty};
+    }
+    constexpr Vector2d apply(const Vector2d& v) const noexcept { return *this * v; }
+    constexpr AffineTransform applyAffine(const AffineTransform& M) const noexcept { return *this * M; }
+    constexpr double det() const noexcept { return a * d - b * c; }
+    // Asserts that the transform is not (nearly) singular
+    constexpr AffineTransform inverse() const noexcept {
+        double det = a * d - b * c;
+        assert(det > 1e-7 || det < -1e-7);
+        return {d / det, -b / det, -c / det, a / det, -(d * tx - b * ty) / det, -(a * ty - c * tx) / det};
+    }
 };
 
 } // namespace scalatrix
 
-#endif // SCALATRIX_AFFINE_TRANSFORM_HPP
\ No newline at end of file
+#endif // SCALATRIX_AFFINE_TRANSFORM_HPP
@@ -63,6 +63,9 @@ void scalatrix_mos_adjust_params(
     int a, int b, int mode, double equave, double generator, int repetitions);
 
 
+void scalatrix_mos_adjust_g(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions);
+
 void scalatrix_mos_adjust_tuning_g(
     scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions);
 
@@ -82,6 +85,7 @@ scalatrix_vec2i scalatrix_mos_map_from_mos(
 
 /* ── Scale generation ──────────────────────────────────────────────── */
 
+/* Both return NULL unless 0 <= root < n_nodes. */
 scalatrix_scale_t* scalatrix_mos_generate_mapped_scale(
     const scalatrix_mos_t* mos,
     int steps, double offset, double base_freq, int n_nodes, int root);
@@ -89,6 +93,50 @@ scalatrix_scale_t* scalatrix_mos_generate_mapped_scale(
 scalatrix_scale_t* scalatrix_mos_generate_scale(
     scalatrix_mos_t* mos, double base_freq, int n_nodes, int root);
 
+/* ── In-place regeneration ─────────────────────────────────────────── */
+
+/* Arguments of scalatrix_mos_generate_mapped_scale */
+typedef struct {
+    int    steps;
+    double offset;
+    double base_freq;
+    int    n_nodes, root;
+} scalatrix_mapping;
+
+/* A scale of n_nodes blank nodes to regenerate into, freed with
+   scalatrix_scale_free. Sizing it up front makes the first regeneration at
+   n_nodes allocation-free too. */
+scalatrix_scale_t* scalatrix_scale_new(int n_nodes);
+
+/* As the generate functions above, but into an existing scale, reusing its
+   storage. Once the scale has held n_nodes nodes these do not allocate.
+   Return 0, or -1 leaving the scale untouched unless 0 <= root < n_nodes. */
+int scalatrix_mos_generate_mapped_scale_into(
+    const scalatrix_mos_t* mos, scalatrix_scale_t* scale,
+    int steps, double offset, double base_freq, int n_nodes, int root);
+
+int scalatrix_mos_generate_scale_into(
+    scalatrix_mos_t* mos, scalatrix_scale_t* scale,
+    double base_freq, int n_nodes, int root);
+
+/* The MOS mutations, followed by regenerating the mapped scale bound to the
+   MOS in the same call. With the pattern size (a + b) and n_nodes unchanged
+   since the last call, an update performs no heap allocation. Return 0, or
+   -1 leaving both the MOS and the scale untouched if mapping or scale is
+   NULL or the mapping root is outside its nodes. */
+int scalatrix_mos_adjust_params_into(
+    scalatrix_mos_t* mos,
+    int a, int b, int mode, double equave, double generator, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale);
+
+int scalatrix_mos_adjust_g_into(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale);
+
+int scalatrix_mos_adjust_tuning_g_into(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale);
+
 /* ── Scale lifecycle and access ────────────────────────────────────── */
 
 void   scalatrix_scale_free(scalatrix_scale_t* scale);
@@ -100,6 +148,332 @@ double scalatrix_scale_base_freq(const scalatrix_scale_t* scale);
 int scalatrix_scale_get_node(
     const scalatrix_scale_t* scale, int index, scalatrix_node* out);
 
+/* Bulk readout of nodes [first, first + count) in one call, into
+   caller-provided arrays of at least count entries. count is clamped to the
+   end of the scale. Returns the number of nodes copied, or -1 if first or
+   count is out of range.
+
+   All scalatrix_*_copy_* functions follow this convention: a NULL output
+   array is skipped, and the return value is the number of entries that
+   would be written whether or not any array is given, so NULL arrays with
+   a large count or capacity query the size. */
+int scalatrix_scale_copy_nodes(
+    const scalatrix_scale_t* scale, int first, int count, scalatrix_node* out);
+
+/* As scalatrix_scale_copy_nodes, one array per field; pass NULL to skip a field. */
+int scalatrix_scale_copy_columns(
+    const scalatrix_scale_t* scale, int first, int count,
+    double* pitches, scalatrix_vec2i* natural_coords, scalatrix_vec2d* tuning_coords);
+
+/* ── MOS families ──────────────────────────────────────────────────── */
+
+typedef struct scalatrix_mos_family scalatrix_mos_family_t;
+
+typedef struct {
+    int    min_size, max_size;  /* range of a + b */
+    int    g_steps;             /* generators across each pattern's range */
+    double equave;
+    int    steps;               /* mapping steps; <= 0: each member's own n */
+    double offset;
+    double base_freq;
+    int    n_nodes, root;       /* mapped scale per member; n_nodes = 0 skips it */
+    int    n_threads;           /* 0: one per core */
+} scalatrix_mos_family_options;
+
+scalatrix_mos_family_options scalatrix_mos_family_default_options(void);
+
+/* Returns NULL if options is NULL, and an empty family if n_nodes > 0 and
+   root lies outside [0, n_nodes) */
+scalatrix_mos_family_t* scalatrix_mos_family_generate(
+    const scalatrix_mos_family_options* options);
+
+void scalatrix_mos_family_free(scalatrix_mos_family_t* family);
+
+int scalatrix_mos_family_size(const scalatrix_mos_family_t* family);
+int scalatrix_mos_family_n_nodes(const scalatrix_mos_family_t* family);
+
+/* Columns, valid until the family is freed. Member columns hold size
+   entries; node columns hold size * n_nodes, member by member. */
+const int*    scalatrix_mos_family_a(const scalatrix_mos_family_t* family);
+const int*    scalatrix_mos_family_b(const scalatrix_mos_family_t* family);
+const int*    scalatrix_mos_family_mode(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_generator(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_L_fr(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_s_fr(const scalatrix_mos_family_t* family);
+const int*    scalatrix_mos_family_coord_x(const scalatrix_mos_family_t* family);
+const int*    scalatrix_mos_family_coord_y(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_tuning_x(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_tuning_y(const scalatrix_mos_family_t* family);
+const double* scalatrix_mos_family_pitch(const scalatrix_mos_family_t* family);
+
+/* ── Spectra ───────────────────────────────────────────────────────── */
+
+typedef struct scalatrix_spectrum scalatrix_spectrum_t;
+
+/* Partials given as frequency ratios with their amplitudes, n of each.
+   NULL if n > 0 and either array is NULL. */
+scalatrix_spectrum_t* scalatrix_spectrum_new(
+    const double* ratios, const double* amplitudes, int n);
+
+scalatrix_spectrum_t* scalatrix_spectrum_harmonic(int n_partials, double decay);
+scalatrix_spectrum_t* scalatrix_spectrum_odd_harmonic(int max_harmonic, double decay);
+
+/* primes[i] tuned to cents[i]; n_primes = 0 takes the default 2, 3, 5
+   tuning. NULL if n_primes > 0 and either array is NULL. */
+scalatrix_spectrum_t* scalatrix_spectrum_pseudoharmonic(
+    int n_partials, double decay, const int* primes, const double* cents, int n_primes);
+
+void scalatrix_spectrum_free(scalatrix_spectrum_t* spectrum);
+
+int scalatrix_spectrum_size(const scalatrix_spectrum_t* spectrum);
+
+/* Copies up to capacity partials; pass NULL to skip an array. Returns the
+   number copied, as scalatrix_scale_copy_nodes. */
+int scalatrix_spectrum_copy_partials(
+    const scalatrix_spectrum_t* spectrum, double* ratios, double* amplitudes, int capacity);
+
+/* ── Consonance ────────────────────────────────────────────────────── */
+
+/* A spectrum, f0 and cents grid prepared for repeated curve evaluation */
+typedef struct scalatrix_consonance scalatrix_consonance_t;
+
+#define SCALATRIX_CONSONANCE_MAX_POINTS (1 << 24)
+
+typedef struct {
+    double peak;
+    double log_baseline;  /* the baseline used, after auto-computation */
+} scalatrix_consonance_info;
+
+/* Copies the spectrum. resolution is the grid step in cents. NULL unless
+   every argument is finite, cents_min < cents_max, resolution > 0 and the
+   grid has at most SCALATRIX_CONSONANCE_MAX_POINTS points. */
+scalatrix_consonance_t* scalatrix_consonance_new(
+    const scalatrix_spectrum_t* spectrum, double f0,
+    double cents_min, double cents_max, double resolution);
+
+void scalatrix_consonance_free(scalatrix_consonance_t* consonance);
+
+/* Points on the cents grid; every output array needs this many entries */
+int scalatrix_consonance_size(const scalatrix_consonance_t* consonance);
+
+/* Evaluates the curve as computeConsonanceCurve (gen3 = 0) or
+   computeConsonanceCurveGen3 (gen3 != 0) into caller-provided arrays; pass
+   NULL to skip any of them, info included. Does not allocate. Returns 0, or
+   -1 if capacity is below scalatrix_consonance_size. */
+int scalatrix_consonance_compute(
+    scalatrix_consonance_t* consonance, double log_baseline, int gen3,
+    double* cents, double* pl, double* hull, double* spiky, double* consonance_out,
+    int capacity, scalatrix_consonance_info* info);
+
+/* Consonance of n intervals in cents, as analyzeScale. Intervals above
+   max_interval_cents are skipped and get NaN (a NaN interval is not above
+   it and gets 0). mean_out (may be NULL) receives the mean over the
+   analyzed ones. Returns how many were analyzed. */
+int scalatrix_analyze_scale(
+    const scalatrix_spectrum_t* spectrum, double f0,
+    const double* interval_cents, int n,
+    double max_cents, double max_interval_cents, double log_baseline,
+    double* consonance_out, double* mean_out);
+
+/* ── Pitch sets ────────────────────────────────────────────────────── */
+
+/* A pitch set indexed for nearest-pitch lookup */
+typedef struct scalatrix_pitchset scalatrix_pitchset_t;
+
+/* JI bounds, as JIBound */
+enum {
+    SCALATRIX_JI_NUM_DEN       = 0,  /* num < limit and den < limit */
+    SCALATRIX_JI_ODD_LIMIT     = 1,  /* odd parts of num and den <= limit */
+    SCALATRIX_JI_TENNEY_HEIGHT = 2   /* num * den <= limit */
+};
+
+/* Generators; ranges are in log2 frequency ratios. The JI ones use the
+   first n_primes of the default prime list. */
+scalatrix_pitchset_t* scalatrix_pitchset_et(
+    int n_et, double equave, double min_log2fr, double max_log2fr);
+
+scalatrix_pitchset_t* scalatrix_pitchset_ji(
+    int n_primes, int max_numtimesden, double min_log2fr, double max_log2fr);
+
+/* Returns NULL for an unknown bound_kind */
+scalatrix_pitchset_t* scalatrix_pitchset_bounded_ji(
+    int n_primes, int bound_kind, long long limit, double min_log2fr, double max_log2fr);
+
+scalatrix_pitchset_t* scalatrix_pitchset_harmonic_series(
+    int n_primes, int base, double min_log2fr, double max_log2fr);
+
+/* From n pitches; labels may be NULL, or hold NULL entries, for no label.
+   NULL if n > 0 and log2fr is NULL. */
+scalatrix_pitchset_t* scalatrix_pitchset_new(
+    const double* log2fr, const char* const* labels, int n);
+
+void scalatrix_pitchset_free(scalatrix_pitchset_t* pitchset);
+
+int scalatrix_pitchset_size(const scalatrix_pitchset_t* pitchset);
+
+/* Copies up to capacity pitches in set order; out may be NULL. Returns the
+   number copied, as scalatrix_scale_copy_nodes. */
+int scalatrix_pitchset_copy_log2fr(
+    const scalatrix_pitchset_t* pitchset, double* out, int capacity);
+
+/* Writes the label of pitch index into buf like snprintf (always
+   NUL-terminated if size > 0) and returns its full length, or -1 if index
+   is out of range. */
+int scalatrix_pitchset_label(
+    const scalatrix_pitchset_t* pitchset, int index, char* buf, int size);
+
+/* Index of the pitch closest to log2fr, or -1 for an empty set */
+int scalatrix_pitchset_closest(const scalatrix_pitchset_t* pitchset, double log2fr);
+
+/* ── Tempering ─────────────────────────────────────────────────────── */
+
+typedef struct {
+    double max_cents;
+    double rms_cents;
+    int    n_nodes;     /* nodes that found a pitch to temper to */
+} scalatrix_tempering_stats;
+
+/* Tempers every node to its closest pitch in the set; stats may be NULL */
+void scalatrix_scale_temper(
+    scalatrix_scale_t* scale, const scalatrix_pitchset_t* pitchset,
+    scalatrix_tempering_stats* stats);
+
+/* Tempering of nodes [first, first + count), as scalatrix_scale_copy_nodes;
+   pass NULL to skip a field. */
+int scalatrix_scale_copy_tempering(
+    const scalatrix_scale_t* scale, int first, int count,
+    int* is_tempered, double* tempered_log2fr);
+
+/* Label of the pitch node index was tempered to, as scalatrix_pitchset_label */
+int scalatrix_scale_tempered_label(
+    const scalatrix_scale_t* scale, int index, char* buf, int size);
+
+/* ── Snapshots ─────────────────────────────────────────────────────── */
+
+/* Binary snapshots of a MOS and its scale; see scalatrix/snapshot.hpp for
+   the format. */
+#define SCALATRIX_SNAPSHOT_FLOAT32 1
+#define SCALATRIX_SNAPSHOT_DELTA   2
+
+/* Bytes a snapshot of n_records nodes takes with the given flags, or -1 if
+   n_records is negative */
+int scalatrix_snapshot_size(int n_records, int flags);
+
+/* Writes scale, generated from mos, as snapshot seq. With previous
+   non-NULL, writes a delta against it (snapshot base_seq) if that is
+   smaller. Returns the bytes written, or -1 if they do not fit in capacity;
+   scalatrix_snapshot_size(node count, float32 ? SCALATRIX_SNAPSHOT_FLOAT32 : 0)
+   bytes always do. */
+int scalatrix_snapshot_write(
+    const scalatrix_mos_t* mos, const scalatrix_scale_t* scale,
+    const scalatrix_scale_t* previous, unsigned int seq, unsigned int base_seq,
+    int float32, unsigned char* out, int capacity);
+
+/* Writes a snapshot's nodes into scale: a full snapshot replaces it, a
+   delta updates it in place. Returns 0, or -1 if data is not a valid
+   snapshot or a delta does not fit the scale. */
+int scalatrix_snapshot_apply(
+    const unsigned char* data, int size, scalatrix_scale_t* scale);
+
+/* ── Shared tuning tables ──────────────────────────────────────────── */
+
+/* Tuning tables published through POSIX shared memory; see
+   scalatrix/shared_tuning.hpp. Not available on Windows or WASM, where
+   the open functions return NULL. */
+typedef struct scalatrix_shared_publisher scalatrix_shared_publisher_t;
+typedef struct scalatrix_shared_reader    scalatrix_shared_reader_t;
+
+/* Creates or reuses segment name ("/name") with room for max_nodes nodes.
+   NULL if the segment cannot be set up. */
+scalatrix_shared_publisher_t* scalatrix_shared_publisher_open(
+    const char* name, int max_nodes, int float32);
+void scalatrix_shared_publisher_close(scalatrix_shared_publisher_t* publisher);
+
+/* Publishes scale, generated from mos. Returns the table's sequence
+   number, or -1 if the scale has more nodes than the segment has room for. */
+long long scalatrix_shared_publisher_publish(
+    scalatrix_shared_publisher_t* publisher,
+    const scalatrix_mos_t* mos, const scalatrix_scale_t* scale);
+
+/* Removes the segment name; processes that have it open keep it. Returns
+   0, or -1 if there was none. */
+int scalatrix_shared_unlink(const char* name);
+
+/* Maps an existing segment read-only; NULL if there is none. If a
+   publisher grows the segment, the next read maps it again. */
+scalatrix_shared_reader_t* scalatrix_shared_reader_open(const char* name);
+void scalatrix_shared_reader_close(scalatrix_shared_reader_t* reader);
+
+/* Whether a table newer than the last one read has been published */
+int scalatrix_shared_reader_has_update(const scalatrix_shared_reader_t* reader);
+
+/* Copies the latest table if it is newer than the last one read, without
+   waiting for the publisher. Returns 1 if a newer table was read, else 0. */
+int scalatrix_shared_reader_read(scalatrix_shared_reader_t* reader);
+
+/* Sequence number of the last table read, 0 before the first */
+unsigned int scalatrix_shared_reader_sequence(const scalatrix_shared_reader_t* reader);
+
+/* The last table read as snapshot bytes, valid until the next read; NULL
+   before the first. *size receives the length. */
+const unsigned char* scalatrix_shared_reader_data(
+    const scalatrix_shared_reader_t* reader, int* size);
+
+/* Writes the last table read into scale. Returns 0, or -1 before the first. */
+int scalatrix_shared_reader_apply(
+    const scalatrix_shared_reader_t* reader, scalatrix_scale_t* scale);
+
+/* ── Label batches ─────────────────────────────────────────────────── */
+
+/* Label styles, as LabelTable::Style in scalatrix/label_calculator.hpp.
+   Or in SCALATRIX_LABEL_TUNING for accidentals that follow the tuning (the
+   *Tuning label functions) and SCALATRIX_LABEL_ACCIDENTAL_BEFORE for "♯C". */
+#define SCALATRIX_LABEL_DIGIT              0
+#define SCALATRIX_LABEL_DIGIT_ZERO_BASED   1
+#define SCALATRIX_LABEL_LETTER             2
+#define SCALATRIX_LABEL_LETTER_WITH_OCTAVE 3
+#define SCALATRIX_LABEL_TUNING             0x10
+#define SCALATRIX_LABEL_ACCIDENTAL_BEFORE  0x20
+
+/* A reusable buffer of labels packed back to back in UTF-8. It keeps the
+   label table of the last MOS structure it labelled, so refilling it for a
+   retuned MOS does not rebuild the table. */
+typedef struct scalatrix_labels scalatrix_labels_t;
+
+scalatrix_labels_t* scalatrix_labels_new(void);
+void scalatrix_labels_free(scalatrix_labels_t* labels);
+
+/* Fills labels with the labels of the width x height coordinates from
+   (x, y), row by row: label (j - y) * width + (i - x) is that of (i, j).
+   middle_c_octave applies to SCALATRIX_LABEL_LETTER_WITH_OCTAVE. Returns
+   the number of labels, or -1 for an unknown style. */
+int scalatrix_labels_rect(
+    scalatrix_labels_t* labels, const scalatrix_mos_t* mos,
+    int x, int y, int width, int height, int style, int middle_c_octave);
+
+/* As scalatrix_labels_rect, for count coordinates (none if count <= 0) */
+int scalatrix_labels_coords(
+    scalatrix_labels_t* labels, const scalatrix_mos_t* mos,
+    const scalatrix_vec2i* coords, int count, int style, int middle_c_octave);
+
+/* Fills labels with the deviation labels of nodes [first, first + count),
+   as scalatrix_scale_copy_nodes. A label is empty if the node's closest
+   pitch has none: a node never tempered to a pitch set, or one whose
+   closest pitch is unlabelled. */
+int scalatrix_labels_deviation(
+    scalatrix_labels_t* labels, const scalatrix_scale_t* scale, int first, int count,
+    double threshold_cents, int compare_with_tempered);
+
+int scalatrix_labels_count(const scalatrix_labels_t* labels);
+
+/* The labels back to back, without separators or a terminating NUL, valid
+   until the next fill. *size receives the length in bytes. */
+const char* scalatrix_labels_text(const scalatrix_labels_t* labels, int* size);
+
+/* count + 1 byte offsets into the text: label i is
+   text[offsets[i], offsets[i + 1]). Valid until the next fill. */
+const unsigned int* scalatrix_labels_offsets(const scalatrix_labels_t* labels);
+
 #ifdef __cplusplus
 }
 #endif
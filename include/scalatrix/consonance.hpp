@@ -57,12 +57,102 @@ ConsonanceCurve computeConsonanceCurveGen3(const Spectrum& spectrum, double f0,
     double cents_min, double cents_max, double resolution = 0.5,
     double logBaseline = 0.5);
 
+/// Caller-owned arrays of ConsonanceEvaluator::size() points each, filled by
+/// ConsonanceEvaluator. Any array may be null to skip it.
+struct ConsonanceCurveOut {
+    double* cents = nullptr;
+    double* pl = nullptr;
+    double* hull = nullptr;
+    double* spiky = nullptr;
+    double* consonance = nullptr;
+    double peak = 0.0;
+    double logBaseline = 0.0;
+};
+
+/// Reusable state for consonance curves of one spectrum and f0 over one cents
+/// grid: the grid and its ratios are built once, and the scratch the curves
+/// need is kept, so repeated evaluation writes only to the caller's arrays.
+/// compute / computeGen3 give exactly computeConsonanceCurve /
+/// computeConsonanceCurveGen3. Not safe to share between threads.
+///
+/// Arguments that fail validArguments() give an empty evaluator: size() is
+/// 0 and compute / computeGen3 write nothing but out.peak = 0 and
+/// out.logBaseline.
+class ConsonanceEvaluator {
+public:
+    static constexpr int MAX_POINTS = 1 << 24;
+
+    ConsonanceEvaluator(const Spectrum& spectrum, double f0,
+        double cents_min, double cents_max, double resolution = 0.5);
+
+    /// Whether every argument is finite, cents_min < cents_max,
+    /// resolution > 0 and the grid has at most MAX_POINTS points
+    static bool validArguments(double f0, double cents_min, double cents_max, double resolution);
+
+    int size() const { return n_points_; }
+    const Spectrum& spectrum() const { return spectrum_; }
+    const std::vector<double>& cents() const { return cents_; }
+
+    void compute(ConsonanceCurveOut& out, double logBaseline = 0.5);
+    void computeGen3(ConsonanceCurveOut& out, double logBaseline = 0.5);
+
+private:
+    void computeCurve(ConsonanceCurveOut& out, double logBaseline, bool gen3);
+
+    Spectrum spectrum_;
+    double f0_;
+    int n_points_;
+    std::vector<double> cents_, cents_ratios_;
+    std::vector<double> pl_, spiky_, scratch_;
+    std::vector<std::pair<double, double>> fa_;
+};
+
+/// A ConsonanceEvaluator that owns its output: compute / computeGen3 fill
+/// arrays of size() points allocated once by the constructor, so views of
+/// them (e.g. typed arrays over the WASM heap) stay valid for the lifetime
+/// of the buffer and show each new curve. All zero before the first compute.
+/// Empty if the arguments fail ConsonanceEvaluator::validArguments().
+class ConsonanceCurveBuffer {
+public:
+    ConsonanceCurveBuffer(const Spectrum& spectrum, double f0,
+        double cents_min, double cents_max, double resolution = 0.5);
+
+    int size() const { return evaluator_.size(); }
+    void compute(double logBaseline = 0.5);
+    void computeGen3(double logBaseline = 0.5);
+
+    const std::vector<double>& cents() const { return evaluator_.cents(); }
+    const std::vector<double>& pl() const { return pl_; }
+    const std::vector<double>& hull() const { return hull_; }
+    const std::vector<double>& spiky() const { return spiky_; }
+    const std::vector<double>& consonance() const { return consonance_; }
+    double peak() const { return peak_; }
+    double logBaseline() const { return log_baseline_; }
+
+private:
+    ConsonanceCurveOut out();
+    void keep(const ConsonanceCurveOut& out);
+
+    ConsonanceEvaluator evaluator_;
+    std::vector<double> pl_, hull_, spiky_, consonance_;
+    double peak_ = 0.0, log_baseline_ = 0.0;
+};
+
 /// Full scale analysis: compute consonance at each interval
 ConsonanceResult analyzeScale(const Spectrum& spectrum, double f0,
     const std::vector<std::pair<std::string, double>>& intervals,
     double max_cents = 2000.0, double max_interval_cents = 1950.0,
     double logBaseline = 0.5);
 
+/// analyzeScale over a plain array of n intervals in cents, without building
+/// the labelled result. consonance_out[i] gets NaN for a skipped interval;
+/// mean_out (may be null) gets the mean over the analyzed ones. Returns how
+/// many were analyzed.
+size_t analyzeIntervals(const Spectrum& spectrum, double f0,
+    const double* interval_cents, size_t n, double* consonance_out, double* mean_out,
+    double max_cents = 2000.0, double max_interval_cents = 1950.0,
+    double logBaseline = 0.5);
+
 } // namespace scalatrix
 
 #endif
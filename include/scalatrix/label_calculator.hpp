@@ -2,13 +2,109 @@
 #define SCALATRIX_LABEL_CALCULATOR_HPP
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include "scalatrix/mos.hpp"
 #include "scalatrix/node.hpp"
 
 namespace scalatrix {
 
+/**
+ * Many labels packed into one UTF-8 buffer, for handing a whole keyboard
+ * across a language boundary at once. Label i is
+ * text[offsets[i], offsets[i + 1]); there are no separators.
+ */
+struct LabelBatch {
+    std::string text;
+    std::vector<uint32_t> offsets; // size() + 1 entries, starting with 0
+
+    size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    std::string_view operator[](size_t i) const {
+        return std::string_view(text).substr(offsets[i], offsets[i + 1] - offsets[i]);
+    }
+    // Keeps the capacity, so a batch refilled every frame stops allocating
+    void clear() {
+        text.clear();
+        offsets.assign(1, 0);
+    }
+};
+
+/**
+ * Precomputed labels for one MOS structure. A label depends only on the
+ * scale degree, the accidental count and the octave of a node, so the
+ * degree and accidental strings are built once into a pool and labels are
+ * assembled from them into caller buffers, without allocating. Labels
+ * match the LabelCalculator function of the same style.
+ *
+ * rebuild() is a no-op while the structure (not the tuning) is unchanged,
+ * so a table can be kept per keyboard and rebuilt on every retune.
+ */
+class LabelTable {
+public:
+    enum Style : unsigned char {
+        DIGIT = 0,              // nodeLabelDigit
+        DIGIT_ZERO_BASED = 1,   // nodeLabelDigitZeroBased
+        LETTER = 2,             // nodeLabelLetter
+        LETTER_WITH_OCTAVE = 3  // nodeLabelLetterWithOctaveNumber
+    };
+
+    // Accidental strings up to this many signs are pooled; longer ones are
+    // written a sign at a time
+    static constexpr int MAX_POOLED_ACCIDENTALS = 8;
+
+    LabelTable() = default;
+    // tuning: accidentals follow L_vec, as the *Tuning label functions
+    explicit LabelTable(const MOS& mos, bool tuning = false) { rebuild(mos, tuning); }
+
+    // Rebuilds the pool if mos has another structure than the table
+    void rebuild(const MOS& mos, bool tuning = false);
+    bool matches(const MOS& mos, bool tuning = false) const;
+    bool empty() const { return n_ == 0; }
+
+    int degree(Vector2i v) const;
+    // Signed number of sharps (> 0) or flats (< 0)
+    int accidentals(Vector2i v) const;
+    int octave(Vector2i v, int middle_C_octave = 4) const;
+
+    // Pooled pieces; empty for a degree out of [0, n) or an accidental
+    // count beyond MAX_POOLED_ACCIDENTALS
+    std::string_view degreeString(int degree, Style style) const;
+    std::string_view accidentalString(int accidentals) const;
+
+    // Writes the label of v into buf like snprintf (always NUL-terminated
+    // if size > 0) and returns its full length
+    size_t write(Vector2i v, Style style, char* buf, size_t size,
+                 bool accidentalAfter = true, int middle_C_octave = 4) const;
+    std::string label(Vector2i v, Style style, bool accidentalAfter = true, int middle_C_octave = 4) const;
+
+    // Replaces the contents of out with the labels of count coordinates
+    void labelCoords(const Vector2i* coords, size_t count, Style style, LabelBatch& out,
+                     bool accidentalAfter = true, int middle_C_octave = 4) const;
+    // Labels of the width x height coordinates from origin, row by row:
+    // label (y - origin.y) * width + (x - origin.x) is that of (x, y)
+    void labelRect(Vector2i origin, int width, int height, Style style, LabelBatch& out,
+                   bool accidentalAfter = true, int middle_C_octave = 4) const;
+
+private:
+    void append(Vector2i v, Style style, LabelBatch& out, bool accidentalAfter, int middle_C_octave) const;
+
+    int n_ = 0, n0_ = 0, a0_ = 0, b0_ = 0;
+    int acc_sign_ = 1, neutral_mode_ = 0;
+    bool tuning_ = false;
+    std::string pool_;
+    // Start of each piece in pool_, and one past the last: three degree
+    // styles of n_ strings each, then accidentals -MAX..MAX
+    std::vector<uint32_t> offsets_;
+
+    std::string_view piece(size_t k) const {
+        return std::string_view(pool_).substr(offsets_[k], offsets_[k + 1] - offsets_[k]);
+    }
+};
+
 class LabelCalculator {
 public:
     // Structure-based labels (default) — stable when tuning changes
@@ -30,25 +126,28 @@ public:
      * @param node The node to generate label for
      * @param thresholdCents If deviation is less than this, show plain label (default 0.1)
      * @param compareWithTempered If true, compare tempered pitch with closest; if false, compare tuning_coord with closest
-     * @return String with format "label" or "label+/-XX.Xct" depending on deviation
+     * @return String with format "label" or "label+/-XX.Xct" depending on deviation,
+     *         or empty if node.closestPitch has no label (e.g. the node was never tempered)
      */
     static std::string deviationLabel(const Node& node, double thresholdCents = 0.1,
                                       bool compareWithTempered = false);
+    // deviationLabel written into buf like snprintf; returns its full length
+    static size_t writeDeviationLabel(const Node& node, char* buf, size_t size,
+                                      double thresholdCents = 0.1, bool compareWithTempered = false);
+    // Replaces the contents of out with the deviation labels of count nodes
+    static void deviationLabels(const Node* nodes, size_t count, LabelBatch& out,
+                                double thresholdCents = 0.1, bool compareWithTempered = false);
 
-    std::string noteLabelNormalized(MOS& mos, Vector2i v, bool override_letter_labels = false) {
-        if (mos.generator > 4.0/7 && mos.generator < 3.0/5 && mos.equave > 0.9 && mos.equave < 1.2 && !override_letter_labels)
-        {
-            Vector2i diatonic_coord = diatonic_mos.mapFromMOS (mos, v);
-            return nodeLabelLetter(diatonic_mos, diatonic_coord);
-        }
-        return nodeLabelDigit(mos, v);
-    }
+    // Letter label through the diatonic reference for diatonic-like MOS
+    // (generator between 4/7 and 3/5 of a near-octave equave), else a digit
+    // label. Reentrant: safe to call from many threads on one labeller.
+    std::string noteLabelNormalized(const MOS& mos, Vector2i v, bool override_letter_labels = false) const;
 
-    LabelCalculator() : diatonic_mos(MOS::fromParams (5, 2, 1, 1.0, .585)) {}
+    // Process-wide 5L 2s reference, built once on first use and never
+    // modified, so labellers cost nothing to construct
+    static const MOS& diatonicReference();
 
 private:
-    MOS diatonic_mos;
-
     // Helper methods to calculate accidental string
     static std::string accidentalString(const MOS& mos, Vector2i v);
     static std::string accidentalStringTuning(const MOS& mos, Vector2i v);
@@ -2,12 +2,76 @@
 #define SCALATRIX_LATTICE_HPP
 
 #include "affine_transform.hpp"
+#include <cstdint>
 #include <utility>
+#include <vector>
 
 namespace scalatrix {
-    
-std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M);
+
+/**
+ * Finds the two lattice vectors r, s whose images under M are the steps of
+ * the path through the strip -1 < y < 1 (r the smaller in x). Runs in bounded
+ * time and without allocating: at most 20 convergents of the strip slope and
+ * 64 reduction rounds.
+ *
+ * With exact set, a transform whose entries all lie within 1e-9 of rationals
+ * with small denominators is snapped to them and searched in integer
+ * arithmetic, so nodes on the strip boundary (as in equal temperaments) are
+ * classified consistently instead of by rounding. Other transforms fall back
+ * to the floating-point search.
+ */
+std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M, bool exact = false);
+
+/**
+ * Remembers the last strip basis so that retuning by a small amount (a
+ * generator drag) skips the search. A basis (r, s) stays the answer for as
+ * long as both still land in the strip on opposite sides of the axis,
+ * 0 < x(r) < x(s), and s - r lands outside the strip. That region is
+ * checked in O(1) on every lookup; only transforms outside it are searched.
+ */
+class StripBasisCache {
+public:
+    std::pair<Vector2i, Vector2i> find(const AffineTransform& M);
+
+    // True if (r, s) is a reduced strip basis under M
+    static bool isValid(const AffineTransform& M, const Vector2i& r, const Vector2i& s);
+
+    void clear() { has_basis_ = false; }
+    unsigned long long hits() const { return hits_; }
+    unsigned long long misses() const { return misses_; }
+    double hitRate() const {
+        unsigned long long n = hits_ + misses_;
+        return n > 0 ? (double)hits_ / n : 0.0;
+    }
+    void resetCounters() { hits_ = 0; misses_ = 0; }
+
+private:
+    Vector2i r_, s_;
+    bool has_basis_ = false;
+    unsigned long long hits_ = 0, misses_ = 0;
+};
+
+// A step of the path through the strip, in terms of the strip basis (r, s)
+enum StripStep : uint8_t {
+    STRIP_STEP_R = 0,
+    STRIP_STEP_S = 1,
+    STRIP_STEP_RS = 2,  // r + s
+};
+
+/**
+ * Writes the step word of the path through the strip 0 <= y < 1 under A: the
+ * n steps walked from node `start`, forward (direction 1) or backward
+ * (direction -1, stepping by -r, -s, -(r + s)). (r, s) is the strip basis of
+ * A without its translation. Each step depends only on the height of the
+ * current node and is chosen without data-dependent branches. Returns the
+ * node reached.
+ */
+Vector2i stripStepWord(const AffineTransform& A, const Vector2i& r, const Vector2i& s,
+                       const Vector2i& start, int direction, int n, uint8_t* word);
+
+// The first n steps forward from the origin, using findClosestWithinStrip
+std::vector<uint8_t> stripStepWord(const AffineTransform& A, int n);
 
 } // namespace scalatrix
 
-#endif // SCALATRIX_LATTICE_HPP
\ No newline at end of file
+#endif // SCALATRIX_LATTICE_HPP
@@ -0,0 +1,145 @@
+#ifndef SCALATRIX_MEMORY_HPP
+#define SCALATRIX_MEMORY_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * Source of memory for Scale and MOS storage, in the shape of
+ * std::pmr::memory_resource. The standard one is not used because Apple's
+ * libc++ only ships it from macOS 14 / iOS 17, below the deployment targets
+ * this library builds for.
+ */
+class MemoryResource {
+public:
+    static constexpr size_t DEFAULT_ALIGN = alignof(std::max_align_t);
+
+    virtual ~MemoryResource() = default;
+
+    void* allocate(size_t bytes, size_t align = DEFAULT_ALIGN) { return doAllocate(bytes, align); }
+    void deallocate(void* p, size_t bytes, size_t align = DEFAULT_ALIGN) { doDeallocate(p, bytes, align); }
+    // True if memory from one may be returned to the other
+    bool isEqual(const MemoryResource& other) const noexcept { return this == &other || doIsEqual(other); }
+
+protected:
+    virtual void* doAllocate(size_t bytes, size_t align) = 0;
+    virtual void doDeallocate(void* p, size_t bytes, size_t align) = 0;
+    virtual bool doIsEqual(const MemoryResource& other) const noexcept { (void)other; return false; }
+};
+
+// Global operator new / delete; what every container uses unless told otherwise
+MemoryResource* defaultMemoryResource() noexcept;
+
+/**
+ * Bump allocator: hands out memory from chunks taken from upstream (or from
+ * a caller's buffer first) and ignores deallocation. Everything is returned
+ * at once by release() or the destructor. Each new chunk is twice the size
+ * of the last. Not thread-safe.
+ */
+class MonotonicResource : public MemoryResource {
+public:
+    explicit MonotonicResource(size_t initial_size = 4096, MemoryResource* upstream = defaultMemoryResource());
+    MonotonicResource(void* buffer, size_t size, MemoryResource* upstream = defaultMemoryResource());
+    ~MonotonicResource() override;
+
+    MonotonicResource(const MonotonicResource&) = delete;
+    MonotonicResource& operator=(const MonotonicResource&) = delete;
+
+    void release();
+    MemoryResource* upstream() const { return upstream_; }
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void*, size_t, size_t) override {}
+
+private:
+    struct Chunk;
+    MemoryResource* upstream_;
+    void* buffer_;
+    size_t buffer_size_;
+    Chunk* chunks_ = nullptr;
+    char* current_ = nullptr;
+    size_t remaining_ = 0;
+    size_t initial_size_;
+    size_t next_size_;
+};
+
+/**
+ * Free lists by power-of-two size class, 16 bytes to MAX_BLOCK (room for
+ * the nodes of a few hundred-node scale), carved from
+ * chunks taken from upstream. A deallocated block is reused by the next
+ * allocation of its class; chunks go back upstream on release() or
+ * destruction. Larger or over-aligned requests go straight to upstream.
+ * Not thread-safe.
+ */
+class PoolResource : public MemoryResource {
+public:
+    static constexpr size_t MAX_BLOCK = 65536;
+
+    explicit PoolResource(MemoryResource* upstream = defaultMemoryResource());
+    ~PoolResource() override;
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    void release();
+    MemoryResource* upstream() const { return upstream_; }
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override;
+    void doDeallocate(void* p, size_t bytes, size_t align) override;
+
+private:
+    static constexpr int N_CLASSES = 13; // 16 .. 65536
+    struct Block { Block* next; };
+    struct Chunk;
+    MemoryResource* upstream_;
+    Block* free_[N_CLASSES] = {};
+    Chunk* chunks_ = nullptr;
+};
+
+/**
+ * Allocator over a MemoryResource, like std::pmr::polymorphic_allocator: the
+ * resource stays with the container it was given to. A copy of a container
+ * goes to the default resource, so it never outlives someone else's arena;
+ * moves keep the resource.
+ */
+template <class T>
+class ResourceAllocator {
+public:
+    typedef T value_type;
+
+    ResourceAllocator() noexcept : resource_(defaultMemoryResource()) {}
+    ResourceAllocator(MemoryResource* resource) noexcept
+        : resource_(resource ? resource : defaultMemoryResource()) {}
+    template <class U>
+    ResourceAllocator(const ResourceAllocator<U>& other) noexcept : resource_(other.resource()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t n) { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+    ResourceAllocator select_on_container_copy_construction() const { return ResourceAllocator(); }
+    MemoryResource* resource() const noexcept { return resource_; }
+
+private:
+    MemoryResource* resource_;
+};
+
+template <class T, class U>
+bool operator==(const ResourceAllocator<T>& a, const ResourceAllocator<U>& b) noexcept {
+    return a.resource()->isEqual(*b.resource());
+}
+
+template <class T, class U>
+bool operator!=(const ResourceAllocator<T>& a, const ResourceAllocator<U>& b) noexcept {
+    return !(a == b);
+}
+
+template <class T>
+using ResourceVector = std::vector<T, ResourceAllocator<T>>;
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_MEMORY_HPP
@@ -0,0 +1,89 @@
+#ifndef SCALATRIX_MONZO_HPP
+#define SCALATRIX_MONZO_HPP
+
+#include "scalatrix/pitchset.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace scalatrix {
+
+// Capacity of a monzo: covers the 25-entry default prime table, padded to a
+// multiple of 8 lanes so the element-wise loops vectorize without a tail.
+constexpr int MONZO_MAX_PRIMES = 32;
+
+/**
+ * Monzo: a just interval as a vector of prime exponents.
+ *
+ * exps[i] is the exponent of the i-th prime of a MonzoBasis, so 3:2 over
+ * {2, 3, 5} is [-1 1 0>. Multiplying ratios adds monzos, raising to a power
+ * scales them, and every monzo is already in lowest terms, so there is no gcd
+ * and no big-integer growth. Unused trailing entries stay zero. Exponents that
+ * would leave the int32 range saturate at INT32_MIN / INT32_MAX rather than
+ * wrapping around.
+ */
+struct Monzo {
+    alignas(32) std::array<int32_t, MONZO_MAX_PRIMES> exps{};
+
+    bool isUnison() const;
+
+    Monzo& operator+=(const Monzo& o);
+    Monzo& operator-=(const Monzo& o);
+    Monzo& operator*=(int32_t power);
+
+    bool operator==(const Monzo& o) const { return exps == o.exps; }
+    bool operator!=(const Monzo& o) const { return exps != o.exps; }
+};
+
+Monzo operator+(Monzo a, const Monzo& b);
+Monzo operator-(Monzo a, const Monzo& b);
+Monzo operator-(Monzo a);
+Monzo operator*(Monzo a, int32_t power);
+Monzo operator*(int32_t power, Monzo a);
+
+/**
+ * The prime basis monzos are expressed in, built once from a PrimeList.
+ *
+ * Keeps the prime numbers and their (possibly detuned) log2 ratios in flat,
+ * zero-padded arrays so log2fr() is a plain dot product. A PrimeList longer
+ * than MONZO_MAX_PRIMES is rejected: the basis is left empty (size() == 0).
+ */
+class MonzoBasis {
+public:
+    MonzoBasis() = default;
+    explicit MonzoBasis(const PrimeList& primes);
+
+    int size() const { return size_; }
+    unsigned int prime(int i) const { return numbers_[i]; }
+    double primeLog2fr(int i) const { return log2fr_[i]; }
+
+    // Monzo of a single basis prime; unison if i is outside [0, size()).
+    Monzo primeMonzo(int i) const;
+
+    // Factor num:den over the basis. Returns false if either has a factor
+    // outside the basis (or is not positive); out is then left unchanged.
+    bool fromRatio(long long num, long long den, Monzo& out) const;
+    bool fromExactPitch(const ExactPitch& pitch, Monzo& out) const;
+
+    // log2 frequency ratio using the basis tuning of each prime.
+    double log2fr(const Monzo& m) const;
+
+    // Exact num:den. Returns false if either side does not fit in 64 bits.
+    bool toRatio(const Monzo& m, long long& num, long long& den) const;
+    ExactPitch toExactPitch(const Monzo& m) const;
+
+    // "num:den" when it fits in 64 bits, otherwise bracket notation "[e0 e1 ...>".
+    int formatLabel(const Monzo& m, char* buf, size_t size) const;
+    std::string label(const Monzo& m) const;
+    PitchSetPitch toPitchSetPitch(const Monzo& m) const;
+
+private:
+    int size_ = 0;
+    std::array<unsigned int, MONZO_MAX_PRIMES> numbers_{};
+    alignas(32) std::array<double, MONZO_MAX_PRIMES> log2fr_{};
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_MONZO_HPP
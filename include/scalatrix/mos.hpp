@@ -8,13 +8,24 @@
 namespace scalatrix {
 
 // Free functions for Stern-Brocot path coordinate conversion
-Vector2i applyPath(const std::vector<bool> path, const Vector2i& v);
-Vector2i applyPathReverse(const std::vector<bool> path, const Vector2i& v);
+std::vector<bool> calcPath(int a, int b);
+// As above, written into path, reusing its storage
+void calcPath(int a, int b, std::vector<bool>& path);
+Vector2i applyPath(const std::vector<bool>& path, const Vector2i& v);
+Vector2i applyPathReverse(const std::vector<bool>& path, const Vector2i& v);
+
+// End of one run of identical steps in the fromG walk: the pattern (a0, b0)
+// reached at that depth. These are the continued-fraction convergents of g.
+struct MOSConvergent {
+    int depth, a0, b0;
+};
 
 class MOS {
 public:
 
-    MOS(int a, int b, int m, double e, double g);
+    // base_scale draws its nodes from resource; see Scale
+    MOS(int a, int b, int m, double e, double g,
+        MemoryResource* resource = defaultMemoryResource());
 
     int a, b, n, a0, b0, n0, mode, nL, nS;
     int repetitions, depth;
@@ -45,6 +56,12 @@ public:
     void adjustTuningG(int depth, int m, double g, double e, int repetitions = 1);
     void adjustParams(int a, int b, int m, double e, double g, int repetitions = 1);
 
+    // Convergents of g in walk order, starting at (1, 1), up to a0 + b0 <= max_size.
+    // The last entry is where the walk stopped, even if max_size cut its run short.
+    static std::vector<MOSConvergent> convergents(double g, int max_size);
+    // Smallest fromG depth at which g reaches a0 + b0 >= size
+    static int depthForSize(double g, int size);
+
     //void adjustParamsFromImpliedAffine(const AffineTransform& A);
 
     double pitchHeight(double x, double y);
@@ -75,9 +92,15 @@ public:
 
     Scale generateScaleFromMOS(double base_freq, int n, int root);
     Scale generateMappedScale(int steps, double offset, double base_freq, int n_nodes, int root) const;
+    // As above, regenerated into an existing scale, reusing its storage: no
+    // allocation once scale has held n_nodes nodes
+    void generateScaleFromMOSInto(Scale& scale, double base_freq, int n, int root);
+    void generateMappedScaleInto(Scale& scale, int steps, double offset, double base_freq, int n_nodes, int root) const;
+    // The transform generateMappedScale selects its nodes with
+    AffineTransform mappedScaleAffine(int steps, double offset) const;
     void retuneScaleWithMOS(Scale& scale, double base_freq);
 
-    Vector2i mapFromMOS(MOS& other, Vector2i v);
+    Vector2i mapFromMOS(const MOS& other, Vector2i v) const;
 
     // Convert between this MOS's coordinate system and root (1,1) coordinates
     Vector2i toRootCoord(Vector2i v) const { return applyPathReverse(path, v); }
@@ -0,0 +1,66 @@
+#ifndef SCALATRIX_MOS_FAMILY_HPP
+#define SCALATRIX_MOS_FAMILY_HPP
+
+#include "scalatrix/mos.hpp"
+#include "scalatrix/scale.hpp"
+#include <cstddef>
+#include <vector>
+
+namespace scalatrix {
+
+struct MOSFamilyOptions {
+    int min_size = 2;           // smallest a + b to generate
+    int max_size = 12;          // largest a + b to generate
+    int g_steps = 8;            // generators across each pattern's range
+    double equave = 1.0;        // log2fr
+    // Mapped scale of every member, as MOS::generateMappedScale. steps <= 0
+    // maps each member onto its own n steps; n_nodes = 0 skips the nodes.
+    // Unless n_nodes = 0, root must lie in [0, n_nodes).
+    int steps = 0;
+    double offset = 0.0;
+    double base_freq = DEFAULT_12TET_C_PITCH;
+    int n_nodes = 128;
+    int root = 60;
+    int n_threads = 0;          // 0: one per core
+};
+
+/**
+ * A whole family of MOS, stored column by column.
+ *
+ * Member i is the MOS (a[i], b[i], mode[i]) at generator[i]; its mapped scale
+ * nodes are entries [i * n_nodes, (i + 1) * n_nodes) of the node columns.
+ * Every column is one contiguous allocation, whatever the family size.
+ */
+struct MOSFamily {
+    int n_nodes = 0;
+
+    std::vector<int> a, b, mode;
+    std::vector<double> generator;
+    std::vector<double> L_fr, s_fr;
+
+    std::vector<int> coord_x, coord_y;
+    std::vector<double> tuning_x, tuning_y;
+    std::vector<double> pitch;
+
+    size_t size() const { return a.size(); }
+};
+
+/**
+ * Generates every MOS pattern (a, b, mode) with min_size <= a + b <= max_size,
+ * each at g_steps generators spread evenly over the open range in which it
+ * keeps a steps of one size and b of the other, along with its mapped scale.
+ *
+ * Members are ordered by a + b, then a, then mode, then generator, the same
+ * as searchTemperaments before sorting. Members are built in parallel, each
+ * worker reusing one MOS and one Scale (adjustParams resets the MOS's
+ * base_scale in place), so besides the columns only a fixed amount of scratch
+ * per worker is allocated. Each worker writes only its own slots, so the
+ * result does not depend on n_threads.
+ *
+ * Returns an empty family if root lies outside [0, n_nodes).
+ */
+MOSFamily generateMOSFamily(const MOSFamilyOptions& options = {});
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_MOS_FAMILY_HPP
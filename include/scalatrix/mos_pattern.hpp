@@ -0,0 +1,110 @@
+#ifndef SCALATRIX_MOS_PATTERN_HPP
+#define SCALATRIX_MOS_PATTERN_HPP
+
+#include "scalatrix/affine_transform.hpp"
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+namespace scalatrix {
+
+// Largest a0 + b0 held in the pattern table. Depth is at most size - 2, so
+// every path fits in 64 bits.
+constexpr int MOS_PATTERN_MAX_SIZE = 48;
+
+// calcPath(a0, b0) packed into bits, bit i being path[i]. depth is -1 unless
+// a0 and b0 are coprime with a0 + b0 <= 65, so that the path fits.
+struct MOSPath {
+    uint64_t bits;
+    int depth;
+};
+
+constexpr MOSPath mosPath(int a0, int b0) noexcept {
+    if (a0 < 1 || b0 < 1 || a0 + b0 > 65) return {0, -1};
+    // Reduce to (1, 1), recording the steps last to first
+    uint64_t reversed = 0;
+    int depth = 0;
+    while (a0 > 1 || b0 > 1) {
+        if (a0 > b0) {
+            a0 -= b0;
+        } else {
+            b0 -= a0;
+            reversed |= uint64_t(1) << depth;
+        }
+        if (b0 == 0) return {0, -1};
+        depth++;
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < depth; i++) {
+        if ((reversed >> i) & 1) bits |= uint64_t(1) << (depth - 1 - i);
+    }
+    return {bits, depth};
+}
+
+// applyPath for a packed path
+constexpr Vector2i applyMOSPath(MOSPath path, Vector2i v) noexcept {
+    for (int i = 0; i < path.depth; i++) {
+        if ((path.bits >> i) & 1) {
+            v.y += v.x;
+        } else {
+            v.x += v.y;
+        }
+    }
+    return v;
+}
+
+// MOS::mosTransform of the a0 x L + b0 x s pattern: the linear map taking
+// (1, 0) to its generator and (1, 1) to (a0, b0)
+constexpr IntegerAffineTransform mosTransformOf(int a0, int b0) noexcept {
+    Vector2i v_gen = applyMOSPath(mosPath(a0, b0), Vector2i(1, 0));
+    return IntegerAffineTransform(v_gen.x, a0 - v_gen.x, v_gen.y, b0 - v_gen.y, 0, 0);
+}
+
+/**
+ * MOSPattern: one node (a0, b0) of the Stern-Brocot tree of MOS structures,
+ * with everything MOS derives from it that does not depend on tuning.
+ *
+ * A (sanitized) generator strictly inside (g_lo, g_hi) walks to this pattern
+ * in exactly depth steps.
+ */
+struct MOSPattern {
+    int a0, b0, depth;
+    uint64_t path_bits;  // bit i is path[i] as returned by calcPath(a0, b0)
+    Vector2i v_gen;
+    double g_lo, g_hi;
+    IntegerAffineTransform mosTransform;
+
+    int size() const { return a0 + b0; }
+    std::vector<bool> path() const;
+};
+
+// Coprime (a0, b0) with a0 + b0 <= max_size: one pattern each
+constexpr int mosPatternCount(int max_size) noexcept {
+    int count = 0;
+    for (int a0 = 1; a0 < max_size; a0++) {
+        for (int b0 = 1; a0 + b0 <= max_size; b0++) {
+            if (std::gcd(a0, b0) == 1) count++;
+        }
+    }
+    return count;
+}
+
+constexpr int MOS_PATTERN_COUNT = mosPatternCount(MOS_PATTERN_MAX_SIZE);
+
+// All patterns with a0 + b0 <= MOS_PATTERN_MAX_SIZE, sorted by (depth, g_lo).
+// Generated at compile time.
+const std::array<MOSPattern, MOS_PATTERN_COUNT>& mosPatternTable();
+
+// Pattern a sanitized generator g reaches after depth steps, found by binary
+// search. Returns nullptr when the pattern is larger than the table, or when
+// g lies so close to an interval edge that only the step-by-step walk can
+// settle which side it falls on.
+const MOSPattern* findMOSPattern(int depth, double g);
+
+// Pattern with the given coprime step counts, or nullptr if not in the table.
+const MOSPattern* findMOSPattern(int a0, int b0);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_MOS_PATTERN_HPP
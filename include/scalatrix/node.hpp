@@ -10,6 +10,9 @@ namespace scalatrix {
 /**
  * Node represents a single musical note in a scale with both lattice coordinates and pitch information.
  * Simple struct with public fields for direct access.
+ *
+ * The pitch labels are std::strings on the global heap, not in the scale's
+ * MemoryResource: only untempered nodes are guaranteed allocation-free.
  */
 struct Node {
     Vector2i natural_coord;    // Integer coords in scale's natural system
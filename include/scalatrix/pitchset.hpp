@@ -1,6 +1,8 @@
 #ifndef SCALATRIX_PITCHSET_HPP
 #define SCALATRIX_PITCHSET_HPP
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -28,8 +30,113 @@ PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b);
 PitchSetPitch operator*(int multiplier, const PitchSetPitch& pitch);
 PitchSetPitch operator*(const PitchSetPitch& pitch, int multiplier);
 typedef std::vector<PitchSetPitch> PitchSet;
+
+/**
+ * Structured, exact form of a PitchSetPitch label.
+ *
+ * A RATIO pitch holds num:den in lowest terms, an ET pitch holds step\division.
+ * The arithmetic below works on the integers directly, so it never parses or
+ * allocates; the textual label is only produced on demand by formatLabel() or
+ * label(). Results that cannot be represented (mixed kinds, different ET
+ * divisions, 64-bit overflow) become NONE, which formats as an empty label,
+ * and so does ratio() unless num and den are both positive.
+ */
+struct ExactPitch {
+    enum Kind : unsigned char { NONE = 0, RATIO = 1, ET = 2 };
+
+    Kind kind = NONE;
+    long long num = 0;    // ratio numerator, or ET step
+    long long den = 1;    // ratio denominator, or ET division
+    double log2fr = 0.0;  // log2 frequency ratio (carried along, may be detuned)
+
+    static ExactPitch ratio(long long num, long long den);
+    static ExactPitch ratio(long long num, long long den, double log2fr);
+    static ExactPitch et(long long step, long long division, double equave_log2fr = 1.0);
+    static ExactPitch none(double log2fr) { ExactPitch p; p.log2fr = log2fr; return p; }
+
+    // Parse "num:den" or "step\\division" once; anything else yields NONE.
+    static ExactPitch fromLabel(const std::string& label, double log2fr);
+    static ExactPitch fromPitchSetPitch(const PitchSetPitch& pitch);
+
+    bool isRatio() const { return kind == RATIO; }
+    bool isET() const { return kind == ET; }
+
+    // Writes the label into buf (always NUL-terminated if size > 0) and returns
+    // its length, like snprintf. NONE writes an empty string.
+    int formatLabel(char* buf, size_t size) const;
+    std::string label() const;
+    PitchSetPitch toPitchSetPitch() const;
+
+    bool operator==(const ExactPitch& o) const { return kind == o.kind && num == o.num && den == o.den; }
+    bool operator!=(const ExactPitch& o) const { return !(*this == o); }
+};
+
+// Interval algebra: + stacks intervals (ratios multiply, ET steps add),
+// * raises to an integer power (ratios) or scales the step count (ET).
+ExactPitch operator+(const ExactPitch& a, const ExactPitch& b);
+ExactPitch operator-(const ExactPitch& a, const ExactPitch& b);
+ExactPitch operator-(const ExactPitch& a);
+ExactPitch operator*(const ExactPitch& pitch, int multiplier);
+ExactPitch operator*(int multiplier, const ExactPitch& pitch);
+
+// Convert a whole pitch set once, so later arithmetic stays on integers.
+std::vector<ExactPitch> toExactPitches(const PitchSet& pitchset);
+
+/**
+ * PitchSetIndex: a copy of a pitch set sorted by log2fr once, so nearest
+ * pitch lookups are O(log n). Ties resolve to the lowest original index,
+ * so results match a front-to-back linear scan of the pitch set.
+ */
+class PitchSetIndex {
+public:
+    PitchSetIndex() = default;
+    explicit PitchSetIndex(const PitchSet& pitchset);
+    explicit PitchSetIndex(PitchSet&& pitchset);
+
+    // Original index of the pitch closest to log2fr, or -1 if there is none.
+    int closest(double log2fr) const;
+    // Whether this index was built from a pitch set equal to pitchset.
+    bool indexes(const PitchSet& pitchset) const;
+    const PitchSet& pitchSet() const { return pitchset_; }
+    size_t size() const { return pitchset_.size(); }
+
+private:
+    void build();
+
+    PitchSet pitchset_;
+    std::vector<double> sorted_log2fr_;
+    std::vector<int> order_;
+};
+
 PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr = 1.0, double min_log2fr = 0.0, double max_log2fr = 1.0);
 PitchSet generateJIPitchSet(PrimeList primes, int max_numtimesden = 20, double min_log2fr = 0.0, double max_log2fr = 1.0);
+
+// Which ratios a JI enumeration admits.
+struct JIBound {
+    enum Kind : unsigned char { NUM_DEN = 0, ODD_LIMIT = 1, TENNEY_HEIGHT = 2 };
+    Kind kind = NUM_DEN;
+    long long limit = 20;
+
+    // num < limit and den < limit, as in generateJIPitchSet
+    static JIBound numDen(long long limit) { return {NUM_DEN, limit}; }
+    // odd parts of num and den <= limit, with any power of two
+    static JIBound oddLimit(long long limit) { return {ODD_LIMIT, limit}; }
+    // num * den <= limit
+    static JIBound tenneyHeight(long long limit) { return {TENNEY_HEIGHT, limit}; }
+};
+
+typedef std::function<void(long long num, long long den, double log2fr)> JIPitchCallback;
+
+// Streams every reduced ratio num:den whose factors are all in primes, that
+// satisfies bound and whose log2fr lies within [min_log2fr, max_log2fr]
+// (same 1e-6 tolerance as generateJIPitchSet). Smooth numbers are enumerated
+// directly and each denominator only visits numerators in range, so the cost
+// follows the output size rather than limit². Ratios arrive grouped by
+// denominator, not in pitch order. primes should be pairwise coprime.
+void enumerateJIPitches(const PrimeList& primes, JIBound bound, double min_log2fr, double max_log2fr,
+                        const JIPitchCallback& emit);
+// enumerateJIPitches collected into a pitch set sorted by log2fr.
+PitchSet generateBoundedJIPitchSet(const PrimeList& primes, JIBound bound, double min_log2fr = 0.0, double max_log2fr = 1.0);
 PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_log2fr = 0.0, double max_log2fr = 1.001);
 
 
@@ -3,8 +3,10 @@
 
 #include "lattice.hpp"
 #include "affine_transform.hpp"
+#include "memory.hpp"
 #include "pitchset.hpp"
 #include "node.hpp"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -12,6 +14,16 @@ const double DEFAULT_12TET_C_PITCH = 261.6255653006;
 
 namespace scalatrix {
 
+// Deviation of tempered pitches from the untempered ones, in cents.
+struct TemperingStats {
+    double max_cents = 0.0;
+    double rms_cents = 0.0;
+    int n_nodes = 0; // nodes that found a pitch to temper to
+};
+
+// Node storage of a Scale, drawn from the scale's MemoryResource
+typedef ResourceVector<Node> NodeVector;
+
 /**
  * Scale represents a collection of musical notes generated from a 2D lattice.
  * 
@@ -25,15 +37,24 @@ namespace scalatrix {
  * 
  * This approach generates scales by "slicing" through the transformed lattice with a 
  * horizontal strip, creating a sequential path that respects the underlying mathematical structure.
+ *
+ * Node storage comes from the MemoryResource given to the constructor (by
+ * default the global heap), so scales can live in an arena or pool. Copies
+ * allocate from the default resource; moves keep the resource.
  */
 class Scale {
 private:
-    std::vector<Node> nodes_;
+    NodeVector nodes_;
     double base_freq_;
     int root_idx_;
+    StripBasisCache strip_cache_;
+    Vector2i strip_r_, strip_s_;
+    ResourceVector<uint8_t> step_word_;
     void initNodes(int N);
+    void placeNode(Node& node, const Vector2i& v, const AffineTransform& A) const;
 public:
-    Scale(double base_freq = DEFAULT_12TET_C_PITCH, int N = 128, int root_node_idx = 60);
+    Scale(double base_freq = DEFAULT_12TET_C_PITCH, int N = 128, int root_node_idx = 60,
+          MemoryResource* resource = defaultMemoryResource());
     
     /**
      * Core method implementing "scale as path on lattice"
@@ -51,16 +72,46 @@ public:
     static Scale fromAffine(const AffineTransform& M, const double base_freq, int N, int n_root);
 
     void print(int first = 58, int num = 5) const;
-    std::vector<Node>& getNodes();
-    const std::vector<Node>& getNodes() const;
+    NodeVector& getNodes();
+    const NodeVector& getNodes() const;
+    MemoryResource* getResource() const { return nodes_.get_allocator().resource(); }
     void recalcWithAffine(const AffineTransform& A, int N, int n_root);
+    // Fresh nodes for regeneration at another size, root or base frequency,
+    // in the existing storage; allocates only if N exceeds its capacity
+    void reset(double base_freq, int N, int root_node_idx);
     void retuneWithAffine(const AffineTransform& A);
     int getRootIdx() const { return root_idx_; }
+    // Indexes pitchset anew on every call; to temper repeatedly to the same
+    // set, or several scales to one set, build a PitchSetIndex once and pass
+    // that instead
     void temperToPitchSet(PitchSet& pitchset);
+    void temperToPitchSet(const PitchSetIndex& index, TemperingStats* stats = nullptr);
     double getBaseFreq() const { return base_freq_; }
 
-    ~Scale();
+    // Step from node i to node i + 1 as of the last recalcWithAffine, in terms
+    // of getStripBasis()
+    const ResourceVector<uint8_t>& getStepWord() const { return step_word_; }
+    std::pair<Vector2i, Vector2i> getStripBasis() const { return {strip_r_, strip_s_}; }
+
+    // Strip basis reused across recalcWithAffine calls, with hit/miss counters
+    StripBasisCache& getStripCache() { return strip_cache_; }
+    const StripBasisCache& getStripCache() const { return strip_cache_; }
+};
+
+/**
+ * The node fields of a Scale gathered into one contiguous array each, so a
+ * whole scale can be handed to another runtime (e.g. as typed-array views
+ * over the WASM heap) instead of node by node. Coordinates are interleaved,
+ * x0, y0, x1, y1, ... update() reuses the storage, and moves it only when
+ * the scale has grown past every earlier size.
+ */
+struct ScaleColumns {
+    std::vector<double> pitch;
+    std::vector<int32_t> natural_coord;
+    std::vector<double> tuning_coord;
 
+    size_t size() const { return pitch.size(); }
+    void update(const Scale& scale);
 };
 
 } // namespace scalatrix
@@ -0,0 +1,113 @@
+#ifndef SCALATRIX_SHARED_TUNING_HPP
+#define SCALATRIX_SHARED_TUNING_HPP
+
+#include "scalatrix/snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// POSIX shared memory is available everywhere but Windows and WASM; on
+// those, open() fails
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define SCALATRIX_HAS_SHARED_MEMORY 1
+#endif
+
+namespace scalatrix {
+
+struct SharedTuningSegment;
+
+/**
+ * Publishes the current tuning table into a named POSIX shared-memory
+ * segment, so that other processes on the host can read it without
+ * sockets and without generating the scale themselves.
+ *
+ * The segment holds two slots, each a full snapshot (see snapshot.hpp)
+ * under its own sequence lock. publish() writes the older slot and then
+ * marks it latest, so a reader is only disturbed if two publishes land
+ * while it copies one table. There must be one publisher per segment at a
+ * time; readers may come and go.
+ */
+class SharedTuningPublisher {
+public:
+    SharedTuningPublisher() = default;
+    ~SharedTuningPublisher() { close(); }
+
+    SharedTuningPublisher(const SharedTuningPublisher&) = delete;
+    SharedTuningPublisher& operator=(const SharedTuningPublisher&) = delete;
+
+    // Creates the segment name ("/name", as for shm_open) with room for
+    // max_nodes nodes, or reuses it, growing it if it has too little room.
+    // A reused segment carries on its sequence and attached readers follow
+    // it. Returns false if the segment cannot be set up.
+    bool open(const std::string& name, int max_nodes, bool float32 = false);
+    void close();
+    bool isOpen() const { return segment_ != nullptr; }
+
+    // Publishes scale, generated from mos, as the next table. Returns
+    // false if not open or if the scale has more than max_nodes nodes.
+    bool publish(const MOS& mos, const Scale& scale);
+
+    // Number of tables published to the segment, by any publisher
+    uint32_t sequence() const;
+    const std::string& name() const { return name_; }
+
+    // Removes the segment name; processes that have it open keep it
+    static bool unlink(const std::string& name);
+
+private:
+    SharedTuningSegment* segment_ = nullptr;
+    size_t mapped_size_ = 0;
+    std::string name_;
+    bool float32_ = false;
+};
+
+/**
+ * Reads the tables of a SharedTuningPublisher. read() never waits for the
+ * publisher: it copies the latest table, checks that it was not written
+ * meanwhile, retries a few times if it was, and otherwise reports failure
+ * and keeps the last table it read. The segment is mapped read-only.
+ *
+ * If a publisher grows the segment, the next read() maps it again, which
+ * allocates; read() is otherwise allocation-free.
+ */
+class SharedTuningReader {
+public:
+    SharedTuningReader() = default;
+    ~SharedTuningReader() { close(); }
+
+    SharedTuningReader(const SharedTuningReader&) = delete;
+    SharedTuningReader& operator=(const SharedTuningReader&) = delete;
+
+    // Maps an existing segment. Returns false if there is none, or it is
+    // not a tuning segment this reader knows.
+    bool open(const std::string& name);
+    void close();
+    bool isOpen() const { return segment_ != nullptr; }
+
+    // Whether a table newer than the last one read has been published
+    bool hasUpdate() const;
+    // Copies the latest table if it is newer than the last one read.
+    // Returns true if view() now holds a table newer than before.
+    bool read();
+
+    // The last table read; invalid before the first
+    const SnapshotView& view() const { return view_; }
+    uint32_t sequence() const { return seq_; }
+
+private:
+    bool map(const std::string& name);
+
+    const SharedTuningSegment* segment_ = nullptr;
+    size_t mapped_size_ = 0;
+    size_t slot_capacity_ = 0;  // loaded once per mapping
+    std::string name_;
+    uint32_t seq_ = 0;
+    std::vector<uint8_t> buffer_;  // holds view_
+    std::vector<uint8_t> scratch_; // copied into, swapped with buffer_ once checked
+    SnapshotView view_;
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_SHARED_TUNING_HPP
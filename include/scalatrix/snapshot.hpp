@@ -0,0 +1,140 @@
+#ifndef SCALATRIX_SNAPSHOT_HPP
+#define SCALATRIX_SNAPSHOT_HPP
+
+#include "scalatrix/mos.hpp"
+#include "scalatrix/scale.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace scalatrix {
+
+/**
+ * Binary snapshot of a MOS and a scale generated from it, for shipping a
+ * whole tuning table in one UDP datagram or shared-memory page.
+ *
+ * Everything is little-endian. A fixed header is followed by the nodes as
+ * separate arrays (structure of arrays), each padded to 8 bytes:
+ *
+ *   offset  type   field
+ *        0  u32    magic, "SXSN"
+ *        4  u16    version (SNAPSHOT_VERSION)
+ *        6  u16    flags (SnapshotFlags)
+ *        8  u32    header size; the payload starts here
+ *       12  u32    seq
+ *       16  u32    base_seq, the snapshot a delta applies to (0 if none)
+ *       20  u32    node_count, nodes in the scale
+ *       24  u32    record_count, nodes in the payload
+ *       28  i32    root, a, b, mode, repetitions, depth
+ *       52  u32    reserved, 0
+ *       56  f64    base_freq, equave, generator
+ *       80         payload:
+ *                  u32 index[record_count]    (SNAPSHOT_DELTA only)
+ *                  i32 natural_x[record_count]
+ *                  i32 natural_y[record_count]
+ *                  F   tuning_x[record_count]
+ *                  F   tuning_y[record_count]
+ *                  F   pitch[record_count]
+ *
+ * F is f64, or f32 with SNAPSHOT_FLOAT32. A full snapshot has one record
+ * per node, in scale order. A delta (SNAPSHOT_DELTA) has records only for
+ * the nodes that differ from snapshot base_seq, which must have the same
+ * node count, root and base frequency; the header fields are always
+ * complete. Readers must skip to the header size given, so later versions
+ * can grow the header.
+ *
+ * The readers in rust/scalatrix (snapshot.rs) and
+ * examples/sx-node/scalatrix/lib/snapshot.js follow this layout.
+ */
+const uint32_t SNAPSHOT_MAGIC = 0x4E535853; // "SXSN" read as little-endian u32
+const uint16_t SNAPSHOT_VERSION = 1;
+const size_t SNAPSHOT_HEADER_SIZE = 80;
+
+enum SnapshotFlags : uint16_t {
+    SNAPSHOT_FLOAT32 = 1, // f32 tuning coordinates and pitches
+    SNAPSHOT_DELTA = 2,   // records only for nodes changed since base_seq
+};
+
+struct SnapshotHeader {
+    uint16_t version = 0;
+    uint16_t flags = 0;
+    uint32_t seq = 0;
+    uint32_t base_seq = 0;
+    uint32_t node_count = 0;
+    uint32_t record_count = 0;
+    int root = 0;
+    int a = 0, b = 0, mode = 0, repetitions = 0, depth = 0;
+    double base_freq = 0.0, equave = 0.0, generator = 0.0;
+};
+
+// Bytes taken by a snapshot of n_records nodes with the given flags
+size_t snapshotSize(size_t n_records, uint16_t flags);
+
+// Writes a full snapshot of scale, generated from mos, to out. Returns the
+// bytes written, or 0 if capacity is smaller than snapshotSize().
+size_t writeSnapshot(const MOS& mos, const Scale& scale, uint32_t seq, bool float32,
+                     uint8_t* out, size_t capacity);
+
+// Writes scale as a delta against previous, snapshot base_seq: only nodes
+// that differ at the precision written are included. Falls back to a full
+// snapshot when the node count, root or base frequency differ, or when the
+// delta would not be smaller, so snapshotSize(scale.getNodes().size(),
+// float32 ? SNAPSHOT_FLOAT32 : 0) bytes always suffice. Returns the bytes written, or 0 if they do not fit.
+size_t writeSnapshotDelta(const MOS& mos, const Scale& scale, const Scale& previous,
+                          uint32_t seq, uint32_t base_seq, bool float32,
+                          uint8_t* out, size_t capacity);
+
+/**
+ * Reads a snapshot in place: parse() checks the header and sizes, and the
+ * accessors decode single values straight from the buffer, which must
+ * outlive the view. Values are read byte-wise, so the buffer needs no
+ * alignment and the host may be either endianness.
+ */
+class SnapshotView {
+public:
+    SnapshotView() = default;
+    SnapshotView(const uint8_t* data, size_t size) { parse(data, size); }
+
+    // Returns false, leaving the view empty, if data is not a complete
+    // snapshot of a version this reader knows, or if its MOS fields could
+    // not have come from a MOS
+    bool parse(const uint8_t* data, size_t size);
+    bool valid() const { return data_ != nullptr; }
+
+    const SnapshotHeader& header() const { return header_; }
+    bool isDelta() const { return header_.flags & SNAPSHOT_DELTA; }
+    bool isFloat32() const { return header_.flags & SNAPSHOT_FLOAT32; }
+    // The snapshot's bytes, which may be fewer than the buffer parsed
+    const uint8_t* data() const { return data_; }
+    size_t byteSize() const { return size_; }
+
+    int size() const { return static_cast<int>(header_.record_count); }
+    // Scale index of record i
+    int index(int i) const;
+    Vector2i naturalCoord(int i) const;
+    Vector2d tuningCoord(int i) const;
+    double pitch(int i) const;
+
+    // Writes the records into scale. A full snapshot resets scale to its
+    // node count, root and base frequency; a delta needs scale to hold
+    // snapshot base_seq and returns false if its node count, root or base
+    // frequency differ. Tempering state and labels of the updated nodes
+    // are cleared.
+    bool applyTo(Scale& scale) const;
+
+    // The MOS the snapshot was generated from; parse() has checked the
+    // fields it is built from
+    MOS mos() const;
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+    SnapshotHeader header_;
+    size_t index_off_ = 0, natural_x_off_ = 0, natural_y_off_ = 0;
+    size_t tuning_x_off_ = 0, tuning_y_off_ = 0, pitch_off_ = 0;
+
+    double real(size_t offset, int i) const;
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_SNAPSHOT_HPP
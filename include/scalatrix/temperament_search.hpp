@@ -0,0 +1,80 @@
+#ifndef SCALATRIX_TEMPERAMENT_SEARCH_HPP
+#define SCALATRIX_TEMPERAMENT_SEARCH_HPP
+
+#include "scalatrix/mos.hpp"
+#include "scalatrix/pitchset.hpp"
+#include <vector>
+
+namespace scalatrix {
+
+/**
+ * TemperamentEvaluator: error of one MOS pattern (a, b, mode) against a
+ * target pitch set, as a closed-form function of generator g and equave e.
+ *
+ * Which lattice nodes land in the strip does not depend on the tuning, only
+ * their pitch does. Writing each base_scale node v as k·(a0,b0) + w·v_gen,
+ * its pitch is (e/r)·(k + w·g), so once (k, w) are known no scale has to be
+ * built again. The pattern keeps a steps of one size and b of the other
+ * while g stays strictly between gMin() and gMax().
+ */
+class TemperamentEvaluator {
+public:
+    // index must outlive the evaluator. weights are per target pitch (parallel
+    // to index.pitchSet()); empty means uniform.
+    TemperamentEvaluator(const MOS& mos, const PitchSetIndex& index, const std::vector<double>& weights = {});
+
+    int a() const { return a_; }
+    int b() const { return b_; }
+    int mode() const { return mode_; }
+    double gMin() const { return g_min_; }
+    double gMax() const { return g_max_; }
+    size_t size() const { return k_.size(); }
+
+    // log2fr of the n+1 base_scale nodes for (g, e), written to out
+    void pitches(double g, double e, double* out) const;
+
+    // Weighted RMS distance in cents from each node to its nearest target
+    // pitch. Fills max_cents with the largest unweighted distance if given.
+    double error(double g, double e, double* max_cents = nullptr) const;
+
+private:
+    int a_, b_, mode_, repetitions_;
+    double g_min_, g_max_;
+    std::vector<double> k_, w_;
+    const PitchSetIndex* index_;
+    std::vector<double> weights_;
+};
+
+struct TemperamentSearchOptions {
+    int min_size = 2;           // smallest a + b to consider
+    int max_size = 12;          // largest a + b to consider
+    double min_equave = 1.0;    // equave stretch range, log2fr
+    double max_equave = 1.0;
+    int g_steps = 256;          // grid points across each generator range
+    int e_steps = 9;            // grid points across the equave range (ignored if fixed)
+    int refine_iterations = 48; // golden-section steps per refinement
+    int n_threads = 0;          // 0: one per core
+    std::vector<double> weights; // per target pitch; empty means uniform
+};
+
+struct TemperamentCandidate {
+    int a, b, mode;
+    double generator;
+    double equave;
+    double rms_cents;
+    double max_cents;
+};
+
+/**
+ * Finds, for every MOS pattern (a, b, mode) within the size bounds, the
+ * generator and equave that minimize the weighted RMS error against target.
+ * Each pattern is scanned on a (g, e) grid and the best grid point refined by
+ * golden-section search; patterns run in parallel. Results are sorted by
+ * rms_cents, best first.
+ */
+std::vector<TemperamentCandidate> searchTemperaments(const PitchSet& target,
+                                                     const TemperamentSearchOptions& options = {});
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_TEMPERAMENT_SEARCH_HPP
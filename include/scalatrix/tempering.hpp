@@ -0,0 +1,52 @@
+#ifndef SCALATRIX_TEMPERING_HPP
+#define SCALATRIX_TEMPERING_HPP
+
+#include "scalatrix/pitchset.hpp"
+#include "scalatrix/scale.hpp"
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace scalatrix {
+
+// Builds without thread support (single-threaded WebAssembly, bare-metal
+// targets) run every parallel loop inline on the calling thread.
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__) && !defined(SCALATRIX_NO_THREADS)
+#define SCALATRIX_NO_THREADS
+#endif
+
+// Workers parallelFor would use for n_chunks chunks (n_threads <= 0: one per core).
+int parallelWorkerCount(size_t n_chunks, int n_threads = 0);
+
+/**
+ * Runs body(begin, end, worker) over [0, n) in chunks of at most grain items.
+ *
+ * Each worker starts on its own contiguous share of the chunks and, once that
+ * runs dry, steals half of the largest remaining share, so uneven items still
+ * balance. worker is a stable index in [0, parallelWorkerCount(...)) for
+ * per-thread scratch; worker 0 is the calling thread. With a single worker
+ * the body runs inline, once, over the whole range.
+ *
+ * The other workers are threads of a pool that persists across calls. A call
+ * made while the pool is busy, from another thread or from inside a body,
+ * starts threads of its own instead.
+ *
+ * If body throws, the workers stop at their next chunk and the first
+ * exception is rethrown on the calling thread once all of them are done.
+ */
+void parallelFor(size_t n, size_t grain, int n_threads,
+                 const std::function<void(size_t begin, size_t end, int worker)>& body);
+
+/**
+ * Tempers every scale to the same indexed pitch set concurrently.
+ *
+ * Equivalent to calling scale.temperToPitchSet(index, &stats) on each scale,
+ * but shares the index between threads. Returns the stats per scale, in the
+ * order of scales.
+ */
+std::vector<TemperingStats> temperScales(std::vector<Scale>& scales, const PitchSetIndex& index, int n_threads = 0);
+std::vector<TemperingStats> temperScales(std::vector<Scale>& scales, const PitchSet& pitchset, int n_threads = 0);
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_TEMPERING_HPP
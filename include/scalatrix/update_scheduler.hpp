@@ -0,0 +1,153 @@
+#ifndef SCALATRIX_UPDATE_SCHEDULER_HPP
+#define SCALATRIX_UPDATE_SCHEDULER_HPP
+
+#include "scalatrix/mos.hpp"
+#include "scalatrix/scale.hpp"
+#include "scalatrix/tempering.hpp" // SCALATRIX_NO_THREADS
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifndef SCALATRIX_NO_THREADS
+#include <thread>
+#endif
+
+namespace scalatrix {
+
+// Arguments of MOS::adjustTuningG
+struct TuningUpdate {
+    int depth = 0;
+    int mode = 0;
+    double generator = 0.5;
+    double equave = 1.0;
+    int repetitions = 1;
+
+    bool operator==(const TuningUpdate& o) const {
+        return depth == o.depth && mode == o.mode && generator == o.generator
+            && equave == o.equave && repetitions == o.repetitions;
+    }
+    bool operator!=(const TuningUpdate& o) const { return !(*this == o); }
+};
+
+// Arguments of MOS::generateMappedScale
+struct ScaleMapping {
+    int steps = 12;
+    double offset = 0.0;
+    double base_freq = DEFAULT_12TET_C_PITCH;
+    int n_nodes = 128;
+    int root = 60;
+
+    bool operator==(const ScaleMapping& o) const {
+        return steps == o.steps && offset == o.offset && base_freq == o.base_freq
+            && n_nodes == o.n_nodes && root == o.root;
+    }
+    bool operator!=(const ScaleMapping& o) const { return !(*this == o); }
+};
+
+struct UpdateSchedulerStats {
+    uint64_t posted = 0;   // updates accepted by post / postMapping
+    uint64_t merged = 0;   // pending updates replaced by a newer one for the same target
+    uint64_t dropped = 0;  // updates for an unknown target, or that changed nothing
+    uint64_t applied = 0;  // target regenerations
+    uint64_t frames = 0;   // passes that regenerated at least one target
+};
+
+/**
+ * Collapses bursts of tuning updates so that each target (a MOS and the
+ * mapped scale generated from it) is regenerated at most once per frame.
+ *
+ * post() and postMapping() may be called from any thread. They only
+ * record the update as the target's pending one, replacing any update not
+ * yet applied, so they cost the same however fast they are called.
+ * Pending updates are applied by flush() or poll() on the caller's
+ * thread, or by the scheduler's own thread after start(). Each is applied
+ * as MOS::adjustTuningG and MOS::generateMappedScaleInto on the target,
+ * after which on_update is called with the target's index, MOS and scale.
+ * on_update runs on the applying thread, one target at a time, and the
+ * MOS and scale must not be kept past the call. It runs while the
+ * scheduler holds its apply lock: from inside it, flush() and poll()
+ * apply nothing and return 0 (updates posted meanwhile wait for the next
+ * pass), and stop() must not be called.
+ *
+ * Regeneration reuses each target's scale, so a steady stream of updates
+ * does not allocate once every target has been applied once.
+ */
+class TuningUpdateScheduler {
+public:
+    typedef std::function<void(int target, const MOS& mos, const Scale& scale)> Callback;
+
+    explicit TuningUpdateScheduler(std::chrono::microseconds frame = std::chrono::microseconds(5000),
+                                   Callback on_update = nullptr);
+    ~TuningUpdateScheduler();
+
+    TuningUpdateScheduler(const TuningUpdateScheduler&) = delete;
+    TuningUpdateScheduler& operator=(const TuningUpdateScheduler&) = delete;
+
+    // Adds a target and returns its index. Its scale is generated now,
+    // without calling on_update.
+    int addTarget(const MOS& mos, const ScaleMapping& mapping = ScaleMapping());
+    int targetCount() const;
+
+    // Record update / mapping as pending for target. Returns false, and
+    // counts the update as dropped, for an unknown target.
+    bool post(int target, const TuningUpdate& update);
+    bool postMapping(int target, const ScaleMapping& mapping);
+
+    // Applies every pending update now and returns the number of targets
+    // regenerated.
+    int flush();
+    // As flush(), but only once a frame has passed since the last pass
+    // that had updates to apply; returns 0 otherwise.
+    int poll();
+
+    // Runs a thread that applies pending updates as they arrive, at most
+    // once per frame. Returns false if already running or if the build has
+    // no threads. stop() joins the thread and leaves any pending updates
+    // for flush().
+    bool start();
+    void stop();
+    bool running() const;
+
+    std::chrono::microseconds frame() const { return frame_; }
+    UpdateSchedulerStats stats() const;
+
+private:
+    struct Target;
+    struct Batch {
+        Target* target;
+        bool has_tuning, has_mapping;
+        TuningUpdate tuning;
+        ScaleMapping mapping;
+    };
+
+    // Moves pending updates into batch_; mutex_ held
+    void takePending();
+    int applyBatch();
+    void run();
+
+    const std::chrono::microseconds frame_;
+    const Callback on_update_;
+
+    mutable std::mutex mutex_; // targets_, pending updates, counters, thread state
+    std::condition_variable wake_;
+    std::vector<std::unique_ptr<Target>> targets_;
+    int n_pending_ = 0;
+    bool has_applied_ = false;
+    std::chrono::steady_clock::time_point last_applied_;
+    UpdateSchedulerStats stats_;
+
+    std::mutex apply_mutex_; // one applying thread at a time; guards batch_
+    std::vector<Batch> batch_;
+
+    bool stopping_ = false;
+#ifndef SCALATRIX_NO_THREADS
+    std::thread thread_;
+#endif
+};
+
+} // namespace scalatrix
+
+#endif // SCALATRIX_UPDATE_SCHEDULER_HPP
@@ -33,17 +33,18 @@
 //! Usage:
 //!   cargo run -p osc-receiver
 
+use std::collections::HashMap;
 use std::net::UdpSocket;
 use std::time::{Duration, Instant};
 
 use rosc::{OscMessage, OscPacket, OscType};
-use scalatrix::Mos;
+use scalatrix::{Mapping, Mos, Node, Scale};
 
 /// Plugin's OSC server port (we send heartbeats here).
 const PLUGIN_PORT: u16 = 34562;
 
 /// Parsed tuning/mapping parameters from an OSC message.
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 struct PitchGridParams {
     mode: i32,
     root_freq: f64,
@@ -84,47 +85,80 @@ fn send_heartbeat(socket: &UdpSocket, my_port: u16) {
     let _ = socket.send_to(&packet, format!("127.0.0.1:{PLUGIN_PORT}"));
 }
 
-/// Process mapping parameters: create MOS and generate scale.
-fn process_mapping(params: &PitchGridParams) {
-    // Create a MOS from the received parameters
-    let mos = Mos::from_params(
-        params.mos_a,
-        params.mos_b,
-        params.mode,
-        params.stretch,    // equave
-        params.skew,       // generator
-        1,                 // repetitions
-    );
+/// MOS, scale, node buffer and coordinate lookup kept across mapping
+/// updates, so that an update regenerates in place instead of allocating a
+/// new scale and lookup.
+struct MappingState {
+    mos: Option<Mos>,
+    scale: Scale,
+    nodes: Vec<Node>,
+    coord_map: HashMap<(i32, i32), usize>,
+}
+
+impl MappingState {
+    fn new() -> Self {
+        Self {
+            mos: None,
+            scale: Scale::new(128),
+            nodes: Vec::with_capacity(128),
+            coord_map: HashMap::with_capacity(128),
+        }
+    }
+}
+
+/// Process mapping parameters: update the MOS and regenerate its scale.
+fn process_mapping(state: &mut MappingState, params: &PitchGridParams) {
+    let mapping = Mapping {
+        steps: params.steps,
+        offset: params.mode_offset,
+        base_freq: params.root_freq,
+        n_nodes: 128, // MIDI range
+        root: 60,     // root = middle C
+    };
+
+    // Update the MOS from the received parameters (stretch is the equave,
+    // skew the generator) and regenerate the MIDI-mapped scale in the same
+    // call; only the first message creates a MOS
+    let scale = &mut state.scale;
+    let mos = state.mos.get_or_insert_with(|| {
+        Mos::from_params(params.mos_a, params.mos_b, params.mode, params.stretch, params.skew, 1)
+    });
+    // On rejected parameters the scale was not regenerated; keep the mapping
+    // last published rather than reporting a stale one as new
+    if !mos.adjust_params_into(
+        params.mos_a, params.mos_b, params.mode, params.stretch, params.skew, 1,
+        &mapping, scale,
+    ) {
+        eprintln!("  Mapping rejected, keeping the previous scale");
+        return;
+    }
+    let mos = &*mos;
 
     println!("  MOS: {mos} — ({}, {}) n={}", mos.a(), mos.b(), mos.n());
     println!("  Generator: {:.6}, Equave: {:.6}", mos.generator(), mos.equave());
     println!("  Large step: {:.4}, Small step: {:.4}, Chroma: {:.4}",
         mos.large_step_ratio(), mos.small_step_ratio(), mos.chroma_ratio());
 
-    // Generate the MIDI-mapped scale
-    let scale = mos.generate_mapped_scale(
-        params.steps,
-        params.mode_offset,
-        params.root_freq,
-        128,  // MIDI range
-        60,   // root = middle C
-    );
-
     println!("  Scale: {} nodes, root at index {}", scale.len(), scale.root_idx());
 
-    // Build coord -> index lookup (what downstream apps need for MIDI mapping)
-    let coord_map = scale.coord_to_index();
+    // Read every node out in one copy, into the reused buffer
+    scale.nodes_into(&mut state.nodes);
+    let nodes = &state.nodes;
+
+    // Refill the coord -> index lookup (what downstream apps need for MIDI
+    // mapping) from the nodes just read, reusing its table
+    let coord_map = &mut state.coord_map;
+    coord_map.clear();
+    coord_map.extend(nodes.iter().enumerate()
+        .map(|(i, node)| ((node.natural_coord.x, node.natural_coord.y), i)));
     println!("  Mapped {} unique coordinates", coord_map.len());
 
     // Show a few nodes around middle C
     println!("  Nodes around root (index 58-62):");
-    for i in 58..=62 {
-        if let Some(node) = scale.node(i) {
-            let in_scale = mos.node_in_scale(scalatrix::Vec2i::new(
-                node.natural_coord.x, node.natural_coord.y));
-            println!("    [{:3}] ({:3}, {:3}) -> {:10.4} Hz  in_scale={}",
-                i, node.natural_coord.x, node.natural_coord.y, node.pitch, in_scale);
-        }
+    for (i, node) in nodes.iter().enumerate().take(63).skip(58) {
+        let in_scale = mos.node_in_scale(node.natural_coord);
+        println!("    [{:3}] ({:3}, {:3}) -> {:10.4} Hz  in_scale={}",
+            i, node.natural_coord.x, node.natural_coord.y, node.pitch, in_scale);
     }
     println!();
 }
@@ -193,7 +227,8 @@ fn main() {
     let mut connected = false;
 
     // Track last received params to avoid redundant processing
-    let mut last_mapping: Option<String> = None;
+    let mut last_mapping: Option<PitchGridParams> = None;
+    let mut mapping_state = MappingState::new();
 
     println!("Waiting for PitchGrid plugin...\n");
 
@@ -245,13 +280,12 @@ fn main() {
                             last_heartbeat_recv = Instant::now();
                             if let Some(params) = PitchGridParams::from_osc_args(&msg.args) {
                                 // Dedup: only process if params actually changed
-                                let key = format!("{:?}", params);
-                                if last_mapping.as_ref() != Some(&key) {
+                                if last_mapping.as_ref() != Some(&params) {
                                     println!("[mapping] mode={}, root={:.2}Hz, stretch={:.6}, skew={:.6}, offset={:.2}, steps={}, mos=({},{})",
                                         params.mode, params.root_freq, params.stretch, params.skew,
                                         params.mode_offset, params.steps, params.mos_a, params.mos_b);
-                                    process_mapping(&params);
-                                    last_mapping = Some(key);
+                                    process_mapping(&mut mapping_state, &params);
+                                    last_mapping = Some(params);
                                 }
                             }
                         }
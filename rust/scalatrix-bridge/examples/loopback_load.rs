@@ -0,0 +1,126 @@
+//! Loopback load test: streams mapping messages at the bridge over local
+//! UDP and measures, for every snapshot each subscriber sees, the time from
+//! sending the newest message in it to the subscriber reading it.
+//!
+//! The message index is encoded in the root frequency, in steps that are
+//! exact in f32, so a subscriber can tell which send it is looking at.
+//!
+//! Usage:
+//!   cargo run --release -p scalatrix-bridge --example loopback_load -- \
+//!       [messages=20000] [rate_hz=5000] [subscribers=9] [frame_us=1000]
+
+use std::net::UdpSocket;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Arc;
+use std::thread;
+use std::time::{Duration, Instant};
+
+use scalatrix_bridge::osc::{Arg, Encoder};
+use scalatrix_bridge::{Bridge, BridgeConfig, MAPPING_ADDR};
+
+// Distinct root frequencies, and so sends in flight that can be told apart
+const RING: usize = 4096;
+const BASE_FREQ: f32 = 220.0;
+const FREQ_STEP: f32 = 1.0 / 16.0;
+
+fn arg<T: std::str::FromStr>(args: &[String], i: usize, default: T) -> T {
+    args.get(i).and_then(|s| s.parse().ok()).unwrap_or(default)
+}
+
+fn percentile(sorted: &[u64], p: f64) -> f64 {
+    if sorted.is_empty() {
+        return 0.0;
+    }
+    let i = ((sorted.len() - 1) as f64 * p).round() as usize;
+    sorted[i] as f64 / 1000.0
+}
+
+fn main() {
+    let args: Vec<String> = std::env::args().collect();
+    let messages: usize = arg(&args, 1, 20000);
+    let rate: f64 = arg(&args, 2, 5000.0);
+    let n_subscribers: usize = arg(&args, 3, 9);
+    let frame_us: u64 = arg(&args, 4, 1000);
+
+    let config = BridgeConfig {
+        plugin: None,
+        frame: Duration::from_micros(frame_us),
+        max_subscribers: n_subscribers.max(1),
+        ..Default::default()
+    };
+    let bridge = Bridge::start(config).expect("failed to start bridge");
+    let target = bridge.local_addr();
+
+    let start = Instant::now();
+    let sent_at: Arc<Vec<AtomicU64>> = Arc::new((0..RING).map(|_| AtomicU64::new(0)).collect());
+    let done = Arc::new(AtomicBool::new(false));
+
+    let subscribers: Vec<_> = (0..n_subscribers)
+        .map(|_| {
+            let mut subscriber = bridge.subscribe().expect("no free subscriber slot");
+            let sent_at = Arc::clone(&sent_at);
+            let done = Arc::clone(&done);
+            thread::spawn(move || {
+                let mut latencies = Vec::with_capacity(messages);
+                let mut last_seq = 0;
+                while !done.load(Ordering::Acquire) {
+                    subscriber.wait_timeout(Duration::from_millis(50));
+                    let Some(snapshot) = subscriber.load() else { continue };
+                    let now = start.elapsed().as_nanos() as u64;
+                    if snapshot.seq == last_seq {
+                        continue;
+                    }
+                    last_seq = snapshot.seq;
+                    let Some(mapping) = snapshot.mapping else { continue };
+                    let k = ((mapping.root_freq as f32 - BASE_FREQ) / FREQ_STEP).round() as usize % RING;
+                    latencies.push(now.saturating_sub(sent_at[k].load(Ordering::Acquire)));
+                }
+                latencies
+            })
+        })
+        .collect();
+
+    let socket = UdpSocket::bind("127.0.0.1:0").expect("failed to bind sender");
+    let mut encoder = Encoder::new();
+    let interval = Duration::from_secs_f64(1.0 / rate);
+    let send_start = Instant::now();
+    for i in 0..messages {
+        // Pace against the schedule, not the previous send
+        let due = send_start + interval * i as u32;
+        while Instant::now() < due {
+            if due - Instant::now() > Duration::from_micros(200) {
+                thread::sleep(Duration::from_micros(100));
+            } else {
+                std::hint::spin_loop();
+            }
+        }
+        let k = i % RING;
+        let root_freq = BASE_FREQ + k as f32 * FREQ_STEP;
+        let skew = 0.57 + 0.02 * (i % 100) as f32 / 100.0;
+        let packet = encoder.message(MAPPING_ADDR, &[
+            Arg::Int(1), Arg::Float(root_freq), Arg::Float(1.0), Arg::Float(skew),
+            Arg::Float(0.0), Arg::Int(12), Arg::Int(5), Arg::Int(2),
+        ]);
+        sent_at[k].store(start.elapsed().as_nanos() as u64, Ordering::Release);
+        socket.send_to(packet, target).expect("send failed");
+    }
+    let send_time = send_start.elapsed();
+
+    // Let the last frame through
+    thread::sleep(Duration::from_millis(100));
+    done.store(true, Ordering::Release);
+    let mut latencies: Vec<u64> = subscribers.into_iter().flat_map(|t| t.join().unwrap()).collect();
+    latencies.sort_unstable();
+    let stats = bridge.stats();
+
+    println!("Loopback load: {messages} mapping messages at {rate:.0} Hz \
+              ({:.0} Hz achieved), {n_subscribers} subscribers, {frame_us} us frame",
+             messages as f64 / send_time.as_secs_f64());
+    println!("  received {} packets, {} coalesced, {} rebuilds, {} snapshots published",
+             stats.packets, stats.coalesced, stats.rebuilds, stats.published);
+    println!("  {} snapshot reads; send -> subscriber latency (us):", latencies.len());
+    println!("    p50 {:9.1}  p90 {:9.1}  p99 {:9.1}  p99.9 {:9.1}  max {:9.1}",
+             percentile(&latencies, 0.50), percentile(&latencies, 0.90),
+             percentile(&latencies, 0.99), percentile(&latencies, 0.999),
+             percentile(&latencies, 1.0));
+}
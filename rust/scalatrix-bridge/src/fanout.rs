@@ -0,0 +1,339 @@
+//! Single-producer fan-out of shared snapshots to many consumers.
+//!
+//! Each subscriber has a slot holding a triple buffer of `Arc<T>`. The
+//! publisher fills the back buffer and swaps it into the middle, and the
+//! subscriber swaps the middle into its front buffer when something new is
+//! there. Neither side ever waits for the other, and reading takes no lock
+//! and touches no reference count. Superseded snapshots come back to the
+//! publisher's buffer, so they are usually dropped on the publisher's
+//! thread, not on a consumer's.
+//!
+//! ```rust
+//! use std::sync::Arc;
+//! use scalatrix_bridge::fanout::Publisher;
+//!
+//! let mut publisher = Publisher::new(4);
+//! let mut subscriber = publisher.fanout().subscribe().unwrap();
+//! assert_eq!(subscriber.load(), None);
+//!
+//! publisher.publish(Arc::new(1));
+//! publisher.publish(Arc::new(2));
+//! assert_eq!(subscriber.load().map(|v| **v), Some(2));
+//! ```
+
+use std::cell::UnsafeCell;
+use std::sync::atomic::{AtomicBool, AtomicU8, Ordering};
+use std::sync::{Arc, Mutex};
+use std::thread::{self, Thread};
+use std::time::Duration;
+
+// Slot states
+const FREE: u8 = 0;
+const CLAIMED: u8 = 1; // subscribed, not yet given the latest value
+const ACTIVE: u8 = 2;
+const RELEASED: u8 = 3; // subscriber dropped, buffers not yet cleared
+
+// Middle buffer word: buffer index, and whether the publisher has put
+// something there the subscriber has not taken
+const INDEX: u8 = 0b011;
+const FRESH: u8 = 0b100;
+
+struct Slot<T> {
+    state: AtomicU8,
+    buffers: [UnsafeCell<Option<Arc<T>>>; 3],
+    middle: AtomicU8,
+    back: UnsafeCell<u8>,  // the publisher's
+    front: UnsafeCell<u8>, // the subscriber's
+    waiting: AtomicBool,
+    waiter: Mutex<Option<Thread>>,
+}
+
+impl<T> Slot<T> {
+    fn new() -> Self {
+        Self {
+            state: AtomicU8::new(FREE),
+            buffers: [UnsafeCell::new(None), UnsafeCell::new(None), UnsafeCell::new(None)],
+            middle: AtomicU8::new(1),
+            back: UnsafeCell::new(0),
+            front: UnsafeCell::new(2),
+            waiting: AtomicBool::new(false),
+            waiter: Mutex::new(None),
+        }
+    }
+
+    // SAFETY: publisher only, on a CLAIMED or ACTIVE slot
+    unsafe fn write(&self, value: Arc<T>) {
+        let back = &mut *self.back.get();
+        *self.buffers[*back as usize].get() = Some(value);
+        // SeqCst pairs with the subscriber's in wait_timeout, so either it
+        // sees FRESH or we see it waiting
+        *back = self.middle.swap(*back | FRESH, Ordering::SeqCst) & INDEX;
+        if self.waiting.load(Ordering::SeqCst) {
+            if let Some(thread) = &*self.waiter.lock().unwrap() {
+                thread.unpark();
+            }
+        }
+    }
+
+    // SAFETY: publisher only, on a RELEASED slot
+    unsafe fn reset(&self) {
+        for buffer in &self.buffers {
+            *buffer.get() = None;
+        }
+        *self.back.get() = 0;
+        *self.front.get() = 2;
+        self.middle.store(1, Ordering::Relaxed);
+        *self.waiter.lock().unwrap() = None;
+        self.state.store(FREE, Ordering::Release);
+    }
+}
+
+/// The slots shared by a [`Publisher`] and its subscribers.
+pub struct Fanout<T> {
+    slots: Box<[Slot<T>]>,
+    closed: AtomicBool,
+}
+
+// SAFETY: each slot's buffers are reached only through the indices its one
+// publisher and one subscriber own, handed over with atomic swaps
+unsafe impl<T: Send + Sync> Send for Fanout<T> {}
+unsafe impl<T: Send + Sync> Sync for Fanout<T> {}
+
+impl<T> Fanout<T> {
+    /// Claim a free slot. Returns `None` if all are taken. The subscriber
+    /// sees the latest value once the publisher next publishes or calls
+    /// [`Publisher::refresh`].
+    pub fn subscribe(self: &Arc<Self>) -> Option<Subscriber<T>> {
+        let index = self.slots.iter().position(|slot| {
+            slot.state.compare_exchange(FREE, CLAIMED, Ordering::Acquire, Ordering::Relaxed).is_ok()
+        })?;
+        Some(Subscriber { fanout: Arc::clone(self), index })
+    }
+
+    /// Maximum number of subscribers at once.
+    pub fn capacity(&self) -> usize {
+        self.slots.len()
+    }
+
+    /// Slots currently claimed, including those released but not yet reclaimed.
+    pub fn subscriber_count(&self) -> usize {
+        self.slots.iter().filter(|s| s.state.load(Ordering::Relaxed) != FREE).count()
+    }
+
+    /// Whether the publisher has been dropped.
+    pub fn is_closed(&self) -> bool {
+        self.closed.load(Ordering::Acquire)
+    }
+}
+
+/// The writing end. There is exactly one per [`Fanout`].
+pub struct Publisher<T> {
+    fanout: Arc<Fanout<T>>,
+    latest: Option<Arc<T>>,
+}
+
+impl<T> Publisher<T> {
+    /// A fan-out to at most `capacity` subscribers.
+    pub fn new(capacity: usize) -> Self {
+        let slots = (0..capacity).map(|_| Slot::new()).collect();
+        Self { fanout: Arc::new(Fanout { slots, closed: AtomicBool::new(false) }), latest: None }
+    }
+
+    /// The shared slots, to subscribe from any thread.
+    pub fn fanout(&self) -> &Arc<Fanout<T>> {
+        &self.fanout
+    }
+
+    /// The last value published.
+    pub fn latest(&self) -> Option<&Arc<T>> {
+        self.latest.as_ref()
+    }
+
+    /// Hand `value` to every subscriber. Costs one reference count
+    /// increment per subscriber; takes no lock unless a subscriber is
+    /// blocked in [`Subscriber::wait_timeout`].
+    pub fn publish(&mut self, value: Arc<T>) {
+        for slot in self.fanout.slots.iter() {
+            match slot.state.load(Ordering::Acquire) {
+                CLAIMED | ACTIVE => {
+                    unsafe { slot.write(Arc::clone(&value)) }
+                    let _ = slot.state.compare_exchange(CLAIMED, ACTIVE, Ordering::Relaxed, Ordering::Relaxed);
+                }
+                RELEASED => unsafe { slot.reset() },
+                _ => {}
+            }
+        }
+        self.latest = Some(value);
+    }
+
+    /// Give new subscribers the latest value and reclaim the slots of
+    /// dropped ones, without publishing anything new.
+    pub fn refresh(&mut self) {
+        for slot in self.fanout.slots.iter() {
+            match slot.state.load(Ordering::Acquire) {
+                CLAIMED => {
+                    if let Some(latest) = &self.latest {
+                        unsafe { slot.write(Arc::clone(latest)) }
+                    }
+                    let _ = slot.state.compare_exchange(CLAIMED, ACTIVE, Ordering::Relaxed, Ordering::Relaxed);
+                }
+                RELEASED => unsafe { slot.reset() },
+                _ => {}
+            }
+        }
+    }
+}
+
+impl<T> Drop for Publisher<T> {
+    fn drop(&mut self) {
+        self.fanout.closed.store(true, Ordering::Release);
+        for slot in self.fanout.slots.iter() {
+            if slot.waiting.load(Ordering::SeqCst) {
+                if let Some(thread) = &*slot.waiter.lock().unwrap() {
+                    thread.unpark();
+                }
+            }
+        }
+    }
+}
+
+/// The reading end of one slot.
+pub struct Subscriber<T> {
+    fanout: Arc<Fanout<T>>,
+    index: usize,
+}
+
+impl<T> Subscriber<T> {
+    fn slot(&self) -> &Slot<T> {
+        &self.fanout.slots[self.index]
+    }
+
+    /// Whether a value newer than the last one loaded is waiting.
+    pub fn has_update(&self) -> bool {
+        self.slot().middle.load(Ordering::Acquire) & FRESH != 0
+    }
+
+    /// The newest value published, or `None` before the first. Wait-free:
+    /// at most one atomic swap.
+    pub fn load(&mut self) -> Option<&Arc<T>> {
+        let slot = &self.fanout.slots[self.index];
+        // SAFETY: front is ours; the publisher never touches the buffer it
+        // indexes
+        unsafe {
+            let front = &mut *slot.front.get();
+            if slot.middle.load(Ordering::Relaxed) & FRESH != 0 {
+                *front = slot.middle.swap(*front, Ordering::AcqRel) & INDEX;
+            }
+            (*slot.buffers[*front as usize].get()).as_ref()
+        }
+    }
+
+    /// Block until there is an update, the publisher is dropped or
+    /// `timeout` passes, and return whether there is an update. May return
+    /// early.
+    pub fn wait_timeout(&mut self, timeout: Duration) -> bool {
+        let slot = self.slot();
+        if slot.middle.load(Ordering::Acquire) & FRESH != 0 {
+            return true;
+        }
+        *slot.waiter.lock().unwrap() = Some(thread::current());
+        slot.waiting.store(true, Ordering::SeqCst);
+        if slot.middle.load(Ordering::SeqCst) & FRESH == 0 && !self.fanout.is_closed() {
+            thread::park_timeout(timeout);
+        }
+        slot.waiting.store(false, Ordering::Relaxed);
+        self.has_update()
+    }
+
+    /// Whether the publisher has been dropped; the last value stays loadable.
+    pub fn is_closed(&self) -> bool {
+        self.fanout.is_closed()
+    }
+}
+
+impl<T> Drop for Subscriber<T> {
+    fn drop(&mut self) {
+        self.slot().state.store(RELEASED, Ordering::Release);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn late_subscribers_get_the_latest_value() {
+        let mut publisher = Publisher::new(2);
+        publisher.publish(Arc::new(7));
+        let mut late = publisher.fanout().subscribe().unwrap();
+        assert!(late.load().is_none());
+        publisher.refresh();
+        assert_eq!(late.load().map(|v| **v), Some(7));
+    }
+
+    #[test]
+    fn slots_are_reused_after_drop() {
+        let mut publisher = Publisher::<i32>::new(1);
+        let fanout = Arc::clone(publisher.fanout());
+        let first = fanout.subscribe().unwrap();
+        assert!(fanout.subscribe().is_none());
+        drop(first);
+        assert!(fanout.subscribe().is_none());
+        publisher.refresh();
+        assert_eq!(fanout.subscriber_count(), 0);
+        assert!(fanout.subscribe().is_some());
+    }
+
+    #[test]
+    fn superseded_values_are_dropped() {
+        let mut publisher = Publisher::new(3);
+        let mut subscribers: Vec<_> = (0..3).map(|_| publisher.fanout().subscribe().unwrap()).collect();
+        let first = Arc::new(0);
+        publisher.publish(Arc::clone(&first));
+        for s in &mut subscribers {
+            s.load();
+        }
+        for i in 1..5 {
+            publisher.publish(Arc::new(i));
+        }
+        for s in &mut subscribers {
+            assert_eq!(s.load().map(|v| **v), Some(4));
+        }
+        // The first value went back to the middle buffers when the
+        // subscribers moved on; the publisher overwrites it within two writes
+        publisher.publish(Arc::new(5));
+        publisher.publish(Arc::new(6));
+        assert_eq!(Arc::strong_count(&first), 1);
+    }
+
+    #[test]
+    fn readers_always_see_whole_values_in_order() {
+        let mut publisher = Publisher::<Vec<u64>>::new(4);
+        let readers: Vec<_> = (0..4)
+            .map(|_| {
+                let mut s = publisher.fanout().subscribe().unwrap();
+                thread::spawn(move || {
+                    let mut last = 0u64;
+                    loop {
+                        s.wait_timeout(Duration::from_millis(10));
+                        if let Some(v) = s.load() {
+                            assert!(v.iter().all(|&x| x == v[0]));
+                            assert!(v[0] >= last);
+                            last = v[0];
+                        }
+                        if s.is_closed() && !s.has_update() {
+                            return last;
+                        }
+                    }
+                })
+            })
+            .collect();
+        for i in 1..=2000u64 {
+            publisher.publish(Arc::new(vec![i; 64]));
+        }
+        drop(publisher);
+        for r in readers {
+            assert_eq!(r.join().unwrap(), 2000);
+        }
+    }
+}
@@ -0,0 +1,786 @@
+//! PitchGrid tuning bridge: receives the plugin's OSC stream and serves
+//! the resulting tuning tables to many consumers in the same process.
+//!
+//! Work is split across two threads:
+//!
+//! - The **receiver** owns the UDP socket. It decodes each packet with
+//!   the allocation-free codec in [`osc`] and stores the result as the
+//!   pending value for its address. A newer message for the same address
+//!   replaces a pending one that was not yet taken (last writer wins). It
+//!   also sends and tracks heartbeats.
+//! - The **worker** takes everything pending at most once per
+//!   [`BridgeConfig::frame`]. It regenerates the mapped scale in place when
+//!   the mapping changed, and publishes an immutable [`TuningSnapshot`]
+//!   through a [`fanout`].
+//!
+//! Consumers call [`Bridge::subscribe`] and read the newest snapshot with
+//! [`Subscriber::load`], which is wait-free. A burst of messages within a
+//! frame therefore costs one rebuild, and however many consumers there are,
+//! none of them can hold up the worker or each other.
+//!
+//! ```no_run
+//! use scalatrix_bridge::{Bridge, BridgeConfig};
+//! use std::time::Duration;
+//!
+//! let bridge = Bridge::start(BridgeConfig::default()).unwrap();
+//! let mut tuning = bridge.subscribe().unwrap();
+//! loop {
+//!     tuning.wait_timeout(Duration::from_millis(100));
+//!     if let Some(snapshot) = tuning.load() {
+//!         println!("{} nodes, root {:.2} Hz", snapshot.nodes.len(), snapshot.nodes[60].pitch);
+//!     }
+//! }
+//! ```
+
+pub mod fanout;
+pub mod osc;
+
+use std::io;
+use std::net::{SocketAddr, UdpSocket};
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread::{self, JoinHandle};
+use std::time::{Duration, Instant};
+
+use scalatrix::{Mapping, Mos, Node, Scale};
+
+pub use fanout::Subscriber;
+
+/// Address of the live tuning parameters.
+pub const TUNING_ADDR: &str = "/pitchgrid/plugin/tuning";
+/// Address of the MIDI mapping parameters.
+pub const MAPPING_ADDR: &str = "/pitchgrid/plugin/mapping";
+/// Address of the forwarded synth spectrum.
+pub const SPECTRUM_ADDR: &str = "/pitchgrid/plugin/spectrum";
+/// Address of the forwarded node consonance.
+pub const CONSONANCE_ADDR: &str = "/pitchgrid/plugin/consonance";
+/// Address of heartbeats in both directions.
+pub const HEARTBEAT_ADDR: &str = "/pitchgrid/heartbeat";
+
+/// The plugin's OSC server port, where heartbeats go.
+pub const PLUGIN_PORT: u16 = 34562;
+
+/// Largest `mos_a + mos_b` accepted. The worker builds the MOS and its scale
+/// from a single packet, so one bogus message must not be able to make it
+/// allocate and walk a lattice of millions of nodes.
+pub const MAX_MOS_SIZE: i32 = 1024;
+/// Largest mapping `steps` accepted, for the same reason.
+pub const MAX_STEPS: i32 = 1024;
+
+/// Parameters carried by the tuning and mapping messages:
+/// `(mode: i32, root_freq: f32, stretch: f32, skew: f32,
+///   mode_offset: f32, steps: i32, mos_a: i32, mos_b: i32)`.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct PitchGridParams {
+    pub mode: i32,
+    pub root_freq: f64,
+    pub stretch: f64,
+    pub skew: f64,
+    pub mode_offset: f64,
+    pub steps: i32,
+    pub mos_a: i32,
+    pub mos_b: i32,
+}
+
+impl PitchGridParams {
+    /// Parse the first eight arguments of a tuning or mapping message.
+    pub fn from_message(msg: &osc::Message<'_>) -> Option<Self> {
+        let mut args = [osc::Arg::Nil; 8];
+        let mut received = msg.args();
+        for arg in &mut args {
+            *arg = received.next()?;
+        }
+        Some(Self {
+            mode:        args[0].int()?,
+            root_freq:   args[1].float()? as f64,
+            stretch:     args[2].float()? as f64,
+            skew:        args[3].float()? as f64,
+            mode_offset: args[4].float()? as f64,
+            steps:       args[5].int()?,
+            mos_a:       args[6].int()?,
+            mos_b:       args[7].int()?,
+        })
+    }
+
+    /// Whether a MOS can be built from these parameters: positive `mos_a`,
+    /// `mos_b` and `steps` within [`MAX_MOS_SIZE`] and [`MAX_STEPS`], a skew
+    /// (the generator, as a fraction of the equave) in `[0, 1]`, and finite,
+    /// positive stretch and root frequency.
+    pub fn is_valid(&self) -> bool {
+        self.mos_a > 0 && self.mos_b > 0
+            && self.mos_a.checked_add(self.mos_b).is_some_and(|n| n <= MAX_MOS_SIZE)
+            && self.steps > 0 && self.steps <= MAX_STEPS
+            && self.stretch.is_finite() && self.stretch > 0.0
+            && (0.0..=1.0).contains(&self.skew)
+            && self.root_freq.is_finite() && self.root_freq > 0.0
+            && self.mode_offset.is_finite()
+    }
+}
+
+/// A partial of the forwarded spectrum.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Partial {
+    pub ratio: f32,
+    pub weight: f32,
+}
+
+/// Consonance of one lattice node, as forwarded by the plugin.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct NodeConsonance {
+    pub x: i32,
+    pub y: i32,
+    pub consonance: f32,
+}
+
+/// Everything known about the plugin's state, as of one frame. Immutable
+/// once published.
+#[derive(Debug)]
+pub struct TuningSnapshot {
+    /// Increases by one with every snapshot published.
+    pub seq: u64,
+    /// Latest live tuning parameters.
+    pub tuning: Option<PitchGridParams>,
+    /// Mapping parameters the nodes were generated from.
+    pub mapping: Option<PitchGridParams>,
+    /// The mapped scale of `mapping`, [`BridgeConfig::n_nodes`] nodes with
+    /// the root at [`BridgeConfig::root`]; empty before the first mapping,
+    /// and always when that root is not one of the nodes.
+    pub nodes: Vec<Node>,
+    pub spectrum: Vec<Partial>,
+    pub consonance: Vec<NodeConsonance>,
+    /// When the newest message that went into this snapshot was received.
+    pub received_at: Instant,
+    /// When this snapshot was published.
+    pub published_at: Instant,
+}
+
+// By hand for clone_from, which refills the vectors in place: the worker
+// publishes into retired snapshots that way
+impl Clone for TuningSnapshot {
+    fn clone(&self) -> Self {
+        Self {
+            seq: self.seq,
+            tuning: self.tuning,
+            mapping: self.mapping,
+            nodes: self.nodes.clone(),
+            spectrum: self.spectrum.clone(),
+            consonance: self.consonance.clone(),
+            received_at: self.received_at,
+            published_at: self.published_at,
+        }
+    }
+
+    fn clone_from(&mut self, source: &Self) {
+        self.seq = source.seq;
+        self.tuning = source.tuning;
+        self.mapping = source.mapping;
+        self.nodes.clone_from(&source.nodes);
+        self.spectrum.clone_from(&source.spectrum);
+        self.consonance.clone_from(&source.consonance);
+        self.received_at = source.received_at;
+        self.published_at = source.published_at;
+    }
+}
+
+/// Configuration of a [`Bridge`].
+#[derive(Debug, Clone)]
+pub struct BridgeConfig {
+    /// Address to receive on; port 0 picks a free one.
+    pub bind: SocketAddr,
+    /// Where to send heartbeats; `None` sends none, for feeding the bridge
+    /// from something other than the plugin.
+    pub plugin: Option<SocketAddr>,
+    /// Shortest time between two rebuilds; messages arriving in between
+    /// are coalesced.
+    pub frame: Duration,
+    /// Nodes of the mapped scale (128 for MIDI).
+    pub n_nodes: i32,
+    /// Index of the root node (60 for middle C), in `0..n_nodes`.
+    pub root: i32,
+    /// Maximum number of subscribers at once.
+    pub max_subscribers: usize,
+}
+
+impl Default for BridgeConfig {
+    fn default() -> Self {
+        Self {
+            bind: SocketAddr::from(([127, 0, 0, 1], 0)),
+            plugin: Some(SocketAddr::from(([127, 0, 0, 1], PLUGIN_PORT))),
+            frame: Duration::from_millis(5),
+            n_nodes: 128,
+            root: 60,
+            max_subscribers: 16,
+        }
+    }
+}
+
+/// Counters since the bridge started.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct BridgeStats {
+    /// Packets received.
+    pub packets: u64,
+    /// Messages decoded, counting each one in a bundle.
+    pub messages: u64,
+    /// Packets that failed to decode.
+    pub decode_errors: u64,
+    /// Tuning or mapping messages with wrong or invalid arguments.
+    pub rejected: u64,
+    /// Messages with an address the bridge does not handle.
+    pub unknown: u64,
+    /// Pending messages replaced by a newer one before the worker took them.
+    pub coalesced: u64,
+    /// Scale regenerations.
+    pub rebuilds: u64,
+    /// Snapshots published.
+    pub published: u64,
+    /// Snapshots allocated; every other one published refilled the buffers
+    /// of one no longer held.
+    pub snapshots_allocated: u64,
+}
+
+#[derive(Default)]
+struct Counters {
+    packets: AtomicU64,
+    messages: AtomicU64,
+    decode_errors: AtomicU64,
+    rejected: AtomicU64,
+    unknown: AtomicU64,
+    coalesced: AtomicU64,
+    rebuilds: AtomicU64,
+    published: AtomicU64,
+    snapshots_allocated: AtomicU64,
+}
+
+fn bump(counter: &AtomicU64) {
+    counter.fetch_add(1, Ordering::Relaxed);
+}
+
+/// Latest message per address, not yet taken by the worker. The receiver
+/// and the worker swap whole `Pending`s, so the vectors are recycled.
+#[derive(Default)]
+struct Pending {
+    tuning: Option<PitchGridParams>,
+    mapping: Option<PitchGridParams>,
+    spectrum: Option<Vec<Partial>>,
+    consonance: Option<Vec<NodeConsonance>>,
+    // Spare vectors for the next spectrum and consonance messages
+    spare_spectrum: Vec<Partial>,
+    spare_consonance: Vec<NodeConsonance>,
+    received_at: Option<Instant>,
+    // A new subscriber is waiting for the latest snapshot
+    refresh: bool,
+}
+
+impl Pending {
+    fn is_empty(&self) -> bool {
+        self.tuning.is_none() && self.mapping.is_none()
+            && self.spectrum.is_none() && self.consonance.is_none()
+    }
+}
+
+struct Shared {
+    pending: Mutex<Pending>,
+    wake: Condvar,
+    stop: AtomicBool,
+    counters: Counters,
+    last_heartbeat: Mutex<Option<Instant>>,
+    fanout: Arc<fanout::Fanout<TuningSnapshot>>,
+}
+
+/// A running bridge. Dropping it stops both threads.
+pub struct Bridge {
+    shared: Arc<Shared>,
+    local_addr: SocketAddr,
+    threads: Vec<JoinHandle<()>>,
+}
+
+impl Bridge {
+    /// Bind the socket and start the receiver and worker threads.
+    pub fn start(config: BridgeConfig) -> io::Result<Self> {
+        let socket = UdpSocket::bind(config.bind)?;
+        // Bounds how long shutdown and heartbeats can be delayed
+        socket.set_read_timeout(Some(Duration::from_millis(100)))?;
+        let local_addr = socket.local_addr()?;
+
+        let publisher = fanout::Publisher::new(config.max_subscribers);
+        let shared = Arc::new(Shared {
+            pending: Mutex::new(Pending::default()),
+            wake: Condvar::new(),
+            stop: AtomicBool::new(false),
+            counters: Counters::default(),
+            last_heartbeat: Mutex::new(None),
+            fanout: Arc::clone(publisher.fanout()),
+        });
+
+        let receiver = {
+            let shared = Arc::clone(&shared);
+            let plugin = config.plugin;
+            thread::Builder::new()
+                .name("scalatrix-bridge-recv".into())
+                .spawn(move || receive(&shared, &socket, plugin))?
+        };
+        let worker = {
+            let shared = Arc::clone(&shared);
+            thread::Builder::new()
+                .name("scalatrix-bridge-worker".into())
+                .spawn(move || Worker::new(&config, publisher).run(&shared))?
+        };
+        Ok(Self { shared, local_addr, threads: vec![receiver, worker] })
+    }
+
+    /// Address the bridge receives on.
+    pub fn local_addr(&self) -> SocketAddr {
+        self.local_addr
+    }
+
+    /// A new consumer of tuning snapshots, or `None` if
+    /// [`BridgeConfig::max_subscribers`] are already connected. Its first
+    /// [`Subscriber::load`] after the worker's next pass returns the latest
+    /// snapshot, if there is one.
+    pub fn subscribe(&self) -> Option<Subscriber<TuningSnapshot>> {
+        let subscriber = self.shared.fanout.subscribe()?;
+        self.shared.pending.lock().unwrap().refresh = true;
+        self.shared.wake.notify_one();
+        Some(subscriber)
+    }
+
+    /// Whether a plugin heartbeat arrived within the last two seconds.
+    pub fn connected(&self) -> bool {
+        let last = *self.shared.last_heartbeat.lock().unwrap();
+        last.is_some_and(|t| t.elapsed() < Duration::from_secs(2))
+    }
+
+    /// Counters since start.
+    pub fn stats(&self) -> BridgeStats {
+        let c = &self.shared.counters;
+        let get = |counter: &AtomicU64| counter.load(Ordering::Relaxed);
+        BridgeStats {
+            packets: get(&c.packets),
+            messages: get(&c.messages),
+            decode_errors: get(&c.decode_errors),
+            rejected: get(&c.rejected),
+            unknown: get(&c.unknown),
+            coalesced: get(&c.coalesced),
+            rebuilds: get(&c.rebuilds),
+            published: get(&c.published),
+            snapshots_allocated: get(&c.snapshots_allocated),
+        }
+    }
+}
+
+impl Drop for Bridge {
+    fn drop(&mut self) {
+        self.shared.stop.store(true, Ordering::Release);
+        {
+            // Under the lock, so the worker cannot miss the notification
+            let _pending = self.shared.pending.lock().unwrap();
+            self.shared.wake.notify_all();
+        }
+        for thread in self.threads.drain(..) {
+            let _ = thread.join();
+        }
+    }
+}
+
+// ── Receiver ───────────────────────────────────────────────────────
+
+fn receive(shared: &Shared, socket: &UdpSocket, plugin: Option<SocketAddr>) {
+    let mut buf = vec![0u8; 65536];
+    let mut encoder = osc::Encoder::new();
+    let my_port = socket.local_addr().map(|a| a.port()).unwrap_or(0);
+    let heartbeat_interval = Duration::from_secs(1);
+    let mut last_sent: Option<Instant> = None;
+
+    while !shared.stop.load(Ordering::Acquire) {
+        if let Some(plugin) = plugin {
+            if last_sent.is_none_or(|t| t.elapsed() >= heartbeat_interval) {
+                let packet = encoder.message(HEARTBEAT_ADDR, &[osc::Arg::Int(1), osc::Arg::Int(my_port as i32)]);
+                let _ = socket.send_to(packet, plugin);
+                last_sent = Some(Instant::now());
+            }
+        }
+
+        let size = match socket.recv_from(&mut buf) {
+            Ok((size, _)) => size,
+            // Timeouts, and refusals after a heartbeat found no plugin
+            Err(_) => continue,
+        };
+        let received_at = Instant::now();
+        bump(&shared.counters.packets);
+
+        let mut pending = shared.pending.lock().unwrap();
+        let mut notify = false;
+        let result = osc::decode(&buf[..size], &mut |msg| {
+            bump(&shared.counters.messages);
+            notify |= accept(shared, &mut pending, &msg, received_at);
+        });
+        drop(pending);
+        if result.is_err() {
+            bump(&shared.counters.decode_errors);
+        }
+        if notify {
+            shared.wake.notify_one();
+        }
+    }
+}
+
+// Store one message as pending; returns whether the worker has new work
+fn accept(shared: &Shared, pending: &mut Pending, msg: &osc::Message<'_>, received_at: Instant) -> bool {
+    let counters = &shared.counters;
+    let replaced = match msg.addr() {
+        HEARTBEAT_ADDR => {
+            *shared.last_heartbeat.lock().unwrap() = Some(received_at);
+            return false;
+        }
+        TUNING_ADDR | MAPPING_ADDR => {
+            let Some(params) = PitchGridParams::from_message(msg).filter(PitchGridParams::is_valid) else {
+                bump(&counters.rejected);
+                return false;
+            };
+            let slot = if msg.addr() == TUNING_ADDR { &mut pending.tuning } else { &mut pending.mapping };
+            slot.replace(params).is_some()
+        }
+        SPECTRUM_ADDR => {
+            let mut partials = match pending.spectrum.take() {
+                Some(v) => { bump(&counters.coalesced); v }
+                None => std::mem::take(&mut pending.spare_spectrum),
+            };
+            partials.clear();
+            let mut args = msg.args();
+            while let (Some(ratio), Some(weight)) = (args.next(), args.next()) {
+                if let (Some(ratio), Some(weight)) = (ratio.float(), weight.float()) {
+                    partials.push(Partial { ratio, weight });
+                }
+            }
+            pending.spectrum = Some(partials);
+            false
+        }
+        CONSONANCE_ADDR => {
+            let mut nodes = match pending.consonance.take() {
+                Some(v) => { bump(&counters.coalesced); v }
+                None => std::mem::take(&mut pending.spare_consonance),
+            };
+            nodes.clear();
+            let mut args = msg.args();
+            while let (Some(x), Some(y), Some(c)) = (args.next(), args.next(), args.next()) {
+                if let (Some(x), Some(y), Some(consonance)) = (x.int(), y.int(), c.float()) {
+                    nodes.push(NodeConsonance { x, y, consonance });
+                }
+            }
+            pending.consonance = Some(nodes);
+            false
+        }
+        _ => {
+            bump(&counters.unknown);
+            return false;
+        }
+    };
+    if replaced {
+        bump(&counters.coalesced);
+    }
+    pending.received_at = Some(received_at);
+    true
+}
+
+// ── Worker ─────────────────────────────────────────────────────────
+
+struct Worker {
+    n_nodes: i32,
+    root: i32,
+    frame: Duration,
+    publisher: fanout::Publisher<TuningSnapshot>,
+    // Swapped with the shared Pending on each pass
+    taken: Pending,
+    mos: Option<Mos>,
+    scale: Scale,
+    current: TuningSnapshot,
+    // Snapshots published before, refilled once no slot or consumer holds
+    // them any more; at most as many as the fan-out can hold at once
+    retired: Vec<Arc<TuningSnapshot>>,
+}
+
+impl Worker {
+    fn new(config: &BridgeConfig, publisher: fanout::Publisher<TuningSnapshot>) -> Self {
+        let now = Instant::now();
+        // Three buffers per slot, the publisher's latest and the one being
+        // filled
+        let max_retired = 3 * publisher.fanout().capacity() + 2;
+        Self {
+            n_nodes: config.n_nodes,
+            root: config.root,
+            frame: config.frame,
+            publisher,
+            taken: Pending::default(),
+            mos: None,
+            scale: Scale::new(config.n_nodes),
+            current: TuningSnapshot {
+                seq: 0,
+                tuning: None,
+                mapping: None,
+                nodes: Vec::with_capacity(config.n_nodes.max(0) as usize),
+                spectrum: Vec::new(),
+                consonance: Vec::new(),
+                received_at: now,
+                published_at: now,
+            },
+            retired: Vec::with_capacity(max_retired),
+        }
+    }
+
+    fn run(mut self, shared: &Shared) {
+        let mut last_pass: Option<Instant> = None;
+        loop {
+            let refresh;
+            {
+                let mut pending = shared.pending.lock().unwrap();
+                while pending.is_empty() && !pending.refresh && !shared.stop.load(Ordering::Acquire) {
+                    pending = shared.wake.wait(pending).unwrap();
+                }
+                if shared.stop.load(Ordering::Acquire) {
+                    return;
+                }
+                // Wait out the rest of the frame; the receiver keeps
+                // coalescing into pending meanwhile
+                if let (Some(last), false) = (last_pass, pending.is_empty()) {
+                    let next = last + self.frame;
+                    loop {
+                        if shared.stop.load(Ordering::Acquire) {
+                            return;
+                        }
+                        let now = Instant::now();
+                        if now >= next {
+                            break;
+                        }
+                        pending = shared.wake.wait_timeout(pending, next - now).unwrap().0;
+                    }
+                }
+                // The receiver gets back the spare vectors left in taken
+                std::mem::swap(&mut *pending, &mut self.taken);
+                refresh = std::mem::take(&mut self.taken.refresh);
+            }
+            if !self.taken.is_empty() {
+                last_pass = Some(Instant::now());
+                self.apply(shared);
+            }
+            if refresh {
+                self.publisher.refresh();
+            }
+        }
+    }
+
+    fn apply(&mut self, shared: &Shared) {
+        if let Some(mapping) = self.taken.mapping.take() {
+            if self.current.mapping != Some(mapping) {
+                self.rebuild(&mapping);
+                bump(&shared.counters.rebuilds);
+                self.current.mapping = Some(mapping);
+            }
+        }
+        let (taken, current) = (&mut self.taken, &mut self.current);
+        if let Some(tuning) = taken.tuning.take() {
+            current.tuning = Some(tuning);
+        }
+        // The replaced vectors become the receiver's spares
+        if let Some(spectrum) = taken.spectrum.take() {
+            let old = std::mem::replace(&mut current.spectrum, spectrum);
+            taken.spare_spectrum = old;
+        }
+        if let Some(consonance) = taken.consonance.take() {
+            let old = std::mem::replace(&mut current.consonance, consonance);
+            taken.spare_consonance = old;
+        }
+        if let Some(received_at) = taken.received_at.take() {
+            current.received_at = received_at;
+        }
+
+        current.seq += 1;
+        current.published_at = Instant::now();
+        let snapshot = self.next_snapshot(shared);
+        self.publisher.publish(snapshot);
+        bump(&shared.counters.published);
+    }
+
+    // A copy of current to publish, in a retired snapshot's buffers if one
+    // is free; allocates only while the fan-out holds every one of them
+    fn next_snapshot(&mut self, shared: &Shared) -> Arc<TuningSnapshot> {
+        let current = &self.current;
+        for retired in &mut self.retired {
+            if let Some(snapshot) = Arc::get_mut(retired) {
+                snapshot.clone_from(current);
+                return Arc::clone(retired);
+            }
+        }
+        let snapshot = Arc::new(current.clone());
+        bump(&shared.counters.snapshots_allocated);
+        if self.retired.len() < self.retired.capacity() {
+            self.retired.push(Arc::clone(&snapshot));
+        }
+        snapshot
+    }
+
+    // Regenerate the mapped scale in place, as the osc-receiver example
+    fn rebuild(&mut self, params: &PitchGridParams) {
+        let mapping = Mapping {
+            steps: params.steps,
+            offset: params.mode_offset,
+            base_freq: params.root_freq,
+            n_nodes: self.n_nodes,
+            root: self.root,
+        };
+        let scale = &mut self.scale;
+        let mos = self.mos.get_or_insert_with(|| {
+            Mos::from_params(params.mos_a, params.mos_b, params.mode, params.stretch, params.skew, 1)
+        });
+        if mos.adjust_params_into(
+            params.mos_a, params.mos_b, params.mode, params.stretch, params.skew, 1,
+            &mapping, scale,
+        ) {
+            scale.nodes_into(&mut self.current.nodes);
+        } else {
+            self.current.nodes.clear();
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn mapping_args(root_freq: f32, skew: f32) -> [osc::Arg<'static>; 8] {
+        use osc::Arg::{Float, Int};
+        [Int(1), Float(root_freq), Float(1.0), Float(skew), Float(0.0), Int(12), Int(5), Int(2)]
+    }
+
+    fn decode_params(args: &[osc::Arg<'_>]) -> Option<PitchGridParams> {
+        let mut encoder = osc::Encoder::new();
+        let packet = encoder.message(MAPPING_ADDR, args).to_vec();
+        let msg = osc::Message::parse(&packet).unwrap();
+        PitchGridParams::from_message(&msg).filter(PitchGridParams::is_valid)
+    }
+
+    #[test]
+    fn rejects_packets_no_mos_can_be_built_from() {
+        use osc::Arg::{Float, Int, Str};
+        assert!(decode_params(&mapping_args(261.5, 0.57)).is_some());
+
+        // One argument changed at a time: (index, value)
+        let rejected = [
+            (1, Float(0.0)), (1, Float(-440.0)), (1, Float(f32::INFINITY)), (1, Float(f32::NAN)),
+            (2, Float(0.0)), (2, Float(-1.0)), (2, Float(f32::NAN)),
+            (3, Float(-0.01)), (3, Float(1.01)), (3, Float(f32::NAN)), (3, Float(f32::INFINITY)),
+            (4, Float(f32::NEG_INFINITY)), (4, Float(f32::NAN)),
+            (5, Int(0)), (5, Int(-12)), (5, Int(MAX_STEPS + 1)), (5, Int(i32::MAX)),
+            (6, Int(0)), (6, Int(-5)), (6, Int(MAX_MOS_SIZE)), (6, Int(i32::MAX)),
+            (7, Int(0)), (7, Int(MAX_MOS_SIZE - 4)), (7, Int(i32::MAX)),
+            (0, Float(1.0)), (6, Str("5")),
+        ];
+        for (index, value) in rejected {
+            let mut args = mapping_args(261.5, 0.57);
+            args[index] = value;
+            assert_eq!(decode_params(&args), None, "argument {index} = {value:?}");
+        }
+        let args = mapping_args(261.5, 0.57);
+        assert_eq!(decode_params(&args[..7]), None, "missing argument");
+
+        // The limits themselves are accepted
+        let accepted = [
+            (3, Float(0.0)), (3, Float(1.0)), (5, Int(MAX_STEPS)), (7, Int(MAX_MOS_SIZE - 5)),
+        ];
+        for (index, value) in accepted {
+            let mut args = mapping_args(261.5, 0.57);
+            args[index] = value;
+            assert!(decode_params(&args).is_some(), "argument {index} = {value:?}");
+        }
+    }
+
+    fn wait_for(subscriber: &mut Subscriber<TuningSnapshot>, done: impl Fn(&TuningSnapshot) -> bool)
+        -> Arc<TuningSnapshot>
+    {
+        let deadline = Instant::now() + Duration::from_secs(5);
+        while Instant::now() < deadline {
+            subscriber.wait_timeout(Duration::from_millis(20));
+            if let Some(snapshot) = subscriber.load() {
+                if done(snapshot) {
+                    return Arc::clone(snapshot);
+                }
+            }
+        }
+        panic!("no matching snapshot within 5 s");
+    }
+
+    #[test]
+    fn serves_the_latest_mapping_to_every_subscriber() {
+        let config = BridgeConfig { plugin: None, frame: Duration::from_millis(20), ..Default::default() };
+        let bridge = Bridge::start(config).unwrap();
+        let mut subscribers: Vec<_> = (0..3).map(|_| bridge.subscribe().unwrap()).collect();
+        let socket = UdpSocket::bind("127.0.0.1:0").unwrap();
+        let mut encoder = osc::Encoder::new();
+
+        // A burst, a packet that does not decode and a message for nobody
+        for i in 0..50 {
+            let packet = encoder.message(MAPPING_ADDR, &mapping_args(261.5, 0.57 + 0.0002 * i as f32));
+            socket.send_to(packet, bridge.local_addr()).unwrap();
+        }
+        socket.send_to(b"/broken", bridge.local_addr()).unwrap();
+        socket.send_to(encoder.message("/other", &[]), bridge.local_addr()).unwrap();
+        let spectrum = [osc::Arg::Float(1.0), osc::Arg::Float(1.0), osc::Arg::Float(2.0), osc::Arg::Float(0.5)];
+        socket.send_to(encoder.message(SPECTRUM_ADDR, &spectrum), bridge.local_addr()).unwrap();
+
+        let last_skew = (0.57 + 0.0002 * 49.0f32) as f64;
+        let expected = Mos::from_params(5, 2, 1, 1.0, last_skew, 1).generate_mapped_scale(12, 0.0, 261.5, 128, 60);
+        for subscriber in &mut subscribers {
+            let snapshot = wait_for(subscriber, |s| {
+                s.mapping.is_some_and(|m| m.skew == last_skew) && !s.spectrum.is_empty()
+            });
+            assert_eq!(snapshot.nodes.len(), 128);
+            assert_eq!(snapshot.nodes[60].pitch, expected.nodes()[60].pitch);
+            assert_eq!(snapshot.spectrum, [Partial { ratio: 1.0, weight: 1.0 }, Partial { ratio: 2.0, weight: 0.5 }]);
+        }
+
+        // A late subscriber gets the current snapshot without new input
+        let mut late = bridge.subscribe().unwrap();
+        let snapshot = wait_for(&mut late, |_| true);
+        assert!(snapshot.mapping.is_some_and(|m| m.skew == last_skew));
+
+        let stats = bridge.stats();
+        assert_eq!(stats.packets, 53);
+        assert_eq!(stats.decode_errors, 1);
+        assert_eq!(stats.unknown, 1);
+        assert!(stats.rebuilds < 50);
+        assert_eq!(stats.rebuilds + stats.coalesced, 50);
+    }
+
+    #[test]
+    fn snapshots_are_refilled_once_released() {
+        let config = BridgeConfig { plugin: None, max_subscribers: 1, frame: Duration::from_millis(1), ..Default::default() };
+        let bridge = Bridge::start(config).unwrap();
+        let mut subscriber = bridge.subscribe().unwrap();
+        let socket = UdpSocket::bind("127.0.0.1:0").unwrap();
+        let mut encoder = osc::Encoder::new();
+
+        for i in 0..40 {
+            let skew = 0.57 + 0.0002 * i as f32;
+            socket.send_to(encoder.message(MAPPING_ADDR, &mapping_args(261.5, skew)), bridge.local_addr()).unwrap();
+            let snapshot = wait_for(&mut subscriber, |s| s.mapping.is_some_and(|m| m.skew == skew as f64));
+            let expected = Mos::from_params(5, 2, 1, 1.0, skew as f64, 1).generate_mapped_scale(12, 0.0, 261.5, 128, 60);
+            assert_eq!(snapshot.nodes[60].pitch, expected.nodes()[60].pitch);
+        }
+        // Three buffers per slot, the latest and the one being filled
+        let stats = bridge.stats();
+        assert!(stats.published >= 40);
+        assert!(stats.snapshots_allocated <= 5, "{stats:?}");
+    }
+
+    #[test]
+    fn a_root_outside_the_nodes_publishes_no_nodes() {
+        let config = BridgeConfig { plugin: None, root: 128, ..Default::default() };
+        let bridge = Bridge::start(config).unwrap();
+        let mut subscriber = bridge.subscribe().unwrap();
+        let socket = UdpSocket::bind("127.0.0.1:0").unwrap();
+        let mut encoder = osc::Encoder::new();
+        socket.send_to(encoder.message(MAPPING_ADDR, &mapping_args(261.5, 0.57)), bridge.local_addr()).unwrap();
+
+        let snapshot = wait_for(&mut subscriber, |s| s.mapping.is_some());
+        assert!(snapshot.nodes.is_empty());
+    }
+}
@@ -0,0 +1,409 @@
+//! Minimal OSC 1.0 codec for the PitchGrid protocol.
+//!
+//! Decoding borrows from the packet buffer and never allocates: a message is
+//! validated once, then its arguments are read through an iterator. Bundles
+//! are walked recursively and each contained message is passed to a
+//! callback. Encoding appends to a reusable buffer.
+//!
+//! ```rust
+//! use scalatrix_bridge::osc::{self, Arg, Encoder};
+//!
+//! let mut encoder = Encoder::new();
+//! let packet = encoder.message("/pitchgrid/heartbeat", &[Arg::Int(1), Arg::Int(9000)]);
+//!
+//! let mut ports = Vec::new();
+//! osc::decode(packet, &mut |msg| {
+//!     assert_eq!(msg.addr(), "/pitchgrid/heartbeat");
+//!     ports.extend(msg.args().nth(1).and_then(|a| a.int()));
+//! }).unwrap();
+//! assert_eq!(ports, [9000]);
+//! ```
+
+use std::fmt;
+
+/// Deepest bundle nesting accepted by [`decode`].
+pub const MAX_BUNDLE_DEPTH: usize = 8;
+
+const BUNDLE_TAG: &[u8] = b"#bundle\0";
+
+/// A decoded or to-be-encoded OSC argument.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum Arg<'a> {
+    /// `i`: 32-bit integer.
+    Int(i32),
+    /// `f`: 32-bit float.
+    Float(f32),
+    /// `s`: string.
+    Str(&'a str),
+    /// `b`: blob.
+    Blob(&'a [u8]),
+    /// `h`: 64-bit integer.
+    Long(i64),
+    /// `d`: 64-bit float.
+    Double(f64),
+    /// `T` / `F`: boolean, no data.
+    Bool(bool),
+    /// `N`: nil, no data.
+    Nil,
+    /// `I`: impulse, no data.
+    Impulse,
+}
+
+impl<'a> Arg<'a> {
+    /// The value of an `i` argument.
+    pub fn int(&self) -> Option<i32> {
+        match *self { Arg::Int(v) => Some(v), _ => None }
+    }
+
+    /// The value of an `f` argument.
+    pub fn float(&self) -> Option<f32> {
+        match *self { Arg::Float(v) => Some(v), _ => None }
+    }
+
+    /// The value of an `s` argument.
+    pub fn str(&self) -> Option<&'a str> {
+        match *self { Arg::Str(v) => Some(v), _ => None }
+    }
+
+    fn tag(&self) -> u8 {
+        match self {
+            Arg::Int(_) => b'i',
+            Arg::Float(_) => b'f',
+            Arg::Str(_) => b's',
+            Arg::Blob(_) => b'b',
+            Arg::Long(_) => b'h',
+            Arg::Double(_) => b'd',
+            Arg::Bool(true) => b'T',
+            Arg::Bool(false) => b'F',
+            Arg::Nil => b'N',
+            Arg::Impulse => b'I',
+        }
+    }
+}
+
+/// Why a packet could not be decoded.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DecodeError {
+    /// The packet ends inside a field.
+    Truncated,
+    /// A string is not NUL-terminated or not UTF-8.
+    BadString,
+    /// The address does not start with `/`.
+    BadAddress,
+    /// The type tag string does not start with `,`.
+    BadTypeTags,
+    /// A type tag this codec does not know.
+    UnsupportedTag(u8),
+    /// A bundle element has a negative or oversized length.
+    BadElement,
+    /// Bundles nested deeper than [`MAX_BUNDLE_DEPTH`].
+    TooDeep,
+}
+
+impl fmt::Display for DecodeError {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            DecodeError::Truncated => write!(f, "packet truncated"),
+            DecodeError::BadString => write!(f, "malformed string"),
+            DecodeError::BadAddress => write!(f, "address must start with '/'"),
+            DecodeError::BadTypeTags => write!(f, "type tags must start with ','"),
+            DecodeError::UnsupportedTag(t) => write!(f, "unsupported type tag '{}'", *t as char),
+            DecodeError::BadElement => write!(f, "bad bundle element size"),
+            DecodeError::TooDeep => write!(f, "bundles nested too deeply"),
+        }
+    }
+}
+
+impl std::error::Error for DecodeError {}
+
+/// A validated OSC message borrowing from its packet.
+#[derive(Debug, Clone, Copy)]
+pub struct Message<'a> {
+    addr: &'a str,
+    tags: &'a [u8],
+    data: &'a [u8],
+}
+
+impl<'a> Message<'a> {
+    /// Decode and validate a single message (not a bundle).
+    pub fn parse(packet: &'a [u8]) -> Result<Self, DecodeError> {
+        let mut r = Reader { buf: packet, pos: 0 };
+        let addr = r.string()?;
+        if !addr.starts_with('/') {
+            return Err(DecodeError::BadAddress);
+        }
+        // A message without type tags is allowed by OSC 1.0 and has no arguments
+        let tags = if r.pos < packet.len() {
+            let tags = r.string()?.as_bytes();
+            if tags.first() != Some(&b',') {
+                return Err(DecodeError::BadTypeTags);
+            }
+            &tags[1..]
+        } else {
+            &[]
+        };
+        let data = &packet[r.pos..];
+        // Walk the arguments once so that Args never fails
+        let mut check = Reader { buf: data, pos: 0 };
+        for &tag in tags {
+            check.arg(tag)?;
+        }
+        Ok(Self { addr, tags, data })
+    }
+
+    /// The address pattern.
+    pub fn addr(&self) -> &'a str {
+        self.addr
+    }
+
+    /// Number of arguments.
+    pub fn len(&self) -> usize {
+        self.tags.len()
+    }
+
+    /// Whether the message has no arguments.
+    pub fn is_empty(&self) -> bool {
+        self.tags.is_empty()
+    }
+
+    /// The arguments in order.
+    pub fn args(&self) -> Args<'a> {
+        Args { tags: self.tags, reader: Reader { buf: self.data, pos: 0 } }
+    }
+}
+
+/// Iterator over the arguments of a [`Message`].
+#[derive(Debug, Clone)]
+pub struct Args<'a> {
+    tags: &'a [u8],
+    reader: Reader<'a>,
+}
+
+impl<'a> Iterator for Args<'a> {
+    type Item = Arg<'a>;
+
+    fn next(&mut self) -> Option<Arg<'a>> {
+        let (&tag, rest) = self.tags.split_first()?;
+        self.tags = rest;
+        // Validated in Message::parse
+        self.reader.arg(tag).ok()
+    }
+
+    fn size_hint(&self) -> (usize, Option<usize>) {
+        (self.tags.len(), Some(self.tags.len()))
+    }
+}
+
+impl ExactSizeIterator for Args<'_> {}
+
+/// Decode a packet, passing every message it contains to `on_message`, in
+/// order. Bundle time tags are ignored: messages are handled on arrival.
+pub fn decode<'a>(packet: &'a [u8], on_message: &mut dyn FnMut(Message<'a>)) -> Result<(), DecodeError> {
+    decode_at(packet, on_message, 0)
+}
+
+fn decode_at<'a>(packet: &'a [u8], on_message: &mut dyn FnMut(Message<'a>), depth: usize)
+    -> Result<(), DecodeError>
+{
+    if !packet.starts_with(BUNDLE_TAG) {
+        on_message(Message::parse(packet)?);
+        return Ok(());
+    }
+    if depth >= MAX_BUNDLE_DEPTH {
+        return Err(DecodeError::TooDeep);
+    }
+    let mut r = Reader { buf: packet, pos: BUNDLE_TAG.len() };
+    r.take(8)?; // time tag
+    while r.pos < packet.len() {
+        let size = r.i32()?;
+        if size < 0 || size % 4 != 0 {
+            return Err(DecodeError::BadElement);
+        }
+        let element = r.take(size as usize).map_err(|_| DecodeError::BadElement)?;
+        decode_at(element, on_message, depth + 1)?;
+    }
+    Ok(())
+}
+
+#[derive(Debug, Clone)]
+struct Reader<'a> {
+    buf: &'a [u8],
+    pos: usize,
+}
+
+impl<'a> Reader<'a> {
+    fn take(&mut self, n: usize) -> Result<&'a [u8], DecodeError> {
+        let end = self.pos.checked_add(n).ok_or(DecodeError::Truncated)?;
+        let bytes = self.buf.get(self.pos..end).ok_or(DecodeError::Truncated)?;
+        self.pos = end;
+        Ok(bytes)
+    }
+
+    fn word(&mut self) -> Result<[u8; 4], DecodeError> {
+        let mut w = [0; 4];
+        w.copy_from_slice(self.take(4)?);
+        Ok(w)
+    }
+
+    fn i32(&mut self) -> Result<i32, DecodeError> {
+        Ok(i32::from_be_bytes(self.word()?))
+    }
+
+    fn u64(&mut self) -> Result<u64, DecodeError> {
+        let mut w = [0; 8];
+        w.copy_from_slice(self.take(8)?);
+        Ok(u64::from_be_bytes(w))
+    }
+
+    // NUL-terminated, padded to a multiple of 4 bytes
+    fn string(&mut self) -> Result<&'a str, DecodeError> {
+        let rest = self.buf.get(self.pos..).ok_or(DecodeError::Truncated)?;
+        let len = rest.iter().position(|&b| b == 0).ok_or(DecodeError::BadString)?;
+        let s = std::str::from_utf8(&rest[..len]).map_err(|_| DecodeError::BadString)?;
+        self.take(padded(len + 1))?;
+        Ok(s)
+    }
+
+    fn blob(&mut self) -> Result<&'a [u8], DecodeError> {
+        let len = self.i32()?;
+        if len < 0 {
+            return Err(DecodeError::Truncated);
+        }
+        let len = len as usize;
+        let bytes = self.take(padded(len))?;
+        Ok(&bytes[..len])
+    }
+
+    fn arg(&mut self, tag: u8) -> Result<Arg<'a>, DecodeError> {
+        Ok(match tag {
+            b'i' => Arg::Int(self.i32()?),
+            b'f' => Arg::Float(f32::from_bits(self.i32()? as u32)),
+            b's' | b'S' => Arg::Str(self.string()?),
+            b'b' => Arg::Blob(self.blob()?),
+            b'h' => Arg::Long(self.u64()? as i64),
+            b'd' => Arg::Double(f64::from_bits(self.u64()?)),
+            b'T' => Arg::Bool(true),
+            b'F' => Arg::Bool(false),
+            b'N' => Arg::Nil,
+            b'I' => Arg::Impulse,
+            other => return Err(DecodeError::UnsupportedTag(other)),
+        })
+    }
+}
+
+fn padded(len: usize) -> usize {
+    (len + 3) & !3
+}
+
+/// Encodes messages into a buffer reused from one message to the next.
+#[derive(Debug, Default)]
+pub struct Encoder {
+    buf: Vec<u8>,
+}
+
+impl Encoder {
+    /// An encoder with an empty buffer.
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Encode one message; the bytes stay valid until the next call.
+    pub fn message(&mut self, addr: &str, args: &[Arg<'_>]) -> &[u8] {
+        self.buf.clear();
+        self.string(addr.as_bytes());
+        self.buf.push(b',');
+        self.buf.extend(args.iter().map(Arg::tag));
+        self.buf.push(0);
+        self.pad();
+        for arg in args {
+            match *arg {
+                Arg::Int(v) => self.buf.extend_from_slice(&v.to_be_bytes()),
+                Arg::Float(v) => self.buf.extend_from_slice(&v.to_bits().to_be_bytes()),
+                Arg::Str(s) => self.string(s.as_bytes()),
+                Arg::Blob(b) => {
+                    self.buf.extend_from_slice(&(b.len() as i32).to_be_bytes());
+                    self.buf.extend_from_slice(b);
+                    self.pad();
+                }
+                Arg::Long(v) => self.buf.extend_from_slice(&v.to_be_bytes()),
+                Arg::Double(v) => self.buf.extend_from_slice(&v.to_bits().to_be_bytes()),
+                Arg::Bool(_) | Arg::Nil | Arg::Impulse => {}
+            }
+        }
+        &self.buf
+    }
+
+    fn string(&mut self, s: &[u8]) {
+        self.buf.extend_from_slice(s);
+        self.buf.push(0);
+        self.pad();
+    }
+
+    fn pad(&mut self) {
+        let len = padded(self.buf.len());
+        self.buf.resize(len, 0);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn round_trips_every_argument_type() {
+        let args = [
+            Arg::Int(-7), Arg::Float(0.5), Arg::Str("abc"), Arg::Blob(&[1, 2, 3, 4, 5]),
+            Arg::Long(1 << 40), Arg::Double(-2.25), Arg::Bool(true), Arg::Bool(false),
+            Arg::Nil, Arg::Impulse, Arg::Str(""),
+        ];
+        let mut encoder = Encoder::new();
+        let packet = encoder.message("/a/b", &args).to_vec();
+        assert_eq!(packet.len() % 4, 0);
+
+        let msg = Message::parse(&packet).unwrap();
+        assert_eq!(msg.addr(), "/a/b");
+        assert_eq!(msg.len(), args.len());
+        assert!(msg.args().eq(args.iter().copied()));
+    }
+
+    #[test]
+    fn walks_nested_bundles() {
+        let mut encoder = Encoder::new();
+        let first = encoder.message("/x", &[Arg::Int(1)]).to_vec();
+        let second = encoder.message("/y", &[Arg::Float(2.0)]).to_vec();
+
+        let element = |bytes: &[u8], out: &mut Vec<u8>| {
+            out.extend_from_slice(&(bytes.len() as i32).to_be_bytes());
+            out.extend_from_slice(bytes);
+        };
+        let mut inner = BUNDLE_TAG.to_vec();
+        inner.extend_from_slice(&[0, 0, 0, 0, 0, 0, 0, 1]);
+        element(&second, &mut inner);
+        let mut outer = BUNDLE_TAG.to_vec();
+        outer.extend_from_slice(&[0, 0, 0, 0, 0, 0, 0, 1]);
+        element(&first, &mut outer);
+        element(&inner, &mut outer);
+
+        let mut seen = Vec::new();
+        decode(&outer, &mut |msg| seen.push(msg.addr().to_string())).unwrap();
+        assert_eq!(seen, ["/x", "/y"]);
+    }
+
+    #[test]
+    fn rejects_malformed_packets() {
+        let mut encoder = Encoder::new();
+        let packet = encoder.message("/x", &[Arg::Int(1), Arg::Str("hello")]).to_vec();
+        // Any cut is an error, except right after the address: a message
+        // without type tags
+        for len in 0..packet.len() {
+            assert_eq!(Message::parse(&packet[..len]).is_ok(), len == 4, "prefix of {len} bytes");
+        }
+        assert_eq!(Message::parse(b"x\0\0\0,\0\0\0").err(), Some(DecodeError::BadAddress));
+        assert_eq!(Message::parse(b"/x\0\0,q\0\0").err(), Some(DecodeError::UnsupportedTag(b'q')));
+
+        let mut bundle = BUNDLE_TAG.to_vec();
+        bundle.extend_from_slice(&[0; 8]);
+        bundle.extend_from_slice(&64i32.to_be_bytes());
+        assert_eq!(decode(&bundle, &mut |_| {}), Err(DecodeError::BadElement));
+    }
+}
@@ -9,16 +9,25 @@ fn main() {
 
     let cpp_files = [
         "affine_transform.cpp",
+        "memory.cpp",
         "scale.cpp",
         "lattice.cpp",
         "params.cpp",
         "mos.cpp",
+        "mos_pattern.cpp",
+        "mos_family.cpp",
         "pitchset.cpp",
+        "monzo.cpp",
+        "tempering.cpp",
+        "temperament_search.cpp",
         "linear_solver.cpp",
         "label_calculator.cpp",
         "node.cpp",
         "spectrum.cpp",
         "consonance.cpp",
+        "update_scheduler.cpp",
+        "snapshot.cpp",
+        "shared_tuning.cpp",
         "c_api.cpp",
     ];
 
@@ -40,6 +49,8 @@ fn main() {
         println!("cargo:rustc-link-lib=c++");
     } else if target_os == "linux" {
         println!("cargo:rustc-link-lib=stdc++");
+        // shm_open, for shared tuning segments, before glibc 2.34
+        println!("cargo:rustc-link-lib=rt");
     }
 
     build.compile("scalatrix");
@@ -4,7 +4,7 @@
 
 #![allow(non_camel_case_types)]
 
-use std::os::raw::c_int;
+use std::os::raw::{c_char, c_int, c_longlong, c_uchar, c_uint};
 
 /// Opaque MOS handle.
 #[repr(C)]
@@ -43,6 +43,106 @@ pub struct scalatrix_node {
     pub pitch: f64,
 }
 
+/// Arguments of `scalatrix_mos_generate_mapped_scale`, for the `_into` updates.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct scalatrix_mapping {
+    pub steps: c_int,
+    pub offset: f64,
+    pub base_freq: f64,
+    pub n_nodes: c_int,
+    pub root: c_int,
+}
+
+/// Options for `scalatrix_mos_family_generate`.
+#[repr(C)]
+#[derive(Debug, Clone, Copy)]
+pub struct scalatrix_mos_family_options {
+    pub min_size: c_int,
+    pub max_size: c_int,
+    pub g_steps: c_int,
+    pub equave: f64,
+    pub steps: c_int,
+    pub offset: f64,
+    pub base_freq: f64,
+    pub n_nodes: c_int,
+    pub root: c_int,
+    pub n_threads: c_int,
+}
+
+/// Opaque MOS family handle.
+#[repr(C)]
+pub struct scalatrix_mos_family_t {
+    _opaque: [u8; 0],
+}
+
+/// Opaque spectrum handle.
+#[repr(C)]
+pub struct scalatrix_spectrum_t {
+    _opaque: [u8; 0],
+}
+
+/// Opaque handle to a spectrum, f0 and cents grid prepared for curve evaluation.
+#[repr(C)]
+pub struct scalatrix_consonance_t {
+    _opaque: [u8; 0],
+}
+
+/// Peak and effective log baseline of a consonance curve.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct scalatrix_consonance_info {
+    pub peak: f64,
+    pub log_baseline: f64,
+}
+
+/// Opaque indexed pitch set handle.
+#[repr(C)]
+pub struct scalatrix_pitchset_t {
+    _opaque: [u8; 0],
+}
+
+/// Opaque shared tuning table publisher handle.
+#[repr(C)]
+pub struct scalatrix_shared_publisher_t {
+    _opaque: [u8; 0],
+}
+
+/// Opaque shared tuning table reader handle.
+#[repr(C)]
+pub struct scalatrix_shared_reader_t {
+    _opaque: [u8; 0],
+}
+
+/// Opaque label batch handle.
+#[repr(C)]
+pub struct scalatrix_labels_t {
+    _opaque: [u8; 0],
+}
+
+/// Label styles for `scalatrix_labels_rect` and `scalatrix_labels_coords`;
+/// or in `SCALATRIX_LABEL_TUNING` and `SCALATRIX_LABEL_ACCIDENTAL_BEFORE`.
+pub const SCALATRIX_LABEL_DIGIT: c_int = 0;
+pub const SCALATRIX_LABEL_DIGIT_ZERO_BASED: c_int = 1;
+pub const SCALATRIX_LABEL_LETTER: c_int = 2;
+pub const SCALATRIX_LABEL_LETTER_WITH_OCTAVE: c_int = 3;
+pub const SCALATRIX_LABEL_TUNING: c_int = 0x10;
+pub const SCALATRIX_LABEL_ACCIDENTAL_BEFORE: c_int = 0x20;
+
+/// JI bounds for `scalatrix_pitchset_bounded_ji`.
+pub const SCALATRIX_JI_NUM_DEN: c_int = 0;
+pub const SCALATRIX_JI_ODD_LIMIT: c_int = 1;
+pub const SCALATRIX_JI_TENNEY_HEIGHT: c_int = 2;
+
+/// Deviation of tempered pitches from the untempered ones, in cents.
+#[repr(C)]
+#[derive(Debug, Clone, Copy, Default)]
+pub struct scalatrix_tempering_stats {
+    pub max_cents: f64,
+    pub rms_cents: f64,
+    pub n_nodes: c_int,
+}
+
 extern "C" {
     // ── MOS lifecycle ──────────────────────────────────────────────
 
@@ -92,6 +192,11 @@ extern "C" {
     );
 
 
+    pub fn scalatrix_mos_adjust_g(
+        mos: *mut scalatrix_mos_t,
+        depth: c_int, mode: c_int, generator: f64, equave: f64, repetitions: c_int,
+    );
+
     pub fn scalatrix_mos_adjust_tuning_g(
         mos: *mut scalatrix_mos_t,
         depth: c_int, mode: c_int, generator: f64, equave: f64, repetitions: c_int,
@@ -135,6 +240,38 @@ extern "C" {
         base_freq: f64, n_nodes: c_int, root: c_int,
     ) -> *mut scalatrix_scale_t;
 
+    // ── In-place regeneration ──────────────────────────────────────
+
+    pub fn scalatrix_scale_new(n_nodes: c_int) -> *mut scalatrix_scale_t;
+
+    pub fn scalatrix_mos_generate_mapped_scale_into(
+        mos: *const scalatrix_mos_t, scale: *mut scalatrix_scale_t,
+        steps: c_int, offset: f64, base_freq: f64, n_nodes: c_int, root: c_int,
+    ) -> c_int;
+
+    pub fn scalatrix_mos_generate_scale_into(
+        mos: *mut scalatrix_mos_t, scale: *mut scalatrix_scale_t,
+        base_freq: f64, n_nodes: c_int, root: c_int,
+    ) -> c_int;
+
+    pub fn scalatrix_mos_adjust_params_into(
+        mos: *mut scalatrix_mos_t,
+        a: c_int, b: c_int, mode: c_int, equave: f64, generator: f64, repetitions: c_int,
+        mapping: *const scalatrix_mapping, scale: *mut scalatrix_scale_t,
+    ) -> c_int;
+
+    pub fn scalatrix_mos_adjust_g_into(
+        mos: *mut scalatrix_mos_t,
+        depth: c_int, mode: c_int, generator: f64, equave: f64, repetitions: c_int,
+        mapping: *const scalatrix_mapping, scale: *mut scalatrix_scale_t,
+    ) -> c_int;
+
+    pub fn scalatrix_mos_adjust_tuning_g_into(
+        mos: *mut scalatrix_mos_t,
+        depth: c_int, mode: c_int, generator: f64, equave: f64, repetitions: c_int,
+        mapping: *const scalatrix_mapping, scale: *mut scalatrix_scale_t,
+    ) -> c_int;
+
     // ── Scale access ───────────────────────────────────────────────
 
     pub fn scalatrix_scale_free(scale: *mut scalatrix_scale_t);
@@ -145,4 +282,173 @@ extern "C" {
     pub fn scalatrix_scale_get_node(
         scale: *const scalatrix_scale_t, index: c_int, out: *mut scalatrix_node,
     ) -> c_int;
+
+    pub fn scalatrix_scale_copy_nodes(
+        scale: *const scalatrix_scale_t, first: c_int, count: c_int, out: *mut scalatrix_node,
+    ) -> c_int;
+
+    pub fn scalatrix_scale_copy_columns(
+        scale: *const scalatrix_scale_t, first: c_int, count: c_int,
+        pitches: *mut f64,
+        natural_coords: *mut scalatrix_vec2i,
+        tuning_coords: *mut scalatrix_vec2d,
+    ) -> c_int;
+
+    // ── MOS families ───────────────────────────────────────────────
+
+    pub fn scalatrix_mos_family_default_options() -> scalatrix_mos_family_options;
+    pub fn scalatrix_mos_family_generate(
+        options: *const scalatrix_mos_family_options,
+    ) -> *mut scalatrix_mos_family_t;
+    pub fn scalatrix_mos_family_free(family: *mut scalatrix_mos_family_t);
+
+    pub fn scalatrix_mos_family_size(family: *const scalatrix_mos_family_t) -> c_int;
+    pub fn scalatrix_mos_family_n_nodes(family: *const scalatrix_mos_family_t) -> c_int;
+
+    pub fn scalatrix_mos_family_a(family: *const scalatrix_mos_family_t) -> *const c_int;
+    pub fn scalatrix_mos_family_b(family: *const scalatrix_mos_family_t) -> *const c_int;
+    pub fn scalatrix_mos_family_mode(family: *const scalatrix_mos_family_t) -> *const c_int;
+    pub fn scalatrix_mos_family_generator(family: *const scalatrix_mos_family_t) -> *const f64;
+    pub fn scalatrix_mos_family_L_fr(family: *const scalatrix_mos_family_t) -> *const f64;
+    pub fn scalatrix_mos_family_s_fr(family: *const scalatrix_mos_family_t) -> *const f64;
+    pub fn scalatrix_mos_family_coord_x(family: *const scalatrix_mos_family_t) -> *const c_int;
+    pub fn scalatrix_mos_family_coord_y(family: *const scalatrix_mos_family_t) -> *const c_int;
+    pub fn scalatrix_mos_family_tuning_x(family: *const scalatrix_mos_family_t) -> *const f64;
+    pub fn scalatrix_mos_family_tuning_y(family: *const scalatrix_mos_family_t) -> *const f64;
+    pub fn scalatrix_mos_family_pitch(family: *const scalatrix_mos_family_t) -> *const f64;
+
+    // ── Spectra ────────────────────────────────────────────────────
+
+    pub fn scalatrix_spectrum_new(
+        ratios: *const f64, amplitudes: *const f64, n: c_int,
+    ) -> *mut scalatrix_spectrum_t;
+    pub fn scalatrix_spectrum_harmonic(n_partials: c_int, decay: f64) -> *mut scalatrix_spectrum_t;
+    pub fn scalatrix_spectrum_odd_harmonic(max_harmonic: c_int, decay: f64) -> *mut scalatrix_spectrum_t;
+    pub fn scalatrix_spectrum_pseudoharmonic(
+        n_partials: c_int, decay: f64,
+        primes: *const c_int, cents: *const f64, n_primes: c_int,
+    ) -> *mut scalatrix_spectrum_t;
+    pub fn scalatrix_spectrum_free(spectrum: *mut scalatrix_spectrum_t);
+    pub fn scalatrix_spectrum_size(spectrum: *const scalatrix_spectrum_t) -> c_int;
+    pub fn scalatrix_spectrum_copy_partials(
+        spectrum: *const scalatrix_spectrum_t,
+        ratios: *mut f64, amplitudes: *mut f64, capacity: c_int,
+    ) -> c_int;
+
+    // ── Consonance ─────────────────────────────────────────────────
+
+    pub fn scalatrix_consonance_new(
+        spectrum: *const scalatrix_spectrum_t, f0: f64,
+        cents_min: f64, cents_max: f64, resolution: f64,
+    ) -> *mut scalatrix_consonance_t;
+    pub fn scalatrix_consonance_free(consonance: *mut scalatrix_consonance_t);
+    pub fn scalatrix_consonance_size(consonance: *const scalatrix_consonance_t) -> c_int;
+    pub fn scalatrix_consonance_compute(
+        consonance: *mut scalatrix_consonance_t, log_baseline: f64, gen3: c_int,
+        cents: *mut f64, pl: *mut f64, hull: *mut f64, spiky: *mut f64, consonance_out: *mut f64,
+        capacity: c_int, info: *mut scalatrix_consonance_info,
+    ) -> c_int;
+
+    pub fn scalatrix_analyze_scale(
+        spectrum: *const scalatrix_spectrum_t, f0: f64,
+        interval_cents: *const f64, n: c_int,
+        max_cents: f64, max_interval_cents: f64, log_baseline: f64,
+        consonance_out: *mut f64, mean_out: *mut f64,
+    ) -> c_int;
+
+    // ── Pitch sets ─────────────────────────────────────────────────
+
+    pub fn scalatrix_pitchset_et(
+        n_et: c_int, equave: f64, min_log2fr: f64, max_log2fr: f64,
+    ) -> *mut scalatrix_pitchset_t;
+    pub fn scalatrix_pitchset_ji(
+        n_primes: c_int, max_numtimesden: c_int, min_log2fr: f64, max_log2fr: f64,
+    ) -> *mut scalatrix_pitchset_t;
+    pub fn scalatrix_pitchset_bounded_ji(
+        n_primes: c_int, bound_kind: c_int, limit: c_longlong, min_log2fr: f64, max_log2fr: f64,
+    ) -> *mut scalatrix_pitchset_t;
+    pub fn scalatrix_pitchset_harmonic_series(
+        n_primes: c_int, base: c_int, min_log2fr: f64, max_log2fr: f64,
+    ) -> *mut scalatrix_pitchset_t;
+    pub fn scalatrix_pitchset_new(
+        log2fr: *const f64, labels: *const *const c_char, n: c_int,
+    ) -> *mut scalatrix_pitchset_t;
+    pub fn scalatrix_pitchset_free(pitchset: *mut scalatrix_pitchset_t);
+    pub fn scalatrix_pitchset_size(pitchset: *const scalatrix_pitchset_t) -> c_int;
+    pub fn scalatrix_pitchset_copy_log2fr(
+        pitchset: *const scalatrix_pitchset_t, out: *mut f64, capacity: c_int,
+    ) -> c_int;
+    pub fn scalatrix_pitchset_label(
+        pitchset: *const scalatrix_pitchset_t, index: c_int, buf: *mut c_char, size: c_int,
+    ) -> c_int;
+    pub fn scalatrix_pitchset_closest(pitchset: *const scalatrix_pitchset_t, log2fr: f64) -> c_int;
+
+    // ── Tempering ──────────────────────────────────────────────────
+
+    pub fn scalatrix_scale_temper(
+        scale: *mut scalatrix_scale_t, pitchset: *const scalatrix_pitchset_t,
+        stats: *mut scalatrix_tempering_stats,
+    );
+    pub fn scalatrix_scale_copy_tempering(
+        scale: *const scalatrix_scale_t, first: c_int, count: c_int,
+        is_tempered: *mut c_int, tempered_log2fr: *mut f64,
+    ) -> c_int;
+    pub fn scalatrix_scale_tempered_label(
+        scale: *const scalatrix_scale_t, index: c_int, buf: *mut c_char, size: c_int,
+    ) -> c_int;
+
+    // ── Snapshots ──────────────────────────────────────────────────
+
+    pub fn scalatrix_snapshot_size(n_records: c_int, flags: c_int) -> c_int;
+    pub fn scalatrix_snapshot_write(
+        mos: *const scalatrix_mos_t, scale: *const scalatrix_scale_t,
+        previous: *const scalatrix_scale_t, seq: c_uint, base_seq: c_uint,
+        float32: c_int, out: *mut c_uchar, capacity: c_int,
+    ) -> c_int;
+    pub fn scalatrix_snapshot_apply(
+        data: *const c_uchar, size: c_int, scale: *mut scalatrix_scale_t,
+    ) -> c_int;
+
+    // ── Shared tuning tables ───────────────────────────────────────
+
+    pub fn scalatrix_shared_publisher_open(
+        name: *const c_char, max_nodes: c_int, float32: c_int,
+    ) -> *mut scalatrix_shared_publisher_t;
+    pub fn scalatrix_shared_publisher_close(publisher: *mut scalatrix_shared_publisher_t);
+    pub fn scalatrix_shared_publisher_publish(
+        publisher: *mut scalatrix_shared_publisher_t,
+        mos: *const scalatrix_mos_t, scale: *const scalatrix_scale_t,
+    ) -> c_longlong;
+    pub fn scalatrix_shared_unlink(name: *const c_char) -> c_int;
+    pub fn scalatrix_shared_reader_open(name: *const c_char) -> *mut scalatrix_shared_reader_t;
+    pub fn scalatrix_shared_reader_close(reader: *mut scalatrix_shared_reader_t);
+    pub fn scalatrix_shared_reader_has_update(reader: *const scalatrix_shared_reader_t) -> c_int;
+    pub fn scalatrix_shared_reader_read(reader: *mut scalatrix_shared_reader_t) -> c_int;
+    pub fn scalatrix_shared_reader_sequence(reader: *const scalatrix_shared_reader_t) -> c_uint;
+    pub fn scalatrix_shared_reader_data(
+        reader: *const scalatrix_shared_reader_t, size: *mut c_int,
+    ) -> *const c_uchar;
+    pub fn scalatrix_shared_reader_apply(
+        reader: *const scalatrix_shared_reader_t, scale: *mut scalatrix_scale_t,
+    ) -> c_int;
+
+    // ── Label batches ──────────────────────────────────────────────
+
+    pub fn scalatrix_labels_new() -> *mut scalatrix_labels_t;
+    pub fn scalatrix_labels_free(labels: *mut scalatrix_labels_t);
+    pub fn scalatrix_labels_rect(
+        labels: *mut scalatrix_labels_t, mos: *const scalatrix_mos_t,
+        x: c_int, y: c_int, width: c_int, height: c_int, style: c_int, middle_c_octave: c_int,
+    ) -> c_int;
+    pub fn scalatrix_labels_coords(
+        labels: *mut scalatrix_labels_t, mos: *const scalatrix_mos_t,
+        coords: *const scalatrix_vec2i, count: c_int, style: c_int, middle_c_octave: c_int,
+    ) -> c_int;
+    pub fn scalatrix_labels_deviation(
+        labels: *mut scalatrix_labels_t, scale: *const scalatrix_scale_t, first: c_int, count: c_int,
+        threshold_cents: f64, compare_with_tempered: c_int,
+    ) -> c_int;
+    pub fn scalatrix_labels_count(labels: *const scalatrix_labels_t) -> c_int;
+    pub fn scalatrix_labels_text(labels: *const scalatrix_labels_t, size: *mut c_int) -> *const c_char;
+    pub fn scalatrix_labels_offsets(labels: *const scalatrix_labels_t) -> *const c_uint;
 }
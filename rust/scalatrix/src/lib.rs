@@ -23,7 +23,10 @@
 
 use scalatrix_sys as ffi;
 
+pub mod snapshot;
+
 /// Integer 2D vector representing lattice coordinates.
+#[repr(C)]
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub struct Vec2i {
     pub x: i32,
@@ -49,6 +52,7 @@ impl From<Vec2i> for ffi::scalatrix_vec2i {
 }
 
 /// Double-precision 2D vector.
+#[repr(C)]
 #[derive(Debug, Clone, Copy)]
 pub struct Vec2d {
     pub x: f64,
@@ -62,6 +66,7 @@ impl From<ffi::scalatrix_vec2d> for Vec2d {
 }
 
 /// A scale node: lattice coordinate + tuning coordinate + pitch.
+#[repr(C)]
 #[derive(Debug, Clone, Copy)]
 pub struct Node {
     /// Integer coordinates in the scale's natural 2D lattice.
@@ -72,6 +77,43 @@ pub struct Node {
     pub pitch: f64,
 }
 
+// The bulk readouts below write C structs straight into these types.
+const _: () = {
+    use std::mem::{align_of, size_of};
+    assert!(size_of::<Vec2i>() == size_of::<ffi::scalatrix_vec2i>());
+    assert!(size_of::<Vec2d>() == size_of::<ffi::scalatrix_vec2d>());
+    assert!(size_of::<Node>() == size_of::<ffi::scalatrix_node>());
+    assert!(align_of::<Node>() == align_of::<ffi::scalatrix_node>());
+};
+
+/// Arguments of [`Mos::generate_mapped_scale`], bound to a scale by the
+/// `_into` updates.
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub struct Mapping {
+    /// Number of EDO steps (e.g. 12 for 12-TET mapping).
+    pub steps: i32,
+    /// Mode offset within the mapping.
+    pub offset: f64,
+    /// Frequency of the root node in Hz.
+    pub base_freq: f64,
+    /// Total number of scale nodes (typically 128 for MIDI).
+    pub n_nodes: i32,
+    /// Index of the root node (typically 60 for middle C).
+    pub root: i32,
+}
+
+impl From<&Mapping> for ffi::scalatrix_mapping {
+    fn from(m: &Mapping) -> Self {
+        ffi::scalatrix_mapping {
+            steps: m.steps,
+            offset: m.offset,
+            base_freq: m.base_freq,
+            n_nodes: m.n_nodes,
+            root: m.root,
+        }
+    }
+}
+
 /// Moment of Symmetry scale system.
 ///
 /// Defines a generalized diatonic scale on a 2D lattice, parameterized by:
@@ -177,6 +219,12 @@ impl Mos {
     }
 
 
+    /// Change structure and tuning by walking the coprime tree to `depth`
+    /// with `generator`, as [`Mos::from_g`].
+    pub fn adjust_g(&mut self, depth: i32, mode: i32, generator: f64, equave: f64, repetitions: i32) {
+        unsafe { ffi::scalatrix_mos_adjust_g(self.ptr, depth, mode, generator, equave, repetitions) }
+    }
+
     /// Like `adjust_g`, but only changes the tuning generator.
     /// The structure generator stays frozen, so the Stern-Brocot tree walk
     /// uses the original generator to determine (a, b).
@@ -229,6 +277,8 @@ impl Mos {
     /// - `base_freq`: frequency of the root note in Hz
     /// - `n_nodes`: total number of scale nodes (typically 128 for MIDI)
     /// - `root`: index of the root node (typically 60 for middle C)
+    ///
+    /// Panics unless `0 <= root < n_nodes`.
     pub fn generate_mapped_scale(&self, steps: i32, offset: f64, base_freq: f64, n_nodes: i32, root: i32) -> Scale {
         let ptr = unsafe {
             ffi::scalatrix_mos_generate_mapped_scale(self.ptr, steps, offset, base_freq, n_nodes, root)
@@ -238,6 +288,8 @@ impl Mos {
     }
 
     /// Generate a scale directly from MOS structure.
+    ///
+    /// Panics unless `0 <= root < n_nodes`.
     pub fn generate_scale(&mut self, base_freq: f64, n_nodes: i32, root: i32) -> Scale {
         let ptr = unsafe {
             ffi::scalatrix_mos_generate_scale(self.ptr, base_freq, n_nodes, root)
@@ -245,6 +297,88 @@ impl Mos {
         assert!(!ptr.is_null(), "scalatrix_mos_generate_scale returned null");
         Scale { ptr }
     }
+
+    // ── In-place regeneration ──────────────────────────────────────
+    //
+    // These reuse the storage of an existing scale. Once it has held
+    // `n_nodes` nodes, and with the pattern size unchanged, they do not
+    // allocate. Each returns false, leaving `scale` untouched, unless
+    // `0 <= root < n_nodes`; the `adjust_*` ones then leave the MOS
+    // untouched too.
+
+    /// [`Mos::generate_mapped_scale`] into an existing scale.
+    pub fn generate_mapped_scale_into(&self, scale: &mut Scale, mapping: &Mapping) -> bool {
+        unsafe {
+            ffi::scalatrix_mos_generate_mapped_scale_into(
+                self.ptr, scale.ptr,
+                mapping.steps, mapping.offset, mapping.base_freq, mapping.n_nodes, mapping.root) == 0
+        }
+    }
+
+    /// [`Mos::generate_scale`] into an existing scale.
+    pub fn generate_scale_into(&mut self, scale: &mut Scale, base_freq: f64, n_nodes: i32, root: i32) -> bool {
+        unsafe { ffi::scalatrix_mos_generate_scale_into(self.ptr, scale.ptr, base_freq, n_nodes, root) == 0 }
+    }
+
+    /// [`Mos::adjust_params`], then regenerate `scale` with `mapping`.
+    ///
+    /// ```rust
+    /// use scalatrix::{Mapping, Mos, Scale};
+    ///
+    /// let mapping = Mapping { steps: 12, offset: 0.0, base_freq: 261.63, n_nodes: 128, root: 60 };
+    /// let mut mos = Mos::from_params(5, 2, 1, 1.0, 0.58, 1);
+    /// let mut scale = Scale::new(mapping.n_nodes);
+    /// let mut nodes = Vec::new();
+    /// for step in 0..10 {
+    ///     let g = 0.57 + 0.002 * step as f64;
+    ///     assert!(mos.adjust_params_into(5, 2, 1, 1.0, g, 1, &mapping, &mut scale));
+    ///     scale.nodes_into(&mut nodes);
+    /// }
+    /// assert_eq!(nodes.len(), 128);
+    /// assert_eq!(nodes[60].pitch, mos.generate_mapped_scale(12, 0.0, 261.63, 128, 60).nodes()[60].pitch);
+    ///
+    /// // A root outside the nodes leaves the scale as it was
+    /// let outside = Mapping { root: 128, ..mapping };
+    /// assert!(!mos.adjust_params_into(5, 2, 1, 1.0, 0.5, 1, &outside, &mut scale));
+    /// assert_eq!(scale.root_idx(), 60);
+    /// ```
+    #[allow(clippy::too_many_arguments)]
+    pub fn adjust_params_into(
+        &mut self, a: i32, b: i32, mode: i32, equave: f64, generator: f64, repetitions: i32,
+        mapping: &Mapping, scale: &mut Scale,
+    ) -> bool {
+        let m = ffi::scalatrix_mapping::from(mapping);
+        unsafe {
+            ffi::scalatrix_mos_adjust_params_into(
+                self.ptr, a, b, mode, equave, generator, repetitions, &m, scale.ptr) == 0
+        }
+    }
+
+    /// [`Mos::adjust_g`], then regenerate `scale` with `mapping`.
+    #[allow(clippy::too_many_arguments)]
+    pub fn adjust_g_into(
+        &mut self, depth: i32, mode: i32, generator: f64, equave: f64, repetitions: i32,
+        mapping: &Mapping, scale: &mut Scale,
+    ) -> bool {
+        let m = ffi::scalatrix_mapping::from(mapping);
+        unsafe {
+            ffi::scalatrix_mos_adjust_g_into(
+                self.ptr, depth, mode, generator, equave, repetitions, &m, scale.ptr) == 0
+        }
+    }
+
+    /// [`Mos::adjust_tuning_g`], then regenerate `scale` with `mapping`.
+    #[allow(clippy::too_many_arguments)]
+    pub fn adjust_tuning_g_into(
+        &mut self, depth: i32, mode: i32, generator: f64, equave: f64, repetitions: i32,
+        mapping: &Mapping, scale: &mut Scale,
+    ) -> bool {
+        let m = ffi::scalatrix_mapping::from(mapping);
+        unsafe {
+            ffi::scalatrix_mos_adjust_tuning_g_into(
+                self.ptr, depth, mode, generator, equave, repetitions, &m, scale.ptr) == 0
+        }
+    }
 }
 
 impl std::fmt::Debug for Mos {
@@ -280,6 +414,14 @@ impl Drop for Scale {
 }
 
 impl Scale {
+    /// A scale of `n_nodes` blank nodes, to regenerate into with the
+    /// `Mos::*_into` methods.
+    pub fn new(n_nodes: i32) -> Self {
+        let ptr = unsafe { ffi::scalatrix_scale_new(n_nodes) };
+        assert!(!ptr.is_null(), "scalatrix_scale_new returned null");
+        Self { ptr }
+    }
+
     /// Number of nodes in the scale.
     pub fn len(&self) -> usize {
         unsafe { ffi::scalatrix_scale_node_count(self.ptr) as usize }
@@ -318,9 +460,72 @@ impl Scale {
         })
     }
 
-    /// Collect all nodes into a Vec.
+    /// Collect all nodes into a Vec, in a single copy.
+    ///
+    /// ```rust
+    /// use scalatrix::Mos;
+    ///
+    /// let mos = Mos::from_params(5, 2, 1, 1.0, 0.583333, 1);
+    /// let scale = mos.generate_mapped_scale(12, 0.0, 261.63, 128, 60);
+    /// let nodes = scale.nodes();
+    /// assert_eq!(nodes.len(), 128);
+    /// assert_eq!(nodes[60].natural_coord, scale.node(60).unwrap().natural_coord);
+    /// assert_eq!(scale.pitches()[60], nodes[60].pitch);
+    /// ```
     pub fn nodes(&self) -> Vec<Node> {
-        (0..self.len()).filter_map(|i| self.node(i)).collect()
+        let mut out = Vec::new();
+        self.nodes_into(&mut out);
+        out
+    }
+
+    /// Like [`Scale::nodes`], into an existing Vec, which only allocates if
+    /// it has to grow.
+    pub fn nodes_into(&self, out: &mut Vec<Node>) {
+        let n = self.len();
+        out.clear();
+        out.reserve(n);
+        // SAFETY: Node has the layout of scalatrix_node (checked above), the
+        // buffer holds n of them, and only the copied prefix is exposed.
+        unsafe {
+            let copied = ffi::scalatrix_scale_copy_nodes(
+                self.ptr, 0, n as i32, out.as_mut_ptr() as *mut ffi::scalatrix_node);
+            out.set_len(copied.max(0) as usize);
+        }
+    }
+
+    /// Pitch of every node in Hz.
+    pub fn pitches(&self) -> Vec<f64> {
+        let mut out = vec![0.0; self.len()];
+        unsafe {
+            ffi::scalatrix_scale_copy_columns(
+                self.ptr, 0, out.len() as i32,
+                out.as_mut_ptr(), std::ptr::null_mut(), std::ptr::null_mut());
+        }
+        out
+    }
+
+    /// Natural coordinate of every node.
+    pub fn natural_coords(&self) -> Vec<Vec2i> {
+        let mut out = vec![Vec2i::new(0, 0); self.len()];
+        unsafe {
+            ffi::scalatrix_scale_copy_columns(
+                self.ptr, 0, out.len() as i32,
+                std::ptr::null_mut(), out.as_mut_ptr() as *mut ffi::scalatrix_vec2i,
+                std::ptr::null_mut());
+        }
+        out
+    }
+
+    /// Tuning coordinate of every node.
+    pub fn tuning_coords(&self) -> Vec<Vec2d> {
+        let mut out = vec![Vec2d { x: 0.0, y: 0.0 }; self.len()];
+        unsafe {
+            ffi::scalatrix_scale_copy_columns(
+                self.ptr, 0, out.len() as i32,
+                std::ptr::null_mut(), std::ptr::null_mut(),
+                out.as_mut_ptr() as *mut ffi::scalatrix_vec2d);
+        }
+        out
     }
 
     /// Build a lookup table from natural coordinate to scale index.
@@ -328,12 +533,41 @@ impl Scale {
     /// This is the primary data structure downstream apps need for
     /// mapping controller coordinates to MIDI note numbers.
     pub fn coord_to_index(&self) -> std::collections::HashMap<(i32, i32), usize> {
-        let mut map = std::collections::HashMap::new();
-        for (i, node) in self.nodes().iter().enumerate() {
-            map.insert((node.natural_coord.x, node.natural_coord.y), i);
+        let coords = self.natural_coords();
+        let mut map = std::collections::HashMap::with_capacity(coords.len());
+        for (i, v) in coords.iter().enumerate() {
+            map.insert((v.x, v.y), i);
         }
         map
     }
+
+    /// Write the scale, generated from `mos`, to `out` as snapshot `seq` in
+    /// the format of [`snapshot`]. With `previous`, write a delta against
+    /// it (snapshot `base_seq`) if that is smaller. `out` is resized to
+    /// the snapshot, reusing its capacity.
+    #[allow(clippy::too_many_arguments)]
+    pub fn write_snapshot(
+        &self, mos: &Mos, previous: Option<&Scale>, seq: u32, base_seq: u32, float32: bool,
+        out: &mut Vec<u8>,
+    ) {
+        let flags = if float32 { snapshot::FLOAT32 } else { 0 } as i32;
+        let size = unsafe { ffi::scalatrix_snapshot_size(self.len() as i32, flags) };
+        out.resize(size.max(0) as usize, 0);
+        let written = unsafe {
+            ffi::scalatrix_snapshot_write(
+                mos.ptr, self.ptr, previous.map_or(std::ptr::null(), |p| p.ptr as *const _),
+                seq, base_seq, float32 as i32, out.as_mut_ptr(), out.len() as i32)
+        };
+        assert!(written >= 0, "scalatrix_snapshot_write failed");
+        out.truncate(written as usize);
+    }
+
+    /// Write the nodes of a snapshot into the scale: a full snapshot
+    /// replaces it, a delta updates it. Returns false if `data` is not a
+    /// valid snapshot or a delta does not fit the scale.
+    pub fn apply_snapshot(&mut self, data: &[u8]) -> bool {
+        unsafe { ffi::scalatrix_snapshot_apply(data.as_ptr(), data.len() as i32, self.ptr) == 0 }
+    }
 }
 
 impl std::fmt::Debug for Scale {
@@ -345,3 +579,169 @@ impl std::fmt::Debug for Scale {
             .finish()
     }
 }
+
+/// Options for [`MosFamily::generate`].
+#[derive(Debug, Clone, Copy)]
+pub struct MosFamilyOptions {
+    /// Smallest a + b to generate.
+    pub min_size: i32,
+    /// Largest a + b to generate.
+    pub max_size: i32,
+    /// Generators across each pattern's range.
+    pub g_steps: i32,
+    /// log2 frequency ratio of the equave.
+    pub equave: f64,
+    /// Mapping steps of each member's scale; 0 maps each member onto its own size.
+    pub steps: i32,
+    /// Mode offset within the mapping.
+    pub offset: f64,
+    /// Frequency of the root node in Hz.
+    pub base_freq: f64,
+    /// Nodes of each member's mapped scale; 0 skips the nodes.
+    pub n_nodes: i32,
+    /// Index of the root node.
+    pub root: i32,
+    /// Worker threads; 0 uses one per core.
+    pub n_threads: i32,
+}
+
+impl Default for MosFamilyOptions {
+    fn default() -> Self {
+        let o = unsafe { ffi::scalatrix_mos_family_default_options() };
+        Self {
+            min_size: o.min_size,
+            max_size: o.max_size,
+            g_steps: o.g_steps,
+            equave: o.equave,
+            steps: o.steps,
+            offset: o.offset,
+            base_freq: o.base_freq,
+            n_nodes: o.n_nodes,
+            root: o.root,
+            n_threads: o.n_threads,
+        }
+    }
+}
+
+/// Every MOS pattern (a, b, mode) in a size range, at a grid of generators,
+/// with their mapped scales, generated in parallel.
+///
+/// Data is stored column by column. Member `i` is described by entry `i` of
+/// the member columns, and its nodes are entries
+/// `i * n_nodes() .. (i + 1) * n_nodes()` of the node columns.
+///
+/// ```rust
+/// use scalatrix::{MosFamily, MosFamilyOptions};
+///
+/// let options = MosFamilyOptions { max_size: 7, n_nodes: 16, root: 8, ..Default::default() };
+/// let family = MosFamily::generate(&options);
+/// for i in 0..family.len() {
+///     let pitches = family.member_pitches(i);
+///     assert_eq!(pitches.len(), 16);
+/// }
+/// ```
+pub struct MosFamily {
+    ptr: *mut ffi::scalatrix_mos_family_t,
+}
+
+// SAFETY: The family is not modified after generation.
+unsafe impl Send for MosFamily {}
+unsafe impl Sync for MosFamily {}
+
+impl Drop for MosFamily {
+    fn drop(&mut self) {
+        unsafe { ffi::scalatrix_mos_family_free(self.ptr) }
+    }
+}
+
+impl MosFamily {
+    /// Generate the family described by `options`; empty if `n_nodes > 0`
+    /// and `root` lies outside `0..n_nodes`.
+    pub fn generate(options: &MosFamilyOptions) -> Self {
+        let raw = ffi::scalatrix_mos_family_options {
+            min_size: options.min_size,
+            max_size: options.max_size,
+            g_steps: options.g_steps,
+            equave: options.equave,
+            steps: options.steps,
+            offset: options.offset,
+            base_freq: options.base_freq,
+            n_nodes: options.n_nodes,
+            root: options.root,
+            n_threads: options.n_threads,
+        };
+        let ptr = unsafe { ffi::scalatrix_mos_family_generate(&raw) };
+        assert!(!ptr.is_null(), "scalatrix_mos_family_generate returned null");
+        Self { ptr }
+    }
+
+    /// Number of members.
+    pub fn len(&self) -> usize {
+        unsafe { ffi::scalatrix_mos_family_size(self.ptr) as usize }
+    }
+
+    /// Whether the family has no members.
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Nodes per member.
+    pub fn n_nodes(&self) -> usize {
+        unsafe { ffi::scalatrix_mos_family_n_nodes(self.ptr) as usize }
+    }
+
+    fn column<T>(&self, data: *const T, len: usize) -> &[T] {
+        if len == 0 {
+            return &[];
+        }
+        // SAFETY: the column holds len entries and lives as long as self
+        unsafe { std::slice::from_raw_parts(data, len) }
+    }
+
+    fn member_column<T>(&self, data: *const T) -> &[T] {
+        self.column(data, self.len())
+    }
+
+    fn node_column<T>(&self, data: *const T) -> &[T] {
+        self.column(data, self.len() * self.n_nodes())
+    }
+
+    /// Number of intervals of type A, per member.
+    pub fn a(&self) -> &[i32] { self.member_column(unsafe { ffi::scalatrix_mos_family_a(self.ptr) }) }
+    /// Number of intervals of type B, per member.
+    pub fn b(&self) -> &[i32] { self.member_column(unsafe { ffi::scalatrix_mos_family_b(self.ptr) }) }
+    /// Mode index, per member.
+    pub fn mode(&self) -> &[i32] { self.member_column(unsafe { ffi::scalatrix_mos_family_mode(self.ptr) }) }
+    /// Generator as fraction of period, per member.
+    pub fn generator(&self) -> &[f64] { self.member_column(unsafe { ffi::scalatrix_mos_family_generator(self.ptr) }) }
+    /// log2 frequency ratio of the large interval, per member.
+    pub fn large_step_ratio(&self) -> &[f64] { self.member_column(unsafe { ffi::scalatrix_mos_family_L_fr(self.ptr) }) }
+    /// log2 frequency ratio of the small interval, per member.
+    pub fn small_step_ratio(&self) -> &[f64] { self.member_column(unsafe { ffi::scalatrix_mos_family_s_fr(self.ptr) }) }
+
+    /// Natural x coordinate of every node.
+    pub fn coord_x(&self) -> &[i32] { self.node_column(unsafe { ffi::scalatrix_mos_family_coord_x(self.ptr) }) }
+    /// Natural y coordinate of every node.
+    pub fn coord_y(&self) -> &[i32] { self.node_column(unsafe { ffi::scalatrix_mos_family_coord_y(self.ptr) }) }
+    /// Tuning x coordinate (log2 frequency ratio) of every node.
+    pub fn tuning_x(&self) -> &[f64] { self.node_column(unsafe { ffi::scalatrix_mos_family_tuning_x(self.ptr) }) }
+    /// Tuning y coordinate of every node.
+    pub fn tuning_y(&self) -> &[f64] { self.node_column(unsafe { ffi::scalatrix_mos_family_tuning_y(self.ptr) }) }
+    /// Frequency in Hz of every node.
+    pub fn pitch(&self) -> &[f64] { self.node_column(unsafe { ffi::scalatrix_mos_family_pitch(self.ptr) }) }
+
+    /// Frequencies in Hz of the nodes of member `i`.
+    pub fn member_pitches(&self, i: usize) -> &[f64] {
+        let n = self.n_nodes();
+        &self.pitch()[i * n..(i + 1) * n]
+    }
+}
+
+impl std::fmt::Debug for MosFamily {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        f.debug_struct("MosFamily")
+            .field("len", &self.len())
+            .field("n_nodes", &self.n_nodes())
+            .finish()
+    }
+}
@@ -0,0 +1,392 @@
+//! Zero-copy reader for the binary tuning snapshots written by
+//! [`Scale::write_snapshot`](crate::Scale::write_snapshot).
+//!
+//! The format is specified in `include/scalatrix/snapshot.hpp`: a fixed
+//! little-endian header followed by one array per node field. A
+//! [`SnapshotView`] checks the header and sizes once and then decodes
+//! single values straight from the borrowed bytes, so it works on a
+//! datagram or shared-memory page without copying it.
+//!
+//! ```rust
+//! use scalatrix::{Mos, Scale};
+//! use scalatrix::snapshot::SnapshotView;
+//!
+//! let mos = Mos::from_params(5, 2, 1, 1.0, 0.583333, 1);
+//! let scale = mos.generate_mapped_scale(12, 0.0, 261.63, 128, 60);
+//! let mut bytes = Vec::new();
+//! scale.write_snapshot(&mos, None, 1, 0, true, &mut bytes);
+//!
+//! let view = SnapshotView::parse(&bytes).unwrap();
+//! assert_eq!(view.header().seq, 1);
+//! assert_eq!(view.len(), 128);
+//! assert_eq!(view.natural_coord(60), scale.node(60).unwrap().natural_coord);
+//! assert_eq!(view.pitch(60), scale.node(60).unwrap().pitch as f32 as f64);
+//! ```
+
+use crate::{Mos, Node, Vec2d, Vec2i};
+
+/// `"SXSN"` read as a little-endian u32.
+pub const MAGIC: u32 = 0x4E53_5853;
+/// The format version this reader understands.
+pub const VERSION: u16 = 1;
+/// Size of the version 1 header; later versions may have a larger one.
+pub const HEADER_SIZE: usize = 80;
+/// Tuning coordinates and pitches are f32 rather than f64.
+pub const FLOAT32: u16 = 1;
+/// Records only for the nodes changed since snapshot `base_seq`.
+pub const DELTA: u16 = 2;
+
+/// The header fields of a snapshot.
+#[derive(Debug, Clone, Copy, PartialEq, Default)]
+pub struct Header {
+    pub version: u16,
+    pub flags: u16,
+    pub seq: u32,
+    /// The snapshot a delta applies to; 0 for a full snapshot.
+    pub base_seq: u32,
+    /// Nodes in the scale.
+    pub node_count: u32,
+    /// Nodes in this snapshot: all of them, or the changed ones of a delta.
+    pub record_count: u32,
+    pub root: i32,
+    pub a: i32,
+    pub b: i32,
+    pub mode: i32,
+    pub repetitions: i32,
+    pub depth: i32,
+    pub base_freq: f64,
+    pub equave: f64,
+    pub generator: f64,
+}
+
+/// Why [`SnapshotView::parse`] rejected a buffer.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Error {
+    /// Shorter than the header or the arrays it describes.
+    Truncated,
+    /// Does not start with [`MAGIC`].
+    BadMagic,
+    /// A version other than [`VERSION`].
+    Version(u16),
+    /// Counts or indices that do not fit together.
+    Inconsistent,
+}
+
+impl std::fmt::Display for Error {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            Error::Truncated => write!(f, "snapshot truncated"),
+            Error::BadMagic => write!(f, "not a scalatrix snapshot"),
+            Error::Version(v) => write!(f, "unsupported snapshot version {v}"),
+            Error::Inconsistent => write!(f, "inconsistent snapshot header"),
+        }
+    }
+}
+
+impl std::error::Error for Error {}
+
+fn pad8(n: usize) -> usize {
+    (n + 7) & !7
+}
+
+fn u16_at(data: &[u8], at: usize) -> u16 {
+    u16::from_le_bytes([data[at], data[at + 1]])
+}
+
+fn u32_at(data: &[u8], at: usize) -> u32 {
+    u32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
+fn i32_at(data: &[u8], at: usize) -> i32 {
+    i32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
+fn f32_at(data: &[u8], at: usize) -> f32 {
+    f32::from_le_bytes(data[at..at + 4].try_into().unwrap())
+}
+
+fn f64_at(data: &[u8], at: usize) -> f64 {
+    f64::from_le_bytes(data[at..at + 8].try_into().unwrap())
+}
+
+fn gcd(mut a: i32, mut b: i32) -> i32 {
+    while b != 0 {
+        (a, b) = (b, a % b);
+    }
+    a
+}
+
+fn mos_fields_valid(h: &Header) -> bool {
+    h.a > 0
+        && h.b > 0
+        && h.a.checked_add(h.b).is_some_and(|n| (0..n).contains(&h.mode))
+        && h.repetitions == gcd(h.a, h.b)
+        && (0.0..=1.0).contains(&h.generator)
+        && h.equave.is_finite()
+        && h.equave > 0.0
+}
+
+/// A snapshot read in place from a byte slice.
+#[derive(Debug, Clone, Copy)]
+pub struct SnapshotView<'a> {
+    data: &'a [u8],
+    header: Header,
+    index: usize,
+    natural_x: usize,
+    natural_y: usize,
+    tuning_x: usize,
+    tuning_y: usize,
+    pitch: usize,
+}
+
+impl<'a> SnapshotView<'a> {
+    /// Check the header and that `data` holds every array it describes.
+    /// Bytes past the snapshot are ignored.
+    pub fn parse(data: &'a [u8]) -> Result<Self, Error> {
+        if data.len() < HEADER_SIZE {
+            return Err(Error::Truncated);
+        }
+        if u32_at(data, 0) != MAGIC {
+            return Err(Error::BadMagic);
+        }
+        let version = u16_at(data, 4);
+        if version != VERSION {
+            return Err(Error::Version(version));
+        }
+        let header_size = u32_at(data, 8) as usize;
+        if header_size < HEADER_SIZE || header_size > data.len() {
+            return Err(Error::Truncated);
+        }
+        let header = Header {
+            version,
+            flags: u16_at(data, 6),
+            seq: u32_at(data, 12),
+            base_seq: u32_at(data, 16),
+            node_count: u32_at(data, 20),
+            record_count: u32_at(data, 24),
+            root: i32_at(data, 28),
+            a: i32_at(data, 32),
+            b: i32_at(data, 36),
+            mode: i32_at(data, 40),
+            repetitions: i32_at(data, 44),
+            depth: i32_at(data, 48),
+            base_freq: f64_at(data, 56),
+            equave: f64_at(data, 64),
+            generator: f64_at(data, 72),
+        };
+        // mos() builds a MOS from these, which aborts on values no MOS has
+        if !mos_fields_valid(&header) {
+            return Err(Error::Inconsistent);
+        }
+        // As in the C++ parser: a root outside the nodes names no node
+        if !u32::try_from(header.root).is_ok_and(|root| root < header.node_count) {
+            return Err(Error::Inconsistent);
+        }
+        let delta = header.flags & DELTA != 0;
+        if header.record_count > header.node_count || (!delta && header.record_count != header.node_count) {
+            return Err(Error::Inconsistent);
+        }
+        let n = header.record_count as usize;
+        if n > (data.len() - header_size) / 4 {
+            return Err(Error::Truncated);
+        }
+        let ints = pad8(4 * n);
+        let reals = pad8(if header.flags & FLOAT32 != 0 { 4 } else { 8 } * n);
+        let index = header_size;
+        let natural_x = index + if delta { ints } else { 0 };
+        let natural_y = natural_x + ints;
+        let tuning_x = natural_y + ints;
+        let tuning_y = tuning_x + reals;
+        let pitch = tuning_y + reals;
+        if pitch + reals > data.len() {
+            return Err(Error::Truncated);
+        }
+        let data = &data[..pitch + reals];
+        if delta && (0..n).any(|i| u32_at(data, index + 4 * i) >= header.node_count) {
+            return Err(Error::Inconsistent);
+        }
+        Ok(Self { data, header, index, natural_x, natural_y, tuning_x, tuning_y, pitch })
+    }
+
+    pub fn header(&self) -> &Header {
+        &self.header
+    }
+
+    pub fn is_delta(&self) -> bool {
+        self.header.flags & DELTA != 0
+    }
+
+    pub fn is_float32(&self) -> bool {
+        self.header.flags & FLOAT32 != 0
+    }
+
+    /// The bytes the snapshot takes, a prefix of the slice parsed.
+    pub fn as_bytes(&self) -> &'a [u8] {
+        self.data
+    }
+
+    /// Number of records.
+    pub fn len(&self) -> usize {
+        self.header.record_count as usize
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Scale index of record `i`.
+    pub fn index(&self, i: usize) -> usize {
+        assert!(i < self.len());
+        if self.is_delta() { u32_at(self.data, self.index + 4 * i) as usize } else { i }
+    }
+
+    pub fn natural_coord(&self, i: usize) -> Vec2i {
+        assert!(i < self.len());
+        Vec2i::new(i32_at(self.data, self.natural_x + 4 * i), i32_at(self.data, self.natural_y + 4 * i))
+    }
+
+    fn real(&self, offset: usize, i: usize) -> f64 {
+        assert!(i < self.len());
+        if self.is_float32() {
+            f32_at(self.data, offset + 4 * i) as f64
+        } else {
+            f64_at(self.data, offset + 8 * i)
+        }
+    }
+
+    pub fn tuning_coord(&self, i: usize) -> Vec2d {
+        Vec2d { x: self.real(self.tuning_x, i), y: self.real(self.tuning_y, i) }
+    }
+
+    /// Frequency of record `i` in Hz.
+    pub fn pitch(&self, i: usize) -> f64 {
+        self.real(self.pitch, i)
+    }
+
+    pub fn node(&self, i: usize) -> Node {
+        Node { natural_coord: self.natural_coord(i), tuning_coord: self.tuning_coord(i), pitch: self.pitch(i) }
+    }
+
+    /// Every record as its scale index and node.
+    pub fn records(&self) -> impl Iterator<Item = (usize, Node)> + '_ {
+        (0..self.len()).map(move |i| (self.index(i), self.node(i)))
+    }
+
+    /// Write the records into `nodes`. A full snapshot replaces them; a
+    /// delta needs `nodes` to hold snapshot `base_seq` and returns false,
+    /// leaving them alone, if the node count differs.
+    pub fn apply_to(&self, nodes: &mut Vec<Node>) -> bool {
+        if self.is_delta() {
+            if nodes.len() != self.header.node_count as usize {
+                return false;
+            }
+        } else {
+            nodes.clear();
+            nodes.reserve(self.len());
+        }
+        for (index, node) in self.records() {
+            if self.is_delta() {
+                nodes[index] = node;
+            } else {
+                nodes.push(node);
+            }
+        }
+        true
+    }
+
+    /// The MOS the snapshot was generated from; `parse` has checked the
+    /// fields it is built from.
+    pub fn mos(&self) -> Mos {
+        let h = &self.header;
+        let r = h.repetitions;
+        Mos::from_params(h.a / r, h.b / r, h.mode, h.equave, h.generator, r)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::{Mapping, Scale};
+
+    #[test]
+    fn deltas_carry_only_changed_nodes() {
+        let mapping = Mapping { steps: 12, offset: 0.0, base_freq: 261.63, n_nodes: 128, root: 60 };
+        let mut mos = Mos::from_params(5, 2, 1, 1.0, 0.583333, 1);
+        let before = mos.generate_mapped_scale(12, 0.0, 261.63, 128, 60);
+        let mut bytes = Vec::new();
+        before.write_snapshot(&mos, None, 1, 0, false, &mut bytes);
+        let full_len = bytes.len();
+        let mut nodes = Vec::new();
+        assert!(SnapshotView::parse(&bytes).unwrap().apply_to(&mut nodes));
+
+        // The same scale again is an empty delta
+        before.write_snapshot(&mos, Some(&before), 2, 1, false, &mut bytes);
+        let view = SnapshotView::parse(&bytes).unwrap();
+        assert!(view.is_delta());
+        assert!(view.is_empty());
+        assert_eq!(bytes.len(), HEADER_SIZE);
+
+        // A retuned scale changes most nodes, so goes out in full
+        let mut after = Scale::new(128);
+        mos.adjust_tuning_g_into(3, 1, 0.59, 1.0, 1, &mapping, &mut after);
+        after.write_snapshot(&mos, Some(&before), 3, 2, false, &mut bytes);
+        let view = SnapshotView::parse(&bytes).unwrap();
+        assert!(!view.is_delta());
+        assert_eq!(bytes.len(), full_len);
+        assert!(view.apply_to(&mut nodes));
+        for (node, expected) in nodes.iter().zip(after.nodes()) {
+            assert_eq!(node.natural_coord, expected.natural_coord);
+            assert_eq!(node.pitch, expected.pitch);
+        }
+        let mut copy = Scale::new(0);
+        assert!(copy.apply_snapshot(&bytes));
+        assert_eq!(copy.pitches(), after.pitches());
+        assert_eq!(view.mos().a(), mos.a());
+        assert_eq!(view.mos().generator(), mos.generator());
+    }
+
+    #[test]
+    fn bad_buffers_are_rejected() {
+        let mos = Mos::from_params(5, 2, 1, 1.0, 0.583333, 1);
+        let scale = mos.generate_mapped_scale(12, 0.0, 261.63, 16, 8);
+        let mut bytes = Vec::new();
+        scale.write_snapshot(&mos, None, 1, 0, true, &mut bytes);
+        assert!(SnapshotView::parse(&bytes).is_ok());
+        assert_eq!(SnapshotView::parse(&bytes[..bytes.len() - 1]).unwrap_err(), Error::Truncated);
+        assert_eq!(SnapshotView::parse(&bytes[..40]).unwrap_err(), Error::Truncated);
+
+        let mut bad = bytes.clone();
+        bad[0] = b'X';
+        assert_eq!(SnapshotView::parse(&bad).unwrap_err(), Error::BadMagic);
+        let mut bad = bytes.clone();
+        bad[4] = 2;
+        assert_eq!(SnapshotView::parse(&bad).unwrap_err(), Error::Version(2));
+        let mut bad = bytes.clone();
+        bad[24] = 15; // record_count != node_count in a full snapshot
+        assert_eq!(SnapshotView::parse(&bad).unwrap_err(), Error::Inconsistent);
+
+        // MOS fields no MOS could have; mos() would abort on them
+        let corrupt = |offset: usize, value: &[u8]| {
+            let mut bad = bytes.clone();
+            bad[offset..offset + value.len()].copy_from_slice(value);
+            SnapshotView::parse(&bad).unwrap_err()
+        };
+        assert_eq!(corrupt(32, &[0; 8]), Error::Inconsistent); // a = b = 0
+        assert_eq!(corrupt(32, &(-5i32).to_le_bytes()), Error::Inconsistent);
+        assert_eq!(corrupt(32, &i32::MAX.to_le_bytes()), Error::Inconsistent);
+        assert_eq!(corrupt(40, &7i32.to_le_bytes()), Error::Inconsistent); // mode
+        assert_eq!(corrupt(40, &(-1i32).to_le_bytes()), Error::Inconsistent);
+        assert_eq!(corrupt(44, &0i32.to_le_bytes()), Error::Inconsistent); // repetitions
+        assert_eq!(corrupt(64, &0.0f64.to_le_bytes()), Error::Inconsistent); // equave
+        assert_eq!(corrupt(64, &f64::INFINITY.to_le_bytes()), Error::Inconsistent);
+        assert_eq!(corrupt(72, &1.5f64.to_le_bytes()), Error::Inconsistent); // generator
+        assert_eq!(corrupt(72, &f64::NAN.to_le_bytes()), Error::Inconsistent);
+        assert_eq!(corrupt(28, &(-1i32).to_le_bytes()), Error::Inconsistent); // root
+        assert_eq!(corrupt(28, &16i32.to_le_bytes()), Error::Inconsistent);
+
+        // The last mode of 5L 2s still parses
+        let mut last_mode = bytes.clone();
+        last_mode[40..44].copy_from_slice(&6i32.to_le_bytes());
+        assert_eq!(SnapshotView::parse(&last_mode).unwrap().mos().mode(), 6);
+    }
+}
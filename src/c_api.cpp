@@ -1,6 +1,19 @@
 #include "scalatrix/c_api.h"
+#include "scalatrix/consonance.hpp"
+#include "scalatrix/label_calculator.hpp"
 #include "scalatrix/mos.hpp"
+#include "scalatrix/mos_family.hpp"
+#include "scalatrix/pitchset.hpp"
 #include "scalatrix/scale.hpp"
+#include "scalatrix/shared_tuning.hpp"
+#include "scalatrix/snapshot.hpp"
+#include "scalatrix/spectrum.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <type_traits>
 
 using namespace scalatrix;
 
@@ -9,6 +22,22 @@ using namespace scalatrix;
 static scalatrix_vec2i to_c(Vector2i v) { return {v.x, v.y}; }
 static Vector2i from_c(scalatrix_vec2i v) { return {v.x, v.y}; }
 
+// Arrays of coordinates are passed through as they are
+static_assert(sizeof(scalatrix_vec2i) == sizeof(Vector2i) &&
+              alignof(scalatrix_vec2i) == alignof(Vector2i) &&
+              offsetof(scalatrix_vec2i, x) == offsetof(Vector2i, x) &&
+              offsetof(scalatrix_vec2i, y) == offsetof(Vector2i, y),
+              "scalatrix_vec2i must share the layout of Vector2i");
+static_assert(std::is_standard_layout<Vector2i>::value && std::is_trivially_copyable<Vector2i>::value,
+              "Vector2i must stay plain data");
+
+// snprintf into a caller's buffer; -1 for a null buffer with a nonzero size
+static int copy_label(const std::string& label, char* buf, int size) {
+    if (size > 0 && !buf)
+        return -1;
+    return std::snprintf(buf, size > 0 ? static_cast<size_t>(size) : 0, "%s", label.c_str());
+}
+
 /* ── MOS lifecycle ─────────────────────────────────────────────────── */
 
 scalatrix_mos_t* scalatrix_mos_from_params(
@@ -68,6 +97,12 @@ void scalatrix_mos_adjust_params(
 }
 
 
+void scalatrix_mos_adjust_g(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions)
+{
+    MOS_MUT(mos)->adjustG(depth, mode, generator, equave, repetitions);
+}
+
 void scalatrix_mos_adjust_tuning_g(
     scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions)
 {
@@ -105,15 +140,23 @@ double scalatrix_mos_coord_to_freq(
 scalatrix_vec2i scalatrix_mos_map_from_mos(
     scalatrix_mos_t* mos, scalatrix_mos_t* other, scalatrix_vec2i v)
 {
-    return to_c(MOS_MUT(mos)->mapFromMOS(*MOS_MUT(other), from_c(v)));
+    return to_c(MOS_PTR(mos)->mapFromMOS(*MOS_PTR(other), from_c(v)));
 }
 
 /* ── Scale generation ──────────────────────────────────────────────── */
 
+// Generation writes the root node and walks out from it, so the root must
+// be one of the nodes
+static bool valid_root(int n_nodes, int root) {
+    return 0 <= root && root < n_nodes;
+}
+
 scalatrix_scale_t* scalatrix_mos_generate_mapped_scale(
     const scalatrix_mos_t* mos,
     int steps, double offset, double base_freq, int n_nodes, int root)
 {
+    if (!valid_root(n_nodes, root))
+        return nullptr;
     auto scale = MOS_PTR(mos)->generateMappedScale(steps, offset, base_freq, n_nodes, root);
     return reinterpret_cast<scalatrix_scale_t*>(new Scale(std::move(scale)));
 }
@@ -121,10 +164,84 @@ scalatrix_scale_t* scalatrix_mos_generate_mapped_scale(
 scalatrix_scale_t* scalatrix_mos_generate_scale(
     scalatrix_mos_t* mos, double base_freq, int n_nodes, int root)
 {
+    if (!valid_root(n_nodes, root))
+        return nullptr;
     auto scale = MOS_MUT(mos)->generateScaleFromMOS(base_freq, n_nodes, root);
     return reinterpret_cast<scalatrix_scale_t*>(new Scale(std::move(scale)));
 }
 
+/* ── In-place regeneration ─────────────────────────────────────────── */
+
+#define SCALE_MUT(p) reinterpret_cast<Scale*>(p)
+
+scalatrix_scale_t* scalatrix_scale_new(int n_nodes) {
+    auto* scale = new Scale(DEFAULT_12TET_C_PITCH, n_nodes > 0 ? n_nodes : 0, 0);
+    return reinterpret_cast<scalatrix_scale_t*>(scale);
+}
+
+int scalatrix_mos_generate_mapped_scale_into(
+    const scalatrix_mos_t* mos, scalatrix_scale_t* scale,
+    int steps, double offset, double base_freq, int n_nodes, int root)
+{
+    if (!valid_root(n_nodes, root))
+        return -1;
+    MOS_PTR(mos)->generateMappedScaleInto(*SCALE_MUT(scale), steps, offset, base_freq, n_nodes, root);
+    return 0;
+}
+
+int scalatrix_mos_generate_scale_into(
+    scalatrix_mos_t* mos, scalatrix_scale_t* scale,
+    double base_freq, int n_nodes, int root)
+{
+    if (!valid_root(n_nodes, root))
+        return -1;
+    MOS_MUT(mos)->generateScaleFromMOSInto(*SCALE_MUT(scale), base_freq, n_nodes, root);
+    return 0;
+}
+
+// Checked before an adjust call changes the MOS, so one that is rejected
+// leaves both the MOS and the scale as they were
+static bool valid_mapping(const scalatrix_mapping* m, const scalatrix_scale_t* scale) {
+    return m && scale && valid_root(m->n_nodes, m->root);
+}
+
+static int regenerate(const MOS& mos, const scalatrix_mapping* m, scalatrix_scale_t* scale) {
+    return scalatrix_mos_generate_mapped_scale_into(
+        reinterpret_cast<const scalatrix_mos_t*>(&mos), scale,
+        m->steps, m->offset, m->base_freq, m->n_nodes, m->root);
+}
+
+int scalatrix_mos_adjust_params_into(
+    scalatrix_mos_t* mos,
+    int a, int b, int mode, double equave, double generator, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale)
+{
+    if (!valid_mapping(mapping, scale))
+        return -1;
+    MOS_MUT(mos)->adjustParams(a, b, mode, equave, generator, repetitions);
+    return regenerate(*MOS_PTR(mos), mapping, scale);
+}
+
+int scalatrix_mos_adjust_g_into(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale)
+{
+    if (!valid_mapping(mapping, scale))
+        return -1;
+    MOS_MUT(mos)->adjustG(depth, mode, generator, equave, repetitions);
+    return regenerate(*MOS_PTR(mos), mapping, scale);
+}
+
+int scalatrix_mos_adjust_tuning_g_into(
+    scalatrix_mos_t* mos, int depth, int mode, double generator, double equave, int repetitions,
+    const scalatrix_mapping* mapping, scalatrix_scale_t* scale)
+{
+    if (!valid_mapping(mapping, scale))
+        return -1;
+    MOS_MUT(mos)->adjustTuningG(depth, mode, generator, equave, repetitions);
+    return regenerate(*MOS_PTR(mos), mapping, scale);
+}
+
 /* ── Scale lifecycle and access ────────────────────────────────────── */
 
 #define SCALE_PTR(p) reinterpret_cast<const Scale*>(p)
@@ -157,3 +274,536 @@ int scalatrix_scale_get_node(
     out->pitch         = n.pitch;
     return 0;
 }
+
+// Nodes to copy from first, or -1 if the range is invalid
+static int copy_count(const NodeVector& nodes, int first, int count) {
+    int size = static_cast<int>(nodes.size());
+    if (first < 0 || first > size || count < 0)
+        return -1;
+    return std::min(count, size - first);
+}
+
+int scalatrix_scale_copy_nodes(
+    const scalatrix_scale_t* s, int first, int count, scalatrix_node* out)
+{
+    const auto& nodes = SCALE_PTR(s)->getNodes();
+    int n = copy_count(nodes, first, count);
+    if (out) {
+        for (int i = 0; i < n; ++i) {
+            const Node& node = nodes[first + i];
+            out[i].natural_coord = to_c(node.natural_coord);
+            out[i].tuning_coord  = {node.tuning_coord.x, node.tuning_coord.y};
+            out[i].pitch         = node.pitch;
+        }
+    }
+    return n;
+}
+
+int scalatrix_scale_copy_columns(
+    const scalatrix_scale_t* s, int first, int count,
+    double* pitches, scalatrix_vec2i* natural_coords, scalatrix_vec2d* tuning_coords)
+{
+    const auto& nodes = SCALE_PTR(s)->getNodes();
+    int n = copy_count(nodes, first, count);
+    if (n <= 0)
+        return n;
+    const Node* src = nodes.data() + first;
+    // One pass per column keeps each store stream contiguous
+    if (pitches)
+        for (int i = 0; i < n; ++i) pitches[i] = src[i].pitch;
+    if (natural_coords)
+        for (int i = 0; i < n; ++i) natural_coords[i] = to_c(src[i].natural_coord);
+    if (tuning_coords)
+        for (int i = 0; i < n; ++i) tuning_coords[i] = {src[i].tuning_coord.x, src[i].tuning_coord.y};
+    return n;
+}
+
+/* ── MOS families ──────────────────────────────────────────────────── */
+
+#define FAMILY_PTR(p) reinterpret_cast<const MOSFamily*>(p)
+
+scalatrix_mos_family_options scalatrix_mos_family_default_options(void) {
+    MOSFamilyOptions o;
+    return {o.min_size, o.max_size, o.g_steps, o.equave, o.steps, o.offset,
+            o.base_freq, o.n_nodes, o.root, o.n_threads};
+}
+
+scalatrix_mos_family_t* scalatrix_mos_family_generate(
+    const scalatrix_mos_family_options* options)
+{
+    if (!options)
+        return nullptr;
+    MOSFamilyOptions o;
+    o.min_size  = options->min_size;
+    o.max_size  = options->max_size;
+    o.g_steps   = options->g_steps;
+    o.equave    = options->equave;
+    o.steps     = options->steps;
+    o.offset    = options->offset;
+    o.base_freq = options->base_freq;
+    o.n_nodes   = options->n_nodes;
+    o.root      = options->root;
+    o.n_threads = options->n_threads;
+    auto* family = new MOSFamily(generateMOSFamily(o));
+    return reinterpret_cast<scalatrix_mos_family_t*>(family);
+}
+
+void scalatrix_mos_family_free(scalatrix_mos_family_t* family) {
+    delete reinterpret_cast<MOSFamily*>(family);
+}
+
+int scalatrix_mos_family_size(const scalatrix_mos_family_t* f)    { return static_cast<int>(FAMILY_PTR(f)->size()); }
+int scalatrix_mos_family_n_nodes(const scalatrix_mos_family_t* f) { return FAMILY_PTR(f)->n_nodes; }
+
+const int*    scalatrix_mos_family_a(const scalatrix_mos_family_t* f)         { return FAMILY_PTR(f)->a.data(); }
+const int*    scalatrix_mos_family_b(const scalatrix_mos_family_t* f)         { return FAMILY_PTR(f)->b.data(); }
+const int*    scalatrix_mos_family_mode(const scalatrix_mos_family_t* f)      { return FAMILY_PTR(f)->mode.data(); }
+const double* scalatrix_mos_family_generator(const scalatrix_mos_family_t* f) { return FAMILY_PTR(f)->generator.data(); }
+const double* scalatrix_mos_family_L_fr(const scalatrix_mos_family_t* f)      { return FAMILY_PTR(f)->L_fr.data(); }
+const double* scalatrix_mos_family_s_fr(const scalatrix_mos_family_t* f)      { return FAMILY_PTR(f)->s_fr.data(); }
+const int*    scalatrix_mos_family_coord_x(const scalatrix_mos_family_t* f)   { return FAMILY_PTR(f)->coord_x.data(); }
+const int*    scalatrix_mos_family_coord_y(const scalatrix_mos_family_t* f)   { return FAMILY_PTR(f)->coord_y.data(); }
+const double* scalatrix_mos_family_tuning_x(const scalatrix_mos_family_t* f)  { return FAMILY_PTR(f)->tuning_x.data(); }
+const double* scalatrix_mos_family_tuning_y(const scalatrix_mos_family_t* f)  { return FAMILY_PTR(f)->tuning_y.data(); }
+const double* scalatrix_mos_family_pitch(const scalatrix_mos_family_t* f)     { return FAMILY_PTR(f)->pitch.data(); }
+
+/* ── Spectra ───────────────────────────────────────────────────────── */
+
+#define SPECTRUM_PTR(p) reinterpret_cast<const Spectrum*>(p)
+
+static scalatrix_spectrum_t* wrap(Spectrum&& spectrum) {
+    return reinterpret_cast<scalatrix_spectrum_t*>(new Spectrum(std::move(spectrum)));
+}
+
+scalatrix_spectrum_t* scalatrix_spectrum_new(
+    const double* ratios, const double* amplitudes, int n)
+{
+    if (n > 0 && (!ratios || !amplitudes))
+        return nullptr;
+    std::vector<Partial> partials(std::max(n, 0));
+    for (size_t i = 0; i < partials.size(); ++i)
+        partials[i] = {ratios[i], amplitudes[i]};
+    return wrap(Spectrum(std::move(partials)));
+}
+
+scalatrix_spectrum_t* scalatrix_spectrum_harmonic(int n_partials, double decay) {
+    return wrap(Spectrum::harmonic(n_partials, decay));
+}
+
+scalatrix_spectrum_t* scalatrix_spectrum_odd_harmonic(int max_harmonic, double decay) {
+    return wrap(Spectrum::oddHarmonic(max_harmonic, decay));
+}
+
+scalatrix_spectrum_t* scalatrix_spectrum_pseudoharmonic(
+    int n_partials, double decay, const int* primes, const double* cents, int n_primes)
+{
+    if (n_primes <= 0)
+        return wrap(Spectrum::pseudoharmonic(n_partials, decay));
+    if (!primes || !cents)
+        return nullptr;
+    std::map<int, double> prime_cents;
+    for (int i = 0; i < n_primes; ++i)
+        prime_cents[primes[i]] = cents[i];
+    return wrap(Spectrum::pseudoharmonic(n_partials, decay, prime_cents));
+}
+
+void scalatrix_spectrum_free(scalatrix_spectrum_t* spectrum) {
+    delete reinterpret_cast<Spectrum*>(spectrum);
+}
+
+int scalatrix_spectrum_size(const scalatrix_spectrum_t* s) {
+    return static_cast<int>(SPECTRUM_PTR(s)->partials.size());
+}
+
+int scalatrix_spectrum_copy_partials(
+    const scalatrix_spectrum_t* s, double* ratios, double* amplitudes, int capacity)
+{
+    const auto& partials = SPECTRUM_PTR(s)->partials;
+    int n = std::min(std::max(capacity, 0), static_cast<int>(partials.size()));
+    for (int i = 0; i < n; ++i) {
+        if (ratios)     ratios[i]     = partials[i].ratio;
+        if (amplitudes) amplitudes[i] = partials[i].amplitude;
+    }
+    return n;
+}
+
+/* ── Consonance ────────────────────────────────────────────────────── */
+
+static_assert(SCALATRIX_CONSONANCE_MAX_POINTS == ConsonanceEvaluator::MAX_POINTS,
+              "C grid limit out of step with ConsonanceEvaluator");
+
+#define CONSONANCE_PTR(p) reinterpret_cast<const ConsonanceEvaluator*>(p)
+#define CONSONANCE_MUT(p) reinterpret_cast<ConsonanceEvaluator*>(p)
+
+scalatrix_consonance_t* scalatrix_consonance_new(
+    const scalatrix_spectrum_t* spectrum, double f0,
+    double cents_min, double cents_max, double resolution)
+{
+    if (!ConsonanceEvaluator::validArguments(f0, cents_min, cents_max, resolution))
+        return nullptr;
+    auto* c = new ConsonanceEvaluator(*SPECTRUM_PTR(spectrum), f0, cents_min, cents_max, resolution);
+    return reinterpret_cast<scalatrix_consonance_t*>(c);
+}
+
+void scalatrix_consonance_free(scalatrix_consonance_t* consonance) {
+    delete CONSONANCE_MUT(consonance);
+}
+
+int scalatrix_consonance_size(const scalatrix_consonance_t* c) {
+    return CONSONANCE_PTR(c)->size();
+}
+
+int scalatrix_consonance_compute(
+    scalatrix_consonance_t* c, double log_baseline, int gen3,
+    double* cents, double* pl, double* hull, double* spiky, double* consonance_out,
+    int capacity, scalatrix_consonance_info* info)
+{
+    ConsonanceEvaluator* evaluator = CONSONANCE_MUT(c);
+    if (capacity < evaluator->size())
+        return -1;
+    ConsonanceCurveOut out;
+    out.cents      = cents;
+    out.pl         = pl;
+    out.hull       = hull;
+    out.spiky      = spiky;
+    out.consonance = consonance_out;
+    if (gen3)
+        evaluator->computeGen3(out, log_baseline);
+    else
+        evaluator->compute(out, log_baseline);
+    if (info)
+        *info = {out.peak, out.logBaseline};
+    return 0;
+}
+
+int scalatrix_analyze_scale(
+    const scalatrix_spectrum_t* spectrum, double f0,
+    const double* interval_cents, int n,
+    double max_cents, double max_interval_cents, double log_baseline,
+    double* consonance_out, double* mean_out)
+{
+    size_t analyzed = analyzeIntervals(*SPECTRUM_PTR(spectrum), f0, interval_cents,
+                                       static_cast<size_t>(std::max(n, 0)), consonance_out, mean_out,
+                                       max_cents, max_interval_cents, log_baseline);
+    return static_cast<int>(analyzed);
+}
+
+/* ── Pitch sets ────────────────────────────────────────────────────── */
+
+#define PITCHSET_PTR(p) reinterpret_cast<const PitchSetIndex*>(p)
+
+static scalatrix_pitchset_t* wrap(PitchSet&& pitchset) {
+    return reinterpret_cast<scalatrix_pitchset_t*>(new PitchSetIndex(std::move(pitchset)));
+}
+
+scalatrix_pitchset_t* scalatrix_pitchset_et(
+    int n_et, double equave, double min_log2fr, double max_log2fr)
+{
+    return wrap(generateETPitchSet(static_cast<unsigned int>(std::max(n_et, 1)),
+                                   equave, min_log2fr, max_log2fr));
+}
+
+scalatrix_pitchset_t* scalatrix_pitchset_ji(
+    int n_primes, int max_numtimesden, double min_log2fr, double max_log2fr)
+{
+    return wrap(generateJIPitchSet(generateDefaultPrimeList(n_primes),
+                                   max_numtimesden, min_log2fr, max_log2fr));
+}
+
+scalatrix_pitchset_t* scalatrix_pitchset_bounded_ji(
+    int n_primes, int bound_kind, long long limit, double min_log2fr, double max_log2fr)
+{
+    JIBound bound;
+    switch (bound_kind) {
+        case SCALATRIX_JI_NUM_DEN:       bound = JIBound::numDen(limit); break;
+        case SCALATRIX_JI_ODD_LIMIT:     bound = JIBound::oddLimit(limit); break;
+        case SCALATRIX_JI_TENNEY_HEIGHT: bound = JIBound::tenneyHeight(limit); break;
+        default: return nullptr;
+    }
+    return wrap(generateBoundedJIPitchSet(generateDefaultPrimeList(n_primes),
+                                          bound, min_log2fr, max_log2fr));
+}
+
+scalatrix_pitchset_t* scalatrix_pitchset_harmonic_series(
+    int n_primes, int base, double min_log2fr, double max_log2fr)
+{
+    return wrap(generateHarmonicSeriesPitchSet(generateDefaultPrimeList(n_primes),
+                                               base, min_log2fr, max_log2fr));
+}
+
+scalatrix_pitchset_t* scalatrix_pitchset_new(
+    const double* log2fr, const char* const* labels, int n)
+{
+    if (n > 0 && !log2fr)
+        return nullptr;
+    PitchSet pitchset(std::max(n, 0));
+    for (size_t i = 0; i < pitchset.size(); ++i) {
+        pitchset[i].log2fr = log2fr[i];
+        if (labels && labels[i])
+            pitchset[i].label = labels[i];
+    }
+    return wrap(std::move(pitchset));
+}
+
+void scalatrix_pitchset_free(scalatrix_pitchset_t* pitchset) {
+    delete reinterpret_cast<PitchSetIndex*>(pitchset);
+}
+
+int scalatrix_pitchset_size(const scalatrix_pitchset_t* p) {
+    return static_cast<int>(PITCHSET_PTR(p)->size());
+}
+
+int scalatrix_pitchset_copy_log2fr(
+    const scalatrix_pitchset_t* p, double* out, int capacity)
+{
+    const PitchSet& pitchset = PITCHSET_PTR(p)->pitchSet();
+    int n = std::min(std::max(capacity, 0), static_cast<int>(pitchset.size()));
+    if (out)
+        for (int i = 0; i < n; ++i) out[i] = pitchset[i].log2fr;
+    return n;
+}
+
+int scalatrix_pitchset_label(
+    const scalatrix_pitchset_t* p, int index, char* buf, int size)
+{
+    const PitchSet& pitchset = PITCHSET_PTR(p)->pitchSet();
+    if (index < 0 || index >= static_cast<int>(pitchset.size()))
+        return -1;
+    return copy_label(pitchset[index].label, buf, size);
+}
+
+int scalatrix_pitchset_closest(const scalatrix_pitchset_t* p, double log2fr) {
+    return PITCHSET_PTR(p)->closest(log2fr);
+}
+
+/* ── Tempering ─────────────────────────────────────────────────────── */
+
+void scalatrix_scale_temper(
+    scalatrix_scale_t* scale, const scalatrix_pitchset_t* pitchset,
+    scalatrix_tempering_stats* stats)
+{
+    TemperingStats result;
+    SCALE_MUT(scale)->temperToPitchSet(*PITCHSET_PTR(pitchset), &result);
+    if (stats)
+        *stats = {result.max_cents, result.rms_cents, result.n_nodes};
+}
+
+int scalatrix_scale_copy_tempering(
+    const scalatrix_scale_t* s, int first, int count,
+    int* is_tempered, double* tempered_log2fr)
+{
+    const auto& nodes = SCALE_PTR(s)->getNodes();
+    int n = copy_count(nodes, first, count);
+    if (n <= 0)
+        return n;
+    const Node* src = nodes.data() + first;
+    if (is_tempered)
+        for (int i = 0; i < n; ++i) is_tempered[i] = src[i].isTempered ? 1 : 0;
+    if (tempered_log2fr)
+        for (int i = 0; i < n; ++i) tempered_log2fr[i] = src[i].temperedPitch.log2fr;
+    return n;
+}
+
+int scalatrix_scale_tempered_label(
+    const scalatrix_scale_t* s, int index, char* buf, int size)
+{
+    const auto& nodes = SCALE_PTR(s)->getNodes();
+    if (index < 0 || index >= static_cast<int>(nodes.size()))
+        return -1;
+    return copy_label(nodes[index].temperedPitch.label, buf, size);
+}
+
+/* ── Snapshots ─────────────────────────────────────────────────────── */
+
+static_assert(SCALATRIX_SNAPSHOT_FLOAT32 == SNAPSHOT_FLOAT32 && SCALATRIX_SNAPSHOT_DELTA == SNAPSHOT_DELTA,
+              "C snapshot flags out of sync");
+
+int scalatrix_snapshot_size(int n_records, int flags)
+{
+    if (n_records < 0)
+        return -1;
+    return static_cast<int>(snapshotSize(n_records, static_cast<uint16_t>(flags)));
+}
+
+int scalatrix_snapshot_write(
+    const scalatrix_mos_t* mos, const scalatrix_scale_t* scale,
+    const scalatrix_scale_t* previous, unsigned int seq, unsigned int base_seq,
+    int float32, unsigned char* out, int capacity)
+{
+    if (capacity < 0)
+        return -1;
+    size_t n = previous
+        ? writeSnapshotDelta(*MOS_PTR(mos), *SCALE_PTR(scale), *SCALE_PTR(previous),
+                             seq, base_seq, float32 != 0, out, capacity)
+        : writeSnapshot(*MOS_PTR(mos), *SCALE_PTR(scale), seq, float32 != 0, out, capacity);
+    return n ? static_cast<int>(n) : -1;
+}
+
+int scalatrix_snapshot_apply(
+    const unsigned char* data, int size, scalatrix_scale_t* scale)
+{
+    if (size < 0)
+        return -1;
+    SnapshotView view(data, static_cast<size_t>(size));
+    return view.applyTo(*SCALE_MUT(scale)) ? 0 : -1;
+}
+
+/* ── Shared tuning tables ──────────────────────────────────────────── */
+
+#define PUBLISHER_MUT(p) reinterpret_cast<SharedTuningPublisher*>(p)
+#define READER_PTR(p) reinterpret_cast<const SharedTuningReader*>(p)
+#define READER_MUT(p) reinterpret_cast<SharedTuningReader*>(p)
+
+scalatrix_shared_publisher_t* scalatrix_shared_publisher_open(
+    const char* name, int max_nodes, int float32)
+{
+    auto* publisher = new SharedTuningPublisher();
+    if (!name || !publisher->open(name, max_nodes, float32 != 0)) {
+        delete publisher;
+        return nullptr;
+    }
+    return reinterpret_cast<scalatrix_shared_publisher_t*>(publisher);
+}
+
+void scalatrix_shared_publisher_close(scalatrix_shared_publisher_t* publisher) {
+    delete PUBLISHER_MUT(publisher);
+}
+
+long long scalatrix_shared_publisher_publish(
+    scalatrix_shared_publisher_t* publisher,
+    const scalatrix_mos_t* mos, const scalatrix_scale_t* scale)
+{
+    SharedTuningPublisher* p = PUBLISHER_MUT(publisher);
+    if (!p->publish(*MOS_PTR(mos), *SCALE_PTR(scale)))
+        return -1;
+    return p->sequence();
+}
+
+int scalatrix_shared_unlink(const char* name) {
+    return name && SharedTuningPublisher::unlink(name) ? 0 : -1;
+}
+
+scalatrix_shared_reader_t* scalatrix_shared_reader_open(const char* name) {
+    auto* reader = new SharedTuningReader();
+    if (!name || !reader->open(name)) {
+        delete reader;
+        return nullptr;
+    }
+    return reinterpret_cast<scalatrix_shared_reader_t*>(reader);
+}
+
+void scalatrix_shared_reader_close(scalatrix_shared_reader_t* reader) {
+    delete READER_MUT(reader);
+}
+
+int scalatrix_shared_reader_has_update(const scalatrix_shared_reader_t* reader) {
+    return READER_PTR(reader)->hasUpdate() ? 1 : 0;
+}
+
+int scalatrix_shared_reader_read(scalatrix_shared_reader_t* reader) {
+    return READER_MUT(reader)->read() ? 1 : 0;
+}
+
+unsigned int scalatrix_shared_reader_sequence(const scalatrix_shared_reader_t* reader) {
+    return READER_PTR(reader)->sequence();
+}
+
+const unsigned char* scalatrix_shared_reader_data(
+    const scalatrix_shared_reader_t* reader, int* size)
+{
+    const SnapshotView& view = READER_PTR(reader)->view();
+    if (size)
+        *size = view.valid() ? static_cast<int>(view.byteSize()) : 0;
+    return view.valid() ? view.data() : nullptr;
+}
+
+int scalatrix_shared_reader_apply(
+    const scalatrix_shared_reader_t* reader, scalatrix_scale_t* scale)
+{
+    return READER_PTR(reader)->view().applyTo(*SCALE_MUT(scale)) ? 0 : -1;
+}
+
+/* ── Label batches ─────────────────────────────────────────────────── */
+
+struct LabelBuffer {
+    LabelTable table;
+    LabelBatch batch;
+};
+
+#define LABELS_PTR(p) reinterpret_cast<const LabelBuffer*>(p)
+#define LABELS_MUT(p) reinterpret_cast<LabelBuffer*>(p)
+
+// Rebuilds the buffer's table for mos and style; false for an unknown style
+static bool prepare_labels(LabelBuffer* labels, const MOS& mos, int style) {
+    int base = style & 0x0f;
+    if (base > LabelTable::LETTER_WITH_OCTAVE || (style & ~0x3f))
+        return false;
+    labels->table.rebuild(mos, (style & SCALATRIX_LABEL_TUNING) != 0);
+    return true;
+}
+
+scalatrix_labels_t* scalatrix_labels_new(void) {
+    auto* labels = new LabelBuffer();
+    labels->batch.clear();
+    return reinterpret_cast<scalatrix_labels_t*>(labels);
+}
+
+void scalatrix_labels_free(scalatrix_labels_t* labels) {
+    delete LABELS_MUT(labels);
+}
+
+int scalatrix_labels_rect(
+    scalatrix_labels_t* l, const scalatrix_mos_t* mos,
+    int x, int y, int width, int height, int style, int middle_c_octave)
+{
+    LabelBuffer* labels = LABELS_MUT(l);
+    if (!prepare_labels(labels, *MOS_PTR(mos), style))
+        return -1;
+    labels->table.labelRect(Vector2i(x, y), width, height,
+                            static_cast<LabelTable::Style>(style & 0x0f), labels->batch,
+                            !(style & SCALATRIX_LABEL_ACCIDENTAL_BEFORE), middle_c_octave);
+    return static_cast<int>(labels->batch.size());
+}
+
+int scalatrix_labels_coords(
+    scalatrix_labels_t* l, const scalatrix_mos_t* mos,
+    const scalatrix_vec2i* coords, int count, int style, int middle_c_octave)
+{
+    LabelBuffer* labels = LABELS_MUT(l);
+    if (!prepare_labels(labels, *MOS_PTR(mos), style))
+        return -1;
+    labels->table.labelCoords(reinterpret_cast<const Vector2i*>(coords),
+                              static_cast<size_t>(std::max(count, 0)),
+                              static_cast<LabelTable::Style>(style & 0x0f), labels->batch,
+                              !(style & SCALATRIX_LABEL_ACCIDENTAL_BEFORE), middle_c_octave);
+    return static_cast<int>(labels->batch.size());
+}
+
+int scalatrix_labels_deviation(
+    scalatrix_labels_t* l, const scalatrix_scale_t* s, int first, int count,
+    double threshold_cents, int compare_with_tempered)
+{
+    LabelBuffer* labels = LABELS_MUT(l);
+    const auto& nodes = SCALE_PTR(s)->getNodes();
+    int n = copy_count(nodes, first, count);
+    if (n < 0)
+        return -1;
+    LabelCalculator::deviationLabels(nodes.data() + first, n, labels->batch,
+                                     threshold_cents, compare_with_tempered != 0);
+    return n;
+}
+
+int scalatrix_labels_count(const scalatrix_labels_t* labels) {
+    return static_cast<int>(LABELS_PTR(labels)->batch.size());
+}
+
+const char* scalatrix_labels_text(const scalatrix_labels_t* l, int* size) {
+    const LabelBatch& batch = LABELS_PTR(l)->batch;
+    if (size)
+        *size = static_cast<int>(batch.text.size());
+    return batch.text.data();
+}
+
+const unsigned int* scalatrix_labels_offsets(const scalatrix_labels_t* labels) {
+    return LABELS_PTR(labels)->batch.offsets.data();
+}
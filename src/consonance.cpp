@@ -1,6 +1,7 @@
 #include "scalatrix/consonance.hpp"
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <numeric>
 
 namespace scalatrix {
@@ -27,12 +28,14 @@ static const double D_FLAT = C1_PL * std::exp(A1 * SF_MAX) + C2_PL * std::exp(A2
 // LOCAL_CONS_AMP = -alpha is the per-pair local-consonance peak at sf = 0.
 static constexpr double LOCAL_CONS_AMP = -(C2_PL + C1_PL * A1 / A2);
 
-static double computeDissonanceAtCents(const Spectrum& spectrum, double f0, double cents) {
-    double ratio = std::pow(2.0, cents / 1200.0);
+// Total PL dissonance of the spectrum against itself transposed by ratio;
+// fa is scratch for the 2 * partials frequencies
+static double dissonanceAtRatio(const Spectrum& spectrum, double f0, double ratio,
+                                std::vector<std::pair<double, double>>& fa) {
     size_t np = spectrum.partials.size();
     size_t total = 2 * np;
 
-    std::vector<std::pair<double, double>> fa(total);
+    fa.resize(total);
     for (size_t i = 0; i < np; ++i) {
         fa[i] = {f0 * spectrum.partials[i].ratio, spectrum.partials[i].amplitude};
         fa[i + np] = {f0 * ratio * spectrum.partials[i].ratio, spectrum.partials[i].amplitude};
@@ -54,116 +57,181 @@ static double computeDissonanceAtCents(const Spectrum& spectrum, double f0, doub
     return diss;
 }
 
+static int curvePoints(double cents_min, double cents_max, double resolution) {
+    return static_cast<int>((cents_max - cents_min) / resolution) + 1;
+}
+
 PLCurve computePLCurve(const Spectrum& spectrum, double f0,
                        double cents_min, double cents_max, double resolution) {
-    int n_points = static_cast<int>((cents_max - cents_min) / resolution) + 1;
+    int n_points = curvePoints(cents_min, cents_max, resolution);
     PLCurve result;
     result.cents.resize(n_points);
     result.pl.resize(n_points);
 
+    std::vector<std::pair<double, double>> fa;
     for (int i = 0; i < n_points; ++i) {
         double c = cents_min + i * (cents_max - cents_min) / (n_points - 1);
         result.cents[i] = c;
-        result.pl[i] = computeDissonanceAtCents(spectrum, f0, c);
+        result.pl[i] = dissonanceAtRatio(spectrum, f0, std::pow(2.0, c / 1200.0), fa);
     }
     return result;
 }
 
-ConsonanceCurve computeConsonanceCurve(const Spectrum& spectrum, double f0,
-    double cents_min, double cents_max, double resolution, double logBaseline)
+bool ConsonanceEvaluator::validArguments(double f0, double cents_min, double cents_max, double resolution) {
+    if (!std::isfinite(f0) || !std::isfinite(cents_min) || !std::isfinite(cents_max)
+        || !std::isfinite(resolution)) {
+        return false;
+    }
+    if (!(cents_min < cents_max) || !(resolution > 0.0)) return false;
+    // Checked in double, before curvePoints converts to int
+    return (cents_max - cents_min) / resolution < MAX_POINTS;
+}
+
+ConsonanceEvaluator::ConsonanceEvaluator(const Spectrum& spectrum, double f0,
+    double cents_min, double cents_max, double resolution)
+    : spectrum_(spectrum), f0_(f0),
+      n_points_(validArguments(f0, cents_min, cents_max, resolution)
+                    ? curvePoints(cents_min, cents_max, resolution) : 0)
 {
-    int n_points = static_cast<int>((cents_max - cents_min) / resolution) + 1;
+    // Build cents grid and precompute ratios
+    cents_.resize(n_points_);
+    cents_ratios_.resize(n_points_);
+    for (int i = 0; i < n_points_; ++i) {
+        // A range narrower than resolution is the single point cents_min
+        cents_[i] = n_points_ > 1 ? cents_min + i * (cents_max - cents_min) / (n_points_ - 1) : cents_min;
+        cents_ratios_[i] = std::pow(2.0, cents_[i] / 1200.0);
+    }
+    pl_.resize(n_points_);
+    spiky_.resize(n_points_);
+    scratch_.reserve(n_points_);
+    fa_.reserve(2 * spectrum_.partials.size());
+}
 
-    ConsonanceCurve result;
-    result.cents.resize(n_points);
-    result.pl.resize(n_points);
-    result.spiky.resize(n_points, 0.0);
-    result.consonance.resize(n_points, 0.0);
+void ConsonanceEvaluator::compute(ConsonanceCurveOut& out, double logBaseline) {
+    computeCurve(out, logBaseline, false);
+}
 
-    // Build cents grid and precompute ratios
-    std::vector<double> cents_ratios(n_points);
-    for (int i = 0; i < n_points; ++i) {
-        result.cents[i] = cents_min + i * (cents_max - cents_min) / (n_points - 1);
-        cents_ratios[i] = std::pow(2.0, result.cents[i] / 1200.0);
+void ConsonanceEvaluator::computeGen3(ConsonanceCurveOut& out, double logBaseline) {
+    computeCurve(out, logBaseline, true);
+}
+
+void ConsonanceEvaluator::computeCurve(ConsonanceCurveOut& out, double logBaseline, bool gen3) {
+    const int n_points = n_points_;
+    out.logBaseline = logBaseline;
+    if (n_points == 0) {
+        out.peak = 0.0;
+        return;
+    }
+    // Written straight into the caller's arrays where given
+    double* pl = out.pl ? out.pl : pl_.data();
+    double* spiky = out.spiky ? out.spiky : spiky_.data();
+
+    if (out.cents) {
+        std::copy(cents_.begin(), cents_.end(), out.cents);
     }
 
     // Compute PL curve
     for (int i = 0; i < n_points; ++i) {
-        result.pl[i] = computeDissonanceAtCents(spectrum, f0, result.cents[i]);
+        pl[i] = dissonanceAtRatio(spectrum_, f0_, cents_ratios_[i], fa_);
     }
 
-    // Compute exact asymmetric pyramids (spiky = d_flat - d for each pair where sf < SF_MAX)
-    // For each pair of (base partial i, transposed partial j):
-    const auto& partials = spectrum.partials;
+    const auto& partials = spectrum_.partials;
     size_t np = partials.size();
-
-    for (size_t pi = 0; pi < np; ++pi) {
-        for (size_t pj = 0; pj < np; ++pj) {
-            double f_base = f0 * partials[pi].ratio;
-            double a_min = std::min(partials[pi].amplitude, partials[pj].amplitude);
-
-            for (int ci = 0; ci < n_points; ++ci) {
-                double f_trans = f0 * cents_ratios[ci] * partials[pj].ratio;
-                double fdif = std::abs(f_base - f_trans);
-                double f_low = std::min(f_base, f_trans);
-                double s = DSTAR / (S1 * f_low + S2);
-                double sf = s * fdif;
-
-                if (sf < SF_MAX) {
-                    double d_normal = a_min * (C1_PL * std::exp(A1 * sf) + C2_PL * std::exp(A2 * sf));
-                    result.spiky[ci] += a_min * D_FLAT - d_normal;
+    std::fill(spiky, spiky + n_points, 0.0);
+
+    if (!gen3) {
+        // Compute exact asymmetric pyramids (spiky = d_flat - d for each pair where sf < SF_MAX)
+        // For each pair of (base partial i, transposed partial j):
+        for (size_t pi = 0; pi < np; ++pi) {
+            for (size_t pj = 0; pj < np; ++pj) {
+                double f_base = f0_ * partials[pi].ratio;
+                double a_min = std::min(partials[pi].amplitude, partials[pj].amplitude);
+
+                for (int ci = 0; ci < n_points; ++ci) {
+                    double f_trans = f0_ * cents_ratios_[ci] * partials[pj].ratio;
+                    double fdif = std::abs(f_base - f_trans);
+                    double f_low = std::min(f_base, f_trans);
+                    double s = DSTAR / (S1 * f_low + S2);
+                    double sf = s * fdif;
+
+                    if (sf < SF_MAX) {
+                        double d_normal = a_min * (C1_PL * std::exp(A1 * sf) + C2_PL * std::exp(A2 * sf));
+                        spiky[ci] += a_min * D_FLAT - d_normal;
+                    }
+                }
+            }
+        }
+    } else {
+        // Generation 3: analytic decomposition of PL atom into local consonance + smooth hull.
+        // Per-pair contribution: a_min * LOCAL_CONS_AMP * exp(A2 * sf).
+        // No cutoff — the decomposition is global and continuous.
+        for (size_t pi = 0; pi < np; ++pi) {
+            for (size_t pj = 0; pj < np; ++pj) {
+                double f_base = f0_ * partials[pi].ratio;
+                double a_min = std::min(partials[pi].amplitude, partials[pj].amplitude);
+                double a_scaled = a_min * LOCAL_CONS_AMP;
+
+                for (int ci = 0; ci < n_points; ++ci) {
+                    double f_trans = f0_ * cents_ratios_[ci] * partials[pj].ratio;
+                    double fdif = std::abs(f_base - f_trans);
+                    double f_low = std::min(f_base, f_trans);
+                    double s = DSTAR / (S1 * f_low + S2);
+                    double sf = s * fdif;
+
+                    spiky[ci] += a_scaled * std::exp(A2 * sf);
                 }
             }
         }
     }
 
     // Hull = PL + spiky (flat-topped PL)
-    result.hull.resize(n_points);
-    for (int i = 0; i < n_points; ++i) {
-        result.hull[i] = result.pl[i] + result.spiky[i];
+    if (out.hull) {
+        for (int i = 0; i < n_points; ++i) {
+            out.hull[i] = pl[i] + spiky[i];
+        }
     }
 
     // Find peak spiky (at unison)
-    result.peak = *std::max_element(result.spiky.begin(), result.spiky.end());
+    out.peak = *std::max_element(spiky, spiky + n_points);
 
     // Auto-compute logBaseline if <= 0: find value where |logBaseline| fraction maps to zero
-    result.logBaseline = logBaseline;
+    out.logBaseline = logBaseline;
     double effectiveLogBaseline = logBaseline;
-    if (logBaseline <= 0.0 && result.peak > 0.0) {
+    if (logBaseline <= 0.0 && out.peak > 0.0) {
         double targetFraction = (logBaseline < 0.0) ? -logBaseline : 0.5;
         targetFraction = std::clamp(targetFraction, 0.01, 0.99);
 
         // Find the threshold: the value at the targetFraction percentile
         // Using nth_element for O(n) median finding
-        std::vector<double> sorted_spiky(result.spiky);
+        scratch_.assign(spiky, spiky + n_points);
         int target_idx = static_cast<int>(targetFraction * (n_points - 1));
-        std::nth_element(sorted_spiky.begin(), sorted_spiky.begin() + target_idx, sorted_spiky.end());
-        double threshold = sorted_spiky[target_idx];
+        std::nth_element(scratch_.begin(), scratch_.begin() + target_idx, scratch_.end());
+        double threshold = scratch_[target_idx];
 
         if (threshold > 0.0) {
             // logBaseline = -1 / log10(threshold / peak)
-            double ratio = threshold / result.peak;
+            double ratio = threshold / out.peak;
             effectiveLogBaseline = -1.0 / std::log10(ratio);
         } else {
             // More than targetFraction of points are already zero
             // Find the smallest nonzero spiky value above the target
             int n_zero = 0;
             for (int i = 0; i < n_points; ++i)
-                if (result.spiky[i] <= 0.0) ++n_zero;
+                if (spiky[i] <= 0.0) ++n_zero;
 
             if (n_zero < n_points) {
                 // Collect nonzero values
-                std::vector<double> nonzero;
-                nonzero.reserve(n_points - n_zero);
+                std::vector<double>& nonzero = scratch_;
+                nonzero.clear();
                 for (int i = 0; i < n_points; ++i)
-                    if (result.spiky[i] > 0.0) nonzero.push_back(result.spiky[i]);
+                    if (spiky[i] > 0.0) nonzero.push_back(spiky[i]);
 
                 // We need (targetFraction * n_points - n_zero) additional points to be cut
                 int additional_cut = static_cast<int>(targetFraction * n_points) - n_zero;
                 if (additional_cut > 0 && additional_cut < static_cast<int>(nonzero.size())) {
                     std::nth_element(nonzero.begin(), nonzero.begin() + additional_cut, nonzero.end());
                     double t = nonzero[additional_cut];
-                    double ratio = t / result.peak;
+                    double ratio = t / out.peak;
                     effectiveLogBaseline = -1.0 / std::log10(ratio);
                 } else {
                     // Already exceeds target or no nonzero values to cut
@@ -173,162 +241,104 @@ ConsonanceCurve computeConsonanceCurve(const Spectrum& spectrum, double f0,
                 effectiveLogBaseline = 0.5; // fallback: all zero
             }
         }
-        result.logBaseline = effectiveLogBaseline;
+        out.logBaseline = effectiveLogBaseline;
     }
 
     // Compute consonance: max(0, 1 + logBaseline * log10(spiky/peak))
-    if (result.peak > 0.0) {
+    if (out.consonance) {
         for (int i = 0; i < n_points; ++i) {
-            if (result.spiky[i] > 0.0) {
-                double norm = result.spiky[i] / result.peak;
-                double c = 1.0 + effectiveLogBaseline * std::log10(norm);
-                result.consonance[i] = std::max(0.0, c);
+            double c = 0.0;
+            if (out.peak > 0.0 && spiky[i] > 0.0) {
+                double norm = spiky[i] / out.peak;
+                c = std::max(0.0, 1.0 + effectiveLogBaseline * std::log10(norm));
             }
+            out.consonance[i] = c;
         }
     }
-
-    return result;
 }
 
-ConsonanceCurve computeConsonanceCurveGen3(const Spectrum& spectrum, double f0,
-    double cents_min, double cents_max, double resolution, double logBaseline)
+// Runs a fresh evaluator straight into the vectors of a ConsonanceCurve
+static ConsonanceCurve evaluateCurve(const Spectrum& spectrum, double f0,
+    double cents_min, double cents_max, double resolution, double logBaseline, bool gen3)
 {
-    int n_points = static_cast<int>((cents_max - cents_min) / resolution) + 1;
+    ConsonanceEvaluator evaluator(spectrum, f0, cents_min, cents_max, resolution);
+    int n_points = evaluator.size();
 
     ConsonanceCurve result;
     result.cents.resize(n_points);
     result.pl.resize(n_points);
-    result.spiky.resize(n_points, 0.0);
-    result.consonance.resize(n_points, 0.0);
-
-    // Build cents grid and precompute ratios
-    std::vector<double> cents_ratios(n_points);
-    for (int i = 0; i < n_points; ++i) {
-        result.cents[i] = cents_min + i * (cents_max - cents_min) / (n_points - 1);
-        cents_ratios[i] = std::pow(2.0, result.cents[i] / 1200.0);
-    }
-
-    // Compute PL curve
-    for (int i = 0; i < n_points; ++i) {
-        result.pl[i] = computeDissonanceAtCents(spectrum, f0, result.cents[i]);
-    }
-
-    // Generation 3: analytic decomposition of PL atom into local consonance + smooth hull.
-    // Per-pair contribution: a_min * LOCAL_CONS_AMP * exp(A2 * sf).
-    // No cutoff — the decomposition is global and continuous.
-    const auto& partials = spectrum.partials;
-    size_t np = partials.size();
-
-    for (size_t pi = 0; pi < np; ++pi) {
-        for (size_t pj = 0; pj < np; ++pj) {
-            double f_base = f0 * partials[pi].ratio;
-            double a_min = std::min(partials[pi].amplitude, partials[pj].amplitude);
-            double a_scaled = a_min * LOCAL_CONS_AMP;
-
-            for (int ci = 0; ci < n_points; ++ci) {
-                double f_trans = f0 * cents_ratios[ci] * partials[pj].ratio;
-                double fdif = std::abs(f_base - f_trans);
-                double f_low = std::min(f_base, f_trans);
-                double s = DSTAR / (S1 * f_low + S2);
-                double sf = s * fdif;
-
-                result.spiky[ci] += a_scaled * std::exp(A2 * sf);
-            }
-        }
-    }
-
-    // Hull = PL + spiky
     result.hull.resize(n_points);
-    for (int i = 0; i < n_points; ++i) {
-        result.hull[i] = result.pl[i] + result.spiky[i];
+    result.spiky.resize(n_points);
+    result.consonance.resize(n_points);
+
+    ConsonanceCurveOut out;
+    out.cents = result.cents.data();
+    out.pl = result.pl.data();
+    out.hull = result.hull.data();
+    out.spiky = result.spiky.data();
+    out.consonance = result.consonance.data();
+    if (gen3) {
+        evaluator.computeGen3(out, logBaseline);
+    } else {
+        evaluator.compute(out, logBaseline);
     }
+    result.peak = out.peak;
+    result.logBaseline = out.logBaseline;
+    return result;
+}
 
-    // Find peak spiky (at unison)
-    result.peak = *std::max_element(result.spiky.begin(), result.spiky.end());
-
-    // Auto-compute logBaseline if <= 0
-    result.logBaseline = logBaseline;
-    double effectiveLogBaseline = logBaseline;
-    if (logBaseline <= 0.0 && result.peak > 0.0) {
-        double targetFraction = (logBaseline < 0.0) ? -logBaseline : 0.5;
-        targetFraction = std::clamp(targetFraction, 0.01, 0.99);
-
-        std::vector<double> sorted_spiky(result.spiky);
-        int target_idx = static_cast<int>(targetFraction * (n_points - 1));
-        std::nth_element(sorted_spiky.begin(), sorted_spiky.begin() + target_idx, sorted_spiky.end());
-        double threshold = sorted_spiky[target_idx];
+ConsonanceCurve computeConsonanceCurve(const Spectrum& spectrum, double f0,
+    double cents_min, double cents_max, double resolution, double logBaseline)
+{
+    return evaluateCurve(spectrum, f0, cents_min, cents_max, resolution, logBaseline, false);
+}
 
-        if (threshold > 0.0) {
-            double ratio = threshold / result.peak;
-            effectiveLogBaseline = -1.0 / std::log10(ratio);
-        } else {
-            int n_zero = 0;
-            for (int i = 0; i < n_points; ++i)
-                if (result.spiky[i] <= 0.0) ++n_zero;
+ConsonanceCurve computeConsonanceCurveGen3(const Spectrum& spectrum, double f0,
+    double cents_min, double cents_max, double resolution, double logBaseline)
+{
+    return evaluateCurve(spectrum, f0, cents_min, cents_max, resolution, logBaseline, true);
+}
 
-            if (n_zero < n_points) {
-                std::vector<double> nonzero;
-                nonzero.reserve(n_points - n_zero);
-                for (int i = 0; i < n_points; ++i)
-                    if (result.spiky[i] > 0.0) nonzero.push_back(result.spiky[i]);
+// Curve the intervals of a scale are read off, extended past both ends
+static ConsonanceCurve analysisCurve(const Spectrum& spectrum, double f0,
+    double max_cents, double logBaseline)
+{
+    double margin = 300.0;
+    double resolution = 0.5;
+    return computeConsonanceCurve(spectrum, f0,
+        0.0 - margin, max_cents + margin, resolution, logBaseline);
+}
 
-                int additional_cut = static_cast<int>(targetFraction * n_points) - n_zero;
-                if (additional_cut > 0 && additional_cut < static_cast<int>(nonzero.size())) {
-                    std::nth_element(nonzero.begin(), nonzero.begin() + additional_cut, nonzero.end());
-                    double t = nonzero[additional_cut];
-                    double ratio = t / result.peak;
-                    effectiveLogBaseline = -1.0 / std::log10(ratio);
-                } else {
-                    effectiveLogBaseline = 0.5;
-                }
-            } else {
-                effectiveLogBaseline = 0.5;
-            }
-        }
-        result.logBaseline = effectiveLogBaseline;
-    }
+// Intervals above max_interval_cents are left out (a NaN interval is not
+// above it, and is analyzed with consonance 0)
+static bool skipInterval(double cents, double max_interval_cents) {
+    return cents > max_interval_cents;
+}
 
-    // Compute consonance: max(0, 1 + logBaseline * log10(spiky/peak))
-    if (result.peak > 0.0) {
-        for (int i = 0; i < n_points; ++i) {
-            if (result.spiky[i] > 0.0) {
-                double norm = result.spiky[i] / result.peak;
-                double c = 1.0 + effectiveLogBaseline * std::log10(norm);
-                result.consonance[i] = std::max(0.0, c);
-            }
+// Consonance at cents by linear interpolation, 0 outside the curve
+static double consonanceAt(const ConsonanceCurve& curve, double cents) {
+    int n = static_cast<int>(curve.cents.size());
+    for (int i = 0; i + 1 < n; ++i) {
+        if (curve.cents[i] <= cents && curve.cents[i + 1] >= cents) {
+            double t = (cents - curve.cents[i]) / (curve.cents[i + 1] - curve.cents[i]);
+            return curve.consonance[i] + t * (curve.consonance[i + 1] - curve.consonance[i]);
         }
     }
-
-    return result;
+    return 0.0;
 }
 
 ConsonanceResult analyzeScale(const Spectrum& spectrum, double f0,
     const std::vector<std::pair<std::string, double>>& intervals,
     double max_cents, double max_interval_cents, double logBaseline)
 {
-    double margin = 300.0;
-    double resolution = 0.5;
+    ConsonanceCurve curve = analysisCurve(spectrum, f0, max_cents, logBaseline);
 
-    // Compute consonance curve on extended range
-    ConsonanceCurve curve = computeConsonanceCurve(spectrum, f0,
-        0.0 - margin, max_cents + margin, resolution, logBaseline);
-
-    // Evaluate consonance at each interval by linear interpolation
     ConsonanceResult result;
     result.total_consonance = 0.0;
 
     for (auto& [name, cents] : intervals) {
-        if (cents > max_interval_cents) continue;
-
-        double c = 0.0;
-        int n = static_cast<int>(curve.cents.size());
-        for (int i = 0; i + 1 < n; ++i) {
-            if (curve.cents[i] <= cents && curve.cents[i + 1] >= cents) {
-                double t = (cents - curve.cents[i]) / (curve.cents[i + 1] - curve.cents[i]);
-                c = curve.consonance[i] + t * (curve.consonance[i + 1] - curve.consonance[i]);
-                break;
-            }
-        }
+        if (skipInterval(cents, max_interval_cents)) continue;
+        double c = consonanceAt(curve, cents);
         result.intervals.push_back({name, cents, c});
         result.total_consonance += c;
     }
@@ -338,4 +348,61 @@ ConsonanceResult analyzeScale(const Spectrum& spectrum, double f0,
     return result;
 }
 
+size_t analyzeIntervals(const Spectrum& spectrum, double f0,
+    const double* interval_cents, size_t n, double* consonance_out, double* mean_out,
+    double max_cents, double max_interval_cents, double logBaseline)
+{
+    ConsonanceCurve curve = analysisCurve(spectrum, f0, max_cents, logBaseline);
+
+    size_t analyzed = 0;
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        if (skipInterval(interval_cents[i], max_interval_cents)) {
+            consonance_out[i] = std::numeric_limits<double>::quiet_NaN();
+            continue;
+        }
+        consonance_out[i] = consonanceAt(curve, interval_cents[i]);
+        total += consonance_out[i];
+        ++analyzed;
+    }
+    if (mean_out) {
+        *mean_out = analyzed == 0 ? 0.0 : total / analyzed;
+    }
+    return analyzed;
+}
+
+ConsonanceCurveBuffer::ConsonanceCurveBuffer(const Spectrum& spectrum, double f0,
+    double cents_min, double cents_max, double resolution)
+    : evaluator_(spectrum, f0, cents_min, cents_max, resolution),
+      pl_(evaluator_.size()), hull_(evaluator_.size()),
+      spiky_(evaluator_.size()), consonance_(evaluator_.size())
+{
+}
+
+ConsonanceCurveOut ConsonanceCurveBuffer::out() {
+    ConsonanceCurveOut out;
+    out.pl = pl_.data();
+    out.hull = hull_.data();
+    out.spiky = spiky_.data();
+    out.consonance = consonance_.data();
+    return out;
+}
+
+void ConsonanceCurveBuffer::keep(const ConsonanceCurveOut& out) {
+    peak_ = out.peak;
+    log_baseline_ = out.logBaseline;
+}
+
+void ConsonanceCurveBuffer::compute(double logBaseline) {
+    ConsonanceCurveOut curve = out();
+    evaluator_.compute(curve, logBaseline);
+    keep(curve);
+}
+
+void ConsonanceCurveBuffer::computeGen3(double logBaseline) {
+    ConsonanceCurveOut curve = out();
+    evaluator_.computeGen3(curve, logBaseline);
+    keep(curve);
+}
+
 } // namespace scalatrix
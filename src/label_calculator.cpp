@@ -1,4 +1,8 @@
 #include "scalatrix/label_calculator.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 namespace scalatrix {
 
@@ -104,16 +108,218 @@ std::string LabelCalculator::nodeLabelLetterWithOctaveNumberTuning(const MOS& mo
     return result;
 }
 
+// ── Normalized labels ────────────────────────────────────────────────────────
+
+const MOS& LabelCalculator::diatonicReference() {
+    // Initialised once, thread-safely, by the first caller
+    static const MOS diatonic = MOS::fromParams(5, 2, 1, 1.0, .585);
+    return diatonic;
+}
+
+std::string LabelCalculator::noteLabelNormalized(const MOS& mos, Vector2i v, bool override_letter_labels) const {
+    if (mos.generator > 4.0/7 && mos.generator < 3.0/5 && mos.equave > 0.9 && mos.equave < 1.2 && !override_letter_labels)
+    {
+        const MOS& diatonic = diatonicReference();
+        Vector2i diatonic_coord = diatonic.mapFromMOS(mos, v);
+        return nodeLabelLetter(diatonic, diatonic_coord);
+    }
+    return nodeLabelDigit(mos, v);
+}
+
+// ── Label tables ─────────────────────────────────────────────────────────────
+
+static const char SHARP[] = "\xe2\x99\xaf"; // ♯ (U+266F)
+static const char FLAT[] = "\xe2\x99\xad";  // ♭ (U+266D)
+static const size_t SIGN_BYTES = 3;
+
+static int floorDiv(int a, int b) {
+    int q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+static int floorMod(int a, int b) {
+    int r = a % b;
+    return r < 0 ? r + b : r;
+}
+
+bool LabelTable::matches(const MOS& mos, bool tuning) const {
+    int L_x = tuning ? mos.L_vec.x : mos.structure_L_vec.x;
+    return n_ == mos.n && n0_ == mos.n0 && a0_ == mos.a0 && b0_ == mos.b0
+        && tuning_ == tuning && acc_sign_ == (L_x == 1 ? 1 : -1)
+        && neutral_mode_ == (L_x == 1 ? 1 : mos.n0 - 2);
+}
+
+void LabelTable::rebuild(const MOS& mos, bool tuning) {
+    if (!empty() && matches(mos, tuning)) return;
+    int L_x = tuning ? mos.L_vec.x : mos.structure_L_vec.x;
+    n_ = mos.n;
+    n0_ = mos.n0;
+    a0_ = mos.a0;
+    b0_ = mos.b0;
+    tuning_ = tuning;
+    acc_sign_ = L_x == 1 ? 1 : -1;
+    neutral_mode_ = L_x == 1 ? 1 : mos.n0 - 2;
+
+    pool_.clear();
+    offsets_.clear();
+    auto add = [&](const std::string& s) {
+        offsets_.push_back(static_cast<uint32_t>(pool_.size()));
+        pool_ += s;
+    };
+    for (int d = 0; d < n_; ++d) add(std::to_string(d + 1));
+    for (int d = 0; d < n_; ++d) add(std::to_string(d));
+    // Degree 0 is C, as in nodeLabelLetter
+    for (int d = 0; d < n_; ++d) add(std::string(1, 'A' + floorMod(d + 2, n_)));
+    for (int acc = -MAX_POOLED_ACCIDENTALS; acc <= MAX_POOLED_ACCIDENTALS; ++acc) {
+        std::string s;
+        for (int i = 0; i < std::abs(acc); ++i) s += acc < 0 ? FLAT : SHARP;
+        add(s);
+    }
+    offsets_.push_back(static_cast<uint32_t>(pool_.size()));
+}
+
+int LabelTable::degree(Vector2i v) const {
+    return floorMod(v.x + v.y, n_);
+}
+
+int LabelTable::accidentals(Vector2i v) const {
+    int n_generators = v.x * b0_ - v.y * a0_;
+    return acc_sign_ * floorDiv(n_generators + neutral_mode_, n0_);
+}
+
+int LabelTable::octave(Vector2i v, int middle_C_octave) const {
+    return middle_C_octave + floorDiv(v.x + v.y, n_);
+}
+
+std::string_view LabelTable::degreeString(int degree, Style style) const {
+    if (degree < 0 || degree >= n_) return {};
+    int column = style == LETTER_WITH_OCTAVE ? LETTER : style;
+    return piece(static_cast<size_t>(column) * n_ + degree);
+}
+
+std::string_view LabelTable::accidentalString(int accidentals) const {
+    if (empty() || std::abs(accidentals) > MAX_POOLED_ACCIDENTALS) return {};
+    return piece(3 * static_cast<size_t>(n_) + accidentals + MAX_POOLED_ACCIDENTALS);
+}
+
+namespace {
+
+// Appends to a fixed buffer, counting what does not fit
+struct LabelWriter {
+    char* buf;
+    size_t size, length = 0;
+
+    void put(const char* s, size_t k) {
+        if (length < size) std::memcpy(buf + length, s, std::min(k, size - length));
+        length += k;
+    }
+    void put(std::string_view s) { put(s.data(), s.size()); }
+    void putInt(int value) {
+        char digits[12];
+        unsigned u = value < 0 ? 0u - static_cast<unsigned>(value) : static_cast<unsigned>(value);
+        int k = sizeof(digits);
+        do {
+            digits[--k] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u);
+        if (value < 0) digits[--k] = '-';
+        put(digits + k, sizeof(digits) - k);
+    }
+};
+
+// Appends the label write(buf, size) formats, like snprintf, to out: into
+// a stack buffer first, and straight into out only if it does not fit. A
+// negative return, snprintf's encoding error, appends nothing.
+template <typename Write>
+void appendLabel(std::string& out, Write write) {
+    char stack[64];
+    long long length = static_cast<long long>(write(stack, sizeof(stack)));
+    if (length < 0) return;
+    if (static_cast<size_t>(length) < sizeof(stack)) {
+        out.append(stack, static_cast<size_t>(length));
+        return;
+    }
+    size_t start = out.size();
+    out.resize(start + static_cast<size_t>(length));
+    // The terminating NUL lands on out's own
+    if (static_cast<long long>(write(&out[start], static_cast<size_t>(length) + 1)) < 0) out.resize(start);
+}
+
+} // namespace
+
+size_t LabelTable::write(Vector2i v, Style style, char* buf, size_t size,
+                         bool accidentalAfter, int middle_C_octave) const {
+    if (empty()) {
+        if (size > 0) buf[0] = '\0';
+        return 0;
+    }
+    LabelWriter out{buf, size > 0 ? size - 1 : 0};
+    std::string_view deg = degreeString(degree(v), style);
+    int acc = accidentals(v);
+    auto putAccidentals = [&]() {
+        if (std::abs(acc) <= MAX_POOLED_ACCIDENTALS) {
+            out.put(accidentalString(acc));
+            return;
+        }
+        for (int i = 0; i < std::abs(acc); ++i) out.put(acc < 0 ? FLAT : SHARP, SIGN_BYTES);
+    };
+    if (!accidentalAfter) putAccidentals();
+    out.put(deg);
+    if (accidentalAfter) putAccidentals();
+    if (style == LETTER_WITH_OCTAVE) out.putInt(octave(v, middle_C_octave));
+    if (size > 0) buf[std::min(out.length, size - 1)] = '\0';
+    return out.length;
+}
+
+std::string LabelTable::label(Vector2i v, Style style, bool accidentalAfter, int middle_C_octave) const {
+    std::string result;
+    appendLabel(result, [&](char* buf, size_t size) {
+        return write(v, style, buf, size, accidentalAfter, middle_C_octave);
+    });
+    return result;
+}
+
+void LabelTable::append(Vector2i v, Style style, LabelBatch& out,
+                        bool accidentalAfter, int middle_C_octave) const {
+    appendLabel(out.text, [&](char* buf, size_t size) {
+        return write(v, style, buf, size, accidentalAfter, middle_C_octave);
+    });
+    out.offsets.push_back(static_cast<uint32_t>(out.text.size()));
+}
+
+void LabelTable::labelCoords(const Vector2i* coords, size_t count, Style style, LabelBatch& out,
+                             bool accidentalAfter, int middle_C_octave) const {
+    out.clear();
+    out.offsets.reserve(count + 1);
+    for (size_t i = 0; i < count; ++i) append(coords[i], style, out, accidentalAfter, middle_C_octave);
+}
+
+void LabelTable::labelRect(Vector2i origin, int width, int height, Style style, LabelBatch& out,
+                           bool accidentalAfter, int middle_C_octave) const {
+    out.clear();
+    if (width <= 0 || height <= 0) return;
+    out.offsets.reserve(static_cast<size_t>(width) * height + 1);
+    for (int y = origin.y; y < origin.y + height; ++y) {
+        for (int x = origin.x; x < origin.x + width; ++x) {
+            append(Vector2i(x, y), style, out, accidentalAfter, middle_C_octave);
+        }
+    }
+}
+
 // ── Deviation label ──────────────────────────────────────────────────────────
 
-std::string LabelCalculator::deviationLabel(const Node& node, double thresholdCents,
-                                            bool compareWithTempered) {
+namespace {
+
+// writeDeviationLabel with snprintf's return, negative on an encoding error
+int formatDeviationLabel(const Node& node, char* buf, size_t size,
+                         double thresholdCents, bool compareWithTempered) {
     // Select which pitch to use as reference
     const PitchSetPitch& referencePitch = node.closestPitch;
     
-    // If no reference pitch is set, return empty string
+    // If no reference pitch is set, the label is empty
     if (referencePitch.label.empty()) {
-        return "";
+        if (size > 0) buf[0] = '\0';
+        return 0;
     }
     
     // Calculate the actual pitch of this node
@@ -124,20 +330,43 @@ std::string LabelCalculator::deviationLabel(const Node& node, double thresholdCe
     
     // If deviation is small enough, use plain label
     if (std::abs(deviationCents) < thresholdCents) {
-        return referencePitch.label;
+        return std::snprintf(buf, size, "%s", referencePitch.label.c_str());
     }
     
     // Otherwise, append deviation
-    char deviationStr[32];
-    if (deviationCents > 0) {
-        std::snprintf(deviationStr, sizeof(deviationStr), "%s+%.1fct", 
-                     referencePitch.label.c_str(), deviationCents);
-    } else {
-        std::snprintf(deviationStr, sizeof(deviationStr), "%s%.1fct", 
-                     referencePitch.label.c_str(), deviationCents);
+    return std::snprintf(buf, size, deviationCents > 0 ? "%s+%.1fct" : "%s%.1fct",
+                         referencePitch.label.c_str(), deviationCents);
+}
+
+} // namespace
+
+size_t LabelCalculator::writeDeviationLabel(const Node& node, char* buf, size_t size,
+                                            double thresholdCents, bool compareWithTempered) {
+    int length = formatDeviationLabel(node, buf, size, thresholdCents, compareWithTempered);
+    if (length >= 0) return static_cast<size_t>(length);
+    if (size > 0) buf[0] = '\0';
+    return 0;
+}
+
+std::string LabelCalculator::deviationLabel(const Node& node, double thresholdCents,
+                                            bool compareWithTempered) {
+    std::string result;
+    appendLabel(result, [&](char* buf, size_t size) {
+        return formatDeviationLabel(node, buf, size, thresholdCents, compareWithTempered);
+    });
+    return result;
+}
+
+void LabelCalculator::deviationLabels(const Node* nodes, size_t count, LabelBatch& out,
+                                      double thresholdCents, bool compareWithTempered) {
+    out.clear();
+    out.offsets.reserve(count + 1);
+    for (size_t i = 0; i < count; ++i) {
+        appendLabel(out.text, [&](char* buf, size_t size) {
+            return formatDeviationLabel(nodes[i], buf, size, thresholdCents, compareWithTempered);
+        });
+        out.offsets.push_back(static_cast<uint32_t>(out.text.size()));
     }
-    
-    return std::string(deviationStr);
 }
 
 } // namespace scalatrix
\ No newline at end of file
@@ -1,85 +1,274 @@
 #include "scalatrix/lattice.hpp"
-#include <vector>
+#include <algorithm>
 #include <cassert>
+#include <climits>
 #include <cmath>
+#include <cstdlib>
+#include <numeric>
 
 namespace scalatrix {
 
 double isnull (double x) {
     return std::abs(x) < 1e-6;
-}   
+}
 
-std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M) {
+namespace {
 
-    auto M_inv = M.inverse();
-    Vector2d v(1.0, 0.0);
-    Vector2d zv = M_inv * v;
+const int CF_MAX_TERMS = 20;          // convergents of the strip slope tried
+const int REDUCTION_MAX_ROUNDS = 64;  // subtract/swap rounds of the reduction
+const int REDUCTION_MAX_FIXUP = 4;    // corrections to the extrapolated step count
 
-    Vector2i r, s;
-    Vector2d z;
-    bool has_first = false, has_second = false;
-    if (isnull(zv.x)){
-        s = Vector2i(0, zv.y>0?1:-1);
-        has_first = true;
-        z = M * Vector2i(1, 0);
-        if (std::abs(z.y) < 1){
-            r = Vector2i(z.y>0?1:-1, 0);
-            has_second = true;
-        }else{
-            r = s;
+// Exact mode snaps every entry of M to p/q with q <= EXACT_MAX_DEN, all over
+// one common denominator EXACT_MAX_UNIT at most. The entry bound keeps every
+// product in the search below 2^62.
+const long long EXACT_MAX_DEN = 1 << 12;
+const long long EXACT_MAX_UNIT = 1 << 20;
+const long long EXACT_MAX_ENTRY = 1LL << 28;
+const double EXACT_TOLERANCE = 1e-9;
+
+/**
+ * Floating-point arithmetic for the strip search. Performs the same
+ * operations as the original implementation, in the same order, so the two
+ * agree wherever the original was well defined.
+ */
+struct FloatArithmetic {
+    typedef double Scalar;
+    typedef Vector2d Point;
+
+    const AffineTransform& M;
+    Scalar zvx, zvy;  // preimage of (1, 0)
+    double f = 0.0;   // fractional part of the continued fraction
+
+    explicit FloatArithmetic(const AffineTransform& M_) : M(M_) {
+        Vector2d zv = M.inverse() * Vector2d(1.0, 0.0);
+        zvx = zv.x;
+        zvy = zv.y;
+    }
+
+    bool isNull(Scalar x) const { return isnull(x); }
+    bool sameSign() const { return zvx * zvy > 0; }
+    Point map(const Vector2i& v) const { return M * v; }
+    bool inStrip(const Point& z) const { return z.y < 1 && z.y > -1; }
+    double unit() const { return 1.0; }
+    static double toDouble(Scalar x) { return x; }
+
+    int cfBegin(bool x_large) {
+        double e = x_large ? std::abs(zvy / zvx) : std::abs(zvx / zvy);
+        int a = std::floor(e);
+        f = e - a;
+        return a;
+    }
+
+    // Next partial quotient; false where 1/f would not fit an int
+    bool cfNext(int& a) {
+        if (!(f > 0) || 1 / f >= (double)INT_MAX) return false;
+        a = std::floor(1 / f);
+        f = 1 / f - a;
+        return true;
+    }
+};
+
+// Best rational approximation p/q of x within tolerance, q <= EXACT_MAX_DEN
+bool snapRational(double x, long long& p, long long& q) {
+    if (!std::isfinite(x) || std::abs(x) > (double)EXACT_MAX_ENTRY) return false;
+    double tol = EXACT_TOLERANCE * std::max(1.0, std::abs(x));
+    long long p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double y = x;
+    for (int i = 0; i < 64; ++i) {
+        double fl = std::floor(y);
+        if (q1 > 0 && fl > (double)EXACT_MAX_DEN) return false;
+        long long a = (long long)fl;
+        long long p2 = a * p1 + p0, q2 = a * q1 + q0;
+        if (q2 > EXACT_MAX_DEN) return false;
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+        if (std::abs(x - (double)p1 / (double)q1) <= tol) {
+            p = p1;
+            q = q1;
+            return true;
         }
+        double frac = y - fl;
+        if (frac <= 0) return false;
+        y = 1 / frac;
     }
-    else if (isnull(zv.y)){
-        s = Vector2i(zv.x>0?1:-1, 0);
-        has_first = true;
-        z = M * Vector2i(0, 1);
-        if (std::abs(z.y) < 1){
-            r = Vector2i(0, z.y>0?1:-1);
-            has_second = true;
-        }else{
-            r = s;
+    return false;
+}
+
+/**
+ * Exact arithmetic for the strip search: M scaled by a common denominator
+ * `scale` to integers, so z.y < 1 becomes z.y < scale and every comparison
+ * is exact. The continued fraction of the strip slope is a plain Euclid and
+ * terminates on its own.
+ */
+struct ExactArithmetic {
+    typedef long long Scalar;
+    struct Point {
+        long long x, y;
+    };
+
+    long long a, b, c, d, tx, ty, scale;
+    long long det;
+    Scalar zvx, zvy;
+    long long p = 0, q = 1;  // remaining fraction p/q of the continued fraction
+
+    // Returns false if M is not close to a rational transform
+    bool snap(const AffineTransform& M) {
+        const double entries[6] = {M.a, M.b, M.c, M.d, M.tx, M.ty};
+        long long num[6], den[6];
+        scale = 1;
+        for (int i = 0; i < 6; ++i) {
+            if (!snapRational(entries[i], num[i], den[i])) return false;
+            scale = scale / std::gcd(scale, den[i]) * den[i];
+            if (scale > EXACT_MAX_UNIT) return false;
+        }
+        long long* out[6] = {&a, &b, &c, &d, &tx, &ty};
+        for (int i = 0; i < 6; ++i) {
+            long long v = num[i] * (scale / den[i]);
+            if (std::llabs(v) > EXACT_MAX_ENTRY) return false;
+            *out[i] = v;
         }
+        det = a * d - b * c;
+        // adj(M) * ((1, 0) - t), the preimage of (1, 0) up to a positive factor
+        long long ux = scale - tx, uy = -ty;
+        zvx = d * ux - b * uy;
+        zvy = -c * ux + a * uy;
+        if (det < 0) {
+            zvx = -zvx;
+            zvy = -zvy;
+        }
+        return true;
+    }
+
+    bool isNull(Scalar x) const { return x == 0; }
+    bool sameSign() const { return (zvx > 0) == (zvy > 0); }
+    Point map(const Vector2i& v) const {
+        return {a * v.x + b * v.y + tx, c * v.x + d * v.y + ty};
+    }
+    bool inStrip(const Point& z) const { return z.y < scale && z.y > -scale; }
+    double unit() const { return (double)scale; }
+    static double toDouble(Scalar x) { return (double)x; }
+
+    int cfBegin(bool x_large) {
+        long long n = std::llabs(x_large ? zvy : zvx);
+        long long m = std::llabs(x_large ? zvx : zvy);
+        long long a0 = n / m;
+        p = n - a0 * m;
+        q = m;
+        return (int)a0;
+    }
+
+    bool cfNext(int& a_next) {
+        if (p == 0) return false;
+        long long a0 = q / p;
+        if (a0 > INT_MAX) return false;
+        long long rem = q - a0 * p;
+        q = p;
+        p = rem;
+        a_next = (int)a0;
+        return true;
+    }
+};
+
+// s - k*r, or false if a coordinate leaves the int range
+bool stepBack(const Vector2i& s, const Vector2i& r, long long k, Vector2i& out) {
+    long long x = (long long)s.x - k * r.x;
+    long long y = (long long)s.y - k * r.y;
+    if (x > INT_MAX || x < INT_MIN || y > INT_MAX || y < INT_MIN) return false;
+    out = Vector2i((int)x, (int)y);
+    return true;
+}
+
+/**
+ * Largest k >= 0 such that s - j*r stays right of the origin and inside the
+ * strip for every j <= k. The point moves linearly in j, so that set is an
+ * interval and k is read off the nearest of the three boundaries, then
+ * corrected against M itself so rounding resolves exactly as stepping would.
+ */
+template <class Arithmetic>
+long long reductionSteps(const Arithmetic& ar, const Vector2i& r, const typename Arithmetic::Point& zr,
+                         const Vector2i& s, const typename Arithmetic::Point& zs) {
+    double rx = Arithmetic::toDouble(zr.x), ry = Arithmetic::toDouble(zr.y);
+    double sx = Arithmetic::toDouble(zs.x), sy = Arithmetic::toDouble(zs.y);
+    double u = ar.unit();
+
+    double k_max = INFINITY;
+    if (rx > 0) k_max = std::min(k_max, sx / rx);
+    if (ry > 0) k_max = std::min(k_max, (u + sy) / ry);
+    else if (ry < 0) k_max = std::min(k_max, (u - sy) / -ry);
+    // Unbounded only if M*r == 0, i.e. M is singular
+    if (!(k_max < INFINITY)) return 0;
+
+    long long limit = INT_MAX / std::max(1, std::max(std::abs(r.x), std::abs(r.y)));
+    long long k = std::min((double)limit, std::max(0.0, std::ceil(k_max) - 1));
+
+    auto holds = [&](long long j) {
+        Vector2i v;
+        if (!stepBack(s, r, j, v)) return false;
+        typename Arithmetic::Point z = ar.map(v);
+        return z.x > 0 && ar.inStrip(z);
+    };
+    for (int i = 0; i < REDUCTION_MAX_FIXUP && k > 0 && !holds(k); ++i) k--;
+    for (int i = 0; i < REDUCTION_MAX_FIXUP && holds(k + 1); ++i) k++;
+    return k;
+}
+
+template <class Arithmetic>
+std::pair<Vector2i, Vector2i> searchStrip(Arithmetic& ar) {
+    Vector2i r, s;
+    bool has_first = false, has_second = false;
+    // If the preimage of the x axis is a lattice direction, that direction
+    // is one step and the unit vector off it the other, if it lands in the
+    // strip. Both point to +x. (The original had the diagonal case as
+    // (1, 0) / (0, 1) and oriented the second step by y.)
+    bool on_axis = true;
+    Vector2i other;
+    if (ar.isNull(ar.zvx)){
+        s = Vector2i(0, ar.zvy>0?1:-1);
+        other = Vector2i(1, 0);
+    }
+    else if (ar.isNull(ar.zvy)){
+        s = Vector2i(ar.zvx>0?1:-1, 0);
+        other = Vector2i(0, 1);
+    }
+    else if (ar.isNull(ar.zvx - ar.zvy)){
+        s = ar.zvx>0 ? Vector2i(1, 1) : Vector2i(-1, -1);
+        other = Vector2i(1, 0);
     }
-    else if (isnull(zv.x - zv.y)){
-        s = Vector2i(zv.x>0?1:-1, 0);
+    else {
+        on_axis = false;
+    }
+    if (on_axis){
         has_first = true;
-        z = M * Vector2i(1, 0);
-        if (std::abs(z.y) < 1){
-            r = Vector2i(0, z.y>0?1:-1);
+        typename Arithmetic::Point z = ar.map(other);
+        if (ar.inStrip(z)){
+            r = (z.x < 0 || (z.x == 0 && z.y < 0)) ? -other : other;
             has_second = true;
         }else{
             r = s;
         }
     }
-    else 
+    else
     {
-        double e;
-        bool x_large = std::abs(zv.x) > std::abs(zv.y);
-        if (x_large){
-            e = std::abs(zv.y/zv.x);
-        }else{
-            e = std::abs(zv.x/zv.y);
-        }
+        // Walk the convergents of the strip slope until two of them land
+        // inside the strip
+        bool x_large = std::abs(ar.zvx) > std::abs(ar.zvy);
+        int sign = ar.sameSign() ? 1 : -1;
+        int a = ar.cfBegin(x_large);
+        int num[CF_MAX_TERMS] = {1, a};
+        int den[CF_MAX_TERMS] = {0, 1};
+        int n = 2;
 
-        int a = std::floor(e);
-        std::vector<int> num = {1, a};
-        std::vector<int> den = {0, 1};
-        double f = e - a;
-
-        while (num.size() < 20) {
+        while (n < CF_MAX_TERMS) {
             if (x_large){
-                r.x = den.back();
-                r.y = (zv.x*zv.y>0?1:-1) * num.back();
+                r = Vector2i(den[n-1], sign * num[n-1]);
             }else{
-                r.x = num.back();
-                r.y = (zv.x*zv.y>0?1:-1) * den.back();
+                r = Vector2i(num[n-1], sign * den[n-1]);
             }
-            z = M * Vector2d((double)r.x, (double)r.y);
+            typename Arithmetic::Point z = ar.map(r);
             if (z.x < 0){
-                z = -z;
                 r = -r;
             }
-            if (z.y < 1 && z.y > -1){
+            if (ar.inStrip(z)){
                 if(!has_first){
                     has_first = true;
                     s = r;
@@ -89,10 +278,13 @@ std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M) {
                     break;
                 }
             }
-            a = std::floor(1/f);
-            f = 1/f - a;
-            num.push_back(a*num[num.size()-1] + num[num.size()-2]);
-            den.push_back(a*den[den.size()-1] + den[den.size()-2]);
+            if (!ar.cfNext(a)) break;
+            long long next_num = (long long)a * num[n-1] + num[n-2];
+            long long next_den = (long long)a * den[n-1] + den[n-2];
+            if (next_num > INT_MAX || next_den > INT_MAX) break;
+            num[n] = (int)next_num;
+            den[n] = (int)next_den;
+            n++;
         }
     }
     if (!has_first){
@@ -102,46 +294,205 @@ std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M) {
         return {s, s};
     }
 
-    Vector2i t;
-    Vector2d zr, zs;
-    bool changed = true;
-    int cnt;
-
-    zr = M * r;
-    zs = M * s;
+    // Lagrange-style reduction: subtract the multiple of r (the vector closer
+    // to the origin in x) that keeps s in the strip, swap if s is now the
+    // closer one, and stop once neither step changes anything
+    typename Arithmetic::Point zr = ar.map(r);
+    typename Arithmetic::Point zs = ar.map(s);
     if (zr.x > zs.x){
         std::swap(r, s);
         std::swap(zr, zs);
     }
 
-    while (changed){
-        changed = false;
-        cnt = 0;
-        if (zs.x>0){
-            while(zs.x > 0 && zs.y > -1 && zs.y < 1){
-                t = s;
-                s -= r;
-                zs = M * s;
-                changed = true;
-                cnt++;
-            }
-            s = t;
-            zs = M * s;             
-            if (cnt==1) {
-                changed = false;
-            }
-            if (zr.x > zs.x){
-                std::swap(r, s);
-                std::swap(zr, zs);
-                changed = true;
-            }   
-        }else{
-            break;
+    for (int round = 0; round < REDUCTION_MAX_ROUNDS && zs.x > 0; ++round) {
+        long long k = reductionSteps(ar, r, zr, s, zs);
+        bool changed = false;
+        if (k > 0) {
+            stepBack(s, r, k, s);
+            zs = ar.map(s);
+            changed = true;
         }
-    } 
+        if (zr.x > zs.x){
+            std::swap(r, s);
+            std::swap(zr, zs);
+            changed = true;
+        }
+        if (!changed) break;
+    }
     assert(zr.x >= 0 && zr.x + zs.x > 0);
     assert(zr.x <= zs.x);
     return {r, s};
 }
 
-} // namespace scalatrix
\ No newline at end of file
+} // namespace
+
+std::pair<Vector2i, Vector2i> findClosestWithinStrip(const AffineTransform& M, bool exact) {
+    if (exact) {
+        ExactArithmetic ar;
+        if (ar.snap(M)) {
+            // A singular transform has no strip steps
+            if (ar.det == 0) return {{0, 0}, {0, 0}};
+            return searchStrip(ar);
+        }
+    }
+    FloatArithmetic ar(M);
+    return searchStrip(ar);
+}
+
+/*static*/
+bool StripBasisCache::isValid(const AffineTransform& M, const Vector2i& r, const Vector2i& s) {
+    long long det = (long long)r.x * s.y - (long long)r.y * s.x;
+    if (det != 1 && det != -1) return false;
+    Vector2d zr = M * r;
+    Vector2d zs = M * s;
+    if (!(zr.x > 0 && zr.x < zs.x)) return false;
+    if (!(zr.y < 1 && zr.y > -1 && zs.y < 1 && zs.y > -1)) return false;
+    if (!((zr.y > 0 && zs.y < 0) || (zr.y < 0 && zs.y > 0))) return false;
+    // The reduction would subtract r from s if s - r were still in the strip
+    Vector2i d(s.x - r.x, s.y - r.y);
+    Vector2d zd = M * d;
+    return !(zd.y < 1 && zd.y > -1);
+}
+
+std::pair<Vector2i, Vector2i> StripBasisCache::find(const AffineTransform& M) {
+    if (has_basis_ && isValid(M, r_, s_)) {
+        hits_++;
+        return {r_, s_};
+    }
+    misses_++;
+    auto basis = findClosestWithinStrip(M);
+    r_ = basis.first;
+    s_ = basis.second;
+    has_basis_ = true;
+    return basis;
+}
+
+namespace {
+
+const int WORD_PERIOD_MAX = 1024;       // steps walked looking for the period
+const double WORD_PERIOD_TOL = 1e-9;    // height difference treated as a return
+
+/**
+ * One strip step per node, chosen the way the node loop in
+ * Scale::recalcWithAffine always has: by the height of the current node
+ * plus the height of r (then s) falling in [0, 1). Coordinates are carried
+ * as doubles as well (exact for any int) so nothing converts in the loop.
+ */
+struct StripStepper {
+    double c, d, ty;
+    double dy_r, dy_s;
+    int step_x[3], step_y[3];
+    double step_xd[3], step_yd[3];
+
+    StripStepper(const AffineTransform& A, const Vector2i& r, const Vector2i& s, int direction)
+        : c(A.c), d(A.d), ty(A.ty) {
+        AffineTransform M = A;
+        M.tx = 0;
+        M.ty = 0;
+        Vector2d zr = M * r;
+        Vector2d zs = M * s;
+        // Same sums as y + zr.y / y - zr.y
+        dy_r = direction > 0 ? zr.y : -zr.y;
+        dy_s = direction > 0 ? zs.y : -zs.y;
+        const Vector2i steps[3] = {r, s, Vector2i(r.x + s.x, r.y + s.y)};
+        for (int k = 0; k < 3; ++k) {
+            step_x[k] = direction * steps[k].x;
+            step_y[k] = direction * steps[k].y;
+            step_xd[k] = step_x[k];
+            step_yd[k] = step_y[k];
+        }
+    }
+
+    // (A * v).y
+    double height(double vx, double vy) const { return c * vx + d * vy + ty; }
+
+    int choose(double y) const {
+        double yr = y + dy_r;
+        double ys = y + dy_s;
+        int in_r = (0 <= yr) & (yr < 1);
+        int in_s = (0 <= ys) & (ys < 1) & (in_r ^ 1);
+        return in_s | (((in_r | in_s) ^ 1) << 1);
+    }
+
+    // Walks word[begin, end) from v without branching on the heights. With
+    // period set, stops early once the path is back at the height it started
+    // from and stores the number of steps taken in it.
+    void walk(Vector2i& v, uint8_t* word, int begin, int end, int* period) const {
+        double vx = v.x, vy = v.y;
+        double y = height(vx, vy);
+        double y0 = y;
+        for (int i = begin; i < end; ++i) {
+            // Heights of all three candidates first, so only the choice
+            // itself is on the path from one step to the next
+            double next_y[3];
+            for (int k = 0; k < 3; ++k) {
+                next_y[k] = height(vx + step_xd[k], vy + step_yd[k]);
+            }
+            int step = choose(y);
+            word[i] = (uint8_t)step;
+            y = next_y[step];
+            vx += step_xd[step];
+            vy += step_yd[step];
+            v.x += step_x[step];
+            v.y += step_y[step];
+            if (period && std::abs(y - y0) <= WORD_PERIOD_TOL) {
+                *period = i + 1 - begin;
+                return;
+            }
+        }
+    }
+
+    // Index of the first step in word[begin, end) that the walk from v would
+    // not take, or end; v is left at that node
+    int verify(Vector2i& v, const uint8_t* word, int begin, int end) const {
+        double vx = v.x, vy = v.y;
+        for (int i = begin; i < end; ++i) {
+            int step = word[i];
+            if (choose(height(vx, vy)) != step) return i;
+            vx += step_xd[step];
+            vy += step_yd[step];
+            v.x += step_x[step];
+            v.y += step_y[step];
+        }
+        return end;
+    }
+};
+
+} // namespace
+
+Vector2i stripStepWord(const AffineTransform& A, const Vector2i& r, const Vector2i& s,
+                       const Vector2i& start, int direction, int n, uint8_t* word) {
+    StripStepper stepper(A, r, s, direction);
+    Vector2i v = start;
+
+    // Walk until the path returns to its starting height. When the word is
+    // periodic (any transform with a rational strip slope, MOS included),
+    // tile the rest from that period and check every node against the
+    // stepping rule. The checks are independent of each other, unlike the
+    // steps of a walk. Resume walking from the first node that disagrees.
+    int period = 0;
+    int searched = std::min(n, WORD_PERIOD_MAX);
+    stepper.walk(v, word, 0, searched, &period);
+    if (period == 0) {
+        stepper.walk(v, word, searched, n, nullptr);
+        return v;
+    }
+    for (int i = period; i < n; ++i) {
+        word[i] = word[i - period];
+    }
+    int failed = stepper.verify(v, word, period, n);
+    stepper.walk(v, word, failed, n, nullptr);
+    return v;
+}
+
+std::vector<uint8_t> stripStepWord(const AffineTransform& A, int n) {
+    AffineTransform M = A;
+    M.tx = 0;
+    M.ty = 0;
+    auto [r, s] = findClosestWithinStrip(M);
+    std::vector<uint8_t> word(n > 0 ? n : 0);
+    stripStepWord(A, r, s, Vector2i(0, 0), 1, (int)word.size(), word.data());
+    return word;
+}
+
+} // namespace scalatrix
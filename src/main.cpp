@@ -4,6 +4,28 @@ using namespace scalatrix;
 #ifdef EMSCRIPTEN
 #include <emscripten/bind.h>
 
+// A label batch crosses to JS as { text: Uint8Array, offsets: Uint32Array },
+// decoded with one TextDecoder pass. Both arrays are copies, so they stay
+// valid when the heap grows.
+static emscripten::val labelBatchToJS(const LabelBatch& batch) {
+    emscripten::val result = emscripten::val::object();
+    result.set("text", emscripten::val::global("Uint8Array").new_(emscripten::typed_memory_view(
+        batch.text.size(), reinterpret_cast<const uint8_t*>(batch.text.data()))));
+    result.set("offsets", emscripten::val::global("Uint32Array").new_(emscripten::typed_memory_view(
+        batch.offsets.size(), batch.offsets.data())));
+    return result;
+}
+
+// Typed-array view over the WASM heap, not a copy: it shows whatever the
+// array holds now. It is invalidated when the array moves, i.e. ScaleColumns
+// views by an update() to a larger scale than before and ConsonanceCurve
+// views by delete(). In a build with ALLOW_MEMORY_GROWTH any allocation may
+// also detach all views, so fetch them again after calls that allocate.
+template <typename T>
+static emscripten::val heapView(const std::vector<T>& values) {
+    return emscripten::val(emscripten::typed_memory_view(values.size(), values.data()));
+}
+
 EMSCRIPTEN_BINDINGS(scalatrix) {
     emscripten::class_<IntegerAffineTransform>("IntegerAffineTransform")
         .constructor<int, int, int, int, int, int>()  // Full constructor with tx, ty
@@ -34,14 +56,29 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
         .constructor<double, int>()
         .class_function("fromAffine", &Scale::fromAffine)
         .function("recalcWithAffine", &Scale::recalcWithAffine)
+        .function("reset", &Scale::reset)
         .function("retuneWithAffine", &Scale::retuneWithAffine)
-        .function("getNodes", static_cast<std::vector<Node>& (Scale::*)()>(&Scale::getNodes))
+        .function("getNodes", static_cast<NodeVector& (Scale::*)()>(&Scale::getNodes))
+        // embind would hand out a copy of the cache, so reach it through the
+        // scale; counters as doubles so JS sees numbers rather than BigInts
+        .function("stripCacheStats", emscripten::optional_override([](const Scale& s) {
+            const StripBasisCache& c = s.getStripCache();
+            emscripten::val stats = emscripten::val::object();
+            stats.set("hits", (double)c.hits());
+            stats.set("misses", (double)c.misses());
+            stats.set("hitRate", c.hitRate());
+            return stats;
+        }))
+        .function("resetStripCache", emscripten::optional_override([](Scale& s) { s.getStripCache().resetCounters(); }))
+        .function("clearStripCache", emscripten::optional_override([](Scale& s) { s.getStripCache().clear(); }))
         .function("print", &Scale::print);
     
     //emscripten::register_vector<bool>("mosPath");
     
     emscripten::class_<MOS>("MOS")
         .class_function("fromG", &MOS::fromG)
+        .class_function("convergents", &MOS::convergents)
+        .class_function("depthForSize", &MOS::depthForSize)
         .class_function("fromParams", &MOS::fromParams)
         .function("adjustG", &MOS::adjustG)
         .function("adjustTuningG", &MOS::adjustTuningG)
@@ -60,6 +97,8 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
         .function("retuneThreePoints", &MOS::retuneThreePoints)
         .function("generateScaleFromMOS", &MOS::generateScaleFromMOS)
         .function("generateMappedScale", &MOS::generateMappedScale)
+        .function("generateScaleFromMOSInto", &MOS::generateScaleFromMOSInto)
+        .function("generateMappedScaleInto", &MOS::generateMappedScaleInto)
         .function("retuneScaleWithMOS", &MOS::retuneScaleWithMOS)
         .function("nodeInScale", &MOS::nodeInScale)
         .function("nodeEquaveNr", &MOS::nodeEquaveNr)
@@ -117,6 +156,79 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
     //emscripten::register_vector<PseudoPrimeInt>("PrimeList");
     //emscripten::function("generateDefaultPrimeList", &scalatrix::generateDefaultPrimeList);
 
+    // Columns of a scale as Float64Array / Int32Array views; coordinates are
+    // interleaved x, y
+    emscripten::class_<ScaleColumns>("ScaleColumns")
+        .constructor<>()
+        .function("update", &ScaleColumns::update)
+        .function("size", emscripten::optional_override([](const ScaleColumns& c) { return (int)c.size(); }))
+        .function("pitches", emscripten::optional_override([](const ScaleColumns& c) { return heapView(c.pitch); }))
+        .function("naturalCoords", emscripten::optional_override([](const ScaleColumns& c) { return heapView(c.natural_coord); }))
+        .function("tuningCoords", emscripten::optional_override([](const ScaleColumns& c) { return heapView(c.tuning_coord); }));
+
+    emscripten::class_<Spectrum>("Spectrum")
+        .constructor<>()
+        .class_function("harmonic", &Spectrum::harmonic)
+        .class_function("oddHarmonic", &Spectrum::oddHarmonic)
+        .class_function("pseudoharmonic", emscripten::optional_override([](int n_partials, double decay) {
+            return Spectrum::pseudoharmonic(n_partials, decay);
+        }));
+
+    // Curve channels as Float64Array views that follow each compute()
+    emscripten::class_<ConsonanceCurveBuffer>("ConsonanceCurve")
+        .constructor<const Spectrum&, double, double, double, double>()
+        .function("size", &ConsonanceCurveBuffer::size)
+        .function("compute", &ConsonanceCurveBuffer::compute)
+        .function("computeGen3", &ConsonanceCurveBuffer::computeGen3)
+        .function("peak", &ConsonanceCurveBuffer::peak)
+        .function("logBaseline", &ConsonanceCurveBuffer::logBaseline)
+        .function("cents", emscripten::optional_override([](const ConsonanceCurveBuffer& c) { return heapView(c.cents()); }))
+        .function("pl", emscripten::optional_override([](const ConsonanceCurveBuffer& c) { return heapView(c.pl()); }))
+        .function("hull", emscripten::optional_override([](const ConsonanceCurveBuffer& c) { return heapView(c.hull()); }))
+        .function("spiky", emscripten::optional_override([](const ConsonanceCurveBuffer& c) { return heapView(c.spiky()); }))
+        .function("consonance", emscripten::optional_override([](const ConsonanceCurveBuffer& c) { return heapView(c.consonance()); }));
+
+    emscripten::enum_<LabelTable::Style>("LabelStyle")
+        .value("DIGIT", LabelTable::DIGIT)
+        .value("DIGIT_ZERO_BASED", LabelTable::DIGIT_ZERO_BASED)
+        .value("LETTER", LabelTable::LETTER)
+        .value("LETTER_WITH_OCTAVE", LabelTable::LETTER_WITH_OCTAVE);
+
+    emscripten::class_<LabelTable>("LabelTable")
+        .constructor<>()
+        .constructor<const MOS&, bool>()
+        .function("rebuild", &LabelTable::rebuild)
+        .function("matches", &LabelTable::matches)
+        .function("degree", &LabelTable::degree)
+        .function("accidentals", &LabelTable::accidentals)
+        .function("octave", &LabelTable::octave)
+        .function("label", &LabelTable::label)
+        .function("labelRect", emscripten::optional_override([](const LabelTable& t, Vector2i origin, int width, int height,
+                                                                LabelTable::Style style, bool accidentalAfter, int middle_C_octave) {
+            LabelBatch batch;
+            t.labelRect(origin, width, height, style, batch, accidentalAfter, middle_C_octave);
+            return labelBatchToJS(batch);
+        }))
+        // coords: Int32Array or array of x, y pairs
+        .function("labelCoords", emscripten::optional_override([](const LabelTable& t, emscripten::val coords,
+                                                                  LabelTable::Style style, bool accidentalAfter, int middle_C_octave) {
+            std::vector<int> xy = emscripten::convertJSArrayToNumberVector<int>(coords);
+            std::vector<Vector2i> vs;
+            vs.reserve(xy.size() / 2);
+            for (size_t i = 0; i + 1 < xy.size(); i += 2) vs.emplace_back(xy[i], xy[i + 1]);
+            LabelBatch batch;
+            t.labelCoords(vs.data(), vs.size(), style, batch, accidentalAfter, middle_C_octave);
+            return labelBatchToJS(batch);
+        }));
+
+    emscripten::function("deviationLabels", emscripten::optional_override([](const Scale& scale, double thresholdCents,
+                                                                             bool compareWithTempered) {
+        LabelBatch batch;
+        const auto& nodes = scale.getNodes();
+        LabelCalculator::deviationLabels(nodes.data(), nodes.size(), batch, thresholdCents, compareWithTempered);
+        return labelBatchToJS(batch);
+    }));
+
     emscripten::value_object<Vector2d>("Vector2d")
         .field("x", &Vector2d::x)
         .field("y", &Vector2d::y);
@@ -130,7 +242,13 @@ EMSCRIPTEN_BINDINGS(scalatrix) {
         .field("tuning_coord", &Node::tuning_coord)
         .field("pitch", &Node::pitch);
 
-    emscripten::register_vector<Node>("VectorNode");
+    emscripten::register_vector<Node, ResourceAllocator<Node>>("VectorNode");
+
+    emscripten::value_object<MOSConvergent>("MOSConvergent")
+        .field("depth", &MOSConvergent::depth)
+        .field("a0", &MOSConvergent::a0)
+        .field("b0", &MOSConvergent::b0);
+    emscripten::register_vector<MOSConvergent>("VectorMOSConvergent");
 
     emscripten::function("affineFromThreeDots", &scalatrix::affineFromThreeDots);
 
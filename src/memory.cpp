@@ -0,0 +1,161 @@
+#include "scalatrix/memory.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace scalatrix {
+
+namespace {
+
+class NewDeleteResource : public MemoryResource {
+protected:
+    void* doAllocate(size_t bytes, size_t align) override {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(align));
+        }
+        return ::operator new(bytes);
+    }
+    void doDeallocate(void* p, size_t, size_t align) override {
+        if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(p, std::align_val_t(align));
+        } else {
+            ::operator delete(p);
+        }
+    }
+};
+
+// Chunk headers are padded so the memory after them keeps DEFAULT_ALIGN
+constexpr size_t roundUp(size_t n, size_t align) { return (n + align - 1) / align * align; }
+
+char* alignUp(char* p, size_t align) {
+    uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    return p + (roundUp(v, align) - v);
+}
+
+} // namespace
+
+MemoryResource* defaultMemoryResource() noexcept {
+    static NewDeleteResource resource;
+    return &resource;
+}
+
+struct MonotonicResource::Chunk {
+    Chunk* next;
+    size_t size; // including this header
+};
+
+MonotonicResource::MonotonicResource(size_t initial_size, MemoryResource* upstream)
+    : upstream_(upstream), buffer_(nullptr), buffer_size_(0),
+      initial_size_(std::max<size_t>(initial_size, 64)), next_size_(initial_size_) {}
+
+MonotonicResource::MonotonicResource(void* buffer, size_t size, MemoryResource* upstream)
+    : upstream_(upstream), buffer_(buffer), buffer_size_(size),
+      current_(static_cast<char*>(buffer)), remaining_(size),
+      initial_size_(std::max<size_t>(size, 64)), next_size_(initial_size_) {}
+
+MonotonicResource::~MonotonicResource() {
+    release();
+}
+
+void MonotonicResource::release() {
+    while (chunks_) {
+        Chunk* next = chunks_->next;
+        upstream_->deallocate(chunks_, chunks_->size, DEFAULT_ALIGN);
+        chunks_ = next;
+    }
+    current_ = static_cast<char*>(buffer_);
+    remaining_ = buffer_size_;
+    next_size_ = initial_size_;
+}
+
+void* MonotonicResource::doAllocate(size_t bytes, size_t align) {
+    if (current_) {
+        char* p = alignUp(current_, align);
+        size_t padding = p - current_;
+        if (padding <= remaining_ && bytes <= remaining_ - padding) {
+            current_ = p + bytes;
+            remaining_ -= padding + bytes;
+            return p;
+        }
+    }
+    const size_t header = roundUp(sizeof(Chunk), DEFAULT_ALIGN);
+    size_t size = std::max(next_size_, bytes + align);
+    void* memory = upstream_->allocate(header + size, DEFAULT_ALIGN);
+    chunks_ = new (memory) Chunk{chunks_, header + size};
+    next_size_ = size * 2;
+    char* p = alignUp(static_cast<char*>(memory) + header, align);
+    current_ = p + bytes;
+    remaining_ = size - (p - (static_cast<char*>(memory) + header)) - bytes;
+    return p;
+}
+
+struct PoolResource::Chunk {
+    Chunk* next;
+    size_t size; // including this header
+};
+
+namespace {
+
+const size_t MIN_BLOCK = 16;
+const size_t POOL_CHUNK_BYTES = 16384;
+
+// Index of the smallest class 16 << k that holds bytes
+int sizeClass(size_t bytes) {
+    int k = 0;
+    while ((MIN_BLOCK << k) < bytes) ++k;
+    return k;
+}
+
+} // namespace
+
+PoolResource::PoolResource(MemoryResource* upstream) : upstream_(upstream) {}
+
+PoolResource::~PoolResource() {
+    release();
+}
+
+void PoolResource::release() {
+    while (chunks_) {
+        Chunk* next = chunks_->next;
+        upstream_->deallocate(chunks_, chunks_->size, DEFAULT_ALIGN);
+        chunks_ = next;
+    }
+    std::fill(free_, free_ + N_CLASSES, nullptr);
+}
+
+void* PoolResource::doAllocate(size_t bytes, size_t align) {
+    if (bytes > MAX_BLOCK || align > DEFAULT_ALIGN) {
+        return upstream_->allocate(bytes, align);
+    }
+    int k = sizeClass(bytes);
+    if (!free_[k]) {
+        // Carve a fresh chunk into blocks of this class
+        const size_t block = MIN_BLOCK << k;
+        const size_t header = roundUp(sizeof(Chunk), DEFAULT_ALIGN);
+        const size_t count = std::max<size_t>(POOL_CHUNK_BYTES / block, 1);
+        void* memory = upstream_->allocate(header + count * block, DEFAULT_ALIGN);
+        chunks_ = new (memory) Chunk{chunks_, header + count * block};
+        char* first = static_cast<char*>(memory) + header;
+        for (size_t i = count; i-- > 0;) {
+            Block* b = reinterpret_cast<Block*>(first + i * block);
+            b->next = free_[k];
+            free_[k] = b;
+        }
+    }
+    Block* b = free_[k];
+    free_[k] = b->next;
+    return b;
+}
+
+void PoolResource::doDeallocate(void* p, size_t bytes, size_t align) {
+    if (bytes > MAX_BLOCK || align > DEFAULT_ALIGN) {
+        upstream_->deallocate(p, bytes, align);
+        return;
+    }
+    int k = sizeClass(bytes);
+    Block* b = static_cast<Block*>(p);
+    b->next = free_[k];
+    free_[k] = b;
+}
+
+} // namespace scalatrix
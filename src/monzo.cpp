@@ -0,0 +1,167 @@
+#include "scalatrix/monzo.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+
+namespace scalatrix {
+
+// ── Monzo ────────────────────────────────────────────────────────────────────
+
+// Exponents are widened to 64 bits and clamped back, which still vectorizes.
+static int32_t saturate(int64_t e) {
+    constexpr int64_t lo = std::numeric_limits<int32_t>::min();
+    constexpr int64_t hi = std::numeric_limits<int32_t>::max();
+    return static_cast<int32_t>(std::min(std::max(e, lo), hi));
+}
+
+bool Monzo::isUnison() const {
+    int32_t any = 0;
+    for (int i = 0; i < MONZO_MAX_PRIMES; ++i) {
+        any |= exps[i];
+    }
+    return any == 0;
+}
+
+Monzo& Monzo::operator+=(const Monzo& o) {
+    for (int i = 0; i < MONZO_MAX_PRIMES; ++i) {
+        exps[i] = saturate(static_cast<int64_t>(exps[i]) + o.exps[i]);
+    }
+    return *this;
+}
+
+Monzo& Monzo::operator-=(const Monzo& o) {
+    for (int i = 0; i < MONZO_MAX_PRIMES; ++i) {
+        exps[i] = saturate(static_cast<int64_t>(exps[i]) - o.exps[i]);
+    }
+    return *this;
+}
+
+Monzo& Monzo::operator*=(int32_t power) {
+    for (int i = 0; i < MONZO_MAX_PRIMES; ++i) {
+        exps[i] = saturate(static_cast<int64_t>(exps[i]) * power);
+    }
+    return *this;
+}
+
+Monzo operator+(Monzo a, const Monzo& b) { return a += b; }
+Monzo operator-(Monzo a, const Monzo& b) { return a -= b; }
+Monzo operator-(Monzo a) { return a *= -1; }
+Monzo operator*(Monzo a, int32_t power) { return a *= power; }
+Monzo operator*(int32_t power, Monzo a) { return a *= power; }
+
+// ── MonzoBasis ───────────────────────────────────────────────────────────────
+
+MonzoBasis::MonzoBasis(const PrimeList& primes) {
+    // Truncating would silently factor over a smaller basis, so refuse instead
+    if (primes.size() > static_cast<size_t>(MONZO_MAX_PRIMES)) return;
+    size_ = static_cast<int>(primes.size());
+    for (int i = 0; i < size_; ++i) {
+        numbers_[i] = primes[i].number;
+        log2fr_[i] = primes[i].log2fr;
+    }
+}
+
+Monzo MonzoBasis::primeMonzo(int i) const {
+    Monzo m;
+    if (i >= 0 && i < size_) m.exps[i] = 1;
+    return m;
+}
+
+static bool factorInto(long long n, int sign, int size,
+                       const std::array<unsigned int, MONZO_MAX_PRIMES>& numbers, Monzo& m) {
+    if (n <= 0) return false;
+    for (int i = 0; i < size && n > 1; ++i) {
+        long long p = numbers[i];
+        if (p < 2) continue;
+        while (n % p == 0) {
+            n /= p;
+            m.exps[i] += sign;
+        }
+    }
+    return n == 1;
+}
+
+bool MonzoBasis::fromRatio(long long num, long long den, Monzo& out) const {
+    Monzo m;
+    if (!factorInto(num, 1, size_, numbers_, m) || !factorInto(den, -1, size_, numbers_, m)) {
+        return false;
+    }
+    out = m;
+    return true;
+}
+
+bool MonzoBasis::fromExactPitch(const ExactPitch& pitch, Monzo& out) const {
+    if (!pitch.isRatio()) return false;
+    return fromRatio(pitch.num, pitch.den, out);
+}
+
+double MonzoBasis::log2fr(const Monzo& m) const {
+    double sum = 0.0;
+    for (int i = 0; i < MONZO_MAX_PRIMES; ++i) {
+        sum += m.exps[i] * log2fr_[i];
+    }
+    return sum;
+}
+
+bool MonzoBasis::toRatio(const Monzo& m, long long& num, long long& den) const {
+    // ExactPitch arithmetic is overflow-checked, so reuse it per prime power
+    ExactPitch acc = ExactPitch::ratio(1, 1, 0.0);
+    for (int i = 0; i < size_; ++i) {
+        if (m.exps[i] == 0) continue;
+        acc = acc + ExactPitch::ratio(numbers_[i], 1, 0.0) * m.exps[i];
+        if (!acc.isRatio()) return false;
+    }
+    num = acc.num;
+    den = acc.den;
+    return true;
+}
+
+ExactPitch MonzoBasis::toExactPitch(const Monzo& m) const {
+    long long num, den;
+    if (!toRatio(m, num, den)) {
+        return ExactPitch::none(log2fr(m));
+    }
+    return ExactPitch::ratio(num, den, log2fr(m));
+}
+
+int MonzoBasis::formatLabel(const Monzo& m, char* buf, size_t size) const {
+    long long num, den;
+    if (toRatio(m, num, den)) {
+        return std::snprintf(buf, size, "%lld:%lld", num, den);
+    }
+    // Bracket notation up to the last non-zero exponent
+    int last = 0;
+    for (int i = 0; i < size_; ++i) {
+        if (m.exps[i] != 0) last = i;
+    }
+    int len = 0;
+    for (int i = 0; i <= last; ++i) {
+        size_t room = static_cast<size_t>(len) < size ? size - len : 0;
+        int n = std::snprintf(room ? buf + len : nullptr, room, i == 0 ? "[%d" : " %d", m.exps[i]);
+        if (n > 0) len += n;
+    }
+    size_t room = static_cast<size_t>(len) < size ? size - len : 0;
+    int n = std::snprintf(room ? buf + len : nullptr, room, ">");
+    return len + (n > 0 ? n : 0);
+}
+
+std::string MonzoBasis::label(const Monzo& m) const {
+    char buf[64];
+    int len = formatLabel(m, buf, sizeof(buf));
+    if (len < static_cast<int>(sizeof(buf))) {
+        return std::string(buf, len);
+    }
+    std::string s(static_cast<size_t>(len) + 1, '\0');
+    formatLabel(m, &s[0], s.size());
+    s.resize(len);
+    return s;
+}
+
+PitchSetPitch MonzoBasis::toPitchSetPitch(const Monzo& m) const {
+    PitchSetPitch p;
+    p.label = label(m);
+    p.log2fr = log2fr(m);
+    return p;
+}
+
+} // namespace scalatrix
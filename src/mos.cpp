@@ -1,4 +1,5 @@
 #include "scalatrix/mos.hpp"
+#include "scalatrix/mos_pattern.hpp"
 #include "scalatrix/params.hpp" 
 #include "scalatrix/label_calculator.hpp"
 
@@ -6,6 +7,7 @@
 #include <vector>
 #include <algorithm>
 #include <cassert>
+#include <climits>
 #include <iostream>
 
 #ifndef M_PI_2
@@ -24,7 +26,99 @@ static double sanitize_generator(double g) {
     return g + (g < 0.5 ? 1e-6 : -1e-6);
 }
 
-MOS::MOS(int a, int b, int m, double e, double g) {
+/*
+ * State of the Stern-Brocot walk fromG performs: a_len > b_len grows b0,
+ * anything else grows a0, and the chosen length shrinks by the other.
+ */
+struct GeneratorWalk {
+    int a0 = 1;
+    int b0 = 1;
+    int depth = 0;
+    double a_len;
+    double b_len;
+    explicit GeneratorWalk(double sg) : a_len(sg), b_len(1.0 - sg) {}
+};
+
+// Runs at least this long are jumped rather than stepped
+static const double RUN_JUMP_MIN = 16.0;
+
+/*
+ * Advances the walk to max_depth steps, stopping early rather than letting
+ * a0 + b0 exceed max_size. A run of identical steps, which for generators
+ * near 0 or 1 can be thousands long, is taken in one jump up to its last two
+ * steps; those and all short runs step exactly as the original loop did.
+ * The jump is clamped to the depth and size left, so a walk cut short
+ * mid-run stops where stepping would. The end of every run passed is
+ * appended to runs if given.
+ */
+static void descend(GeneratorWalk& w, int max_depth, int max_size, std::vector<MOSConvergent>* runs) {
+    bool prev_grow_b = false;
+    while (w.depth < max_depth) {
+        bool grow_b = w.a_len > w.b_len;
+        int grow = grow_b ? w.a0 : w.b0;
+        if (w.a0 + w.b0 > max_size - grow) break;
+        if (runs && w.depth > 0 && grow_b != prev_grow_b) {
+            runs->push_back({w.depth, w.a0, w.b0});
+        }
+        prev_grow_b = grow_b;
+
+        double big = grow_b ? w.a_len : w.b_len;
+        double small = grow_b ? w.b_len : w.a_len;
+        long long jump = 1;
+        if (!(small > 0.0)) {
+            jump = LLONG_MAX; // the other length is used up, so the run never ends
+        } else if (big / small > RUN_JUMP_MIN) {
+            jump = static_cast<long long>(std::min(big / small, 1e15)) - 2;
+        }
+        jump = std::min<long long>(jump, max_depth - w.depth);
+        jump = std::min<long long>(jump, (max_size - w.a0 - w.b0) / grow);
+
+        if (grow_b) {
+            w.b0 += static_cast<int>(jump) * w.a0;
+            w.a_len -= jump == 1 ? w.b_len : jump * w.b_len;
+        } else {
+            w.a0 += static_cast<int>(jump) * w.b0;
+            w.b_len -= jump == 1 ? w.a_len : jump * w.a_len;
+        }
+        w.depth += static_cast<int>(jump);
+    }
+}
+
+/*
+ * (a0, b0) reached by walking the Stern-Brocot tree depth steps with the
+ * given (unsanitized) generator. Looked up in the pattern table when
+ * possible, descended run by run otherwise.
+ */
+static Vector2i walkGenerator(int depth, double g) {
+    double sg = sanitize_generator(g);
+    if (const MOSPattern* pattern = findMOSPattern(depth, sg)) {
+        return {pattern->a0, pattern->b0};
+    }
+    GeneratorWalk w(sg);
+    descend(w, depth, INT_MAX, nullptr);
+    return {w.a0, w.b0};
+}
+
+std::vector<MOSConvergent> MOS::convergents(double g, int max_size) {
+    std::vector<MOSConvergent> runs;
+    runs.push_back({0, 1, 1});
+    GeneratorWalk w(sanitize_generator(g));
+    descend(w, INT_MAX, max_size, &runs);
+    // The run max_size cut short ends where the walk stopped
+    if (w.depth > runs.back().depth) {
+        runs.push_back({w.depth, w.a0, w.b0});
+    }
+    return runs;
+}
+
+int MOS::depthForSize(double g, int size) {
+    GeneratorWalk w(sanitize_generator(g));
+    descend(w, INT_MAX, size - 1, nullptr);
+    return w.a0 + w.b0 >= size ? w.depth : w.depth + 1;
+}
+
+MOS::MOS(int a, int b, int m, double e, double g, MemoryResource* resource)
+    : base_scale(1.0, 0, 0, resource) {
     this->structure_generator = g;
     adjustParams(a, b, m, e, g);
 }
@@ -61,6 +155,12 @@ double MOS::angle() const {
 
 std::vector<bool> calcPath(int a, int b){
     std::vector<bool> path;
+    calcPath(a, b, path);
+    return path;
+}
+
+void calcPath(int a, int b, std::vector<bool>& path){
+    path.clear();
     int a_ = a;
     int b_ = b;
     while (a_ > 1 || b_ > 1) {
@@ -73,11 +173,10 @@ std::vector<bool> calcPath(int a, int b){
         }
     }
     std::reverse(path.begin(), path.end());
-    return path;
 }
 
 
-Vector2i applyPath(const std::vector<bool> path, const Vector2i& v) {
+Vector2i applyPath(const std::vector<bool>& path, const Vector2i& v) {
     int a = v.x;
     int b = v.y;
     for (bool p : path) {
@@ -90,13 +189,11 @@ Vector2i applyPath(const std::vector<bool> path, const Vector2i& v) {
     return {a,b};
 }
 
-Vector2i applyPathReverse(const std::vector<bool> path, const Vector2i& v) {
+Vector2i applyPathReverse(const std::vector<bool>& path, const Vector2i& v) {
     int a = v.x;
     int b = v.y;
-    std::vector<bool> reversed_path = path;
-    std::reverse(reversed_path.begin(), reversed_path.end());
-    for (bool p : reversed_path) {
-        if (p) {
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        if (*it) {
             b -= a;
         } else {
             a -= b;
@@ -183,7 +280,7 @@ void MOS::adjustParams(int a, int b, int m, double e, double g, int repetitions)
     this->period = e / r;
     this->generator = g;
 
-    this->path = calcPath(a0, b0);
+    calcPath(a0, b0, this->path);
     this->depth = this->path.size();
     this->v_gen = applyPath(this->path, {1, 0});
     this->impliedAffine = calcImpliedAffine();
@@ -192,9 +289,12 @@ void MOS::adjustParams(int a, int b, int m, double e, double g, int repetitions)
 
     this->structureImpliedAffine = calcStructureImpliedAffine();
     this->updateStructureVectors();
-    this->base_scale = Scale::fromAffine(this->impliedAffine, 1.0, n+1, 0);
+    // Rebuilt in place, so it keeps its resource and, unless it grows, its
+    // storage
+    this->base_scale.reset(1.0, n + 1, 0);
+    this->base_scale.recalcWithAffine(this->impliedAffine, n + 1, 0);
 
-    this->mosTransform = IntegerAffineTransform::linearFromTwoDots(
+    this->mosTransform = IntegerAffineTransform::linearMapFromTwoDots(
         {1, 0}, {1, 1},
         v_gen, {a0, b0}
     );
@@ -203,59 +303,20 @@ void MOS::adjustParams(int a, int b, int m, double e, double g, int repetitions)
 
 void MOS::adjustG(int depth, int m, double g, double e, int _repetitions){
     this->structure_generator = g;
-    double sg = sanitize_generator(g);
-    int a0 = 1;
-    int b0 = 1;
-    double a_len = sg;
-    double b_len = 1.0 - sg;
-    for (int i = 0; i < depth; i++) {
-        if (a_len > b_len) {
-            b0+=a0;
-            a_len -= b_len;
-        } else {
-            a0+=b0;
-            b_len -= a_len;
-        }
-    }
-    this->adjustParams(a0, b0, m, e, g, _repetitions);
+    Vector2i ab = walkGenerator(depth, g);
+    this->adjustParams(ab.x, ab.y, m, e, g, _repetitions);
 }
 
 void MOS::adjustTuningG(int depth, int m, double g, double e, int _repetitions){
     // Tree walk uses frozen structure_generator to determine (a,b)
-    double sg = sanitize_generator(this->structure_generator);
-    int a0 = 1;
-    int b0 = 1;
-    double a_len = sg;
-    double b_len = 1.0 - sg;
-    for (int i = 0; i < depth; i++) {
-        if (a_len > b_len) {
-            b0+=a0;
-            a_len -= b_len;
-        } else {
-            a0+=b0;
-            b_len -= a_len;
-        }
-    }
+    Vector2i ab = walkGenerator(depth, this->structure_generator);
     // Only tuning generator changes; structure_generator stays frozen
-    this->adjustParams(a0, b0, m, e, g, _repetitions);
+    this->adjustParams(ab.x, ab.y, m, e, g, _repetitions);
 }
 
 MOS MOS::fromG(int depth, int m, double g, double e, int repetitions){
-    double sg = sanitize_generator(g);
-    int a0 = 1;
-    int b0 = 1;
-    double a_len = sg;
-    double b_len = 1.0 - sg;
-    for (int i = 0; i < depth; i++) {
-        if (a_len > b_len) {
-            b0+=a0;
-            a_len -= b_len;
-        } else {
-            a0+=b0;
-            b_len -= a_len;
-        }
-    }
-    return MOS(a0*repetitions, b0*repetitions, m, e, g);
+    Vector2i ab = walkGenerator(depth, g);
+    return MOS(ab.x*repetitions, ab.y*repetitions, m, e, g);
 }
 
 double MOS::gFromAngle(double angle){
@@ -353,14 +414,25 @@ void MOS::retuneThreePoints(Vector2i fixed1, Vector2i fixed2, Vector2i v, double
     _recalcOnRetuneUsingAffine(A);
 };
 
-Scale MOS::generateMappedScale(int steps, double offset, double base_freq, int n_nodes, int root) const {
+AffineTransform MOS::mappedScaleAffine(int steps, double offset) const {
     // Use structureImpliedAffine for node selection (which notes land in the strip)
     double mos_offset = (offset + 0.5) / steps;
     double mos_scale_factor = static_cast<double>(n) / steps;
     AffineTransform stretched_t(1, 0, 0, mos_scale_factor, 0, 0);
     AffineTransform squeezed_t = stretched_t * structureImpliedAffine;
     squeezed_t.ty = mos_offset;
-    Scale scale = Scale::fromAffine(squeezed_t, base_freq, n_nodes, root);
+    return squeezed_t;
+}
+
+Scale MOS::generateMappedScale(int steps, double offset, double base_freq, int n_nodes, int root) const {
+    Scale scale(base_freq, n_nodes, root);
+    generateMappedScaleInto(scale, steps, offset, base_freq, n_nodes, root);
+    return scale;
+}
+
+void MOS::generateMappedScaleInto(Scale& scale, int steps, double offset, double base_freq, int n_nodes, int root) const {
+    scale.reset(base_freq, n_nodes, root);
+    scale.recalcWithAffine(mappedScaleAffine(steps, offset), n_nodes, root);
 
     // Retune pitches using impliedAffine (tuning generator), but preserve
     // strip y-coordinate from squeezed_t (which includes modeOffset)
@@ -368,12 +440,16 @@ Scale MOS::generateMappedScale(int steps, double offset, double base_freq, int n
         node.tuning_coord.x = (impliedAffine * node.natural_coord).x;
         node.pitch = base_freq * std::exp2(node.tuning_coord.x);
     }
-
-    return scale;
 }
 
 Scale MOS::generateScaleFromMOS(double base_freq, int n_nodes, int root){
     Scale scale = Scale(base_freq, n_nodes, root);
+    generateScaleFromMOSInto(scale, base_freq, n_nodes, root);
+    return scale;
+}
+
+void MOS::generateScaleFromMOSInto(Scale& scale, double base_freq, int n_nodes, int root){
+    scale.reset(base_freq, n_nodes, root);
     for (int i=-root; i<n_nodes-root; i++){
         int idx = (i +  128*n) % n;
         int octave_nr = (i + 128*n) / n - 128;
@@ -386,7 +462,6 @@ Scale MOS::generateScaleFromMOS(double base_freq, int n_nodes, int root){
         node.isTempered = ref.isTempered;
         node.temperedPitch = ref.temperedPitch;
     }
-    return scale;
 };
 
 void MOS::retuneScaleWithMOS(Scale& scale, double base_freq){
@@ -405,7 +480,7 @@ void MOS::retuneScaleWithMOS(Scale& scale, double base_freq){
 };
 
 
-Vector2i MOS::mapFromMOS(MOS& other, Vector2i v){
+Vector2i MOS::mapFromMOS(const MOS& other, Vector2i v) const {
     Vector2i result = applyPathReverse(other.path, v);
     result = applyPath(path, result);
     return result;
@@ -441,7 +516,7 @@ Vector2i MOS::mosCoordFromNotation(int step, int alter, int octave) const {
     int normalized_step = ((step % n) + n) % n;
     
     // Get natural note coordinates from base_scale
-    const std::vector<Node>& nodes = base_scale.getNodes();
+    const NodeVector& nodes = base_scale.getNodes();
     Vector2i natural_coord = nodes[normalized_step].natural_coord;
     
     // Add octave offset (using period vector a0, b0)
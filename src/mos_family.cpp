@@ -0,0 +1,102 @@
+#include "scalatrix/mos_family.hpp"
+#include "scalatrix/tempering.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace scalatrix {
+
+namespace {
+
+// Scratch reused by one worker for all the members it builds
+struct FamilyWorker {
+    MOS mos;
+    Scale scale;
+    FamilyWorker(double equave, double base_freq, int n_nodes, int root)
+        : mos(1, 1, 0, equave, 0.5), scale(base_freq, n_nodes, root) {}
+};
+
+} // namespace
+
+MOSFamily generateMOSFamily(const MOSFamilyOptions& options) {
+    MOSFamily family;
+    const int n_nodes = std::max(options.n_nodes, 0);
+    // A root outside the nodes would have the workers' scales write past
+    // their storage
+    if (n_nodes > 0 && (options.root < 0 || options.root >= n_nodes)) return family;
+    const int g_steps = std::max(options.g_steps, 1);
+    family.n_nodes = n_nodes;
+
+    // Members are listed serially, so their order is fixed before any
+    // worker starts
+    for (int n = std::max(options.min_size, 2); n <= options.max_size; ++n) {
+        for (int a = 1; a < n; ++a) {
+            int b = n - a;
+            int r = std::gcd(a, b);
+            int a0 = a / r, b0 = b / r;
+            Vector2i v_gen = applyPath(calcPath(a0, b0), {1, 0});
+            double g1 = static_cast<double>(v_gen.y) / b0;
+            double g2 = static_cast<double>(v_gen.x) / a0;
+            double g_min = std::min(g1, g2);
+            double dg = (std::max(g1, g2) - g_min) / g_steps;
+            for (int mode = 0; mode < a0 + b0; ++mode) {
+                for (int ig = 0; ig < g_steps; ++ig) {
+                    family.a.push_back(a);
+                    family.b.push_back(b);
+                    family.mode.push_back(mode);
+                    family.generator.push_back(g_min + (ig + 0.5) * dg);
+                }
+            }
+        }
+    }
+
+    const size_t size = family.size();
+    const size_t total_nodes = size * n_nodes;
+    family.L_fr.resize(size);
+    family.s_fr.resize(size);
+    family.coord_x.resize(total_nodes);
+    family.coord_y.resize(total_nodes);
+    family.tuning_x.resize(total_nodes);
+    family.tuning_y.resize(total_nodes);
+    family.pitch.resize(total_nodes);
+
+    // parallelFor is given exactly as many threads as there are scratch
+    // workers, so its worker indices stay within them
+    const size_t grain = 16;
+    int n_workers = parallelWorkerCount((size + grain - 1) / grain, options.n_threads);
+    std::vector<FamilyWorker> workers(n_workers, FamilyWorker(options.equave, options.base_freq,
+                                                              n_nodes, n_nodes > 0 ? options.root : 0));
+
+    parallelFor(size, grain, n_workers, [&](size_t begin, size_t end, int worker) {
+        MOS& mos = workers[worker].mos;
+        Scale& scale = workers[worker].scale;
+        for (size_t i = begin; i < end; ++i) {
+            double g = family.generator[i];
+            // As the MOS constructor: structure and tuning generator agree
+            mos.structure_generator = g;
+            mos.adjustParams(family.a[i], family.b[i], family.mode[i], options.equave, g);
+            family.L_fr[i] = mos.L_fr;
+            family.s_fr[i] = mos.s_fr;
+            if (n_nodes == 0) continue;
+
+            // Same nodes and pitches as mos.generateMappedScale, written
+            // straight into the columns
+            int steps = options.steps > 0 ? options.steps : mos.n;
+            scale.recalcWithAffine(mos.mappedScaleAffine(steps, options.offset), n_nodes, options.root);
+            const NodeVector& nodes = scale.getNodes();
+            size_t first = i * n_nodes;
+            for (int j = 0; j < n_nodes; ++j) {
+                const Node& node = nodes[j];
+                double x = (mos.impliedAffine * node.natural_coord).x;
+                family.coord_x[first + j] = node.natural_coord.x;
+                family.coord_y[first + j] = node.natural_coord.y;
+                family.tuning_x[first + j] = x;
+                family.tuning_y[first + j] = node.tuning_coord.y;
+                family.pitch[first + j] = options.base_freq * std::exp2(x);
+            }
+        }
+    });
+    return family;
+}
+
+} // namespace scalatrix
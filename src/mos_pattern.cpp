@@ -0,0 +1,156 @@
+#include "scalatrix/mos_pattern.hpp"
+#include <algorithm>
+
+namespace scalatrix {
+
+std::vector<bool> MOSPattern::path() const {
+    std::vector<bool> path(depth);
+    for (int i = 0; i < depth; i++) {
+        path[i] = (path_bits >> i) & 1;
+    }
+    return path;
+}
+
+namespace {
+
+// A generator range bound p/q, kept exact so sibling intervals tile exactly
+struct Fraction {
+    long long p, q; // q > 0
+    constexpr bool operator<(const Fraction& o) const { return p * o.q < o.p * q; }
+    constexpr double value() const { return static_cast<double>(p) / q; }
+};
+
+// Step length as a linear function of the generator: p + q*g
+struct Length {
+    long long p, q;
+};
+
+// Where the walk stands at a pattern: its exact interval and step lengths
+struct WalkState {
+    Fraction lo, hi;
+    Length a_len, b_len;
+};
+
+struct PatternTable {
+    std::array<MOSPattern, MOS_PATTERN_COUNT> patterns{};
+    // patterns at depth d are [depth_offsets[d], depth_offsets[d + 1])
+    std::array<int, MOS_PATTERN_MAX_SIZE> depth_offsets{};
+    // index of (a0, b0) at a0 * (MAX + 1) + b0, -1 if absent
+    std::array<int, (MOS_PATTERN_MAX_SIZE + 1) * (MOS_PATTERN_MAX_SIZE + 1)> by_size{};
+    int count = 0;
+};
+
+// Fills a PatternTable, keeping the walk state of each pattern alongside
+struct PatternBuilder {
+    PatternTable table;
+    std::array<WalkState, MOS_PATTERN_COUNT> states{};
+
+    constexpr void add(int a0, int b0, int depth, uint64_t reduced_bits, const WalkState& state) {
+        if (table.count < MOS_PATTERN_COUNT) {
+            MOSPattern& pattern = table.patterns[table.count];
+            pattern.a0 = a0;
+            pattern.b0 = b0;
+            pattern.depth = depth;
+            // calcPath lists the reduction from (a0, b0) back to (1, 1), reversed,
+            // which is the walk order; its bit is set where b0 was grown
+            pattern.path_bits = reduced_bits;
+            pattern.v_gen = applyMOSPath({reduced_bits, depth}, Vector2i(1, 0));
+            pattern.g_lo = state.lo.value();
+            pattern.g_hi = state.hi.value();
+            pattern.mosTransform = mosTransformOf(a0, b0);
+            states[table.count] = state;
+        }
+        table.count++;
+    }
+
+    // Replays MOS::fromG symbolically from pattern i: a_len > b_len grows b0,
+    // ties grow a0. The child with the lower interval is added first.
+    constexpr void expand(int i) {
+        const MOSPattern pattern = table.patterns[i];
+        const WalkState s = states[i];
+        const int a0 = pattern.a0, b0 = pattern.b0;
+
+        // a_len - b_len > 0 splits the interval at g = -dp/dq
+        long long dp = s.a_len.p - s.b_len.p;
+        long long dq = s.a_len.q - s.b_len.q;
+        Fraction grow_b_lo = s.lo, grow_b_hi = s.hi, grow_a_lo = s.lo, grow_a_hi = s.hi;
+        if (dq != 0) {
+            Fraction t = dq > 0 ? Fraction{-dp, dq} : Fraction{dp, -dq};
+            if (dq > 0) {
+                grow_b_lo = std::max(s.lo, t);
+                grow_a_hi = std::min(s.hi, t);
+            } else {
+                grow_b_hi = std::min(s.hi, t);
+                grow_a_lo = std::max(s.lo, t);
+            }
+        } else if (dp > 0) {
+            grow_a_hi = grow_a_lo;
+        } else {
+            grow_b_hi = grow_b_lo;
+        }
+
+        bool grow_b = 2 * a0 + b0 <= MOS_PATTERN_MAX_SIZE && grow_b_lo < grow_b_hi;
+        bool grow_a = a0 + 2 * b0 <= MOS_PATTERN_MAX_SIZE && grow_a_lo < grow_a_hi;
+        const uint64_t b_bits = pattern.path_bits | (uint64_t(1) << pattern.depth);
+        const WalkState b_state = {grow_b_lo, grow_b_hi, {dp, dq}, s.b_len};
+        const WalkState a_state = {grow_a_lo, grow_a_hi, s.a_len, {-dp, -dq}};
+        if (grow_b && !(grow_a && grow_a_lo < grow_b_lo)) {
+            add(a0, b0 + a0, pattern.depth + 1, b_bits, b_state);
+            grow_b = false;
+        }
+        if (grow_a) add(a0 + b0, b0, pattern.depth + 1, pattern.path_bits, a_state);
+        if (grow_b) add(a0, b0 + a0, pattern.depth + 1, b_bits, b_state);
+    }
+};
+
+// Breadth first, so the patterns come out sorted by depth, and within a
+// depth by g_lo, since the children of a pattern split its interval
+constexpr PatternTable buildPatternTable() {
+    PatternBuilder builder;
+    PatternTable& table = builder.table;
+    builder.add(1, 1, 0, 0, {{0, 1}, {1, 1}, {0, 1}, {1, -1}});
+    for (auto& offset : table.depth_offsets) offset = MOS_PATTERN_COUNT;
+    int level_begin = 0;
+    for (int depth = 0; level_begin < table.count && table.count <= MOS_PATTERN_COUNT; depth++) {
+        int level_end = table.count;
+        table.depth_offsets[depth] = level_begin;
+        for (int i = level_begin; i < level_end; i++) builder.expand(i);
+        level_begin = level_end;
+    }
+    for (auto& index : table.by_size) index = -1;
+    for (int i = 0; i < MOS_PATTERN_COUNT; i++) {
+        table.by_size[table.patterns[i].a0 * (MOS_PATTERN_MAX_SIZE + 1) + table.patterns[i].b0] = i;
+    }
+    return table;
+}
+
+constexpr PatternTable pattern_table = buildPatternTable();
+static_assert(pattern_table.count == MOS_PATTERN_COUNT, "one pattern per coprime (a0, b0)");
+
+} // namespace
+
+const std::array<MOSPattern, MOS_PATTERN_COUNT>& mosPatternTable() {
+    return pattern_table.patterns;
+}
+
+const MOSPattern* findMOSPattern(int depth, double g) {
+    const PatternTable& table = pattern_table;
+    if (depth < 0 || depth >= MOS_PATTERN_MAX_SIZE - 1) return nullptr;
+    auto first = table.patterns.begin() + table.depth_offsets[depth];
+    auto last = table.patterns.begin() + table.depth_offsets[depth + 1];
+    auto it = std::upper_bound(first, last, g, [](double v, const MOSPattern& p) { return v < p.g_lo; });
+    if (it == first) return nullptr;
+    --it;
+    // Keep well clear of the edges, where float rounding in the walk decides
+    const double margin = 1e-9;
+    if (g <= it->g_lo + margin || g >= it->g_hi - margin) return nullptr;
+    return &*it;
+}
+
+const MOSPattern* findMOSPattern(int a0, int b0) {
+    if (a0 < 1 || b0 < 1 || a0 > MOS_PATTERN_MAX_SIZE || b0 > MOS_PATTERN_MAX_SIZE) return nullptr;
+    int i = pattern_table.by_size[a0 * (MOS_PATTERN_MAX_SIZE + 1) + b0];
+    return i < 0 ? nullptr : &pattern_table.patterns[i];
+}
+
+} // namespace scalatrix
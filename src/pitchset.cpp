@@ -3,6 +3,8 @@
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <climits>
+#include <cstdio>
 #include <cstdlib>
 #include <string>
 
@@ -11,18 +13,6 @@ const int PRIMES[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53
 
 namespace scalatrix {
 
-// Non-throwing strict integer parse (replaces std::stoi + try/catch so the
-// library builds on MCUs with -fno-exceptions). Returns false unless `s` is a
-// full, valid decimal integer.
-static bool parseIntStrict(const std::string& s, int& out) {
-    if (s.empty()) return false;
-    char* end = nullptr;
-    long v = std::strtol(s.c_str(), &end, 10);
-    if (end != s.c_str() + s.size()) return false;
-    out = static_cast<int>(v);
-    return true;
-}
-
 PseudoPrimeInt pseudoPrimeFromIndexNumber(unsigned int index) {
     PseudoPrimeInt p;
     p.label = std::to_string(PRIMES[index]);
@@ -43,6 +33,55 @@ PrimeList generateDefaultPrimeList(int n_primes) {
 };
 
 
+PitchSetIndex::PitchSetIndex(const PitchSet& pitchset) : pitchset_(pitchset) {
+    build();
+}
+
+PitchSetIndex::PitchSetIndex(PitchSet&& pitchset) : pitchset_(std::move(pitchset)) {
+    build();
+}
+
+void PitchSetIndex::build() {
+    order_.reserve(pitchset_.size());
+    for (size_t i = 0; i < pitchset_.size(); ++i) {
+        // NaN never wins the linear scan, so leave it out of the index
+        if (!std::isnan(pitchset_[i].log2fr)) order_.push_back(static_cast<int>(i));
+    }
+    std::sort(order_.begin(), order_.end(), [&](int a, int b) {
+        if (pitchset_[a].log2fr != pitchset_[b].log2fr) return pitchset_[a].log2fr < pitchset_[b].log2fr;
+        return a < b;
+    });
+    sorted_log2fr_.reserve(order_.size());
+    for (int i : order_) sorted_log2fr_.push_back(pitchset_[i].log2fr);
+}
+
+bool PitchSetIndex::indexes(const PitchSet& pitchset) const {
+    if (pitchset.size() != pitchset_.size()) return false;
+    for (size_t i = 0; i < pitchset.size(); ++i) {
+        if (pitchset[i].log2fr != pitchset_[i].log2fr || pitchset[i].label != pitchset_[i].label) return false;
+    }
+    return true;
+}
+
+int PitchSetIndex::closest(double log2fr) const {
+    const size_t n = sorted_log2fr_.size();
+    if (n == 0 || std::isnan(log2fr)) return -1;
+    size_t hi = std::lower_bound(sorted_log2fr_.begin(), sorted_log2fr_.end(), log2fr) - sorted_log2fr_.begin();
+    auto dist = [&](size_t i) { return std::abs(sorted_log2fr_[i] - log2fr); };
+
+    double best = 1e6; // same cutoff as the linear scan
+    if (hi < n) best = std::min(best, dist(hi));
+    if (hi > 0) best = std::min(best, dist(hi - 1));
+    if (!(best < 1e6)) return -1;
+
+    // Rounding can make more than the two neighbours tie, so collect them all
+    int result = INT_MAX;
+    for (size_t i = hi; i < n && dist(i) == best; ++i) result = std::min(result, order_[i]);
+    for (size_t i = hi; i > 0 && dist(i - 1) == best; --i) result = std::min(result, order_[i - 1]);
+    return result;
+}
+
+
 PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr, double min_log2fr, double max_log2fr) {
     PitchSet pitchset;
     
@@ -74,55 +113,127 @@ PitchSet generateETPitchSet(unsigned int n_et, double equave_log2fr, double min_
 };
 
 PitchSet generateJIPitchSet(PrimeList primes, int max_numorden, double min_log2fr, double max_log2fr) {
-    PitchSet pitchset;
-    PrimeList nums;
-    // generate all numbers with prime factors in primes up to max_numorden
-    for (int i = 1; i < max_numorden; i++) {
-        int r = i;
-        double log2fr = 0.0;
-        for (auto p : primes) {
-            while (r % p.number == 0) {
-                r /= p.number;
-                log2fr += p.log2fr;
-            }
-        }
-        bool include = r == 1;
-        if(include){
-            PseudoPrimeInt p;
-            p.label = std::to_string(i);
-            p.number = i;
-            p.log2fr = log2fr;
-            nums.push_back(p);
+    return generateBoundedJIPitchSet(primes, JIBound::numDen(max_numorden), min_log2fr, max_log2fr);
+};
+
+// ── JI enumeration ───────────────────────────────────────────────────────────
+
+typedef struct {
+    long long number;
+    double log2fr;
+} SmoothNumber;
+
+// Depth-first products of primes[first..], so each number's log2fr is summed
+// in prime-list order, exactly as trial division would accumulate it.
+static void collectSmoothNumbers(const PrimeList& primes, size_t first, long long n, double log2fr,
+                                 long long limit, std::vector<SmoothNumber>& out) {
+    out.push_back({n, log2fr});
+    for (size_t i = first; i < primes.size(); ++i) {
+        long long p = primes[i].number;
+        if (n > limit / p) continue;
+        collectSmoothNumbers(primes, i, n * p, log2fr + primes[i].log2fr, limit, out);
+    }
+}
+
+static bool inJIRange(double log2fr, double min_log2fr, double max_log2fr) {
+    return log2fr > min_log2fr - 1e-6 && log2fr < max_log2fr + 1e-6;
+}
+
+void enumerateJIPitches(const PrimeList& primes, JIBound bound, double min_log2fr, double max_log2fr,
+                        const JIPitchCallback& emit) {
+    // Drop repeated and degenerate entries; for odd limits, set 2 aside
+    const bool odd = bound.kind == JIBound::ODD_LIMIT;
+    PrimeList basis;
+    double two_log2fr = 0.0;
+    bool has_two = false;
+    for (const auto& p : primes) {
+        if (p.number < 2) continue;
+        bool seen = (has_two && p.number == 2) ||
+            std::any_of(basis.begin(), basis.end(), [&](const PseudoPrimeInt& q) { return q.number == p.number; });
+        if (seen) continue;
+        if (odd && p.number == 2) {
+            has_two = true;
+            two_log2fr = p.log2fr;
+            continue;
         }
+        basis.push_back(p);
     }
-    for (auto num: nums){
-        for (auto den: nums){
-            if (std::gcd(num.number, den.number) > 1){
-                continue;
-            }
-            if (static_cast<int>(num.number) <= max_numorden && static_cast<int>(den.number) <= max_numorden) {
-                PitchSetPitch pitch;
-                pitch.label = num.label + ":" + den.label;
-                pitch.log2fr = num.log2fr - den.log2fr;
-                pitchset.push_back(pitch);
+
+    long long limit = bound.kind == JIBound::NUM_DEN ? bound.limit - 1 : bound.limit;
+    if (limit < 1) return;
+
+    std::vector<SmoothNumber> smooth;
+    collectSmoothNumbers(basis, 0, 1, 0.0, limit, smooth);
+    std::sort(smooth.begin(), smooth.end(), [](const SmoothNumber& a, const SmoothNumber& b) {
+        return a.log2fr < b.log2fr;
+    });
+    auto firstAtLeast = [&](double log2fr) {
+        return std::lower_bound(smooth.begin(), smooth.end(), log2fr,
+            [](const SmoothNumber& s, double v) { return s.log2fr < v; });
+    };
+    const double slack = 1e-6 + 1e-9;
+
+    if (odd && has_two && two_log2fr > 0.0) {
+        // Every coprime odd pair, shifted by the powers of two that land in range
+        for (const auto& den : smooth) {
+            for (const auto& num : smooth) {
+                if (std::gcd(num.number, den.number) > 1) continue;
+                double base = num.log2fr - den.log2fr;
+                long long k_lo = static_cast<long long>(std::ceil((min_log2fr - slack - base) / two_log2fr));
+                long long k_hi = static_cast<long long>(std::floor((max_log2fr + slack - base) / two_log2fr));
+                for (long long k = std::max(k_lo, -62LL); k <= std::min(k_hi, 62LL); ++k) {
+                    double log2fr = base + k * two_log2fr;
+                    if (!inJIRange(log2fr, min_log2fr, max_log2fr)) continue;
+                    long long n = num.number, d = den.number;
+                    long long& shifted = k >= 0 ? n : d;
+                    int shift = static_cast<int>(k >= 0 ? k : -k);
+                    if (shifted > (LLONG_MAX >> shift)) continue;
+                    shifted <<= shift;
+                    emit(n, d, log2fr);
+                }
             }
         }
+        return;
     }
-    // filter out pitches with log2fr outside of min_log2fr and max_log2fr
-    PitchSet filtered_pitchset;
-    for (auto pitch : pitchset) {
-        if (pitch.log2fr > min_log2fr - 1e-6 && pitch.log2fr < max_log2fr + 1e-6) {
-            filtered_pitchset.push_back(pitch);
+
+    for (const auto& den : smooth) {
+        auto it = firstAtLeast(min_log2fr + den.log2fr - slack);
+        for (; it != smooth.end() && it->log2fr <= max_log2fr + den.log2fr + slack; ++it) {
+            double log2fr = it->log2fr - den.log2fr;
+            if (!inJIRange(log2fr, min_log2fr, max_log2fr)) continue;
+            if (bound.kind == JIBound::TENNEY_HEIGHT && it->number > limit / den.number) continue;
+            if (std::gcd(it->number, den.number) > 1) continue;
+            emit(it->number, den.number, log2fr);
         }
     }
-    // sort
-    std::sort(filtered_pitchset.begin(), filtered_pitchset.end(), 
-        [](PitchSetPitch a, PitchSetPitch b) {
-            return a.log2fr < b.log2fr;
-        }
-    );
-    return filtered_pitchset;
-};
+}
+
+PitchSet generateBoundedJIPitchSet(const PrimeList& primes, JIBound bound, double min_log2fr, double max_log2fr) {
+    typedef struct {
+        long long num;
+        long long den;
+        double log2fr;
+    } Ratio;
+    std::vector<Ratio> ratios;
+    enumerateJIPitches(primes, bound, min_log2fr, max_log2fr,
+        [&](long long num, long long den, double log2fr) { ratios.push_back({num, den, log2fr}); });
+    std::sort(ratios.begin(), ratios.end(), [](const Ratio& a, const Ratio& b) {
+        if (a.log2fr != b.log2fr) return a.log2fr < b.log2fr;
+        return a.den != b.den ? a.den < b.den : a.num < b.num;
+    });
+
+    PitchSet pitchset;
+    pitchset.reserve(ratios.size());
+    char buf[48];
+    for (const auto& r : ratios) {
+        int len = std::snprintf(buf, sizeof(buf), "%lld:%lld", r.num, r.den);
+        PitchSetPitch pitch;
+        pitch.label.assign(buf, len);
+        pitch.log2fr = r.log2fr;
+        pitchset.push_back(std::move(pitch));
+    }
+    return pitchset;
+}
 
 
 PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_log2fr, double max_log2fr) {
@@ -166,152 +277,230 @@ PitchSet generateHarmonicSeriesPitchSet(PrimeList primes, int base, double min_l
     return pitchset;
 };
 
-PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b) {
-    PitchSetPitch result;
-    result.log2fr = a.log2fr + b.log2fr;
-    
-    // Parse label formats
-    auto parseRatio = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t colonPos = label.find(':');
-        if (colonPos != std::string::npos) {
-            int num, den;
-            if (parseIntStrict(label.substr(0, colonPos), num) &&
-                parseIntStrict(label.substr(colonPos + 1), den)) {
-                return {true, {num, den}};
-            }
-            return {false, {0, 0}};
+// ── ExactPitch ───────────────────────────────────────────────────────────────
+
+// Overflow-checked 64-bit multiply; returns false instead of wrapping.
+static bool mulChecked(long long a, long long b, long long& out) {
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_mul_overflow(a, b, &out);
+#else
+    if (a != 0 && b != 0) {
+        // llabs(LLONG_MIN) is undefined, and LLONG_MIN times anything but 1 overflows
+        if (a == LLONG_MIN || b == LLONG_MIN) {
+            if (a != 1 && b != 1) return false;
+        } else if (std::llabs(a) > LLONG_MAX / std::llabs(b)) {
+            return false;
         }
-        return {false, {0, 0}};
-    };
-    
-    auto parseET = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t backslashPos = label.find('\\');
-        if (backslashPos != std::string::npos) {
-            int num, den;
-            if (parseIntStrict(label.substr(0, backslashPos), num) &&
-                parseIntStrict(label.substr(backslashPos + 1), den)) {
-                return {true, {num, den}};
-            }
-            return {false, {0, 0}};
+    }
+    out = a * b;
+    return true;
+#endif
+}
+
+static bool addChecked(long long a, long long b, long long& out) {
+#if defined(__GNUC__) || defined(__clang__)
+    return !__builtin_add_overflow(a, b, &out);
+#else
+    if ((b > 0 && a > LLONG_MAX - b) || (b < 0 && a < LLONG_MIN - b)) return false;
+    out = a + b;
+    return true;
+#endif
+}
+
+// base^exp for exp >= 0 by repeated squaring, with overflow detection.
+static bool powChecked(long long base, unsigned int exp, long long& out) {
+    long long result = 1;
+    while (exp > 0) {
+        if (exp & 1u) {
+            if (!mulChecked(result, base, result)) return false;
         }
-        return {false, {0, 0}};
-    };
-    
-    auto [isRatioA, ratioA] = parseRatio(a.label);
-    auto [isRatioB, ratioB] = parseRatio(b.label);
-    auto [isETA, etA] = parseET(a.label);
-    auto [isETB, etB] = parseET(b.label);
-    
-    if (isRatioA && isRatioB) {
-        // Both are ratios: multiply fractions and simplify
-        int newNum = ratioA.first * ratioB.first;
-        int newDen = ratioA.second * ratioB.second;
-        int gcd = std::gcd(newNum, newDen);
-        newNum /= gcd;
-        newDen /= gcd;
-        result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
-    } else if (isETA && isETB && etA.second == etB.second) {
-        // Both are ET fractions with same denominator: add numerators
-        int newNum = etA.first + etB.first;
-        int den = etA.second;
-        result.label = std::to_string(newNum) + "\\" + std::to_string(den);
-    } else {
-        // Incompatible formats or different denominators - return empty label
-        result.label = "";
+        exp >>= 1;
+        if (exp > 0 && !mulChecked(base, base, base)) return false;
     }
-    
-    return result;
+    out = result;
+    return true;
 }
 
-PitchSetPitch operator*(int multiplier, const PitchSetPitch& pitch) {
-    return pitch * multiplier;
+// Strict parse of [begin, end) as a decimal integer, without allocating.
+// Non-throwing (replaces std::stoi + try/catch) so the library builds on MCUs
+// with -fno-exceptions.
+static bool parseSpanStrict(const char* begin, const char* end, long long& out) {
+    if (begin == end) return false;
+    char* stop = nullptr;
+    long long v = std::strtoll(begin, &stop, 10);
+    if (stop != end) return false;
+    out = v;
+    return true;
 }
 
-PitchSetPitch operator*(const PitchSetPitch& pitch, int multiplier) {
-    PitchSetPitch result;
-    result.log2fr = multiplier * pitch.log2fr;
-    
-    // Parse label formats
-    auto parseRatio = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t colonPos = label.find(':');
-        if (colonPos != std::string::npos) {
-            int num, den;
-            if (parseIntStrict(label.substr(0, colonPos), num) &&
-                parseIntStrict(label.substr(colonPos + 1), den)) {
-                return {true, {num, den}};
-            }
-            return {false, {0, 0}};
+ExactPitch ExactPitch::ratio(long long num, long long den, double log2fr) {
+    ExactPitch p;
+    p.log2fr = log2fr;
+    // Frequency ratios are positive; anything else has no RATIO form
+    if (num <= 0 || den <= 0) return p;
+    long long g = std::gcd(num, den);
+    if (g > 1) {
+        num /= g;
+        den /= g;
+    }
+    p.kind = RATIO;
+    p.num = num;
+    p.den = den;
+    return p;
+}
+
+ExactPitch ExactPitch::ratio(long long num, long long den) {
+    if (num <= 0 || den <= 0) return none(0.0);
+    return ratio(num, den, std::log2(static_cast<double>(num)) - std::log2(static_cast<double>(den)));
+}
+
+ExactPitch ExactPitch::et(long long step, long long division, double equave_log2fr) {
+    ExactPitch p;
+    p.log2fr = division != 0 ? step * equave_log2fr / division : 0.0;
+    if (division == 0) return p;
+    p.kind = ET;
+    p.num = step;
+    p.den = division;
+    return p;
+}
+
+ExactPitch ExactPitch::fromLabel(const std::string& label, double log2fr) {
+    const char* begin = label.c_str();
+    const char* end = begin + label.size();
+    long long num, den;
+    size_t colonPos = label.find(':');
+    if (colonPos != std::string::npos) {
+        if (parseSpanStrict(begin, begin + colonPos, num) &&
+            parseSpanStrict(begin + colonPos + 1, end, den)) {
+            return ratio(num, den, log2fr);
         }
-        return {false, {0, 0}};
-    };
-    
-    auto parseET = [](const std::string& label) -> std::pair<bool, std::pair<int, int>> {
-        size_t backslashPos = label.find('\\');
-        if (backslashPos != std::string::npos) {
-            int num, den;
-            if (parseIntStrict(label.substr(0, backslashPos), num) &&
-                parseIntStrict(label.substr(backslashPos + 1), den)) {
-                return {true, {num, den}};
-            }
-            return {false, {0, 0}};
+        return none(log2fr);
+    }
+    size_t backslashPos = label.find('\\');
+    if (backslashPos != std::string::npos) {
+        if (parseSpanStrict(begin, begin + backslashPos, num) &&
+            parseSpanStrict(begin + backslashPos + 1, end, den) && den != 0) {
+            ExactPitch p;
+            p.kind = ET;
+            p.num = num;
+            p.den = den;
+            p.log2fr = log2fr;
+            return p;
         }
-        return {false, {0, 0}};
-    };
-    
-    auto [isRatio, ratio] = parseRatio(pitch.label);
-    auto [isET, et] = parseET(pitch.label);
-    
-    if (isRatio) {
-        // For ratios: integer is the power
-        // multiplier * (num:den) = num^multiplier : den^multiplier
-        if (multiplier >= 0) {
-            long long newNum = 1;
-            long long newDen = 1;
-            
-            // Calculate num^multiplier and den^multiplier
-            for (int i = 0; i < multiplier; i++) {
-                newNum *= ratio.first;
-                newDen *= ratio.second;
-            }
-            
-            // Simplify with GCD
-            long long gcd = std::gcd(newNum, newDen);
-            newNum /= gcd;
-            newDen /= gcd;
-            
-            result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
-        } else {
-            // Negative multiplier: invert and raise to positive power
-            int posMultiplier = -multiplier;
-            long long newNum = 1;
-            long long newDen = 1;
-            
-            // Calculate den^|multiplier| : num^|multiplier| (inverted)
-            for (int i = 0; i < posMultiplier; i++) {
-                newNum *= ratio.second;  // denominator becomes numerator
-                newDen *= ratio.first;   // numerator becomes denominator
-            }
-            
-            // Simplify with GCD
-            long long gcd = std::gcd(newNum, newDen);
-            newNum /= gcd;
-            newDen /= gcd;
-            
-            result.label = std::to_string(newNum) + ":" + std::to_string(newDen);
+    }
+    return none(log2fr);
+}
+
+ExactPitch ExactPitch::fromPitchSetPitch(const PitchSetPitch& pitch) {
+    return fromLabel(pitch.label, pitch.log2fr);
+}
+
+int ExactPitch::formatLabel(char* buf, size_t size) const {
+    switch (kind) {
+        case RATIO: return std::snprintf(buf, size, "%lld:%lld", num, den);
+        case ET:    return std::snprintf(buf, size, "%lld\\%lld", num, den);
+        default:
+            if (size > 0) buf[0] = '\0';
+            return 0;
+    }
+}
+
+std::string ExactPitch::label() const {
+    char buf[48];
+    int len = formatLabel(buf, sizeof(buf));
+    return std::string(buf, len > 0 ? static_cast<size_t>(len) : 0);
+}
+
+PitchSetPitch ExactPitch::toPitchSetPitch() const {
+    PitchSetPitch p;
+    p.label = label();
+    p.log2fr = log2fr;
+    return p;
+}
+
+ExactPitch operator+(const ExactPitch& a, const ExactPitch& b) {
+    double log2fr = a.log2fr + b.log2fr;
+    if (a.kind == ExactPitch::RATIO && b.kind == ExactPitch::RATIO) {
+        // Cross-reduce first so intermediate products stay as small as possible
+        long long g1 = std::gcd(a.num, b.den);
+        long long g2 = std::gcd(b.num, a.den);
+        if (g1 == 0) g1 = 1;
+        if (g2 == 0) g2 = 1;
+        long long num, den;
+        if (mulChecked(a.num / g1, b.num / g2, num) && mulChecked(a.den / g2, b.den / g1, den)) {
+            return ExactPitch::ratio(num, den, log2fr);
+        }
+    } else if (a.kind == ExactPitch::ET && b.kind == ExactPitch::ET && a.den == b.den) {
+        long long step;
+        if (addChecked(a.num, b.num, step)) {
+            ExactPitch p = a;
+            p.num = step;
+            p.log2fr = log2fr;
+            return p;
         }
-    } else if (isET) {
-        // For ET: multiply the numerator
-        // multiplier * (num\\den) = (multiplier * num)\\den
-        int newNum = multiplier * et.first;
-        int den = et.second;
-        result.label = std::to_string(newNum) + "\\" + std::to_string(den);
-    } else {
-        // Unknown format - return empty label
-        result.label = "";
     }
-    
+    return ExactPitch::none(log2fr);
+}
+
+ExactPitch operator-(const ExactPitch& a) {
+    return a * -1;
+}
+
+ExactPitch operator-(const ExactPitch& a, const ExactPitch& b) {
+    return a + (b * -1);
+}
+
+ExactPitch operator*(int multiplier, const ExactPitch& pitch) {
+    return pitch * multiplier;
+}
+
+ExactPitch operator*(const ExactPitch& pitch, int multiplier) {
+    double log2fr = multiplier * pitch.log2fr;
+    if (pitch.kind == ExactPitch::RATIO) {
+        // Integer is the power; num and den are coprime so their powers are too
+        long long base_num = multiplier >= 0 ? pitch.num : pitch.den;
+        long long base_den = multiplier >= 0 ? pitch.den : pitch.num;
+        unsigned int exp = multiplier >= 0 ? static_cast<unsigned int>(multiplier)
+                                           : 0u - static_cast<unsigned int>(multiplier);
+        long long num, den;
+        if (powChecked(base_num, exp, num) && powChecked(base_den, exp, den)) {
+            return ExactPitch::ratio(num, den, log2fr);
+        }
+    } else if (pitch.kind == ExactPitch::ET) {
+        long long step;
+        if (mulChecked(pitch.num, multiplier, step)) {
+            ExactPitch p = pitch;
+            p.num = step;
+            p.log2fr = log2fr;
+            return p;
+        }
+    }
+    return ExactPitch::none(log2fr);
+}
+
+std::vector<ExactPitch> toExactPitches(const PitchSet& pitchset) {
+    std::vector<ExactPitch> result;
+    result.reserve(pitchset.size());
+    for (const auto& pitch : pitchset) {
+        result.push_back(ExactPitch::fromPitchSetPitch(pitch));
+    }
     return result;
 }
 
+// ── PitchSetPitch operators ──────────────────────────────────────────────────
+// Labels are parsed once into ExactPitch, combined on integers, and formatted once.
+
+PitchSetPitch operator+(const PitchSetPitch& a, const PitchSetPitch& b) {
+    return (ExactPitch::fromPitchSetPitch(a) + ExactPitch::fromPitchSetPitch(b)).toPitchSetPitch();
+}
+
+PitchSetPitch operator*(int multiplier, const PitchSetPitch& pitch) {
+    return pitch * multiplier;
+}
+
+PitchSetPitch operator*(const PitchSetPitch& pitch, int multiplier) {
+    return (ExactPitch::fromPitchSetPitch(pitch) * multiplier).toPitchSetPitch();
+}
+
 
 };
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>  // For std::vector, std::pair
+#include <pybind11/operators.h>
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <scalatrix.hpp>
+#include <algorithm>
 
 namespace py = pybind11;
 using namespace scalatrix;
@@ -68,7 +72,13 @@ PYBIND11_MODULE(scalatrix, m) {
                    ", c=" + std::to_string(t.c) + ", d=" + std::to_string(t.d) +
                    ", tx=" + std::to_string(t.tx) + ", ty=" + std::to_string(t.ty) + ")";
         })
-        .def_static("linearFromTwoDots", &IntegerAffineTransform::linearFromTwoDots);
+        .def_static("linearFromTwoDots", &IntegerAffineTransform::linearFromTwoDots)
+        .def_static("linearMapFromTwoDots", [](const Vector2i& a1, const Vector2i& a2,
+                                               const Vector2i& b1, const Vector2i& b2) {
+            bool exact = false;
+            IntegerAffineTransform M = IntegerAffineTransform::linearMapFromTwoDots(a1, a2, b1, b2, &exact);
+            return std::make_pair(M, exact);
+        });
 
     py::class_<AffineTransform>(m, "AffineTransform")
         .def(py::init<double, double, double, double, double, double>())
@@ -92,16 +102,53 @@ PYBIND11_MODULE(scalatrix, m) {
                    ", tx=" + std::to_string(t.tx) + ", ty=" + std::to_string(t.ty) + ")";
         });
 
+    py::class_<StripBasisCache>(m, "StripBasisCache")
+        .def("hits", &StripBasisCache::hits)
+        .def("misses", &StripBasisCache::misses)
+        .def("hitRate", &StripBasisCache::hitRate)
+        .def("resetCounters", &StripBasisCache::resetCounters)
+        .def("clear", &StripBasisCache::clear);
+
+    m.def("stripStepWord", py::overload_cast<const AffineTransform&, int>(&stripStepWord));
+
     py::class_<Scale>(m, "Scale")
         .def(py::init<double>())
         .def("fromAffine", &Scale::fromAffine)
         .def("recalcWithAffine", &Scale::recalcWithAffine)
+        .def("reset", &Scale::reset)
         .def("retuneWithAffine", &Scale::retuneWithAffine)
-        .def("getNodes", static_cast<std::vector<Node>& (Scale::*)()>(&Scale::getNodes), py::return_value_policy::reference)
+        .def("getNodes", static_cast<NodeVector& (Scale::*)()>(&Scale::getNodes), py::return_value_policy::reference)
         .def("getRootIdx", &Scale::getRootIdx)
-        .def("temperToPitchSet", &Scale::temperToPitchSet)
+        .def("temperToPitchSet", py::overload_cast<PitchSet&>(&Scale::temperToPitchSet))
+        .def("temperToPitchSet", [](Scale& self, const PitchSetIndex& index) {
+            TemperingStats stats;
+            self.temperToPitchSet(index, &stats);
+            return stats;
+        })
+        .def("getStripCache", static_cast<StripBasisCache& (Scale::*)()>(&Scale::getStripCache), py::return_value_policy::reference_internal)
+        .def("getStepWord", &Scale::getStepWord)
+        .def("getStripBasis", &Scale::getStripBasis)
         .def("print", &Scale::print);
 
+    py::class_<MOSConvergent>(m, "MOSConvergent")
+        .def_readonly("depth", &MOSConvergent::depth)
+        .def_readonly("a0", &MOSConvergent::a0)
+        .def_readonly("b0", &MOSConvergent::b0);
+
+    py::class_<MOSPattern>(m, "MOSPattern")
+        .def_readonly("a0", &MOSPattern::a0)
+        .def_readonly("b0", &MOSPattern::b0)
+        .def_readonly("depth", &MOSPattern::depth)
+        .def_readonly("v_gen", &MOSPattern::v_gen)
+        .def_readonly("g_lo", &MOSPattern::g_lo)
+        .def_readonly("g_hi", &MOSPattern::g_hi)
+        .def_readonly("mosTransform", &MOSPattern::mosTransform)
+        .def("size", &MOSPattern::size)
+        .def("path", &MOSPattern::path);
+    m.def("mosPatternTable", &mosPatternTable, py::return_value_policy::reference);
+    m.def("findMOSPattern", py::overload_cast<int, double>(&findMOSPattern), py::return_value_policy::reference);
+    m.def("findMOSPatternBySize", py::overload_cast<int, int>(&findMOSPattern), py::return_value_policy::reference);
+
     py::class_<MOS>(m, "MOS")
         .def(py::init<int, int, int, double, double>())
         .def_readwrite("L_vec", &MOS::L_vec)
@@ -132,6 +179,8 @@ PYBIND11_MODULE(scalatrix, m) {
         .def_readwrite("base_scale", &MOS::base_scale)
         .def_static("fromParams", &MOS::fromParams,
             py::arg("a"), py::arg("b"), py::arg("m"), py::arg("e"), py::arg("g"), py::arg("repetitions") = 1)
+        .def_static("convergents", &MOS::convergents)
+        .def_static("depthForSize", &MOS::depthForSize)
         .def_static("fromG", &MOS::fromG,
             py::arg("depth"), py::arg("m"), py::arg("g"), py::arg("e"), py::arg("repetitions") = 1)
         .def("adjustG", &MOS::adjustG)
@@ -153,6 +202,8 @@ PYBIND11_MODULE(scalatrix, m) {
         .def("retuneThreePoints", &MOS::retuneThreePoints)
         .def("generateScaleFromMOS", &MOS::generateScaleFromMOS)
         .def("generateMappedScale", &MOS::generateMappedScale)
+        .def("generateScaleFromMOSInto", &MOS::generateScaleFromMOSInto)
+        .def("generateMappedScaleInto", &MOS::generateMappedScaleInto)
         .def("retuneScaleWithMOS", &MOS::retuneScaleWithMOS)
         .def("mapFromMOS", &MOS::mapFromMOS)
         .def("toRootCoord", &MOS::toRootCoord)
@@ -163,17 +214,260 @@ PYBIND11_MODULE(scalatrix, m) {
         .def("nodeAccidental", &MOS::nodeAccidental)
         .def("mosCoordFromNotation", &MOS::mosCoordFromNotation);
 
+    // label_calculator.hpp
+
+    // A label batch goes to Python as (text, offsets): bytes and a NumPy
+    // uint32 array, label i being text[offsets[i]:offsets[i + 1]].decode()
+    auto label_batch = [](const LabelBatch& batch) {
+        py::array_t<uint32_t> offsets(static_cast<py::ssize_t>(batch.offsets.size()), batch.offsets.data());
+        return py::make_tuple(py::bytes(batch.text), offsets);
+    };
+
+    py::class_<LabelTable> labelTable(m, "LabelTable");
+    py::enum_<LabelTable::Style>(labelTable, "Style")
+        .value("DIGIT", LabelTable::DIGIT)
+        .value("DIGIT_ZERO_BASED", LabelTable::DIGIT_ZERO_BASED)
+        .value("LETTER", LabelTable::LETTER)
+        .value("LETTER_WITH_OCTAVE", LabelTable::LETTER_WITH_OCTAVE);
+    labelTable
+        .def(py::init<>())
+        .def(py::init<const MOS&, bool>(), py::arg("mos"), py::arg("tuning") = false)
+        .def("rebuild", &LabelTable::rebuild, py::arg("mos"), py::arg("tuning") = false)
+        .def("matches", &LabelTable::matches, py::arg("mos"), py::arg("tuning") = false)
+        .def("degree", &LabelTable::degree)
+        .def("accidentals", &LabelTable::accidentals)
+        .def("octave", &LabelTable::octave, py::arg("v"), py::arg("middle_C_octave") = 4)
+        .def("label", &LabelTable::label,
+            py::arg("v"), py::arg("style"), py::arg("accidentalAfter") = true, py::arg("middle_C_octave") = 4)
+        .def("labelRect", [label_batch](const LabelTable& t, Vector2i origin, int width, int height,
+                                        LabelTable::Style style, bool accidentalAfter, int middle_C_octave) {
+            LabelBatch batch;
+            t.labelRect(origin, width, height, style, batch, accidentalAfter, middle_C_octave);
+            return label_batch(batch);
+        }, py::arg("origin"), py::arg("width"), py::arg("height"), py::arg("style"),
+           py::arg("accidentalAfter") = true, py::arg("middle_C_octave") = 4)
+        .def("labelCoords", [label_batch](const LabelTable& t, const std::vector<Vector2i>& coords,
+                                          LabelTable::Style style, bool accidentalAfter, int middle_C_octave) {
+            LabelBatch batch;
+            t.labelCoords(coords.data(), coords.size(), style, batch, accidentalAfter, middle_C_octave);
+            return label_batch(batch);
+        }, py::arg("coords"), py::arg("style"), py::arg("accidentalAfter") = true, py::arg("middle_C_octave") = 4);
+
+    m.def("deviationLabels", [label_batch](const Scale& scale, double thresholdCents, bool compareWithTempered) {
+        LabelBatch batch;
+        const auto& nodes = scale.getNodes();
+        LabelCalculator::deviationLabels(nodes.data(), nodes.size(), batch, thresholdCents, compareWithTempered);
+        return label_batch(batch);
+    }, py::arg("scale"), py::arg("thresholdCents") = 0.1, py::arg("compareWithTempered") = false);
+
     // pitchset.hpp
 
     py::class_<PitchSetPitch>(m, "PitchSetPitch")
         .def(py::init<>())
         .def_readwrite("label", &PitchSetPitch::label)
         .def_readwrite("log2fr", &PitchSetPitch::log2fr);
+
+    py::class_<ExactPitch> exactPitch(m, "ExactPitch");
+    py::enum_<ExactPitch::Kind>(exactPitch, "Kind")
+        .value("NONE", ExactPitch::NONE)
+        .value("RATIO", ExactPitch::RATIO)
+        .value("ET", ExactPitch::ET);
+    exactPitch
+        .def(py::init<>())
+        .def_readwrite("kind", &ExactPitch::kind)
+        .def_readwrite("num", &ExactPitch::num)
+        .def_readwrite("den", &ExactPitch::den)
+        .def_readwrite("log2fr", &ExactPitch::log2fr)
+        .def_static("ratio", py::overload_cast<long long, long long>(&ExactPitch::ratio))
+        .def_static("et", &ExactPitch::et,
+            py::arg("step"), py::arg("division"), py::arg("equave_log2fr") = 1.0)
+        .def_static("fromLabel", &ExactPitch::fromLabel)
+        .def_static("fromPitchSetPitch", &ExactPitch::fromPitchSetPitch)
+        .def("label", &ExactPitch::label)
+        .def("toPitchSetPitch", &ExactPitch::toPitchSetPitch)
+        .def(py::self + py::self)
+        .def(py::self - py::self)
+        .def(-py::self)
+        .def(py::self * int())
+        .def(int() * py::self)
+        .def(py::self == py::self)
+        .def("__repr__", [](const ExactPitch& p) {
+            return "ExactPitch(" + p.label() + ", log2fr=" + std::to_string(p.log2fr) + ")";
+        });
+    m.def("toExactPitches", &toExactPitches);
+
+    py::class_<Monzo>(m, "Monzo")
+        .def(py::init<>())
+        .def_property("exps",
+            [](const Monzo& mz) { return std::vector<int32_t>(mz.exps.begin(), mz.exps.end()); },
+            [](Monzo& mz, const std::vector<int32_t>& e) {
+                mz.exps.fill(0);
+                std::copy_n(e.begin(), std::min<size_t>(e.size(), MONZO_MAX_PRIMES), mz.exps.begin());
+            })
+        .def("isUnison", &Monzo::isUnison)
+        .def(py::self + py::self)
+        .def(py::self - py::self)
+        .def(-py::self)
+        .def(py::self * int32_t())
+        .def(int32_t() * py::self)
+        .def(py::self == py::self);
+
+    py::class_<MonzoBasis>(m, "MonzoBasis")
+        .def(py::init<>())
+        .def(py::init<const PrimeList&>())
+        .def("size", &MonzoBasis::size)
+        .def("prime", &MonzoBasis::prime)
+        .def("primeLog2fr", &MonzoBasis::primeLog2fr)
+        .def("primeMonzo", &MonzoBasis::primeMonzo)
+        .def("fromRatio", [](const MonzoBasis& b, long long num, long long den) -> py::object {
+            Monzo mz;
+            if (!b.fromRatio(num, den, mz)) return py::none();
+            return py::cast(mz);
+        })
+        .def("log2fr", &MonzoBasis::log2fr)
+        .def("toExactPitch", &MonzoBasis::toExactPitch)
+        .def("label", &MonzoBasis::label)
+        .def("toPitchSetPitch", &MonzoBasis::toPitchSetPitch);
     
+    py::class_<JIBound> jiBound(m, "JIBound");
+    py::enum_<JIBound::Kind>(jiBound, "Kind")
+        .value("NUM_DEN", JIBound::NUM_DEN)
+        .value("ODD_LIMIT", JIBound::ODD_LIMIT)
+        .value("TENNEY_HEIGHT", JIBound::TENNEY_HEIGHT);
+    jiBound
+        .def(py::init<>())
+        .def_readwrite("kind", &JIBound::kind)
+        .def_readwrite("limit", &JIBound::limit)
+        .def_static("numDen", &JIBound::numDen)
+        .def_static("oddLimit", &JIBound::oddLimit)
+        .def_static("tenneyHeight", &JIBound::tenneyHeight);
+    m.def("enumerateJIPitches", &enumerateJIPitches,
+        py::arg("primes"), py::arg("bound"), py::arg("min_log2fr"), py::arg("max_log2fr"), py::arg("emit"));
+
+    py::class_<PitchSetIndex>(m, "PitchSetIndex")
+        .def(py::init<>())
+        .def(py::init<const PitchSet&>())
+        .def("closest", &PitchSetIndex::closest)
+        .def("pitchSet", &PitchSetIndex::pitchSet)
+        .def("size", &PitchSetIndex::size);
+
+    py::class_<TemperingStats>(m, "TemperingStats")
+        .def(py::init<>())
+        .def_readwrite("max_cents", &TemperingStats::max_cents)
+        .def_readwrite("rms_cents", &TemperingStats::rms_cents)
+        .def_readwrite("n_nodes", &TemperingStats::n_nodes);
+
+    // Tempers the Python-owned scales in place, without copying them into a
+    // std::vector and back. The scales are held for the whole call, as the
+    // list may change once the GIL is released, and each may appear only once,
+    // as two workers must not temper the same scale.
+    m.def("temperScales", [](const py::list& list, const PitchSetIndex& index, int n_threads) {
+        std::vector<py::object> owners;
+        std::vector<Scale*> scales;
+        owners.reserve(list.size());
+        scales.reserve(list.size());
+        for (py::handle item : list) {
+            scales.push_back(&item.cast<Scale&>());
+            owners.push_back(py::reinterpret_borrow<py::object>(item));
+        }
+        std::vector<Scale*> sorted = scales;
+        std::sort(sorted.begin(), sorted.end());
+        if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+            throw py::value_error("temperScales: a scale appears more than once");
+        }
+        std::vector<TemperingStats> stats(scales.size());
+        {
+            py::gil_scoped_release release;
+            parallelFor(scales.size(), 1, n_threads, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; ++i) {
+                    scales[i]->temperToPitchSet(index, &stats[i]);
+                }
+            });
+        }
+        return stats;
+    }, py::arg("scales"), py::arg("index"), py::arg("n_threads") = 0);
+
+    py::class_<MOSFamilyOptions>(m, "MOSFamilyOptions")
+        .def(py::init<>())
+        .def_readwrite("min_size", &MOSFamilyOptions::min_size)
+        .def_readwrite("max_size", &MOSFamilyOptions::max_size)
+        .def_readwrite("g_steps", &MOSFamilyOptions::g_steps)
+        .def_readwrite("equave", &MOSFamilyOptions::equave)
+        .def_readwrite("steps", &MOSFamilyOptions::steps)
+        .def_readwrite("offset", &MOSFamilyOptions::offset)
+        .def_readwrite("base_freq", &MOSFamilyOptions::base_freq)
+        .def_readwrite("n_nodes", &MOSFamilyOptions::n_nodes)
+        .def_readwrite("root", &MOSFamilyOptions::root)
+        .def_readwrite("n_threads", &MOSFamilyOptions::n_threads);
+
+    // Columns are NumPy views into the family, which they keep alive:
+    // one entry per member, or (members, n_nodes) for the node columns
+    auto member_column = [](auto column) {
+        return [column](py::object self) {
+            auto& values = self.cast<MOSFamily&>().*column;
+            return py::array(static_cast<py::ssize_t>(values.size()), values.data(), self);
+        };
+    };
+    auto node_column = [](auto column) {
+        return [column](py::object self) {
+            MOSFamily& family = self.cast<MOSFamily&>();
+            auto& values = family.*column;
+            std::vector<py::ssize_t> shape = {static_cast<py::ssize_t>(family.size()), family.n_nodes};
+            return py::array(shape, values.data(), self);
+        };
+    };
+    py::class_<MOSFamily>(m, "MOSFamily")
+        .def_readonly("n_nodes", &MOSFamily::n_nodes)
+        .def("__len__", &MOSFamily::size)
+        .def_property_readonly("a", member_column(&MOSFamily::a))
+        .def_property_readonly("b", member_column(&MOSFamily::b))
+        .def_property_readonly("mode", member_column(&MOSFamily::mode))
+        .def_property_readonly("generator", member_column(&MOSFamily::generator))
+        .def_property_readonly("L_fr", member_column(&MOSFamily::L_fr))
+        .def_property_readonly("s_fr", member_column(&MOSFamily::s_fr))
+        .def_property_readonly("coord_x", node_column(&MOSFamily::coord_x))
+        .def_property_readonly("coord_y", node_column(&MOSFamily::coord_y))
+        .def_property_readonly("tuning_x", node_column(&MOSFamily::tuning_x))
+        .def_property_readonly("tuning_y", node_column(&MOSFamily::tuning_y))
+        .def_property_readonly("pitch", node_column(&MOSFamily::pitch));
+
+    m.def("generateMOSFamily", [](const MOSFamilyOptions& options) {
+        py::gil_scoped_release release;
+        return generateMOSFamily(options);
+    }, py::arg("options") = MOSFamilyOptions());
+
+    py::class_<TemperamentSearchOptions>(m, "TemperamentSearchOptions")
+        .def(py::init<>())
+        .def_readwrite("min_size", &TemperamentSearchOptions::min_size)
+        .def_readwrite("max_size", &TemperamentSearchOptions::max_size)
+        .def_readwrite("min_equave", &TemperamentSearchOptions::min_equave)
+        .def_readwrite("max_equave", &TemperamentSearchOptions::max_equave)
+        .def_readwrite("g_steps", &TemperamentSearchOptions::g_steps)
+        .def_readwrite("e_steps", &TemperamentSearchOptions::e_steps)
+        .def_readwrite("refine_iterations", &TemperamentSearchOptions::refine_iterations)
+        .def_readwrite("n_threads", &TemperamentSearchOptions::n_threads)
+        .def_readwrite("weights", &TemperamentSearchOptions::weights);
+
+    py::class_<TemperamentCandidate>(m, "TemperamentCandidate")
+        .def_readonly("a", &TemperamentCandidate::a)
+        .def_readonly("b", &TemperamentCandidate::b)
+        .def_readonly("mode", &TemperamentCandidate::mode)
+        .def_readonly("generator", &TemperamentCandidate::generator)
+        .def_readonly("equave", &TemperamentCandidate::equave)
+        .def_readonly("rms_cents", &TemperamentCandidate::rms_cents)
+        .def_readonly("max_cents", &TemperamentCandidate::max_cents);
+
+    m.def("searchTemperaments", [](const PitchSet& target, const TemperamentSearchOptions& options) {
+        py::gil_scoped_release release;
+        return searchTemperaments(target, options);
+    }, py::arg("target"), py::arg("options") = TemperamentSearchOptions());
+
     py::class_<PitchSet>(m, "PitchSet")
         .def(py::init<>())
         .def_static("generateETPitchSet", &generateETPitchSet)
         .def_static("generateJIPitchSet", &generateJIPitchSet)
+        .def_static("generateBoundedJIPitchSet", &generateBoundedJIPitchSet,
+            py::arg("primes"), py::arg("bound"), py::arg("min_log2fr") = 0.0, py::arg("max_log2fr") = 1.0)
         .def_static("generateHarmonicSeriesPitchSet", &generateHarmonicSeriesPitchSet);
     
     py::class_<PseudoPrimeInt>(m, "PseudoPrimeInt")
@@ -2,6 +2,7 @@
 #include "scalatrix/lattice.hpp"
 #include <iostream>
 #include <cassert>
+#include <algorithm>
 #include <cmath>
 
 namespace scalatrix {
@@ -12,12 +13,45 @@ void Scale::initNodes(int N){
     for (int i = 0; i < N; ++i) {
         nodes_.push_back(Node());
     }
+    step_word_.assign(N > 0 ? N - 1 : 0, STRIP_STEP_R);
 }
 
-Scale::Scale(double base_freq, int N, int root_node_idx) : base_freq_(base_freq), root_idx_(root_node_idx) {
+Scale::Scale(double base_freq, int N, int root_node_idx, MemoryResource* resource)
+    : nodes_(resource), base_freq_(base_freq), root_idx_(root_node_idx), step_word_(resource) {
     initNodes(N);
 }  
 
+// Untempers node, keeping its label storage
+static void clearNode(Node& node) {
+    node.isTempered = false;
+    node.temperedPitch.label.clear();
+    node.temperedPitch.log2fr = 0.0;
+    node.closestPitch.label.clear();
+    node.closestPitch.log2fr = 0.0;
+}
+
+void Scale::reset(double base_freq, int N, int root_node_idx) {
+    base_freq_ = base_freq;
+    root_idx_ = root_node_idx;
+    nodes_.resize(N);
+    for (Node& node : nodes_) {
+        clearNode(node);
+        node.natural_coord = Vector2i(0, 0);
+        node.tuning_coord = Vector2d(0, 0);
+        node.pitch = 0.0;
+    }
+    step_word_.assign(N > 0 ? N - 1 : 0, STRIP_STEP_R);
+}
+
+// Resets node to a fresh untempered node at v, reusing its label storage
+void Scale::placeNode(Node& node, const Vector2i& v, const AffineTransform& A) const {
+    node.natural_coord = v;
+    // A * v, spelled out so it inlines
+    node.tuning_coord = Vector2d(A.a * v.x + A.b * v.y + A.tx, A.c * v.x + A.d * v.y + A.ty);
+    node.pitch = base_freq_ * std::exp2(node.tuning_coord.x);
+    clearNode(node);
+}
+
 /**
  * Core implementation of "a scale is a path on a 2D lattice"
  * 
@@ -42,62 +76,50 @@ Scale Scale::fromAffine(const AffineTransform& A, const double base_freq, int N,
  * 2. Find lattice vectors r,s that map closest to strip boundaries
  * 3. Use 3-gap theorem to generate nodes within strip 0 ≤ y < 1
  * 4. Order resulting nodes by x-coordinate to form sequential scale path
+ *
+ * Step 3 runs in two passes: the step word (r, s or r+s per node) is chosen
+ * without branching on the node heights, then natural coordinates are prefix
+ * sums over it.
  */
 void Scale::recalcWithAffine(const AffineTransform& A, int N, int root_node_idx) {
     
     AffineTransform M = AffineTransform(A);
     M.tx = 0;
     M.ty = 0;
-    auto [r, s] = findClosestWithinStrip(M);
+    auto [r, s] = strip_cache_.find(M);
+    strip_r_ = r;
+    strip_s_ = s;
 
-    Vector2d zr = M * r;
-    Vector2d zs = M * s;
-
-    //printf("r = (%d, %d) -> (%f, %f)\n", r.x, r.y, zr.x, zr.y);
-    //printf("s = (%d, %d) -> (%f, %f)\n", s.x, s.y, zs.x, zs.y);
-
-    int n_min = -root_node_idx, n_max = N - root_node_idx;
+    int n_max = N - root_node_idx;
+    step_word_.resize(N > 0 ? N - 1 : 0);
+    uint8_t* word = step_word_.data();
 
     // Generate nodes within the strip 0 ≤ y < 1 using the 3-gap theorem
     // This creates the sequential scale path by selecting lattice nodes that
     // fall within the horizontal strip after transformation
+    if (n_max > 1) {
+        stripStepWord(A, r, s, Vector2i(0, 0), 1, n_max - 1, word + root_node_idx);
+    }
+    // The backward walk comes out in reverse index order
+    stripStepWord(A, r, s, Vector2i(0, 0), -1, root_node_idx, word);
+    std::reverse(word, word + root_node_idx);
+
+    const Vector2i steps[3] = {r, s, r + s};
     Node root;
     root.natural_coord = Vector2i(0, 0);
     root.tuning_coord = A * root.natural_coord;
     root.pitch = base_freq_;
-
     nodes_[root_node_idx] = root;
 
-    Node last = root;
-
-    // forward pass
-    for (int n = 1; n < n_max; ++n) {
-        if (0 <= last.tuning_coord.y + zr.y && last.tuning_coord.y + zr.y < 1) {
-            last.natural_coord += r;
-        } else if (0 <= last.tuning_coord.y + zs.y && last.tuning_coord.y + zs.y < 1) {
-            last.natural_coord += s;
-        } else {
-            last.natural_coord += (r + s);
-        }
-        last.tuning_coord = A * last.natural_coord;
-        last.pitch = base_freq_ * std::exp2(last.tuning_coord.x);
-        nodes_[root_node_idx + n] = last;
+    Vector2i v(0, 0);
+    for (int i = root_node_idx + 1; i < N; ++i) {
+        v += steps[word[i - 1]];
+        placeNode(nodes_[i], v, A);
     }
-    //std::cout << "Length of right: " << right.size() << "\n";
-
-    // backward pass
-    last = root;
-    for (int n = -1; n >= n_min; --n) {
-        if (0 <= last.tuning_coord.y - zr.y && last.tuning_coord.y - zr.y < 1) {
-            last.natural_coord -= r;
-        } else if (0 <= last.tuning_coord.y - zs.y && last.tuning_coord.y - zs.y < 1) {
-            last.natural_coord -= s;
-        } else {
-            last.natural_coord -= (r + s);
-        }
-        last.tuning_coord = A * last.natural_coord;
-        last.pitch = base_freq_ * std::exp2(last.tuning_coord.x);
-        nodes_[root_node_idx + n] = last;
+    v = Vector2i(0, 0);
+    for (int i = root_node_idx - 1; i >= 0; --i) {
+        v -= steps[word[i]];
+        placeNode(nodes_[i], v, A);
     }
 }
 
@@ -136,47 +158,63 @@ void Scale::print(int first, int num) const {
 }
 
 void Scale::temperToPitchSet(PitchSet& pitchset){
+    temperToPitchSet(PitchSetIndex(pitchset));
+};
+
+void Scale::temperToPitchSet(const PitchSetIndex& index, TemperingStats* stats){
     // find the closest pitch in pitchset to each node in base_scale
+    const PitchSet& pitchset = index.pitchSet();
+    double max_cents = 0.0;
+    double sum_sq_cents = 0.0;
+    int n_matched = 0;
     for (auto& node : nodes_) {
         double node_pitch_log2fr = log2(node.pitch/base_freq_);
+        int closest = index.closest(node_pitch_log2fr);
         double closest_pitch_log2fr = 0.0;
-        double min_dist = 1e6;
         PitchSetPitch closest_pitch;
-        for (auto& pitch : pitchset) {
-            double dist = std::abs(pitch.log2fr - node_pitch_log2fr);
-            if (dist < min_dist) {
-                min_dist = dist;
-                closest_pitch_log2fr = pitch.log2fr;
-                closest_pitch = pitch;
-            }
+        if (closest >= 0) {
+            closest_pitch = pitchset[closest];
+            closest_pitch_log2fr = closest_pitch.log2fr;
+            double cents = 1200.0 * (closest_pitch_log2fr - node_pitch_log2fr);
+            max_cents = std::max(max_cents, std::abs(cents));
+            sum_sq_cents += cents * cents;
+            n_matched++;
         }
-        //node.tuning_coord.x = closest_pitch_log2fr;
         node.pitch = base_freq_ * exp2(closest_pitch_log2fr);
         node.isTempered = true;
         node.temperedPitch = closest_pitch;
         node.closestPitch = closest_pitch;
     }
+    if (stats) {
+        stats->max_cents = max_cents;
+        stats->rms_cents = n_matched > 0 ? std::sqrt(sum_sq_cents / n_matched) : 0.0;
+        stats->n_nodes = n_matched;
+    }
 };
 
 
-std::vector<Node>& Scale::getNodes(){
+NodeVector& Scale::getNodes(){
     return nodes_;
 }
 
-const std::vector<Node>& Scale::getNodes() const {
+const NodeVector& Scale::getNodes() const {
     return nodes_;
 }
 
-
-// destructor
-Scale::~Scale() {
-
-    // free the memory
-    // https://stackoverflow.com/questions/13944886/is-stdvector-memory-freed-upon-a-clear
-    nodes_.clear();
-    //nodes_.shrink_to_fit();
-    std::vector<Node>(nodes_).swap(nodes_);
-    
+void ScaleColumns::update(const Scale& scale) {
+    const NodeVector& nodes = scale.getNodes();
+    size_t n = nodes.size();
+    pitch.resize(n);
+    natural_coord.resize(2 * n);
+    tuning_coord.resize(2 * n);
+    for (size_t i = 0; i < n; ++i) {
+        const Node& node = nodes[i];
+        pitch[i] = node.pitch;
+        natural_coord[2 * i] = node.natural_coord.x;
+        natural_coord[2 * i + 1] = node.natural_coord.y;
+        tuning_coord[2 * i] = node.tuning_coord.x;
+        tuning_coord[2 * i + 1] = node.tuning_coord.y;
+    }
 }
 
-} // namespace scalatrix
\ No newline at end of file
+} // namespace scalatrix
@@ -0,0 +1,264 @@
+#include "scalatrix/shared_tuning.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifdef SCALATRIX_HAS_SHARED_MEMORY
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace scalatrix {
+
+static const uint32_t SEGMENT_MAGIC = 0x4D535853; // "SXSM"
+static const uint32_t SEGMENT_VERSION = 1;
+static const int READ_ATTEMPTS = 4;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "shared tuning segments need address-free atomics");
+
+/*
+ * Layout of a segment: this header, then the two slots' payloads of
+ * slot_capacity bytes each. Table n (counting from 1) goes to slot n & 1.
+ * A slot's lock is odd while its payload is being written. slot_capacity
+ * only grows, when a publisher needs larger slots; readers map the
+ * segment again when it changes.
+ */
+struct SharedTuningSegment {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    std::atomic<uint32_t> slot_capacity;
+    uint32_t reserved;
+    std::atomic<uint32_t> latest; // tables published
+    uint8_t pad0[44];
+
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> lock;
+        std::atomic<uint32_t> size;
+    } slots[2];
+
+    // capacity is the caller's copy of slot_capacity, loaded once
+    uint8_t* payload(int slot, size_t capacity) {
+        return reinterpret_cast<uint8_t*>(this + 1) + slot * capacity;
+    }
+    const uint8_t* payload(int slot, size_t capacity) const {
+        return reinterpret_cast<const uint8_t*>(this + 1) + slot * capacity;
+    }
+};
+
+#ifdef SCALATRIX_HAS_SHARED_MEMORY
+
+static void* mapSegment(int fd, size_t size, int prot) {
+    void* p = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    return p == MAP_FAILED ? nullptr : p;
+}
+
+bool SharedTuningPublisher::open(const std::string& name, int max_nodes, bool float32) {
+    close();
+    if (max_nodes < 0) return false;
+    size_t capacity = (snapshotSize(max_nodes, float32 ? SNAPSHOT_FLOAT32 : 0) + 7) & ~size_t(7);
+    if (capacity > UINT32_MAX) return false;
+
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Reuse a segment that already fits, so attached readers carry on
+    size_t existing = static_cast<size_t>(st.st_size);
+    if (existing >= sizeof(SharedTuningSegment)) {
+        auto* seg = static_cast<SharedTuningSegment*>(mapSegment(fd, existing, PROT_READ | PROT_WRITE));
+        size_t existing_capacity = seg ? seg->slot_capacity.load(std::memory_order_relaxed) : 0;
+        if (seg && seg->magic.load(std::memory_order_acquire) == SEGMENT_MAGIC && seg->version == SEGMENT_VERSION
+            && existing_capacity >= capacity
+            && existing >= sizeof(SharedTuningSegment) + 2 * existing_capacity) {
+            ::close(fd);
+            segment_ = seg;
+            mapped_size_ = existing;
+            name_ = name;
+            float32_ = float32;
+            return true;
+        }
+        if (seg) munmap(seg, existing);
+    }
+
+    // Never shrink: readers may have the old size mapped
+    size_t size = std::max(existing, sizeof(SharedTuningSegment) + 2 * capacity);
+    capacity = ((size - sizeof(SharedTuningSegment)) / 2) & ~size_t(7);
+    if (capacity > UINT32_MAX || ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = mapSegment(fd, size, PROT_READ | PROT_WRITE);
+    ::close(fd);
+    if (!p) return false;
+
+    // The magic goes in last, so a reader opening meanwhile gives up
+    // rather than seeing a half-built header
+    auto* seg = static_cast<SharedTuningSegment*>(p);
+    if (seg->magic.load(std::memory_order_acquire) == SEGMENT_MAGIC && seg->version == SEGMENT_VERSION) {
+        // Growing a segment readers may have mapped: the sequence and the
+        // locks carry on, and the new capacity is stored before publish()
+        // writes at the new offsets, so a reader that copies any of those
+        // bytes sees the capacity change when it checks the copy
+        seg->magic.store(0, std::memory_order_relaxed);
+        seg->slot_capacity.store(static_cast<uint32_t>(capacity), std::memory_order_relaxed);
+        for (SharedTuningSegment::Slot& slot : seg->slots) slot.size.store(0, std::memory_order_relaxed);
+    } else {
+        seg->magic.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        new (seg) SharedTuningSegment();
+        seg->version = SEGMENT_VERSION;
+        seg->slot_capacity.store(static_cast<uint32_t>(capacity), std::memory_order_relaxed);
+    }
+    seg->magic.store(SEGMENT_MAGIC, std::memory_order_release);
+
+    segment_ = seg;
+    mapped_size_ = size;
+    name_ = name;
+    float32_ = float32;
+    return true;
+}
+
+void SharedTuningPublisher::close() {
+    if (segment_) munmap(segment_, mapped_size_);
+    segment_ = nullptr;
+    mapped_size_ = 0;
+}
+
+bool SharedTuningPublisher::unlink(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
+
+bool SharedTuningReader::open(const std::string& name) {
+    close();
+    if (!map(name)) return false;
+    buffer_.clear();
+    buffer_.reserve(slot_capacity_);
+    return true;
+}
+
+// Replaces the mapping only once the new one checks out; the last table
+// read stays in buffer_ either way
+bool SharedTuningReader::map(const std::string& name) {
+    // Readers never write the segment, so it may belong to another user
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(SharedTuningSegment)) {
+        ::close(fd);
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    auto* seg = static_cast<const SharedTuningSegment*>(mapSegment(fd, size, PROT_READ));
+    ::close(fd);
+    if (!seg) return false;
+    if (seg->magic.load(std::memory_order_acquire) != SEGMENT_MAGIC || seg->version != SEGMENT_VERSION) {
+        munmap(const_cast<SharedTuningSegment*>(seg), size);
+        return false;
+    }
+    size_t capacity = seg->slot_capacity.load(std::memory_order_acquire);
+    if (size < sizeof(SharedTuningSegment) + 2 * capacity) {
+        munmap(const_cast<SharedTuningSegment*>(seg), size);
+        return false;
+    }
+    if (segment_) munmap(const_cast<SharedTuningSegment*>(segment_), mapped_size_);
+    segment_ = seg;
+    mapped_size_ = size;
+    slot_capacity_ = capacity;
+    name_ = name;
+    scratch_.assign(slot_capacity_, 0);
+    return true;
+}
+
+void SharedTuningReader::close() {
+    if (segment_) munmap(const_cast<SharedTuningSegment*>(segment_), mapped_size_);
+    segment_ = nullptr;
+    mapped_size_ = 0;
+    slot_capacity_ = 0;
+    seq_ = 0;
+    view_ = SnapshotView();
+}
+
+#else
+
+bool SharedTuningPublisher::open(const std::string&, int, bool) { return false; }
+void SharedTuningPublisher::close() {}
+bool SharedTuningPublisher::unlink(const std::string&) { return false; }
+bool SharedTuningReader::open(const std::string&) { return false; }
+bool SharedTuningReader::map(const std::string&) { return false; }
+void SharedTuningReader::close() {}
+
+#endif
+
+bool SharedTuningPublisher::publish(const MOS& mos, const Scale& scale) {
+    if (!segment_) return false;
+    size_t size = snapshotSize(scale.getNodes().size(), float32_ ? SNAPSHOT_FLOAT32 : 0);
+    size_t capacity = segment_->slot_capacity.load(std::memory_order_relaxed);
+    if (size > capacity) return false;
+
+    uint32_t n = segment_->latest.load(std::memory_order_relaxed) + 1;
+    SharedTuningSegment::Slot& slot = segment_->slots[n & 1];
+    // Odd while writing whatever the lock was left at: a publisher that died
+    // mid-write leaves it odd, and counting on from there would invert it
+    uint32_t writing = slot.lock.load(std::memory_order_relaxed) | 1;
+    slot.lock.store(writing, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    writeSnapshot(mos, scale, n, float32_, segment_->payload(n & 1, capacity), capacity);
+    slot.size.store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    slot.lock.store(writing + 1, std::memory_order_release);
+    segment_->latest.store(n, std::memory_order_release);
+    return true;
+}
+
+uint32_t SharedTuningPublisher::sequence() const {
+    return segment_ ? segment_->latest.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedTuningReader::hasUpdate() const {
+    return segment_ && segment_->latest.load(std::memory_order_acquire) != seq_;
+}
+
+bool SharedTuningReader::read() {
+    if (!segment_) return false;
+    for (int attempt = 0; attempt < READ_ATTEMPTS; ++attempt) {
+        // A publisher that needed larger slots has moved them; this
+        // mapping no longer describes the segment. Until the new header is
+        // in, map() fails and the next read() tries again.
+        if (segment_->slot_capacity.load(std::memory_order_acquire) != slot_capacity_ && !map(name_)) {
+            return false;
+        }
+        uint32_t n = segment_->latest.load(std::memory_order_acquire);
+        if (n == 0 || n == seq_) return false;
+
+        const SharedTuningSegment::Slot& slot = segment_->slots[n & 1];
+        uint32_t lock = slot.lock.load(std::memory_order_acquire);
+        if (lock & 1) continue;
+        uint32_t size = slot.size.load(std::memory_order_relaxed);
+        if (size > slot_capacity_) continue;
+        std::memcpy(scratch_.data(), segment_->payload(n & 1, slot_capacity_), size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.lock.load(std::memory_order_relaxed) != lock
+            || segment_->slot_capacity.load(std::memory_order_relaxed) != slot_capacity_) {
+            continue;
+        }
+
+        SnapshotView view;
+        if (!view.parse(scratch_.data(), size)) continue;
+        view_ = view;
+        seq_ = view.header().seq;
+        // view_ points into the storage scratch_ hands over
+        buffer_.swap(scratch_);
+        scratch_.resize(slot_capacity_);
+        return true;
+    }
+    return false;
+}
+
+} // namespace scalatrix
@@ -0,0 +1,341 @@
+#include "scalatrix/snapshot.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace scalatrix {
+
+namespace {
+
+// Offsets of the header fields; see snapshot.hpp
+enum : size_t {
+    OFF_MAGIC = 0,
+    OFF_VERSION = 4,
+    OFF_FLAGS = 6,
+    OFF_HEADER_SIZE = 8,
+    OFF_SEQ = 12,
+    OFF_BASE_SEQ = 16,
+    OFF_NODE_COUNT = 20,
+    OFF_RECORD_COUNT = 24,
+    OFF_ROOT = 28,
+    OFF_A = 32,
+    OFF_B = 36,
+    OFF_MODE = 40,
+    OFF_REPETITIONS = 44,
+    OFF_DEPTH = 48,
+    OFF_RESERVED = 52,
+    OFF_BASE_FREQ = 56,
+    OFF_EQUAVE = 64,
+    OFF_GENERATOR = 72,
+};
+
+size_t pad8(size_t n) {
+    return (n + 7) & ~size_t(7);
+}
+
+void put16(uint8_t* p, uint16_t v) {
+    p[0] = uint8_t(v);
+    p[1] = uint8_t(v >> 8);
+}
+
+void put32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = uint8_t(v >> (8 * i));
+}
+
+void put64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = uint8_t(v >> (8 * i));
+}
+
+void putF32(uint8_t* p, float v) {
+    uint32_t bits;
+    std::memcpy(&bits, &v, 4);
+    put32(p, bits);
+}
+
+void putF64(uint8_t* p, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, 8);
+    put64(p, bits);
+}
+
+uint16_t get16(const uint8_t* p) {
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t get32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+uint64_t get64(const uint8_t* p) {
+    return uint64_t(get32(p)) | (uint64_t(get32(p + 4)) << 32);
+}
+
+float getF32(const uint8_t* p) {
+    uint32_t bits = get32(p);
+    float v;
+    std::memcpy(&v, &bits, 4);
+    return v;
+}
+
+double getF64(const uint8_t* p) {
+    uint64_t bits = get64(p);
+    double v;
+    std::memcpy(&v, &bits, 8);
+    return v;
+}
+
+// Payload array offsets, relative to the start of the snapshot
+struct Layout {
+    size_t index, natural_x, natural_y, tuning_x, tuning_y, pitch, end;
+
+    Layout(size_t header_size, size_t n, uint16_t flags) {
+        size_t ints = pad8(4 * n);
+        size_t reals = pad8((flags & SNAPSHOT_FLOAT32 ? 4 : 8) * n);
+        index = header_size;
+        natural_x = index + (flags & SNAPSHOT_DELTA ? ints : 0);
+        natural_y = natural_x + ints;
+        tuning_x = natural_y + ints;
+        tuning_y = tuning_x + reals;
+        pitch = tuning_y + reals;
+        end = pitch + reals;
+    }
+};
+
+// A node as written: reals rounded to float when float32
+struct Record {
+    Vector2i natural;
+    double tuning_x, tuning_y, pitch;
+
+    Record(const Node& node, bool float32)
+        : natural(node.natural_coord), tuning_x(node.tuning_coord.x),
+          tuning_y(node.tuning_coord.y), pitch(node.pitch) {
+        if (float32) {
+            tuning_x = static_cast<float>(tuning_x);
+            tuning_y = static_cast<float>(tuning_y);
+            pitch = static_cast<float>(pitch);
+        }
+    }
+
+    bool operator==(const Record& o) const {
+        return natural == o.natural && tuning_x == o.tuning_x && tuning_y == o.tuning_y && pitch == o.pitch;
+    }
+};
+
+void writeHeader(uint8_t* out, const MOS& mos, const Scale& scale, uint16_t flags,
+                 uint32_t seq, uint32_t base_seq, size_t n_records) {
+    put32(out + OFF_MAGIC, SNAPSHOT_MAGIC);
+    put16(out + OFF_VERSION, SNAPSHOT_VERSION);
+    put16(out + OFF_FLAGS, flags);
+    put32(out + OFF_HEADER_SIZE, static_cast<uint32_t>(SNAPSHOT_HEADER_SIZE));
+    put32(out + OFF_SEQ, seq);
+    put32(out + OFF_BASE_SEQ, base_seq);
+    put32(out + OFF_NODE_COUNT, static_cast<uint32_t>(scale.getNodes().size()));
+    put32(out + OFF_RECORD_COUNT, static_cast<uint32_t>(n_records));
+    put32(out + OFF_ROOT, static_cast<uint32_t>(scale.getRootIdx()));
+    put32(out + OFF_A, static_cast<uint32_t>(mos.a));
+    put32(out + OFF_B, static_cast<uint32_t>(mos.b));
+    put32(out + OFF_MODE, static_cast<uint32_t>(mos.mode));
+    put32(out + OFF_REPETITIONS, static_cast<uint32_t>(mos.repetitions));
+    put32(out + OFF_DEPTH, static_cast<uint32_t>(mos.depth));
+    put32(out + OFF_RESERVED, 0);
+    putF64(out + OFF_BASE_FREQ, scale.getBaseFreq());
+    putF64(out + OFF_EQUAVE, mos.equave);
+    putF64(out + OFF_GENERATOR, mos.generator);
+}
+
+void writeRecord(uint8_t* out, const Layout& layout, size_t slot, const Record& r, bool float32) {
+    put32(out + layout.natural_x + 4 * slot, static_cast<uint32_t>(r.natural.x));
+    put32(out + layout.natural_y + 4 * slot, static_cast<uint32_t>(r.natural.y));
+    if (float32) {
+        putF32(out + layout.tuning_x + 4 * slot, static_cast<float>(r.tuning_x));
+        putF32(out + layout.tuning_y + 4 * slot, static_cast<float>(r.tuning_y));
+        putF32(out + layout.pitch + 4 * slot, static_cast<float>(r.pitch));
+    } else {
+        putF64(out + layout.tuning_x + 8 * slot, r.tuning_x);
+        putF64(out + layout.tuning_y + 8 * slot, r.tuning_y);
+        putF64(out + layout.pitch + 8 * slot, r.pitch);
+    }
+}
+
+// Zeroes the padding after each array, so equal snapshots are equal bytes
+void clearPadding(uint8_t* out, const Layout& layout, size_t n, bool float32, bool delta) {
+    size_t ints = 4 * n, reals = (float32 ? 4 : 8) * n;
+    if (delta) std::memset(out + layout.index + ints, 0, layout.natural_x - layout.index - ints);
+    std::memset(out + layout.natural_x + ints, 0, layout.natural_y - layout.natural_x - ints);
+    std::memset(out + layout.natural_y + ints, 0, layout.tuning_x - layout.natural_y - ints);
+    std::memset(out + layout.tuning_x + reals, 0, layout.tuning_y - layout.tuning_x - reals);
+    std::memset(out + layout.tuning_y + reals, 0, layout.pitch - layout.tuning_y - reals);
+    std::memset(out + layout.pitch + reals, 0, layout.end - layout.pitch - reals);
+}
+
+} // namespace
+
+size_t snapshotSize(size_t n_records, uint16_t flags) {
+    return Layout(SNAPSHOT_HEADER_SIZE, n_records, flags).end;
+}
+
+size_t writeSnapshot(const MOS& mos, const Scale& scale, uint32_t seq, bool float32,
+                     uint8_t* out, size_t capacity) {
+    const NodeVector& nodes = scale.getNodes();
+    uint16_t flags = float32 ? SNAPSHOT_FLOAT32 : 0;
+    Layout layout(SNAPSHOT_HEADER_SIZE, nodes.size(), flags);
+    if (!out || capacity < layout.end) return 0;
+
+    writeHeader(out, mos, scale, flags, seq, 0, nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        writeRecord(out, layout, i, Record(nodes[i], float32), float32);
+    }
+    clearPadding(out, layout, nodes.size(), float32, false);
+    return layout.end;
+}
+
+size_t writeSnapshotDelta(const MOS& mos, const Scale& scale, const Scale& previous,
+                          uint32_t seq, uint32_t base_seq, bool float32,
+                          uint8_t* out, size_t capacity) {
+    const NodeVector& nodes = scale.getNodes();
+    const NodeVector& prev = previous.getNodes();
+    if (nodes.size() != prev.size() || scale.getRootIdx() != previous.getRootIdx()
+        || scale.getBaseFreq() != previous.getBaseFreq()) {
+        return writeSnapshot(mos, scale, seq, float32, out, capacity);
+    }
+    size_t n_changed = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        n_changed += !(Record(nodes[i], float32) == Record(prev[i], float32));
+    }
+    uint16_t flags = (float32 ? SNAPSHOT_FLOAT32 : 0) | SNAPSHOT_DELTA;
+    Layout layout(SNAPSHOT_HEADER_SIZE, n_changed, flags);
+    if (layout.end >= snapshotSize(nodes.size(), float32 ? SNAPSHOT_FLOAT32 : 0)) {
+        return writeSnapshot(mos, scale, seq, float32, out, capacity);
+    }
+    if (!out || capacity < layout.end) return 0;
+
+    writeHeader(out, mos, scale, flags, seq, base_seq, n_changed);
+    size_t slot = 0;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Record r(nodes[i], float32);
+        if (r == Record(prev[i], float32)) continue;
+        put32(out + layout.index + 4 * slot, static_cast<uint32_t>(i));
+        writeRecord(out, layout, slot, r, float32);
+        ++slot;
+    }
+    clearPadding(out, layout, n_changed, float32, true);
+    return layout.end;
+}
+
+bool SnapshotView::parse(const uint8_t* data, size_t size) {
+    *this = SnapshotView();
+    if (!data || size < SNAPSHOT_HEADER_SIZE) return false;
+    if (get32(data + OFF_MAGIC) != SNAPSHOT_MAGIC) return false;
+    SnapshotHeader h;
+    h.version = get16(data + OFF_VERSION);
+    if (h.version != SNAPSHOT_VERSION) return false;
+    size_t header_size = get32(data + OFF_HEADER_SIZE);
+    if (header_size < SNAPSHOT_HEADER_SIZE || header_size > size) return false;
+
+    h.flags = get16(data + OFF_FLAGS);
+    h.seq = get32(data + OFF_SEQ);
+    h.base_seq = get32(data + OFF_BASE_SEQ);
+    h.node_count = get32(data + OFF_NODE_COUNT);
+    h.record_count = get32(data + OFF_RECORD_COUNT);
+    h.root = static_cast<int32_t>(get32(data + OFF_ROOT));
+    h.a = static_cast<int32_t>(get32(data + OFF_A));
+    h.b = static_cast<int32_t>(get32(data + OFF_B));
+    h.mode = static_cast<int32_t>(get32(data + OFF_MODE));
+    h.repetitions = static_cast<int32_t>(get32(data + OFF_REPETITIONS));
+    h.depth = static_cast<int32_t>(get32(data + OFF_DEPTH));
+    h.base_freq = getF64(data + OFF_BASE_FREQ);
+    h.equave = getF64(data + OFF_EQUAVE);
+    h.generator = getF64(data + OFF_GENERATOR);
+
+    // mos() hands these to the MOS constructor, which asserts on them
+    if (h.a <= 0 || h.b <= 0 || h.a > INT32_MAX - h.b) return false;
+    if (h.mode < 0 || h.mode >= h.a + h.b) return false;
+    if (h.repetitions != std::gcd(h.a, h.b)) return false;
+    if (!(h.generator >= 0.0 && h.generator <= 1.0)) return false;
+    if (!(h.equave > 0.0) || !std::isfinite(h.equave)) return false;
+
+    // applyTo() resets a scale to this root
+    if (h.root < 0 || static_cast<uint32_t>(h.root) >= h.node_count) return false;
+
+    bool delta = h.flags & SNAPSHOT_DELTA;
+    if (h.record_count > h.node_count || (!delta && h.record_count != h.node_count)) return false;
+    // Checked before Layout so the offsets cannot overflow
+    if (h.record_count > (size - header_size) / 4) return false;
+    Layout layout(header_size, h.record_count, h.flags);
+    if (layout.end > size) return false;
+    if (delta) {
+        for (uint32_t i = 0; i < h.record_count; ++i) {
+            if (get32(data + layout.index + 4 * i) >= h.node_count) return false;
+        }
+    }
+
+    data_ = data;
+    size_ = layout.end;
+    header_ = h;
+    index_off_ = layout.index;
+    natural_x_off_ = layout.natural_x;
+    natural_y_off_ = layout.natural_y;
+    tuning_x_off_ = layout.tuning_x;
+    tuning_y_off_ = layout.tuning_y;
+    pitch_off_ = layout.pitch;
+    return true;
+}
+
+int SnapshotView::index(int i) const {
+    assert(i >= 0 && i < size());
+    return isDelta() ? static_cast<int>(get32(data_ + index_off_ + 4 * i)) : i;
+}
+
+Vector2i SnapshotView::naturalCoord(int i) const {
+    assert(i >= 0 && i < size());
+    return Vector2i(static_cast<int32_t>(get32(data_ + natural_x_off_ + 4 * i)),
+                    static_cast<int32_t>(get32(data_ + natural_y_off_ + 4 * i)));
+}
+
+double SnapshotView::real(size_t offset, int i) const {
+    return isFloat32() ? getF32(data_ + offset + 4 * i) : getF64(data_ + offset + 8 * i);
+}
+
+Vector2d SnapshotView::tuningCoord(int i) const {
+    assert(i >= 0 && i < size());
+    return Vector2d(real(tuning_x_off_, i), real(tuning_y_off_, i));
+}
+
+double SnapshotView::pitch(int i) const {
+    assert(i >= 0 && i < size());
+    return real(pitch_off_, i);
+}
+
+bool SnapshotView::applyTo(Scale& scale) const {
+    if (!valid()) return false;
+    if (isDelta()) {
+        if (scale.getNodes().size() != header_.node_count || scale.getRootIdx() != header_.root
+            || scale.getBaseFreq() != header_.base_freq) {
+            return false;
+        }
+    } else {
+        scale.reset(header_.base_freq, static_cast<int>(header_.node_count), header_.root);
+    }
+    NodeVector& nodes = scale.getNodes();
+    for (int i = 0; i < size(); ++i) {
+        Node& node = nodes[index(i)];
+        node.natural_coord = naturalCoord(i);
+        node.tuning_coord = tuningCoord(i);
+        node.pitch = pitch(i);
+        node.isTempered = false;
+        node.temperedPitch.label.clear();
+        node.temperedPitch.log2fr = 0.0;
+        node.closestPitch.label.clear();
+        node.closestPitch.log2fr = 0.0;
+    }
+    return true;
+}
+
+MOS SnapshotView::mos() const {
+    assert(valid());
+    return MOS(header_.a, header_.b, header_.mode, header_.equave, header_.generator);
+}
+
+} // namespace scalatrix
@@ -0,0 +1,181 @@
+#include "scalatrix/temperament_search.hpp"
+#include "scalatrix/tempering.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace scalatrix {
+
+TemperamentEvaluator::TemperamentEvaluator(const MOS& mos, const PitchSetIndex& index,
+                                           const std::vector<double>& weights)
+    : a_(mos.a), b_(mos.b), mode_(mos.mode), repetitions_(mos.repetitions),
+      index_(&index), weights_(weights) {
+    const int a0 = mos.a0, b0 = mos.b0;
+    const Vector2i g = mos.v_gen;
+    // Both step vectors keep a positive size between these two generators
+    double g1 = static_cast<double>(g.y) / b0;
+    double g2 = static_cast<double>(g.x) / a0;
+    g_min_ = std::min(g1, g2);
+    g_max_ = std::max(g1, g2);
+
+    // (a0,b0) and v_gen form a unimodular basis, so k and w are integers
+    const int det = a0 * g.y - g.x * b0;
+    const auto& nodes = mos.base_scale.getNodes();
+    k_.reserve(nodes.size());
+    w_.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        Vector2i v = node.natural_coord;
+        k_.push_back(static_cast<double>((v.x * g.y - g.x * v.y) / det));
+        w_.push_back(static_cast<double>((a0 * v.y - b0 * v.x) / det));
+    }
+}
+
+void TemperamentEvaluator::pitches(double g, double e, double* out) const {
+    const double period = e / repetitions_;
+    const size_t n = k_.size();
+    for (size_t j = 0; j < n; ++j) {
+        out[j] = period * (k_[j] + w_[j] * g);
+    }
+}
+
+double TemperamentEvaluator::error(double g, double e, double* max_cents) const {
+    const PitchSet& target = index_->pitchSet();
+    const double period = e / repetitions_;
+    double sum = 0.0, sum_weights = 0.0, max_dev = 0.0;
+    for (size_t j = 0; j < k_.size(); ++j) {
+        double x = period * (k_[j] + w_[j] * g);
+        int closest = index_->closest(x);
+        if (closest < 0) continue;
+        double cents = 1200.0 * (x - target[closest].log2fr);
+        double weight = static_cast<size_t>(closest) < weights_.size() ? weights_[closest] : 1.0;
+        sum += weight * cents * cents;
+        sum_weights += weight;
+        max_dev = std::max(max_dev, std::abs(cents));
+    }
+    if (max_cents) *max_cents = max_dev;
+    return sum_weights > 0.0 ? std::sqrt(sum / sum_weights) : 0.0;
+}
+
+// Golden-section minimum of f on [lo, hi]
+template <typename F>
+static double goldenSection(F f, double lo, double hi, int iterations) {
+    const double inv_phi = 0.5 * (std::sqrt(5.0) - 1.0);
+    double x1 = hi - inv_phi * (hi - lo);
+    double x2 = lo + inv_phi * (hi - lo);
+    double f1 = f(x1), f2 = f(x2);
+    for (int i = 0; i < iterations; ++i) {
+        if (f1 < f2) {
+            hi = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = hi - inv_phi * (hi - lo);
+            f1 = f(x1);
+        } else {
+            lo = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = lo + inv_phi * (hi - lo);
+            f2 = f(x2);
+        }
+    }
+    return f1 < f2 ? x1 : x2;
+}
+
+static TemperamentCandidate searchPattern(const TemperamentEvaluator& eval, const TemperamentSearchOptions& options) {
+    const bool stretch = options.max_equave > options.min_equave;
+    const int g_steps = std::max(options.g_steps, 2);
+    const int e_steps = stretch ? std::max(options.e_steps, 2) : 1;
+    const double g_span = eval.gMax() - eval.gMin();
+    const double e_span = options.max_equave - options.min_equave;
+    const double dg = g_span / g_steps;
+    const double de = stretch ? e_span / (e_steps - 1) : 0.0;
+
+    // Coarse grid over the open generator range and the closed equave range
+    double best_g = eval.gMin() + 0.5 * dg, best_e = options.min_equave;
+    double best = eval.error(best_g, best_e);
+    for (int ie = 0; ie < e_steps; ++ie) {
+        double e = options.min_equave + ie * de;
+        for (int ig = 0; ig < g_steps; ++ig) {
+            double g = eval.gMin() + (ig + 0.5) * dg;
+            double err = eval.error(g, e);
+            if (err < best) {
+                best = err;
+                best_g = g;
+                best_e = e;
+            }
+        }
+    }
+
+    // Refine around the best grid point, one coordinate at a time
+    for (int pass = 0; pass < (stretch ? 3 : 1); ++pass) {
+        double g_lo = std::max(best_g - dg, eval.gMin() + 1e-9 * g_span);
+        double g_hi = std::min(best_g + dg, eval.gMax() - 1e-9 * g_span);
+        double e = best_e;
+        double g = goldenSection([&](double x) { return eval.error(x, e); }, g_lo, g_hi, options.refine_iterations);
+        double err = eval.error(g, e);
+        if (err < best) {
+            best = err;
+            best_g = g;
+        }
+        if (!stretch) break;
+        double e_lo = std::max(best_e - de, options.min_equave);
+        double e_hi = std::min(best_e + de, options.max_equave);
+        double gg = best_g;
+        e = goldenSection([&](double x) { return eval.error(gg, x); }, e_lo, e_hi, options.refine_iterations);
+        err = eval.error(best_g, e);
+        if (err < best) {
+            best = err;
+            best_e = e;
+        }
+    }
+
+    TemperamentCandidate result;
+    result.a = eval.a();
+    result.b = eval.b();
+    result.mode = eval.mode();
+    result.generator = best_g;
+    result.equave = best_e;
+    result.rms_cents = eval.error(best_g, best_e, &result.max_cents);
+    return result;
+}
+
+std::vector<TemperamentCandidate> searchTemperaments(const PitchSet& target, const TemperamentSearchOptions& options) {
+    std::vector<TemperamentCandidate> results;
+    if (target.empty()) return results;
+    PitchSetIndex index(target);
+
+    // Enumerate the patterns first; building each MOS and evaluating it both
+    // run in parallel
+    struct Pattern {
+        int a, b, mode;
+        double g_mid;
+    };
+    std::vector<Pattern> patterns;
+    for (int n = std::max(options.min_size, 2); n <= options.max_size; ++n) {
+        for (int a = 1; a < n; ++a) {
+            int b = n - a;
+            int r = std::gcd(a, b);
+            int a0 = a / r, b0 = b / r;
+            Vector2i v_gen = applyPath(calcPath(a0, b0), {1, 0});
+            double g_mid = 0.5 * (static_cast<double>(v_gen.y) / b0 + static_cast<double>(v_gen.x) / a0);
+            for (int mode = 0; mode < a0 + b0; ++mode) {
+                patterns.push_back({a, b, mode, g_mid});
+            }
+        }
+    }
+
+    results.resize(patterns.size());
+    parallelFor(patterns.size(), 1, options.n_threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const Pattern& p = patterns[i];
+            MOS mos = MOS::fromParams(p.a, p.b, p.mode, 1.0, p.g_mid);
+            results[i] = searchPattern(TemperamentEvaluator(mos, index, options.weights), options);
+        }
+    });
+    std::stable_sort(results.begin(), results.end(), [](const TemperamentCandidate& x, const TemperamentCandidate& y) {
+        return x.rms_cents < y.rms_cents;
+    });
+    return results;
+}
+
+} // namespace scalatrix
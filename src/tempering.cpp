@@ -0,0 +1,238 @@
+#include "scalatrix/tempering.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#ifndef SCALATRIX_NO_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#endif
+
+namespace scalatrix {
+
+int parallelWorkerCount(size_t n_chunks, int n_threads) {
+#ifdef SCALATRIX_NO_THREADS
+    (void)n_chunks;
+    (void)n_threads;
+    return 1;
+#else
+    if (n_threads <= 0) {
+        n_threads = static_cast<int>(std::thread::hardware_concurrency());
+    }
+    size_t workers = std::min(static_cast<size_t>(std::max(n_threads, 1)), n_chunks);
+    return static_cast<int>(std::max<size_t>(workers, 1));
+#endif
+}
+
+#ifndef SCALATRIX_NO_THREADS
+
+// A worker's share of chunk indices [begin, end), packed into one word so the
+// owner (taking from the front) and thieves (splitting off the back) agree
+// through a single compare-exchange.
+struct alignas(64) ChunkRange {
+    std::atomic<uint64_t> packed{0};
+};
+
+static uint64_t packRange(uint32_t begin, uint32_t end) {
+    return (static_cast<uint64_t>(begin) << 32) | end;
+}
+static uint32_t rangeBegin(uint64_t r) { return static_cast<uint32_t>(r >> 32); }
+static uint32_t rangeEnd(uint64_t r) { return static_cast<uint32_t>(r); }
+
+static bool takeFront(ChunkRange& range, uint32_t& chunk) {
+    uint64_t r = range.packed.load(std::memory_order_acquire);
+    while (rangeBegin(r) < rangeEnd(r)) {
+        if (range.packed.compare_exchange_weak(r, packRange(rangeBegin(r) + 1, rangeEnd(r)),
+                                               std::memory_order_acq_rel)) {
+            chunk = rangeBegin(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Moves the back half of the fullest other range into ranges[self].
+// Chunk indices are handed out exactly once, so a stale range can never
+// reappear and the compare-exchange is ABA-safe.
+static bool steal(std::vector<ChunkRange>& ranges, int self) {
+    for (;;) {
+        int victim = -1;
+        uint64_t victim_range = 0;
+        uint32_t most = 0;
+        for (int i = 0; i < static_cast<int>(ranges.size()); ++i) {
+            if (i == self) continue;
+            uint64_t r = ranges[i].packed.load(std::memory_order_acquire);
+            uint32_t left = rangeBegin(r) < rangeEnd(r) ? rangeEnd(r) - rangeBegin(r) : 0;
+            if (left > most) {
+                most = left;
+                victim = i;
+                victim_range = r;
+            }
+        }
+        if (victim < 0) return false;
+        uint32_t begin = rangeBegin(victim_range), end = rangeEnd(victim_range);
+        uint32_t mid = begin + (end - begin) / 2;
+        if (ranges[victim].packed.compare_exchange_strong(victim_range, packRange(begin, mid),
+                                                          std::memory_order_acq_rel)) {
+            ranges[self].packed.store(packRange(mid, end), std::memory_order_release);
+            return true;
+        }
+    }
+}
+
+// Threads kept between parallelFor calls, so a call wakes parked workers
+// instead of starting new ones. The pool grows to the most workers any call
+// asked for and runs one call at a time.
+class WorkerPool {
+public:
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& t : threads_) {
+            t.join();
+        }
+    }
+
+    // Runs work(1) .. work(n_workers - 1) on pool threads and work(0) on the
+    // calling thread; work must not throw. Returns false, running nothing, if
+    // the pool is already running a call (from another thread, or from inside
+    // a body). If the pool cannot grow to n_workers, fewer workers run, so
+    // work has to cope with missing ones.
+    bool run(int n_workers, const std::function<void(int)>& work) {
+        if (busy_.exchange(true, std::memory_order_acquire)) return false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            try {
+                while (static_cast<int>(threads_.size()) < n_workers - 1) {
+                    int worker = static_cast<int>(threads_.size()) + 1;
+                    threads_.emplace_back(&WorkerPool::loop, this, worker, generation_);
+                }
+            } catch (const std::system_error&) {
+                n_workers = static_cast<int>(threads_.size()) + 1;
+            }
+            work_ = &work;
+            n_workers_ = n_workers;
+            pending_ = n_workers - 1;
+            ++generation_;
+        }
+        wake_.notify_all();
+        work(0);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [&] { return pending_ == 0; });
+            work_ = nullptr;
+        }
+        busy_.store(false, std::memory_order_release);
+        return true;
+    }
+
+private:
+    void loop(int worker, uint64_t seen) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            if (worker >= n_workers_) continue;
+            const std::function<void(int)>& work = *work_;
+            lock.unlock();
+            work(worker);
+            lock.lock();
+            if (--pending_ == 0) done_.notify_one();
+        }
+    }
+
+    std::atomic<bool> busy_{false};
+    std::mutex mutex_;
+    std::condition_variable wake_, done_;
+    std::vector<std::thread> threads_;
+    const std::function<void(int)>* work_ = nullptr;
+    int n_workers_ = 0;
+    int pending_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+};
+
+static WorkerPool& workerPool() {
+    static WorkerPool pool;
+    return pool;
+}
+
+#endif // SCALATRIX_NO_THREADS
+
+void parallelFor(size_t n, size_t grain, int n_threads,
+                 const std::function<void(size_t begin, size_t end, int worker)>& body) {
+    if (n == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    const size_t n_chunks = (n + grain - 1) / grain;
+    const int n_workers = parallelWorkerCount(n_chunks, n_threads);
+#ifndef SCALATRIX_NO_THREADS
+    if (n_workers > 1 && n_chunks <= UINT32_MAX) {
+        std::vector<ChunkRange> ranges(n_workers);
+        for (int w = 0; w < n_workers; ++w) {
+            uint32_t begin = static_cast<uint32_t>(n_chunks * w / n_workers);
+            uint32_t end = static_cast<uint32_t>(n_chunks * (w + 1) / n_workers);
+            ranges[w].packed.store(packRange(begin, end), std::memory_order_relaxed);
+        }
+        // A throwing body stops every worker at its next chunk. The first
+        // exception is kept and rethrown here once all workers are done, so
+        // none of them outlives ranges or work.
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        const std::function<void(int)> work = [&](int worker) {
+            try {
+                uint32_t chunk;
+                do {
+                    while (!failed.load(std::memory_order_relaxed) && takeFront(ranges[worker], chunk)) {
+                        size_t begin = chunk * grain;
+                        body(begin, std::min(begin + grain, n), worker);
+                    }
+                } while (!failed.load(std::memory_order_relaxed) && steal(ranges, worker));
+            } catch (...) {
+                if (!failed.exchange(true)) error = std::current_exception();
+            }
+        };
+        if (!workerPool().run(n_workers, work)) {
+            // The pool is taken, so this call brings its own threads. Any
+            // share left by a thread that could not start is stolen by the
+            // others.
+            std::vector<std::thread> threads;
+            threads.reserve(n_workers - 1);
+            try {
+                for (int w = 1; w < n_workers; ++w) {
+                    threads.emplace_back(work, w);
+                }
+            } catch (const std::system_error&) {
+            }
+            work(0);
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+#endif
+    body(0, n, 0);
+}
+
+std::vector<TemperingStats> temperScales(std::vector<Scale>& scales, const PitchSetIndex& index, int n_threads) {
+    std::vector<TemperingStats> stats(scales.size());
+    parallelFor(scales.size(), 1, n_threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            scales[i].temperToPitchSet(index, &stats[i]);
+        }
+    });
+    return stats;
+}
+
+std::vector<TemperingStats> temperScales(std::vector<Scale>& scales, const PitchSet& pitchset, int n_threads) {
+    return temperScales(scales, PitchSetIndex(pitchset), n_threads);
+}
+
+} // namespace scalatrix
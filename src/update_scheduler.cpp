@@ -0,0 +1,217 @@
+#include "scalatrix/update_scheduler.hpp"
+
+namespace scalatrix {
+
+// Scheduler whose on_update is running on this thread, if any
+static thread_local const TuningUpdateScheduler* t_in_callback = nullptr;
+
+struct TuningUpdateScheduler::Target {
+    int index;
+    MOS mos;
+    ScaleMapping mapping;
+    Scale scale;
+    TuningUpdate tuning; // last applied
+
+    // Pending, guarded by the scheduler's mutex_
+    bool has_tuning = false, has_mapping = false;
+    TuningUpdate pending_tuning;
+    ScaleMapping pending_mapping;
+
+    Target(int i, const MOS& m, const ScaleMapping& map)
+        : index(i), mos(m), mapping(map),
+          scale(map.base_freq, map.n_nodes, map.root),
+          tuning{m.depth, m.mode, m.generator, m.equave, m.repetitions} {}
+
+    void regenerate() {
+        mos.generateMappedScaleInto(scale, mapping.steps, mapping.offset, mapping.base_freq,
+                                    mapping.n_nodes, mapping.root);
+    }
+};
+
+TuningUpdateScheduler::TuningUpdateScheduler(std::chrono::microseconds frame, Callback on_update)
+    : frame_(frame), on_update_(std::move(on_update)) {}
+
+TuningUpdateScheduler::~TuningUpdateScheduler() {
+    stop();
+}
+
+int TuningUpdateScheduler::addTarget(const MOS& mos, const ScaleMapping& mapping) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int index = static_cast<int>(targets_.size());
+    targets_.push_back(std::make_unique<Target>(index, mos, mapping));
+    targets_.back()->regenerate();
+    return index;
+}
+
+int TuningUpdateScheduler::targetCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<int>(targets_.size());
+}
+
+bool TuningUpdateScheduler::post(int target, const TuningUpdate& update) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (target < 0 || target >= static_cast<int>(targets_.size())) {
+        ++stats_.dropped;
+        return false;
+    }
+    Target& t = *targets_[target];
+    ++stats_.posted;
+    if (t.has_tuning) {
+        ++stats_.merged;
+    } else if (!t.has_mapping) {
+        ++n_pending_;
+    }
+    t.has_tuning = true;
+    t.pending_tuning = update;
+    wake_.notify_one();
+    return true;
+}
+
+bool TuningUpdateScheduler::postMapping(int target, const ScaleMapping& mapping) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (target < 0 || target >= static_cast<int>(targets_.size())) {
+        ++stats_.dropped;
+        return false;
+    }
+    Target& t = *targets_[target];
+    ++stats_.posted;
+    if (t.has_mapping) {
+        ++stats_.merged;
+    } else if (!t.has_tuning) {
+        ++n_pending_;
+    }
+    t.has_mapping = true;
+    t.pending_mapping = mapping;
+    wake_.notify_one();
+    return true;
+}
+
+void TuningUpdateScheduler::takePending() {
+    batch_.clear();
+    if (n_pending_ == 0) return;
+    for (auto& target : targets_) {
+        Target& t = *target;
+        if (!t.has_tuning && !t.has_mapping) continue;
+        batch_.push_back({&t, t.has_tuning, t.has_mapping, t.pending_tuning, t.pending_mapping});
+        t.has_tuning = t.has_mapping = false;
+    }
+    n_pending_ = 0;
+}
+
+int TuningUpdateScheduler::applyBatch() {
+    int applied = 0, dropped = 0;
+    for (const Batch& b : batch_) {
+        Target& t = *b.target;
+        bool retune = b.has_tuning && b.tuning != t.tuning;
+        bool remap = b.has_mapping && b.mapping != t.mapping;
+        if (!retune && !remap) {
+            dropped += b.has_tuning + b.has_mapping;
+            continue;
+        }
+        if (retune) {
+            t.mos.adjustTuningG(b.tuning.depth, b.tuning.mode, b.tuning.generator,
+                                b.tuning.equave, b.tuning.repetitions);
+            t.tuning = b.tuning;
+        }
+        if (remap) {
+            t.mapping = b.mapping;
+        }
+        t.regenerate();
+        ++applied;
+        if (on_update_) {
+            const TuningUpdateScheduler* outer = t_in_callback;
+            t_in_callback = this;
+            on_update_(t.index, t.mos, t.scale);
+            t_in_callback = outer;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.applied += applied;
+    stats_.dropped += dropped;
+    if (applied > 0) {
+        ++stats_.frames;
+    }
+    return applied;
+}
+
+int TuningUpdateScheduler::flush() {
+    // apply_mutex_ is held around on_update, so applying from inside it
+    // would deadlock; what is pending waits for the next pass instead
+    if (t_in_callback == this) return 0;
+    std::lock_guard<std::mutex> apply(apply_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        takePending();
+        if (!batch_.empty()) {
+            has_applied_ = true;
+            last_applied_ = std::chrono::steady_clock::now();
+        }
+    }
+    return applyBatch();
+}
+
+int TuningUpdateScheduler::poll() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (n_pending_ == 0) return 0;
+        if (has_applied_ && std::chrono::steady_clock::now() < last_applied_ + frame_) return 0;
+    }
+    return flush();
+}
+
+bool TuningUpdateScheduler::start() {
+#ifdef SCALATRIX_NO_THREADS
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (thread_.joinable()) return false;
+    stopping_ = false;
+    thread_ = std::thread(&TuningUpdateScheduler::run, this);
+    return true;
+#endif
+}
+
+void TuningUpdateScheduler::stop() {
+#ifndef SCALATRIX_NO_THREADS
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!thread_.joinable()) return;
+        stopping_ = true;
+        wake_.notify_all();
+    }
+    thread_.join();
+#endif
+}
+
+bool TuningUpdateScheduler::running() const {
+#ifdef SCALATRIX_NO_THREADS
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thread_.joinable() && !stopping_;
+#endif
+}
+
+UpdateSchedulerStats TuningUpdateScheduler::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void TuningUpdateScheduler::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [&] { return stopping_ || n_pending_ > 0; });
+        if (stopping_) return;
+        // Wait out the rest of the frame; updates posted meanwhile merge
+        // into the pending ones
+        if (has_applied_) {
+            auto next = last_applied_ + frame_;
+            if (wake_.wait_until(lock, next, [&] { return stopping_; })) return;
+        }
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+} // namespace scalatrix
@@ -0,0 +1,76 @@
+#include "allocation_counter.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+void* allocate(size_t size) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* allocate(size_t size, std::align_val_t al) noexcept {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = static_cast<size_t>(al);
+    if (align < sizeof(void*))
+        align = sizeof(void*);
+    // aligned_alloc wants a whole number of alignments
+    size_t rounded = ((size ? size : 1) + align - 1) / align * align;
+    return std::aligned_alloc(align, rounded);
+}
+
+} // namespace
+
+size_t scalatrix::allocationCount() {
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+// Every replaceable form, so no allocation or release in the binary mixes
+// these with the library's own
+
+void* operator new(size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if (void* p = allocate(size)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return allocate(size); }
+
+void* operator new(size_t size, std::align_val_t al) {
+    if (void* p = allocate(size, al)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t al) {
+    if (void* p = allocate(size, al)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocate(size, al);
+}
+
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return allocate(size, al);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// Linking allocation_counter.cpp into a binary replaces every global
+// operator new and delete with malloc/free wrappers that count allocations
+
+namespace scalatrix {
+
+// Global operator new calls so far, of any form
+size_t allocationCount();
+
+} // namespace scalatrix
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/scale.hpp"
+
+namespace scalatrix {
+
+// Same node count, root, base frequency and, exactly, the same nodes
+inline void requireSameNodes(const Scale& a, const Scale& b) {
+    const auto& na = a.getNodes();
+    const auto& nb = b.getNodes();
+    REQUIRE(na.size() == nb.size());
+    REQUIRE(a.getRootIdx() == b.getRootIdx());
+    REQUIRE(a.getBaseFreq() == b.getBaseFreq());
+    for (size_t i = 0; i < na.size(); ++i) {
+        REQUIRE(na[i].natural_coord == nb[i].natural_coord);
+        REQUIRE(na[i].tuning_coord.x == nb[i].tuning_coord.x);
+        REQUIRE(na[i].tuning_coord.y == nb[i].tuning_coord.y);
+        REQUIRE(na[i].pitch == nb[i].pitch);
+    }
+}
+
+} // namespace scalatrix
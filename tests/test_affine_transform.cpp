@@ -1,6 +1,7 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/mos_pattern.hpp"
 #include "scalatrix/params.hpp"
 #include <cmath>
 
@@ -105,4 +106,93 @@ TEST_CASE("affineFromThreeDots shear transformation", "[affine]") {
     REQUIRE_THAT(result.d, WithinAbs(1.0, 1e-10));
     REQUIRE_THAT(result.tx, WithinAbs(0.0, 1e-10));
     REQUIRE_THAT(result.ty, WithinAbs(0.0, 1e-10));
-}
\ No newline at end of file
+}
+
+// MOS structures from the library's constexpr path and transform
+constexpr Vector2i mosGenerator(int a, int b) {
+    return applyMOSPath(mosPath(a, b), Vector2i(1, 0));
+}
+
+constexpr bool isMOSStructure(int a, int b) {
+    IntegerAffineTransform T = mosTransformOf(a, b);
+    IntegerAffineTransform T_inv = T.inverse();
+    return T * Vector2i(1, 0) == mosGenerator(a, b)
+        && T * Vector2i(1, 1) == Vector2i(a, b)
+        && T.det() == 1
+        && T_inv.applyAffine(T) == IntegerAffineTransform()
+        && T_inv * Vector2i(a, b) == Vector2i(1, 1);
+}
+
+constexpr int gcd(int a, int b) { return b == 0 ? a : gcd(b, a % b); }
+
+constexpr bool allMOSStructures(int max_size) {
+    for (int a = 1; a < max_size; ++a) {
+        for (int b = 1; a + b <= max_size; ++b) {
+            if (gcd(a, b) == 1 && !isMOSStructure(a, b)) return false;
+        }
+    }
+    return true;
+}
+
+static_assert(mosPath(1, 1).depth == 0, "root pattern");
+static_assert(mosPath(5, 2).depth == 3 && mosPath(5, 2).bits == 0b001, "diatonic path grows b, then a twice");
+static_assert(mosPath(4, 2).depth == -1 && mosPath(0, 1).depth == -1 && mosPath(33, 33).depth == -1,
+              "no path without coprime step counts that fit");
+static_assert(mosGenerator(1, 1) == Vector2i(1, 0), "root pattern generator");
+static_assert(mosGenerator(5, 2) == Vector2i(3, 1), "diatonic fifth is 3L + 1s");
+static_assert(mosGenerator(2, 5) == Vector2i(1, 2), "antidiatonic generator");
+static_assert(mosGenerator(7, 5) == Vector2i(3, 2), "7L 5s generator is 3L + 2s");
+static_assert(allMOSStructures(32), "MOS transforms are unimodular up to 32 notes");
+
+constexpr AffineTransform shear(2.0, 1.0, 0.0, 0.5, 0.25, -1.0);
+static_assert((shear * Vector2i(1, 2)).x == 4.25 && (shear * Vector2i(1, 2)).y == 0.0,
+              "affine map of a lattice point");
+static_assert((shear.inverse() * (shear * Vector2d(3.0, -2.0))).x == 3.0 &&
+              (shear.inverse() * (shear * Vector2d(3.0, -2.0))).y == -2.0, "exact inverse");
+static_assert((shear * shear.inverse()).a == 1.0 && (shear * shear.inverse()).b == 0.0 &&
+              (shear * shear.inverse()).c == 0.0 && (shear * shear.inverse()).d == 1.0,
+              "composition with the inverse is the identity");
+
+TEST_CASE("Compile-time MOS structures agree at runtime", "[affine]") {
+    for (int a = 1; a < 32; ++a) {
+        for (int b = 1; a + b <= 32; ++b) {
+            if (gcd(a, b) != 1) continue;
+            REQUIRE(isMOSStructure(a, b));
+        }
+    }
+}
+
+TEST_CASE("linearMapFromTwoDots solves exactly in integers", "[affine]") {
+    SECTION("Maps both dots") {
+        Vector2i a1(1, 0), a2(1, 1), b1(3, 1), b2(5, 2);
+        bool exact = false;
+        IntegerAffineTransform M = IntegerAffineTransform::linearMapFromTwoDots(a1, a2, b1, b2, &exact);
+        REQUIRE(exact);
+        REQUIRE(M * a1 == b1);
+        REQUIRE(M * a2 == b2);
+        REQUIRE(M.tx == 0);
+        REQUIRE(M.ty == 0);
+    }
+
+    SECTION("Rejects maps with non-integer entries") {
+        // (2, 0) -> (1, 0) needs a = 1/2
+        bool exact = true;
+        IntegerAffineTransform M = IntegerAffineTransform::linearMapFromTwoDots(
+            {2, 0}, {0, 1}, {1, 0}, {0, 1}, &exact);
+        REQUIRE_FALSE(exact);
+        REQUIRE(M == IntegerAffineTransform());
+    }
+
+    SECTION("Rejects collinear dots") {
+        bool exact = true;
+        IntegerAffineTransform::linearMapFromTwoDots({1, 2}, {2, 4}, {1, 0}, {0, 1}, &exact);
+        REQUIRE_FALSE(exact);
+    }
+
+    SECTION("Returns independent values") {
+        IntegerAffineTransform M1 = IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, {3, 1}, {5, 2});
+        IntegerAffineTransform M2 = IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, {1, 2}, {2, 5});
+        REQUIRE(M1 == IntegerAffineTransform(3, 2, 1, 1));
+        REQUIRE(M2 == IntegerAffineTransform(1, 1, 2, 3));
+    }
+}
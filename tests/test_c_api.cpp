@@ -0,0 +1,428 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/c_api.h"
+#include "scalatrix/consonance.hpp"
+#include "scalatrix/label_calculator.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/mos_family.hpp"
+#include "scalatrix/pitchset.hpp"
+#include "scalatrix/scale.hpp"
+#include "scalatrix/spectrum.hpp"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace scalatrix;
+
+namespace {
+
+const Spectrum& spectrumOf(const scalatrix_spectrum_t* s) {
+    return *reinterpret_cast<const Spectrum*>(s);
+}
+
+void requireSamePartials(const Spectrum& a, const Spectrum& b) {
+    REQUIRE(a.partials.size() == b.partials.size());
+    for (size_t i = 0; i < a.partials.size(); ++i) {
+        REQUIRE(a.partials[i].ratio == b.partials[i].ratio);
+        REQUIRE(a.partials[i].amplitude == b.partials[i].amplitude);
+    }
+}
+
+void requireSamePitchSet(const scalatrix_pitchset_t* p, const PitchSet& expected) {
+    int n = scalatrix_pitchset_size(p);
+    REQUIRE(n == static_cast<int>(expected.size()));
+    std::vector<double> log2fr(n);
+    REQUIRE(scalatrix_pitchset_copy_log2fr(p, log2fr.data(), n) == n);
+    char label[64];
+    for (int i = 0; i < n; ++i) {
+        REQUIRE(log2fr[i] == expected[i].log2fr);
+        REQUIRE(scalatrix_pitchset_label(p, i, label, sizeof(label)) ==
+                static_cast<int>(expected[i].label.size()));
+        REQUIRE(expected[i].label == label);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Bulk node readout through the C API", "[c_api][scale]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(3, 1, 0.58, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 32, 10);
+    const NodeVector& nodes = reinterpret_cast<const Scale*>(scale)->getNodes();
+    REQUIRE(nodes.size() == 32);
+
+    SECTION("Whole nodes, clamped to the end of the scale") {
+        std::vector<scalatrix_node> out(40);
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 5, 8, out.data()) == 8);
+        for (int i = 0; i < 8; ++i) {
+            REQUIRE(out[i].pitch == nodes[5 + i].pitch);
+            REQUIRE(out[i].natural_coord.x == nodes[5 + i].natural_coord.x);
+            REQUIRE(out[i].natural_coord.y == nodes[5 + i].natural_coord.y);
+            REQUIRE(out[i].tuning_coord.x == nodes[5 + i].tuning_coord.x);
+        }
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 28, 10, out.data()) == 4);
+        REQUIRE(out[3].pitch == nodes[31].pitch);
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 32, 10, out.data()) == 0);
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 0, 0, out.data()) == 0);
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 0, 32, nullptr) == 32);
+    }
+
+    SECTION("One array per field; NULL fields are skipped") {
+        std::vector<double> pitches(40, -1.0);
+        std::vector<scalatrix_vec2i> natural(40);
+        std::vector<scalatrix_vec2d> tuning(40);
+        REQUIRE(scalatrix_scale_copy_columns(scale, 30, 10, pitches.data(), natural.data(), tuning.data()) == 2);
+        for (int i = 0; i < 2; ++i) {
+            REQUIRE(pitches[i] == nodes[30 + i].pitch);
+            REQUIRE(natural[i].x == nodes[30 + i].natural_coord.x);
+            REQUIRE(tuning[i].y == nodes[30 + i].tuning_coord.y);
+        }
+        REQUIRE(pitches[2] == -1.0);
+
+        REQUIRE(scalatrix_scale_copy_columns(scale, 0, 32, nullptr, natural.data(), nullptr) == 32);
+        REQUIRE(natural[31].y == nodes[31].natural_coord.y);
+        REQUIRE(scalatrix_scale_copy_columns(scale, 0, 32, nullptr, nullptr, nullptr) == 32);
+    }
+
+    SECTION("Out-of-range first or count writes nothing") {
+        std::vector<scalatrix_node> out(1);
+        out[0].pitch = -1.0;
+        std::vector<double> pitches(1, -1.0);
+        for (int first : {-1, 33, 1 << 30}) {
+            REQUIRE(scalatrix_scale_copy_nodes(scale, first, 1, out.data()) == -1);
+            REQUIRE(scalatrix_scale_copy_columns(scale, first, 1, pitches.data(), nullptr, nullptr) == -1);
+        }
+        REQUIRE(scalatrix_scale_copy_nodes(scale, 0, -1, out.data()) == -1);
+        REQUIRE(scalatrix_scale_copy_columns(scale, 0, -1, pitches.data(), nullptr, nullptr) == -1);
+        REQUIRE(out[0].pitch == -1.0);
+        REQUIRE(pitches[0] == -1.0);
+    }
+
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+}
+
+TEST_CASE("Scale generation through the C API rejects a root outside its nodes", "[c_api][scale]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(3, 1, 0.58, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 32, 10);
+    Scale before = *reinterpret_cast<const Scale*>(scale);
+
+    for (int root : {-1, 32, 1 << 30}) {
+        REQUIRE(scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 32, root) == nullptr);
+        REQUIRE(scalatrix_mos_generate_scale(mos, 261.63, 32, root) == nullptr);
+        REQUIRE(scalatrix_mos_generate_mapped_scale_into(mos, scale, 12, 0.0, 261.63, 32, root) == -1);
+        REQUIRE(scalatrix_mos_generate_scale_into(mos, scale, 261.63, 32, root) == -1);
+    }
+    REQUIRE(scalatrix_mos_generate_scale(mos, 261.63, 0, 0) == nullptr);
+
+    // The adjust variants leave the MOS untouched too, as they do for a
+    // missing mapping or scale
+    scalatrix_mapping bad = {12, 0.0, 261.63, 32, 32};
+    scalatrix_mapping good = {12, 0.0, 261.63, 32, 31};
+    int n = scalatrix_mos_n(mos);
+    double g = scalatrix_mos_generator(mos);
+    REQUIRE(scalatrix_mos_adjust_g_into(mos, 5, 1, 0.57, 1.0, 1, &bad, scale) == -1);
+    REQUIRE(scalatrix_mos_adjust_tuning_g_into(mos, 5, 1, 0.57, 1.0, 1, &bad, scale) == -1);
+    REQUIRE(scalatrix_mos_adjust_params_into(mos, 5, 2, 1, 1.0, 0.57, 1, &bad, scale) == -1);
+    REQUIRE(scalatrix_mos_adjust_g_into(mos, 5, 1, 0.57, 1.0, 1, nullptr, scale) == -1);
+    REQUIRE(scalatrix_mos_adjust_tuning_g_into(mos, 5, 1, 0.57, 1.0, 1, &good, nullptr) == -1);
+    REQUIRE(scalatrix_mos_adjust_params_into(mos, 5, 2, 1, 1.0, 0.57, 1, nullptr, nullptr) == -1);
+    REQUIRE(scalatrix_mos_n(mos) == n);
+    REQUIRE(scalatrix_mos_generator(mos) == g);
+    const Scale& after = *reinterpret_cast<const Scale*>(scale);
+    REQUIRE(after.getRootIdx() == before.getRootIdx());
+    for (int i = 0; i < 32; ++i)
+        REQUIRE(after.getNodes()[i].pitch == before.getNodes()[i].pitch);
+
+    REQUIRE(scalatrix_mos_adjust_params_into(mos, 5, 2, 1, 1.0, 0.57, 1, &good, scale) == 0);
+    REQUIRE(after.getRootIdx() == 31);
+
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+}
+
+TEST_CASE("MOS families through the C API match generateMOSFamily", "[c_api][mos_family]") {
+    REQUIRE(scalatrix_mos_family_generate(nullptr) == nullptr);
+
+    scalatrix_mos_family_options options = scalatrix_mos_family_default_options();
+    options.max_size = 7;
+    options.g_steps = 3;
+    options.n_nodes = 16;
+    options.root = 4;
+    scalatrix_mos_family_t* family = scalatrix_mos_family_generate(&options);
+    REQUIRE(family != nullptr);
+
+    MOSFamilyOptions o;
+    o.max_size = 7;
+    o.g_steps = 3;
+    o.n_nodes = 16;
+    o.root = 4;
+    MOSFamily expected = generateMOSFamily(o);
+    REQUIRE(scalatrix_mos_family_size(family) == static_cast<int>(expected.size()));
+    REQUIRE(scalatrix_mos_family_n_nodes(family) == 16);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        REQUIRE(scalatrix_mos_family_generator(family)[i] == expected.generator[i]);
+    }
+    for (size_t i = 0; i < expected.pitch.size(); ++i) {
+        REQUIRE(scalatrix_mos_family_pitch(family)[i] == expected.pitch[i]);
+    }
+    scalatrix_mos_family_free(family);
+}
+
+TEST_CASE("Spectra through the C API match the C++ constructors", "[c_api][spectrum]") {
+    scalatrix_spectrum_t* harmonic = scalatrix_spectrum_harmonic(8, 0.8);
+    requireSamePartials(spectrumOf(harmonic), Spectrum::harmonic(8, 0.8));
+
+    scalatrix_spectrum_t* odd = scalatrix_spectrum_odd_harmonic(9, 0.9);
+    requireSamePartials(spectrumOf(odd), Spectrum::oddHarmonic(9, 0.9));
+
+    scalatrix_spectrum_t* pseudo = scalatrix_spectrum_pseudoharmonic(6, 0.88, nullptr, nullptr, 0);
+    requireSamePartials(spectrumOf(pseudo), Spectrum::pseudoharmonic(6, 0.88));
+
+    int primes[] = {2, 3};
+    double cents[] = {1210.0, 1890.0};
+    scalatrix_spectrum_t* stretched = scalatrix_spectrum_pseudoharmonic(6, 0.88, primes, cents, 2);
+    requireSamePartials(spectrumOf(stretched),
+                        Spectrum::pseudoharmonic(6, 0.88, {{2, 1210.0}, {3, 1890.0}}));
+
+    double ratios[] = {1.0, 2.76, 5.40};
+    double amplitudes[] = {1.0, 0.5, 0.25};
+    scalatrix_spectrum_t* custom = scalatrix_spectrum_new(ratios, amplitudes, 3);
+    REQUIRE(scalatrix_spectrum_size(custom) == 3);
+    double r[8] = {}, a[8] = {};
+    REQUIRE(scalatrix_spectrum_copy_partials(custom, r, a, 2) == 2);
+    REQUIRE(r[2] == 0.0);
+    REQUIRE(r[1] == 2.76);
+    REQUIRE(a[1] == 0.5);
+    REQUIRE(scalatrix_spectrum_copy_partials(custom, nullptr, a, 8) == 3);
+    REQUIRE(a[2] == 0.25);
+    REQUIRE(scalatrix_spectrum_copy_partials(custom, nullptr, nullptr, 8) == 3);
+
+    // Missing arrays
+    REQUIRE(scalatrix_spectrum_new(nullptr, a, 2) == nullptr);
+    REQUIRE(scalatrix_spectrum_new(r, nullptr, 2) == nullptr);
+    scalatrix_spectrum_t* none = scalatrix_spectrum_new(nullptr, nullptr, 0);
+    REQUIRE(scalatrix_spectrum_size(none) == 0);
+    scalatrix_spectrum_free(none);
+    REQUIRE(scalatrix_spectrum_pseudoharmonic(8, 0.88, primes, nullptr, 1) == nullptr);
+
+    scalatrix_spectrum_free(custom);
+    scalatrix_spectrum_free(stretched);
+    scalatrix_spectrum_free(pseudo);
+    scalatrix_spectrum_free(odd);
+    scalatrix_spectrum_free(harmonic);
+}
+
+TEST_CASE("Consonance curves through the C API match the C++ functions", "[c_api][consonance]") {
+    scalatrix_spectrum_t* spectrum = scalatrix_spectrum_harmonic(10, 0.88);
+    const Spectrum& s = spectrumOf(spectrum);
+    scalatrix_consonance_t* c = scalatrix_consonance_new(spectrum, 261.63, -100.0, 1300.0, 1.0);
+    int n = scalatrix_consonance_size(c);
+    REQUIRE(n > 0);
+
+    std::vector<double> cents(n), pl(n), hull(n), spiky(n), consonance(n);
+    scalatrix_consonance_info info;
+    REQUIRE(scalatrix_consonance_compute(c, 0.5, 0, nullptr, nullptr, nullptr, nullptr,
+                                         consonance.data(), n - 1, nullptr) == -1);
+
+    // Both generations, with a fixed and an auto-computed baseline; repeated
+    // evaluation on the same handle gives the same result
+    for (int gen3 = 0; gen3 <= 1; ++gen3) {
+        for (double baseline : {0.5, -0.4, 0.5}) {
+            ConsonanceCurve expected = gen3
+                ? computeConsonanceCurveGen3(s, 261.63, -100.0, 1300.0, 1.0, baseline)
+                : computeConsonanceCurve(s, 261.63, -100.0, 1300.0, 1.0, baseline);
+            REQUIRE(scalatrix_consonance_compute(c, baseline, gen3, cents.data(), pl.data(),
+                                                 hull.data(), spiky.data(), consonance.data(),
+                                                 n, &info) == 0);
+            REQUIRE(static_cast<int>(expected.cents.size()) == n);
+            REQUIRE(cents == expected.cents);
+            REQUIRE(pl == expected.pl);
+            REQUIRE(hull == expected.hull);
+            REQUIRE(spiky == expected.spiky);
+            REQUIRE(consonance == expected.consonance);
+            REQUIRE(info.peak == expected.peak);
+            REQUIRE(info.log_baseline == expected.logBaseline);
+        }
+    }
+
+    // Only the consonance column
+    std::vector<double> only(n);
+    REQUIRE(scalatrix_consonance_compute(c, 0.5, 1, nullptr, nullptr, nullptr, nullptr,
+                                         only.data(), n, nullptr) == 0);
+    REQUIRE(only == computeConsonanceCurveGen3(s, 261.63, -100.0, 1300.0, 1.0, 0.5).consonance);
+
+    scalatrix_consonance_free(c);
+
+    // Reversed, empty, non-finite or unbounded grids
+    REQUIRE(scalatrix_consonance_new(spectrum, 261.63, 1300.0, -100.0, 1.0) == nullptr);
+    REQUIRE(scalatrix_consonance_new(spectrum, 261.63, 0.0, 0.0, 1.0) == nullptr);
+    REQUIRE(scalatrix_consonance_new(spectrum, 261.63, 0.0, 1200.0, 0.0) == nullptr);
+    REQUIRE(scalatrix_consonance_new(spectrum, NAN, 0.0, 1200.0, 1.0) == nullptr);
+    REQUIRE(scalatrix_consonance_new(spectrum, 261.63, 0.0, 1e12, 1e-3) == nullptr);
+    scalatrix_spectrum_free(spectrum);
+}
+
+TEST_CASE("Scale analysis through the C API matches analyzeScale", "[c_api][consonance]") {
+    scalatrix_spectrum_t* spectrum = scalatrix_spectrum_harmonic(8, 0.88);
+    // A NaN interval is not above the limit, so analyzeScale keeps it
+    double cents[] = {0.0, 386.3, 2100.0, 701.955, NAN, 1200.0};
+    std::vector<std::pair<std::string, double>> intervals;
+    for (double c : cents) intervals.push_back({"", c});
+    ConsonanceResult expected = analyzeScale(spectrumOf(spectrum), 261.63, intervals,
+                                             2000.0, 1950.0, 0.5);
+    REQUIRE(expected.intervals.size() == 5);
+
+    double consonance[6];
+    double mean = 0.0;
+    int n = scalatrix_analyze_scale(spectrum, 261.63, cents, 6, 2000.0, 1950.0, 0.5,
+                                    consonance, &mean);
+    REQUIRE(n == 5);
+    REQUIRE(std::isnan(consonance[2]));
+    REQUIRE(consonance[0] == expected.intervals[0].consonance);
+    REQUIRE(consonance[1] == expected.intervals[1].consonance);
+    REQUIRE(consonance[3] == expected.intervals[2].consonance);
+    REQUIRE(consonance[4] == expected.intervals[3].consonance);
+    REQUIRE(consonance[5] == expected.intervals[4].consonance);
+    REQUIRE(mean == expected.mean_consonance);
+
+    scalatrix_spectrum_free(spectrum);
+}
+
+TEST_CASE("Pitch sets through the C API match the generators", "[c_api][pitchset]") {
+    scalatrix_pitchset_t* et = scalatrix_pitchset_et(12, 1.0, 0.0, 1.0);
+    requireSamePitchSet(et, generateETPitchSet(12, 1.0, 0.0, 1.0));
+
+    scalatrix_pitchset_t* ji = scalatrix_pitchset_ji(4, 30, 0.0, 1.0);
+    requireSamePitchSet(ji, generateJIPitchSet(generateDefaultPrimeList(4), 30, 0.0, 1.0));
+
+    scalatrix_pitchset_t* odd = scalatrix_pitchset_bounded_ji(4, SCALATRIX_JI_ODD_LIMIT, 9, 0.0, 1.0);
+    requireSamePitchSet(odd, generateBoundedJIPitchSet(generateDefaultPrimeList(4),
+                                                       JIBound::oddLimit(9), 0.0, 1.0));
+    REQUIRE(scalatrix_pitchset_bounded_ji(4, 7, 9, 0.0, 1.0) == nullptr);
+
+    scalatrix_pitchset_t* series = scalatrix_pitchset_harmonic_series(5, 8, 0.0, 1.001);
+    requireSamePitchSet(series, generateHarmonicSeriesPitchSet(generateDefaultPrimeList(5), 8,
+                                                               0.0, 1.001));
+
+    // Closest pitch agrees with the index the wrapper holds
+    PitchSetIndex index(generateJIPitchSet(generateDefaultPrimeList(4), 30, 0.0, 1.0));
+    for (double x = -0.1; x < 1.1; x += 0.013)
+        REQUIRE(scalatrix_pitchset_closest(ji, x) == index.closest(x));
+
+    // Custom set, labels optional; labels truncate like snprintf
+    double log2fr[] = {0.0, 0.5, 1.0};
+    const char* labels[] = {"1:1", nullptr, "2:1"};
+    scalatrix_pitchset_t* custom = scalatrix_pitchset_new(log2fr, labels, 3);
+    REQUIRE(scalatrix_pitchset_closest(custom, 0.4) == 1);
+    char buf[3];
+    REQUIRE(scalatrix_pitchset_label(custom, 2, buf, sizeof(buf)) == 3);
+    REQUIRE(std::strcmp(buf, "2:") == 0);
+    REQUIRE(scalatrix_pitchset_label(custom, 1, buf, sizeof(buf)) == 0);
+    REQUIRE(scalatrix_pitchset_label(custom, 0, nullptr, 0) == 3);
+    REQUIRE(scalatrix_pitchset_label(custom, 3, buf, sizeof(buf)) == -1);
+
+    scalatrix_pitchset_t* empty = scalatrix_pitchset_new(nullptr, nullptr, 0);
+    REQUIRE(scalatrix_pitchset_size(empty) == 0);
+    REQUIRE(scalatrix_pitchset_closest(empty, 0.5) == -1);
+    REQUIRE(scalatrix_pitchset_new(nullptr, labels, 3) == nullptr);
+    REQUIRE(scalatrix_pitchset_copy_log2fr(custom, nullptr, 8) == 3);
+
+    scalatrix_pitchset_free(empty);
+    scalatrix_pitchset_free(custom);
+    scalatrix_pitchset_free(series);
+    scalatrix_pitchset_free(odd);
+    scalatrix_pitchset_free(ji);
+    scalatrix_pitchset_free(et);
+}
+
+TEST_CASE("Tempering through the C API matches temperToPitchSet", "[c_api][tempering]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(5, 1, 0.585, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 128, 60);
+    scalatrix_pitchset_t* ji = scalatrix_pitchset_ji(4, 30, 0.0, 1.0);
+
+    Scale expected(*reinterpret_cast<const Scale*>(scale));
+    PitchSetIndex index(generateJIPitchSet(generateDefaultPrimeList(4), 30, 0.0, 1.0));
+    TemperingStats expected_stats;
+    expected.temperToPitchSet(index, &expected_stats);
+
+    scalatrix_tempering_stats stats;
+    scalatrix_scale_temper(scale, ji, &stats);
+    REQUIRE(stats.max_cents == expected_stats.max_cents);
+    REQUIRE(stats.rms_cents == expected_stats.rms_cents);
+    REQUIRE(stats.n_nodes == expected_stats.n_nodes);
+    REQUIRE(stats.n_nodes > 0);
+
+    std::vector<double> pitches(128), tempered_log2fr(128);
+    std::vector<int> is_tempered(128);
+    REQUIRE(scalatrix_scale_copy_columns(scale, 0, 128, pitches.data(), nullptr, nullptr) == 128);
+    REQUIRE(scalatrix_scale_copy_tempering(scale, 0, 128, is_tempered.data(),
+                                           tempered_log2fr.data()) == 128);
+    REQUIRE(scalatrix_scale_copy_tempering(scale, 100, 64, nullptr, nullptr) == 28);
+    REQUIRE(scalatrix_scale_copy_tempering(scale, 129, 1, nullptr, nullptr) == -1);
+
+    const NodeVector& nodes = expected.getNodes();
+    char label[32];
+    for (int i = 0; i < 128; ++i) {
+        REQUIRE(pitches[i] == nodes[i].pitch);
+        REQUIRE(is_tempered[i] == (nodes[i].isTempered ? 1 : 0));
+        REQUIRE(tempered_log2fr[i] == nodes[i].temperedPitch.log2fr);
+        REQUIRE(scalatrix_scale_tempered_label(scale, i, label, sizeof(label)) >= 0);
+        REQUIRE(nodes[i].temperedPitch.label == label);
+    }
+    REQUIRE(scalatrix_scale_tempered_label(scale, 128, label, sizeof(label)) == -1);
+
+    // Stats are optional
+    scalatrix_scale_temper(scale, ji, nullptr);
+
+    scalatrix_pitchset_free(ji);
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+}
+
+TEST_CASE("Label batches through the C API match LabelTable", "[c_api][labels]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(5, 1, 0.585, 1.0, 1);
+    const MOS& m = *reinterpret_cast<const MOS*>(mos);
+    scalatrix_labels_t* labels = scalatrix_labels_new();
+    REQUIRE(scalatrix_labels_count(labels) == 0);
+
+    auto label = [&](int i) {
+        int size = 0;
+        const char* text = scalatrix_labels_text(labels, &size);
+        const unsigned int* offsets = scalatrix_labels_offsets(labels);
+        REQUIRE(offsets[scalatrix_labels_count(labels)] == static_cast<unsigned int>(size));
+        return std::string(text + offsets[i], offsets[i + 1] - offsets[i]);
+    };
+
+    REQUIRE(scalatrix_labels_rect(labels, mos, -2, -1, 6, 3, SCALATRIX_LABEL_LETTER_WITH_OCTAVE, 5) == 18);
+    for (int y = -1; y < 2; ++y) {
+        for (int x = -2; x < 4; ++x) {
+            REQUIRE(label((y + 1) * 6 + (x + 2)) == LabelCalculator::nodeLabelLetterWithOctaveNumber(m, Vector2i(x, y), 5));
+        }
+    }
+
+    scalatrix_vec2i coords[3] = {{0, 0}, {3, -1}, {-4, 2}};
+    int style = SCALATRIX_LABEL_DIGIT | SCALATRIX_LABEL_TUNING | SCALATRIX_LABEL_ACCIDENTAL_BEFORE;
+    REQUIRE(scalatrix_labels_coords(labels, mos, coords, 3, style, 4) == 3);
+    for (int i = 0; i < 3; ++i) {
+        REQUIRE(label(i) == LabelCalculator::nodeLabelDigitTuning(m, Vector2i(coords[i].x, coords[i].y), false));
+    }
+    REQUIRE(scalatrix_labels_coords(labels, mos, coords, 0, style, 4) == 0);
+    REQUIRE(scalatrix_labels_coords(labels, mos, coords, -1, style, 4) == 0);
+    REQUIRE(scalatrix_labels_coords(labels, mos, coords, 3, 4, 4) == -1);
+    REQUIRE(scalatrix_labels_coords(labels, mos, coords, 3, 0x40, 4) == -1);
+
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 32, 16);
+    scalatrix_pitchset_t* et = scalatrix_pitchset_et(12, 1.0, -3.0, 3.0);
+    scalatrix_scale_temper(scale, et, nullptr);
+    const NodeVector& nodes = reinterpret_cast<const Scale*>(scale)->getNodes();
+    REQUIRE(scalatrix_labels_deviation(labels, scale, 4, 100, 0.1, 0) == 28);
+    for (int i = 0; i < 28; ++i) {
+        REQUIRE(label(i) == LabelCalculator::deviationLabel(nodes[4 + i], 0.1, false));
+    }
+    REQUIRE(scalatrix_labels_deviation(labels, scale, 33, 1, 0.1, 0) == -1);
+
+    scalatrix_pitchset_free(et);
+    scalatrix_scale_free(scale);
+    scalatrix_labels_free(labels);
+    scalatrix_mos_free(mos);
+}
@@ -0,0 +1,65 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/consonance.hpp"
+#include <cmath>
+#include <vector>
+
+using namespace scalatrix;
+
+TEST_CASE("ConsonanceCurveBuffer matches the curve functions", "[consonance]") {
+    Spectrum spectrum = Spectrum::harmonic(10, 0.88);
+    ConsonanceCurveBuffer buffer(spectrum, 261.63, -100.0, 1300.0, 1.0);
+    REQUIRE(buffer.size() > 0);
+    REQUIRE(static_cast<int>(buffer.consonance().size()) == buffer.size());
+    for (double v : buffer.consonance()) REQUIRE(v == 0.0);
+
+    // The arrays never move, so views taken before computing follow it
+    const double* consonance = buffer.consonance().data();
+    const double* pl = buffer.pl().data();
+    for (int gen3 = 0; gen3 <= 1; ++gen3) {
+        for (double baseline : {0.5, -0.4}) {
+            ConsonanceCurve expected = gen3
+                ? computeConsonanceCurveGen3(spectrum, 261.63, -100.0, 1300.0, 1.0, baseline)
+                : computeConsonanceCurve(spectrum, 261.63, -100.0, 1300.0, 1.0, baseline);
+            if (gen3) {
+                buffer.computeGen3(baseline);
+            } else {
+                buffer.compute(baseline);
+            }
+            REQUIRE(buffer.cents() == expected.cents);
+            REQUIRE(buffer.pl() == expected.pl);
+            REQUIRE(buffer.hull() == expected.hull);
+            REQUIRE(buffer.spiky() == expected.spiky);
+            REQUIRE(buffer.consonance() == expected.consonance);
+            REQUIRE(buffer.peak() == expected.peak);
+            REQUIRE(buffer.logBaseline() == expected.logBaseline);
+            REQUIRE(buffer.consonance().data() == consonance);
+            REQUIRE(buffer.pl().data() == pl);
+        }
+    }
+}
+
+TEST_CASE("Grids that cannot be built give empty curves", "[consonance]") {
+    Spectrum spectrum = Spectrum::harmonic(4, 0.88);
+    REQUIRE(ConsonanceEvaluator::validArguments(261.63, -100.0, 1300.0, 1.0));
+    struct Args { double f0, cents_min, cents_max, resolution; };
+    for (Args a : {Args{261.63, 1300.0, -100.0, 1.0}, Args{261.63, 0.0, 0.0, 1.0},
+                   Args{261.63, 0.0, 1200.0, 0.0}, Args{261.63, 0.0, 1200.0, -1.0},
+                   Args{NAN, 0.0, 1200.0, 1.0}, Args{261.63, 0.0, INFINITY, 1.0},
+                   Args{261.63, 0.0, 1200.0, NAN}, Args{261.63, 0.0, 1e12, 1e-3}}) {
+        REQUIRE_FALSE(ConsonanceEvaluator::validArguments(a.f0, a.cents_min, a.cents_max, a.resolution));
+        ConsonanceCurveBuffer buffer(spectrum, a.f0, a.cents_min, a.cents_max, a.resolution);
+        REQUIRE(buffer.size() == 0);
+        REQUIRE(buffer.consonance().empty());
+        buffer.compute(-0.4);
+        buffer.computeGen3(0.5);
+        REQUIRE(buffer.peak() == 0.0);
+        REQUIRE(buffer.logBaseline() == 0.5);
+    }
+
+    // A range narrower than the resolution is one point
+    ConsonanceCurveBuffer one(spectrum, 261.63, 10.0, 10.5, 1.0);
+    REQUIRE(one.size() == 1);
+    REQUIRE(one.cents()[0] == 10.0);
+    one.compute(-0.4);
+    REQUIRE(std::isfinite(one.peak()));
+}
@@ -1,6 +1,9 @@
 #include "catch2/catch_test_macros.hpp"
 #include "scalatrix/label_calculator.hpp"
 #include "scalatrix/mos.hpp"
+#include "scalatrix/pitchset.hpp"
+#include <atomic>
+#include <thread>
 
 using namespace scalatrix;
 
@@ -236,4 +239,211 @@ TEST_CASE("LabelCalculator deviationLabel", "[labelcalculator]") {
         std::string result = LabelCalculator::deviationLabel(node, 0.1, false);
         REQUIRE(result == "3:2");
     }
-}
\ No newline at end of file
+
+    SECTION("Labels longer than the stack buffer") {
+        std::string ratio = std::string(90, '3') + ":" + std::string(90, '2');
+        Node nodes[3];
+        nodes[0].closestPitch = {"3:2", 0.5849625007};
+        nodes[0].tuning_coord.x = 0.5849625007;
+        nodes[1].closestPitch = {ratio, 0.5849625007};
+        nodes[1].tuning_coord.x = 0.6;
+        nodes[2] = nodes[0];
+
+        std::string result = LabelCalculator::deviationLabel(nodes[1], 0.1, false);
+        REQUIRE(result.size() == ratio.size() + 7);
+        REQUIRE(result.compare(0, ratio.size(), ratio) == 0);
+        REQUIRE(result.substr(ratio.size()) == "+18.0ct");
+
+        LabelBatch batch;
+        LabelCalculator::deviationLabels(nodes, 3, batch, 0.1, false);
+        REQUIRE(batch.size() == 3);
+        REQUIRE(batch[0] == "3:2");
+        REQUIRE(batch[1] == result);
+        REQUIRE(batch[2] == "3:2");
+    }
+}
+
+TEST_CASE("LabelTable matches LabelCalculator", "[labelcalculator][labeltable]") {
+    std::vector<MOS> systems = {
+        MOS::fromParams(5, 2, 1, 1.0, 0.585),
+        MOS::fromG(3, 1, 0.58, 1.0),
+        MOS::fromG(4, 1, 0.41, 1.0),
+        MOS::fromG(2, 1, 0.72, 1.0),
+        MOS::fromG(3, 2, 0.3, 1.0, 2),
+    };
+    for (const MOS& mos : systems) {
+        for (bool tuning : {false, true}) {
+            LabelTable table(mos, tuning);
+            REQUIRE(table.matches(mos, tuning));
+            for (int x = -20; x <= 20; ++x) {
+                for (int y = -20; y <= 20; ++y) {
+                    Vector2i v(x, y);
+                    for (bool after : {true, false}) {
+                        if (tuning) {
+                            REQUIRE(table.label(v, LabelTable::DIGIT, after) == LabelCalculator::nodeLabelDigitTuning(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::DIGIT_ZERO_BASED, after) == LabelCalculator::nodeLabelDigitTuningZeroBased(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::LETTER, after) == LabelCalculator::nodeLabelLetterTuning(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::LETTER_WITH_OCTAVE, after, 3) == LabelCalculator::nodeLabelLetterWithOctaveNumberTuning(mos, v, 3, after));
+                        } else {
+                            REQUIRE(table.label(v, LabelTable::DIGIT, after) == LabelCalculator::nodeLabelDigit(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::DIGIT_ZERO_BASED, after) == LabelCalculator::nodeLabelDigitZeroBased(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::LETTER, after) == LabelCalculator::nodeLabelLetter(mos, v, after));
+                            REQUIRE(table.label(v, LabelTable::LETTER_WITH_OCTAVE, after, 3) == LabelCalculator::nodeLabelLetterWithOctaveNumber(mos, v, 3, after));
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("LabelTable writes into caller buffers", "[labelcalculator][labeltable]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    LabelTable table(mos);
+
+    SECTION("Pooled pieces") {
+        REQUIRE(table.degreeString(0, LabelTable::DIGIT) == "1");
+        REQUIRE(table.degreeString(0, LabelTable::DIGIT_ZERO_BASED) == "0");
+        REQUIRE(table.degreeString(0, LabelTable::LETTER) == "C");
+        REQUIRE(table.degreeString(7, LabelTable::LETTER).empty());
+        REQUIRE(table.accidentalString(0).empty());
+        REQUIRE(table.accidentalString(2) == "\xe2\x99\xaf\xe2\x99\xaf");
+        REQUIRE(table.accidentalString(-1) == "\xe2\x99\xad");
+        REQUIRE(table.accidentalString(LabelTable::MAX_POOLED_ACCIDENTALS + 1).empty());
+    }
+
+    SECTION("Truncates like snprintf") {
+        Vector2i v(1, 0);
+        std::string full = table.label(v, LabelTable::LETTER_WITH_OCTAVE);
+        char buf[64];
+        REQUIRE(table.write(v, LabelTable::LETTER_WITH_OCTAVE, buf, sizeof(buf)) == full.size());
+        REQUIRE(std::string(buf) == full);
+        char small[3];
+        REQUIRE(table.write(v, LabelTable::LETTER_WITH_OCTAVE, small, sizeof(small)) == full.size());
+        REQUIRE(std::string(small) == full.substr(0, 2));
+        REQUIRE(table.write(v, LabelTable::LETTER_WITH_OCTAVE, nullptr, 0) == full.size());
+    }
+
+    SECTION("Accidentals beyond the pool") {
+        Vector2i v(40, -40);
+        REQUIRE(std::abs(table.accidentals(v)) > LabelTable::MAX_POOLED_ACCIDENTALS);
+        REQUIRE(table.label(v, LabelTable::LETTER) == LabelCalculator::nodeLabelLetter(mos, v));
+        REQUIRE(table.label(v, LabelTable::DIGIT, false) == LabelCalculator::nodeLabelDigit(mos, v, false));
+    }
+
+    SECTION("Retuning keeps the pool") {
+        const char* pool = table.degreeString(0, LabelTable::DIGIT).data();
+        MOS retuned = mos;
+        retuned.retuneOnePoint(Vector2i(1, 0), 0.16);
+        REQUIRE(table.matches(retuned));
+        table.rebuild(retuned);
+        REQUIRE(table.degreeString(0, LabelTable::DIGIT).data() == pool);
+
+        MOS other = MOS::fromG(3, 1, 0.41, 1.0);
+        REQUIRE_FALSE(table.matches(other));
+        table.rebuild(other);
+        REQUIRE(table.matches(other));
+        REQUIRE(table.label(Vector2i(2, 1), LabelTable::DIGIT) == LabelCalculator::nodeLabelDigit(other, Vector2i(2, 1)));
+    }
+
+    SECTION("Empty table") {
+        LabelTable none;
+        char buf[8] = "x";
+        REQUIRE(none.empty());
+        REQUIRE(none.write(Vector2i(0, 0), LabelTable::DIGIT, buf, sizeof(buf)) == 0);
+        REQUIRE(buf[0] == '\0');
+    }
+}
+
+TEST_CASE("LabelTable labels whole grids at once", "[labelcalculator][labeltable]") {
+    MOS mos = MOS::fromParams(5, 2, 1, 1.0, 0.585);
+    LabelTable table(mos);
+    LabelBatch batch;
+
+    SECTION("Rectangles go row by row") {
+        table.labelRect(Vector2i(-3, -2), 9, 5, LabelTable::LETTER_WITH_OCTAVE, batch);
+        REQUIRE(batch.size() == 45);
+        REQUIRE(batch.offsets.front() == 0);
+        REQUIRE(batch.offsets.back() == batch.text.size());
+        for (int y = -2; y < 3; ++y) {
+            for (int x = -3; x < 6; ++x) {
+                size_t i = (y + 2) * 9 + (x + 3);
+                REQUIRE(batch[i] == LabelCalculator::nodeLabelLetterWithOctaveNumber(mos, Vector2i(x, y)));
+            }
+        }
+        table.labelRect(Vector2i(0, 0), 0, 5, LabelTable::DIGIT, batch);
+        REQUIRE(batch.size() == 0);
+        REQUIRE(batch.text.empty());
+    }
+
+    SECTION("Coordinate lists") {
+        std::vector<Vector2i> coords = {Vector2i(0, 0), Vector2i(40, -40), Vector2i(-3, 1), Vector2i(2, 2)};
+        table.labelCoords(coords.data(), coords.size(), LabelTable::DIGIT, batch, false);
+        REQUIRE(batch.size() == coords.size());
+        for (size_t i = 0; i < coords.size(); ++i) {
+            REQUIRE(batch[i] == LabelCalculator::nodeLabelDigit(mos, coords[i], false));
+        }
+    }
+
+    SECTION("Refilling replaces the labels") {
+        table.labelRect(Vector2i(0, 0), 12, 12, LabelTable::LETTER, batch);
+        const char* text = batch.text.data();
+        table.labelRect(Vector2i(0, 0), 12, 12, LabelTable::LETTER, batch);
+        REQUIRE(batch.text.data() == text);
+        table.labelRect(Vector2i(5, 5), 12, 12, LabelTable::LETTER, batch);
+        REQUIRE(batch.size() == 144);
+        REQUIRE(batch[0] == LabelCalculator::nodeLabelLetter(mos, Vector2i(5, 5)));
+    }
+
+    SECTION("Deviation labels") {
+        Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 64, 30);
+        PitchSet et = generateETPitchSet(12, 1.0);
+        scale.temperToPitchSet(et);
+        const NodeVector& nodes = scale.getNodes();
+        LabelCalculator::deviationLabels(nodes.data(), nodes.size(), batch, 0.1, true);
+        REQUIRE(batch.size() == nodes.size());
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            REQUIRE(batch[i] == LabelCalculator::deviationLabel(nodes[i], 0.1, true));
+        }
+    }
+}
+
+TEST_CASE("LabelCalculator shares one diatonic reference", "[labelcalculator]") {
+    const MOS& diatonic = LabelCalculator::diatonicReference();
+    REQUIRE(&diatonic == &LabelCalculator::diatonicReference());
+    REQUIRE(diatonic.a == 5);
+    REQUIRE(diatonic.b == 2);
+
+    std::vector<MOS> systems = {
+        MOS::fromParams(5, 2, 1, 1.0, 0.585),
+        MOS::fromG(4, 1, 0.59, 1.0),
+        MOS::fromG(3, 1, 0.41, 1.0),
+    };
+    const LabelCalculator lc;
+    std::vector<std::string> expected;
+    for (const MOS& mos : systems) {
+        for (int x = -6; x <= 6; ++x) {
+            for (int y = -6; y <= 6; ++y) expected.push_back(lc.noteLabelNormalized(mos, Vector2i(x, y)));
+        }
+    }
+
+    // One labeller, used from several threads at once
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            for (int round = 0; round < 20; ++round) {
+                size_t k = 0;
+                for (const MOS& mos : systems) {
+                    for (int x = -6; x <= 6; ++x) {
+                        for (int y = -6; y <= 6; ++y) {
+                            if (lc.noteLabelNormalized(mos, Vector2i(x, y)) != expected[k++]) ++mismatches;
+                        }
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    REQUIRE(mismatches == 0);
+}
@@ -0,0 +1,405 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/lattice.hpp"
+#include "scalatrix/mos.hpp"
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace scalatrix;
+
+namespace {
+
+/**
+ * The original findClosestWithinStrip, kept verbatim as the fuzz reference
+ * except that it reports (via `defined`) when it would have hit undefined
+ * behaviour: 1/f not fitting an int, or a convergent overflowing.
+ */
+std::pair<Vector2i, Vector2i> referenceClosestWithinStrip(const AffineTransform& M, bool& defined) {
+    defined = true;
+    auto isnull = [](double x) { return std::abs(x) < 1e-6; };
+
+    auto M_inv = M.inverse();
+    Vector2d v(1.0, 0.0);
+    Vector2d zv = M_inv * v;
+
+    Vector2i r, s;
+    Vector2d z;
+    bool has_first = false, has_second = false;
+    if (isnull(zv.x)){
+        s = Vector2i(0, zv.y>0?1:-1);
+        has_first = true;
+        z = M * Vector2i(1, 0);
+        if (std::abs(z.y) < 1){
+            r = Vector2i(z.y>0?1:-1, 0);
+            has_second = true;
+        }else{
+            r = s;
+        }
+    }
+    else if (isnull(zv.y)){
+        s = Vector2i(zv.x>0?1:-1, 0);
+        has_first = true;
+        z = M * Vector2i(0, 1);
+        if (std::abs(z.y) < 1){
+            r = Vector2i(0, z.y>0?1:-1);
+            has_second = true;
+        }else{
+            r = s;
+        }
+    }
+    else if (isnull(zv.x - zv.y)){
+        s = Vector2i(zv.x>0?1:-1, 0);
+        has_first = true;
+        z = M * Vector2i(1, 0);
+        if (std::abs(z.y) < 1){
+            r = Vector2i(0, z.y>0?1:-1);
+            has_second = true;
+        }else{
+            r = s;
+        }
+    }
+    else
+    {
+        double e;
+        bool x_large = std::abs(zv.x) > std::abs(zv.y);
+        if (x_large){
+            e = std::abs(zv.y/zv.x);
+        }else{
+            e = std::abs(zv.x/zv.y);
+        }
+
+        int a = std::floor(e);
+        std::vector<int> num = {1, a};
+        std::vector<int> den = {0, 1};
+        double f = e - a;
+
+        while (num.size() < 20) {
+            if (x_large){
+                r.x = den.back();
+                r.y = (zv.x*zv.y>0?1:-1) * num.back();
+            }else{
+                r.x = num.back();
+                r.y = (zv.x*zv.y>0?1:-1) * den.back();
+            }
+            z = M * Vector2d((double)r.x, (double)r.y);
+            if (z.x < 0){
+                z = -z;
+                r = -r;
+            }
+            if (z.y < 1 && z.y > -1){
+                if(!has_first){
+                    has_first = true;
+                    s = r;
+                }
+                else{
+                    has_second = true;
+                    break;
+                }
+            }
+            if (num.size() == 19) break;  // the last push is never read
+            if (!(f > 0) || 1/f >= (double)INT_MAX) { defined = false; break; }
+            a = std::floor(1/f);
+            f = 1/f - a;
+            long long next_num = (long long)a*num[num.size()-1] + num[num.size()-2];
+            long long next_den = (long long)a*den[den.size()-1] + den[den.size()-2];
+            if (next_num > INT_MAX || next_den > INT_MAX) { defined = false; break; }
+            num.push_back(a*num[num.size()-1] + num[num.size()-2]);
+            den.push_back(a*den[den.size()-1] + den[den.size()-2]);
+        }
+    }
+    if (!has_first){
+        return {{0,0}, {0,0}};
+    }
+    if (!has_second){
+        return {s, s};
+    }
+
+    Vector2i t;
+    Vector2d zr, zs;
+    bool changed = true;
+    int cnt;
+
+    zr = M * r;
+    zs = M * s;
+    if (zr.x > zs.x){
+        std::swap(r, s);
+        std::swap(zr, zs);
+    }
+
+    while (changed){
+        changed = false;
+        cnt = 0;
+        if (zs.x>0){
+            while(zs.x > 0 && zs.y > -1 && zs.y < 1){
+                t = s;
+                s -= r;
+                zs = M * s;
+                changed = true;
+                cnt++;
+                if (cnt > 1000000) { defined = false; return {r, s}; }
+            }
+            s = t;
+            zs = M * s;
+            if (cnt==1) {
+                changed = false;
+            }
+            if (zr.x > zs.x){
+                std::swap(r, s);
+                std::swap(zr, zs);
+                changed = true;
+            }
+        }else{
+            break;
+        }
+    }
+    return {r, s};
+}
+
+bool inStrip(const AffineTransform& M, const Vector2i& v) {
+    Vector2d z = M * v;
+    return z.y > -1 && z.y < 1;
+}
+
+// Bound on the rounding error of evaluating M*v
+double roundingError(const AffineTransform& M, const Vector2i& v) {
+    return DBL_EPSILON * (std::abs(M.a * v.x) + std::abs(M.b * v.y) +
+                          std::abs(M.c * v.x) + std::abs(M.d * v.y));
+}
+
+} // namespace
+
+TEST_CASE("findClosestWithinStrip matches the reference on random transforms", "[lattice]") {
+    std::mt19937_64 rng(20240611);
+    std::uniform_real_distribution<double> entry(-4.0, 4.0);
+    std::uniform_real_distribution<double> log_scale(-3.0, 3.0);
+
+    const int n_transforms = 2000000;
+    int n_compared = 0, n_mismatch = 0, n_noisy = 0, n_reference_wrong = 0;
+    for (int i = 0; i < n_transforms; ++i) {
+        // Rescale the second row so the strip ranges from very wide to very
+        // thin relative to the lattice
+        double row_scale = std::pow(10.0, log_scale(rng));
+        AffineTransform M(entry(rng), entry(rng), entry(rng) * row_scale, entry(rng) * row_scale);
+        if (std::abs(M.a * M.d - M.b * M.c) < 1e-9) continue;
+
+        bool defined;
+        auto expected = referenceClosestWithinStrip(M, defined);
+        if (!defined) continue;
+        auto actual = findClosestWithinStrip(M);
+        if (!inStrip(M, expected.first) || !inStrip(M, expected.second)) {
+            // The original's diagonal case, fixed in the new search
+            n_reference_wrong++;
+            if (!inStrip(M, actual.first) || !inStrip(M, actual.second)) n_mismatch++;
+            continue;
+        }
+        n_compared++;
+        if (!(actual.first == expected.first && actual.second == expected.second)) {
+            n_mismatch++;
+            // Once M*v carries rounding error near the strip width, the
+            // reference's stop condition is decided by that noise
+            bool noisy = false;
+            for (Vector2i v : {actual.first, actual.second, expected.first, expected.second}) {
+                noisy = noisy || roundingError(M, v) > 1e-9;
+            }
+            if (noisy) n_noisy++;
+        }
+    }
+    INFO("compared " << n_compared << " transforms, " << n_noisy << " ill-conditioned, "
+         << n_reference_wrong << " outside the strip in the reference");
+    REQUIRE(n_compared > n_transforms * 9 / 10);
+    REQUIRE(n_noisy < n_transforms / 10000);
+    REQUIRE(n_mismatch == n_noisy);
+}
+
+TEST_CASE("findClosestWithinStrip matches the reference on MOS transforms", "[lattice]") {
+    std::mt19937_64 rng(7);
+    std::uniform_real_distribution<double> gen(0.05, 0.95);
+    std::uniform_int_distribution<int> depth(1, 10);
+
+    int n_mismatch = 0;
+    for (int i = 0; i < 20000; ++i) {
+        MOS mos = MOS::fromG(depth(rng), 1, gen(rng), 1.0, 1);
+        AffineTransform M = mos.impliedAffine;
+        M.tx = 0;
+        M.ty = 0;
+        bool defined;
+        auto expected = referenceClosestWithinStrip(M, defined);
+        REQUIRE(defined);
+        auto actual = findClosestWithinStrip(M);
+        if (!(actual.first == expected.first && actual.second == expected.second)) {
+            n_mismatch++;
+        }
+    }
+    REQUIRE(n_mismatch == 0);
+}
+
+TEST_CASE("findClosestWithinStrip terminates on degenerate transforms", "[lattice]") {
+    SECTION("Rational strip slopes stop at the exact convergent") {
+        // 1/f is infinite once the continued fraction of a rational slope ends
+        for (int p = 1; p < 12; ++p) {
+            for (int q = p + 1; q <= 12; ++q) {
+                AffineTransform M(1.0, 0.0, -(double)p / q, 1.0);
+                auto [r, s] = findClosestWithinStrip(M);
+                REQUIRE(inStrip(M, r));
+                REQUIRE(inStrip(M, s));
+                REQUIRE((M * r).x <= (M * s).x);
+            }
+        }
+    }
+
+    SECTION("Axis-aligned strip directions") {
+        // (1, 1) maps onto the x axis; the original returned (1, 0), which
+        // lies outside the strip
+        AffineTransform M(0.5, 0.5, -1.0, 1.0);
+        auto [r, s] = findClosestWithinStrip(M);
+        REQUIRE(r == Vector2i(1, 1));
+        REQUIRE(s == Vector2i(1, 1));
+
+        // (0, 1) maps onto the x axis and (1, 0) into the strip at -x
+        AffineTransform N(-0.25, 1.0, 0.5, 0.0);
+        auto [r2, s2] = findClosestWithinStrip(N);
+        REQUIRE(inStrip(N, r2));
+        REQUIRE(inStrip(N, s2));
+        REQUIRE((N * r2).x >= 0);
+        REQUIRE((N * r2).x <= (N * s2).x);
+    }
+
+    SECTION("Transforms singular up to rounding") {
+        AffineTransform M(1.2, 8.0, -0.9, -6.0);
+        auto [r, s] = findClosestWithinStrip(M, true);
+        REQUIRE(r == Vector2i(0, 0));
+        REQUIRE(s == Vector2i(0, 0));
+    }
+
+    SECTION("Slopes within rounding of a rational") {
+        AffineTransform M(1.0, 0.0, -(7.0 / 12.0 + 1e-15), 1.0 / 3.0);
+        auto [r, s] = findClosestWithinStrip(M);
+        REQUIRE(inStrip(M, r));
+        REQUIRE(inStrip(M, s));
+    }
+}
+
+TEST_CASE("findClosestWithinStrip exact mode", "[lattice]") {
+    SECTION("Agrees with the floating-point search away from the boundary") {
+        std::mt19937_64 rng(11);
+        std::uniform_int_distribution<int> num(-24, 24);
+        std::uniform_int_distribution<int> den(1, 16);
+        int n_compared = 0;
+        for (int i = 0; i < 200000; ++i) {
+            AffineTransform M((double)num(rng) / den(rng), (double)num(rng) / den(rng),
+                              (double)num(rng) / den(rng), (double)num(rng) / den(rng));
+            if (std::abs(M.a * M.d - M.b * M.c) < 1e-9) continue;
+            auto [r, s] = findClosestWithinStrip(M, true);
+            auto [fr, fs] = findClosestWithinStrip(M);
+            REQUIRE(inStrip(M, r));
+            REQUIRE(inStrip(M, s));
+            REQUIRE((M * r).x > -1e-9);
+            // Only boundary nodes may be classified differently
+            bool boundary = false;
+            for (Vector2i v : {r, s, fr, fs}) {
+                double y = std::abs((M * v).y);
+                if (std::abs(y - 1.0) < 1e-9 || (M * v).x < 1e-9) boundary = true;
+            }
+            // Steps of equal x are ordered by rounding
+            if (std::abs((M * r).x - (M * s).x) < 1e-9) boundary = true;
+            if (boundary) continue;
+            n_compared++;
+            REQUIRE(r == fr);
+            REQUIRE(s == fs);
+        }
+        REQUIRE(n_compared > 1000);
+    }
+
+    SECTION("Equal temperaments classify boundary nodes exactly") {
+        // 12-EDO fifths put lattice nodes on the strip boundary; rounding noise
+        // in the generator must not change the steps
+        MOS et = MOS::fromG(3, 1, 7.0 / 12.0, 1.0, 1);
+        AffineTransform et_M = et.impliedAffine;
+        et_M.tx = 0;
+        et_M.ty = 0;
+        auto expected = findClosestWithinStrip(et_M, true);
+        for (double noise : {-1e-13, 1e-13}) {
+            MOS mos = MOS::fromG(3, 1, 7.0 / 12.0 + noise, 1.0, 1);
+            AffineTransform M = mos.impliedAffine;
+            M.tx = 0;
+            M.ty = 0;
+            auto [r, s] = findClosestWithinStrip(M, true);
+            REQUIRE(r == expected.first);
+            REQUIRE(s == expected.second);
+        }
+    }
+
+    SECTION("Irrational transforms fall back to floating point") {
+        AffineTransform M(1.0 - std::log2(1.5), std::log2(1.5), -1.0 / std::sqrt(2.0), 1.0);
+        auto exact = findClosestWithinStrip(M, true);
+        auto approx = findClosestWithinStrip(M);
+        REQUIRE(exact.first == approx.first);
+        REQUIRE(exact.second == approx.second);
+    }
+}
+
+TEST_CASE("StripBasisCache agrees with the search", "[lattice]") {
+    SECTION("Search results are valid bases") {
+        std::mt19937_64 rng(3);
+        std::uniform_real_distribution<double> gen(0.05, 0.95);
+        std::uniform_int_distribution<int> depth(1, 8);
+        for (int i = 0; i < 5000; ++i) {
+            MOS mos = MOS::fromG(depth(rng), 1, gen(rng), 1.0, 1);
+            AffineTransform M = mos.impliedAffine;
+            M.tx = 0;
+            M.ty = 0;
+            auto [r, s] = findClosestWithinStrip(M);
+            REQUIRE(StripBasisCache::isValid(M, r, s));
+        }
+    }
+
+    SECTION("Cache hits return what the search would") {
+        std::mt19937_64 rng(5);
+        std::uniform_real_distribution<double> entry(-4.0, 4.0);
+        std::uniform_real_distribution<double> log_scale(-3.0, 3.0);
+        std::uniform_real_distribution<double> jitter(-1.0, 1.0);
+        int n_mismatch = 0;
+        unsigned long long n_hits = 0;
+        for (int i = 0; i < 100000; ++i) {
+            double row_scale = std::pow(10.0, log_scale(rng));
+            AffineTransform M(entry(rng), entry(rng), entry(rng) * row_scale, entry(rng) * row_scale);
+            if (std::abs(M.a * M.d - M.b * M.c) < 1e-3) continue;
+            StripBasisCache cache;
+            cache.find(M);
+            // Perturbations from 10% down to 1e-5, relative
+            for (int k = 0; k < 5; ++k) {
+                double eps = std::pow(10.0, -1 - k);
+                AffineTransform Mk = M;
+                Mk.a *= 1 + jitter(rng) * eps;
+                Mk.b *= 1 + jitter(rng) * eps;
+                Mk.c *= 1 + jitter(rng) * eps;
+                Mk.d *= 1 + jitter(rng) * eps;
+                auto expected = findClosestWithinStrip(Mk);
+                auto actual = cache.find(Mk);
+                if (!(actual.first == expected.first && actual.second == expected.second)) n_mismatch++;
+            }
+            n_hits += cache.hits();
+        }
+        REQUIRE(n_mismatch == 0);
+        REQUIRE(n_hits > 100000);
+    }
+
+    SECTION("Counters") {
+        AffineTransform M(0.585, 0.415, 0.3, -0.55);
+        StripBasisCache cache;
+        cache.find(M);
+        cache.find(M);
+        cache.find(M);
+        REQUIRE(cache.misses() == 1);
+        REQUIRE(cache.hits() == 2);
+        REQUIRE(cache.hitRate() > 0.66);
+        cache.clear();
+        cache.find(M);
+        REQUIRE(cache.misses() == 2);
+        cache.resetCounters();
+        REQUIRE(cache.hits() == 0);
+        REQUIRE(cache.hitRate() == 0.0);
+    }
+}
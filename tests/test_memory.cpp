@@ -0,0 +1,207 @@
+#include "catch2/catch_test_macros.hpp"
+#include "allocation_counter.hpp"
+#include "scale_checks.hpp"
+#include "scalatrix/c_api.h"
+#include "scalatrix/memory.hpp"
+#include "scalatrix/mos.hpp"
+#include "scalatrix/scale.hpp"
+#include <cstddef>
+#include <cstdint>
+
+using namespace scalatrix;
+
+namespace {
+
+// Passes everything upstream, counting what goes through
+class CountingResource : public MemoryResource {
+public:
+    int allocations = 0;
+    int deallocations = 0;
+    size_t live_bytes = 0;
+
+protected:
+    void* doAllocate(size_t bytes, size_t align) override {
+        ++allocations;
+        live_bytes += bytes;
+        return defaultMemoryResource()->allocate(bytes, align);
+    }
+    void doDeallocate(void* p, size_t bytes, size_t align) override {
+        ++deallocations;
+        live_bytes -= bytes;
+        defaultMemoryResource()->deallocate(p, bytes, align);
+    }
+};
+
+bool isAligned(void* p, size_t align) {
+    return reinterpret_cast<uintptr_t>(p) % align == 0;
+}
+
+} // namespace
+
+TEST_CASE("MonotonicResource bumps through chunks", "[memory]") {
+    CountingResource upstream;
+    {
+        MonotonicResource arena(256, &upstream);
+        void* a = arena.allocate(24, 8);
+        void* b = arena.allocate(40, 32);
+        REQUIRE(isAligned(a, 8));
+        REQUIRE(isAligned(b, 32));
+        REQUIRE(static_cast<char*>(b) >= static_cast<char*>(a) + 24);
+        REQUIRE(upstream.allocations == 1);
+
+        // Deallocation is a no-op; a request larger than the chunk gets its own
+        arena.deallocate(a, 24, 8);
+        void* big = arena.allocate(1000);
+        REQUIRE(big != nullptr);
+        REQUIRE(upstream.allocations == 2);
+
+        arena.release();
+        REQUIRE(upstream.deallocations == 2);
+        REQUIRE(upstream.live_bytes == 0);
+        arena.allocate(16);
+        REQUIRE(upstream.allocations == 3);
+    }
+    REQUIRE(upstream.live_bytes == 0);
+}
+
+TEST_CASE("MonotonicResource uses the caller's buffer first", "[memory]") {
+    CountingResource upstream;
+    alignas(std::max_align_t) char buffer[512];
+    MonotonicResource arena(buffer, sizeof(buffer), &upstream);
+    void* p = arena.allocate(256);
+    REQUIRE(static_cast<char*>(p) >= buffer);
+    REQUIRE(static_cast<char*>(p) + 256 <= buffer + sizeof(buffer));
+    REQUIRE(upstream.allocations == 0);
+
+    arena.allocate(512);
+    REQUIRE(upstream.allocations == 1);
+
+    // Back to the start of the buffer
+    arena.release();
+    REQUIRE(arena.allocate(256) == p);
+    REQUIRE(upstream.live_bytes == 0);
+}
+
+TEST_CASE("PoolResource reuses freed blocks", "[memory]") {
+    CountingResource upstream;
+    {
+        PoolResource pool(&upstream);
+        void* a = pool.allocate(100);
+        REQUIRE(isAligned(a, MemoryResource::DEFAULT_ALIGN));
+        int chunks = upstream.allocations;
+        REQUIRE(chunks == 1);
+
+        pool.deallocate(a, 100);
+        REQUIRE(pool.allocate(120) == a);
+        REQUIRE(upstream.allocations == chunks);
+
+        // Larger than any class: straight through
+        void* big = pool.allocate(PoolResource::MAX_BLOCK + 1);
+        REQUIRE(upstream.allocations == chunks + 1);
+        pool.deallocate(big, PoolResource::MAX_BLOCK + 1);
+        REQUIRE(upstream.deallocations == 1);
+    }
+    REQUIRE(upstream.live_bytes == 0);
+}
+
+TEST_CASE("ResourceAllocator follows pmr rules", "[memory]") {
+    MonotonicResource arena;
+    ResourceVector<int> v(&arena);
+    v.assign(100, 7);
+    REQUIRE(v.get_allocator().resource() == &arena);
+
+    ResourceVector<int> copy(v);
+    REQUIRE(copy.get_allocator().resource() == defaultMemoryResource());
+    REQUIRE(copy == v);
+
+    ResourceVector<int> moved(std::move(v));
+    REQUIRE(moved.get_allocator().resource() == &arena);
+
+    ResourceAllocator<int> a(&arena), b(&arena), c;
+    REQUIRE(a == b);
+    REQUIRE(a != c);
+}
+
+TEST_CASE("Scale built in a resource matches the default", "[memory][scale]") {
+    AffineTransform A = MOS(5, 2, 1, 1.0, 0.58).impliedAffine;
+
+    Scale reference = Scale::fromAffine(A, 261.63, 128, 60);
+
+    CountingResource counting;
+    Scale scale(261.63, 128, 60, &counting);
+    scale.recalcWithAffine(A, 128, 60);
+    REQUIRE(scale.getResource() == &counting);
+    REQUIRE(counting.allocations == 2); // nodes and step word
+    requireSameNodes(scale, reference);
+    REQUIRE(scale.getStepWord() == reference.getStepWord());
+
+    // Moves keep the resource, copies leave it
+    Scale moved(std::move(scale));
+    REQUIRE(moved.getResource() == &counting);
+    Scale copied(moved);
+    REQUIRE(copied.getResource() == defaultMemoryResource());
+    requireSameNodes(copied, reference);
+    REQUIRE(counting.allocations == 2);
+}
+
+TEST_CASE("MOS keeps its base scale in its resource", "[memory][mos]") {
+    MOS reference(5, 2, 1, 1.0, 0.58);
+
+    PoolResource pool;
+    MOS mos(5, 2, 1, 1.0, 0.58, &pool);
+    REQUIRE(mos.base_scale.getResource() == &pool);
+    requireSameNodes(mos.base_scale, reference.base_scale);
+
+    // Rebuilding for another pattern stays in the pool
+    mos.adjustParams(7, 5, 2, 1.0, 0.58);
+    reference.adjustParams(7, 5, 2, 1.0, 0.58);
+    REQUIRE(mos.base_scale.getResource() == &pool);
+    requireSameNodes(mos.base_scale, reference.base_scale);
+    REQUIRE(mos.L_fr == reference.L_fr);
+
+    MOS copy(mos);
+    REQUIRE(copy.base_scale.getResource() == defaultMemoryResource());
+}
+
+TEST_CASE("In-place regeneration matches a fresh scale", "[memory][mos]") {
+    MOS mos(5, 2, 1, 1.0, 0.58);
+    Scale scale(100.0, 16, 3);
+    mos.generateMappedScaleInto(scale, 12, 0.0, 261.63, 128, 60);
+    REQUIRE(scale.getRootIdx() == 60);
+    REQUIRE(scale.getBaseFreq() == 261.63);
+    requireSameNodes(scale, mos.generateMappedScale(12, 0.0, 261.63, 128, 60));
+
+    // Shrinking reuses the storage
+    mos.adjustParams(7, 5, 2, 1.0, 0.58);
+    mos.generateScaleFromMOSInto(scale, 440.0, 64, 30);
+    requireSameNodes(scale, mos.generateScaleFromMOS(440.0, 64, 30));
+}
+
+TEST_CASE("Steady-state updates through the C API do not allocate", "[memory][c_api]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(5, 1, 0.58, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_scale_new(128);
+    scalatrix_mapping mapping = {12, 0.0, 261.63, 128, 60};
+
+    auto updates = [&] {
+        for (int i = 0; i < 40; ++i) {
+            double g = 0.575 + 0.0005 * i;
+            scalatrix_mos_adjust_g_into(mos, 5, i % 7, g, 1.0, 1, &mapping, scale);
+            scalatrix_mos_adjust_tuning_g_into(mos, 5, i % 7, g + 0.001, 1.0, 1, &mapping, scale);
+            scalatrix_mos_adjust_params_into(mos, 5, 2, i % 7, 1.0, g, 1, &mapping, scale);
+        }
+    };
+    // The first pass sizes the MOS path and scales for the patterns it meets
+    updates();
+    size_t before = allocationCount();
+    updates();
+    size_t allocations = allocationCount() - before;
+    REQUIRE(allocations == 0);
+
+    scalatrix_scale_t* fresh = scalatrix_mos_generate_mapped_scale(
+        mos, mapping.steps, mapping.offset, mapping.base_freq, mapping.n_nodes, mapping.root);
+    requireSameNodes(*reinterpret_cast<Scale*>(scale), *reinterpret_cast<Scale*>(fresh));
+
+    scalatrix_scale_free(fresh);
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+}
@@ -1,7 +1,11 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "scalatrix/mos.hpp"
+#include "scalatrix/mos_pattern.hpp"
+#include <climits>
 #include <cmath>
+#include <numeric>
+#include <thread>
 
 using namespace scalatrix;
 using Catch::Matchers::WithinAbs;
@@ -225,4 +229,295 @@ TEST_CASE("MOS step sizes", "[mos]") {
     SECTION("Chroma is the difference") {
         REQUIRE_THAT(mos.chroma_fr, WithinAbs(std::abs(mos.L_fr - mos.s_fr), 1e-10));
     }
-}
\ No newline at end of file
+}
+
+// The original generator walk, kept as a reference for the pattern table
+static Vector2i referenceWalk(int depth, double sg) {
+    int a0 = 1, b0 = 1;
+    double a_len = sg, b_len = 1.0 - sg;
+    for (int i = 0; i < depth; i++) {
+        if (a_len > b_len) {
+            b0 += a0;
+            a_len -= b_len;
+        } else {
+            a0 += b0;
+            b_len -= a_len;
+        }
+    }
+    return {a0, b0};
+}
+
+// The same walk one step at a time, stopped by depth and by size as
+// descend() must stop it
+struct SteppedWalk {
+    MOSConvergent at = {0, 1, 1};
+    double a_len, b_len;
+    explicit SteppedWalk(double sg) : a_len(sg), b_len(1.0 - sg) {}
+
+    bool growB() const { return a_len > b_len; }
+    int nextSize() const { return at.a0 + at.b0 + (growB() ? at.a0 : at.b0); }
+    void step() {
+        if (growB()) {
+            at.b0 += at.a0;
+            a_len -= b_len;
+        } else {
+            at.a0 += at.b0;
+            b_len -= a_len;
+        }
+        at.depth++;
+    }
+};
+
+static MOSConvergent referenceDescent(double sg, int max_depth, int max_size) {
+    SteppedWalk w(sg);
+    while (w.at.depth < max_depth && w.nextSize() <= max_size) w.step();
+    return w.at;
+}
+
+TEST_CASE("MOS pattern table", "[mos]") {
+    const auto& table = mosPatternTable();
+
+    SECTION("Holds every coprime pattern up to the size bound") {
+        size_t coprime = 0;
+        for (int a0 = 1; a0 < MOS_PATTERN_MAX_SIZE; a0++) {
+            for (int b0 = 1; a0 + b0 <= MOS_PATTERN_MAX_SIZE; b0++) {
+                if (std::gcd(a0, b0) == 1) coprime++;
+            }
+        }
+        REQUIRE(table.size() == coprime);
+    }
+
+    SECTION("Entries agree with MOS") {
+        for (const auto& p : table) {
+            REQUIRE(findMOSPattern(p.a0, p.b0) == &p);
+            std::vector<bool> path = calcPath(p.a0, p.b0);
+            REQUIRE(p.path() == path);
+            REQUIRE(p.depth == static_cast<int>(path.size()));
+            REQUIRE(p.v_gen == applyPath(path, {1, 0}));
+            IntegerAffineTransform t = IntegerAffineTransform::linearFromTwoDots({1, 0}, {1, 1}, p.v_gen, {p.a0, p.b0});
+            REQUIRE(p.mosTransform.a == t.a);
+            REQUIRE(p.mosTransform.b == t.b);
+            REQUIRE(p.mosTransform.c == t.c);
+            REQUIRE(p.mosTransform.d == t.d);
+            REQUIRE(p.g_lo < p.g_hi);
+        }
+        for (size_t i = 1; i < table.size(); i++) {
+            if (table[i].depth == table[i - 1].depth) {
+                REQUIRE(table[i - 1].g_hi <= table[i].g_lo);
+            } else {
+                REQUIRE(table[i - 1].depth < table[i].depth);
+            }
+        }
+    }
+
+    SECTION("Packed paths agree with calcPath and MOS") {
+        for (int a0 = 1; a0 < 40; a0++) {
+            for (int b0 = 1; a0 + b0 <= 65; b0++) {
+                MOSPath packed = mosPath(a0, b0);
+                if (std::gcd(a0, b0) != 1) {
+                    REQUIRE(packed.depth == -1);
+                    continue;
+                }
+                std::vector<bool> path = calcPath(a0, b0);
+                REQUIRE(packed.depth == static_cast<int>(path.size()));
+                for (int i = 0; i < packed.depth; i++) {
+                    REQUIRE(((packed.bits >> i) & 1) == path[i]);
+                }
+                MOS mos = MOS::fromParams(a0, b0, 0, 1.0, 0.5);
+                REQUIRE(applyMOSPath(packed, {1, 0}) == mos.v_gen);
+                REQUIRE(mosTransformOf(a0, b0) == mos.mosTransform);
+            }
+        }
+    }
+
+    SECTION("Lookup matches the step-by-step walk") {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        int found = 0;
+        for (int i = 0; i < 200000; i++) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            double g = (state >> 11) * (1.0 / 9007199254740992.0);
+            int depth = static_cast<int>(state % 24);
+            const MOSPattern* p = findMOSPattern(depth, g);
+            Vector2i expected = referenceWalk(depth, g);
+            if (p) {
+                found++;
+                REQUIRE(p->a0 == expected.x);
+                REQUIRE(p->b0 == expected.y);
+                REQUIRE(p->depth == depth);
+            }
+        }
+        REQUIRE(found > 100000);
+    }
+
+    SECTION("fromG, adjustG and adjustTuningG are unchanged") {
+        for (double g : {0.0001, 0.1, 0.25, 0.3333333, 0.4, 0.5, 0.585, 0.6, 0.7071, 0.9, 0.99999}) {
+            for (int depth = 0; depth < 16; depth++) {
+                double sg = g + (g < 0.5 ? 1e-6 : -1e-6);
+                Vector2i expected = referenceWalk(depth, sg);
+                int r = std::gcd(expected.x, expected.y);
+                MOS mos = MOS::fromG(depth, 0, g, 1.0);
+                REQUIRE(mos.a0 == expected.x / r);
+                REQUIRE(mos.b0 == expected.y / r);
+                mos.adjustG(depth, 0, g, 1.0);
+                REQUIRE(mos.a == expected.x);
+                REQUIRE(mos.b == expected.y);
+                mos.adjustTuningG(depth, 0, 0.5, 1.0);
+                REQUIRE(mos.a == expected.x);
+                REQUIRE(mos.b == expected.y);
+            }
+        }
+    }
+}
+
+TEST_CASE("MOS continued-fraction descent", "[mos]") {
+    auto sanitize = [](double g) { return g + (g < 0.5 ? 1e-6 : -1e-6); };
+
+    SECTION("Extreme generators give the same patterns as stepping") {
+        for (double g : {0.0001, 0.003, 0.01, 0.0625, 0.9375, 0.997, 0.9999}) {
+            for (int depth : {0, 1, 15, 16, 17, 40, 99, 150}) {
+                Vector2i expected = referenceWalk(depth, sanitize(g));
+                int r = std::gcd(expected.x, expected.y);
+                MOS mos = MOS::fromG(depth, 0, g, 1.0);
+                REQUIRE(mos.a0 == expected.x / r);
+                REQUIRE(mos.b0 == expected.y / r);
+                REQUIRE(mos.depth == static_cast<int>(calcPath(mos.a0, mos.b0).size()));
+            }
+        }
+    }
+
+    SECTION("Convergents and depth by size") {
+        uint64_t state = 12345;
+        for (int i = 0; i < 2000; i++) {
+            state = state * 6364136223846793005ull + 1442695040888963407ull;
+            double g = (state >> 11) * (1.0 / 9007199254740992.0);
+            if (i % 4 == 0) g *= 0.001; // long first runs
+            const int max_size = 5000;
+
+            // Step the walk, noting each change of direction
+            std::vector<MOSConvergent> expected = {{0, 1, 1}};
+            double sg = sanitize(g), a_len = sg, b_len = 1.0 - sg;
+            int a0 = 1, b0 = 1, depth = 0;
+            bool prev = false;
+            std::vector<int> depth_for_size(max_size + 1, -1);
+            depth_for_size[0] = depth_for_size[1] = depth_for_size[2] = 0;
+            int filled = 2;
+            while (true) {
+                bool grow_b = a_len > b_len;
+                if (a0 + b0 + (grow_b ? a0 : b0) > max_size) break;
+                if (depth > 0 && grow_b != prev) expected.push_back({depth, a0, b0});
+                prev = grow_b;
+                if (grow_b) { b0 += a0; a_len -= b_len; } else { a0 += b0; b_len -= a_len; }
+                depth++;
+                while (filled < a0 + b0) depth_for_size[++filled] = depth;
+            }
+            if (depth > expected.back().depth) expected.push_back({depth, a0, b0});
+
+            std::vector<MOSConvergent> actual = MOS::convergents(g, max_size);
+            REQUIRE(actual.size() == expected.size());
+            for (size_t k = 0; k < actual.size(); k++) {
+                REQUIRE(actual[k].depth == expected[k].depth);
+                REQUIRE(actual[k].a0 == expected[k].a0);
+                REQUIRE(actual[k].b0 == expected[k].b0);
+            }
+            int wrong_depths = 0;
+            for (int n = 2; n <= filled; n++) {
+                if (MOS::depthForSize(g, n) != depth_for_size[n]) wrong_depths++;
+            }
+            REQUIRE(wrong_depths == 0);
+        }
+    }
+
+    SECTION("Jumped runs stop where stepping does at every limit") {
+        std::vector<double> generators;
+        for (int k = 1; k < 64; k++) {
+            generators.push_back(k / 64.0 + 0.0037);
+            generators.push_back(k * 1.7e-4); // first runs of hundreds of steps
+            generators.push_back(1.0 - k * 2.3e-4);
+        }
+        MOS mos = MOS::fromG(0, 0, 0.585, 1.0);
+        for (double g : generators) {
+            double sg = sanitize(g);
+            // Every size limit, through the final convergent: a stepped walk
+            // stops at the last state of size <= max_size
+            int wrong_stops = 0;
+            SteppedWalk w(sg);
+            for (int max_size = 2; max_size <= 3000; max_size++) {
+                if (w.nextSize() <= max_size) w.step();
+                const MOSConvergent& expected = w.at;
+                MOSConvergent actual = MOS::convergents(g, max_size).back();
+                if (actual.depth != expected.depth || actual.a0 != expected.a0 || actual.b0 != expected.b0) {
+                    wrong_stops++;
+                }
+            }
+            REQUIRE(wrong_stops == 0);
+            // Depth limits all through the first runs and around each later
+            // run end, where a jump is clamped or ends
+            std::vector<int> depths;
+            for (int depth = 0; depth < 48; depth++) depths.push_back(depth);
+            for (const MOSConvergent& run : MOS::convergents(g, 3000)) {
+                for (int d = run.depth - 3; d <= run.depth + 3; d++) depths.push_back(d);
+            }
+            for (int depth : depths) {
+                if (depth < 0) continue;
+                MOSConvergent expected = referenceDescent(sg, depth, INT_MAX);
+                if (expected.a0 + expected.b0 > 3000) continue;
+                mos.adjustG(depth, 0, g, 1.0);
+                REQUIRE(mos.a == expected.a0);
+                REQUIRE(mos.b == expected.b0);
+            }
+        }
+    }
+
+    SECTION("Depth chosen by size feeds fromG") {
+        int depth = MOS::depthForSize(0.585, 12);
+        MOS mos = MOS::fromG(depth, 0, 0.585, 1.0);
+        REQUIRE(mos.n0 >= 12);
+        MOS smaller = MOS::fromG(depth - 1, 0, 0.585, 1.0);
+        REQUIRE(smaller.n0 < 12);
+    }
+}
+
+TEST_CASE("MOS construction is thread-safe", "[mos]") {
+    // Build the same MOS family on several threads at once; each must come
+    // out exactly as it does single-threaded (run under SCALATRIX_TSAN to
+    // check for races as well)
+    std::vector<std::pair<int, int>> params;
+    for (int a = 1; a <= 12; a++) {
+        for (int b = 1; b <= 12; b++) {
+            if (std::gcd(a, b) == 1) params.push_back({a, b});
+        }
+    }
+    std::vector<IntegerAffineTransform> expected;
+    std::vector<Vector2i> expected_gen;
+    for (const auto& ab : params) {
+        MOS mos = MOS::fromParams(ab.first, ab.second, 0, 1.0, 0.5);
+        expected.push_back(mos.mosTransform);
+        expected_gen.push_back(mos.v_gen);
+    }
+
+    const int n_threads = 8;
+    const int rounds = 20;
+    std::vector<int> mismatches(n_threads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int round = 0; round < rounds; round++) {
+                for (size_t i = 0; i < params.size(); i++) {
+                    // Threads start at different offsets so they disagree
+                    // on (a, b) at any one moment
+                    size_t k = (i + t * 7) % params.size();
+                    MOS mos = MOS::fromParams(params[k].first, params[k].second, 0, 1.0, 0.5);
+                    if (!(mos.mosTransform == expected[k]) || !(mos.v_gen == expected_gen[k])) {
+                        mismatches[t]++;
+                    }
+                    mos.adjustParams(params[i].first, params[i].second, 0, 1.0, 0.5);
+                    if (!(mos.mosTransform == expected[i])) mismatches[t]++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    for (int t = 0; t < n_threads; t++) {
+        REQUIRE(mismatches[t] == 0);
+    }
+}
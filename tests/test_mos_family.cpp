@@ -0,0 +1,120 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/mos_family.hpp"
+#include <numeric>
+
+using namespace scalatrix;
+
+TEST_CASE("MOS family enumerates every pattern", "[mos_family]") {
+    MOSFamilyOptions options;
+    options.min_size = 3;
+    options.max_size = 10;
+    options.g_steps = 3;
+    options.n_nodes = 0;
+    MOSFamily family = generateMOSFamily(options);
+
+    size_t expected = 0;
+    for (int n = 3; n <= 10; n++) {
+        for (int a = 1; a < n; a++) {
+            expected += n / std::gcd(a, n - a) * options.g_steps;
+        }
+    }
+    REQUIRE(family.size() == expected);
+    REQUIRE(family.generator.size() == expected);
+    REQUIRE(family.L_fr.size() == expected);
+    REQUIRE(family.pitch.empty());
+
+    for (size_t i = 1; i < family.size(); i++) {
+        int n_prev = family.a[i - 1] + family.b[i - 1];
+        int n = family.a[i] + family.b[i];
+        REQUIRE(n_prev <= n);
+        int n0 = n / std::gcd(family.a[i], family.b[i]);
+        REQUIRE(family.mode[i] < n0);
+        REQUIRE(family.generator[i] > 0.0);
+        REQUIRE(family.generator[i] < 1.0);
+    }
+}
+
+TEST_CASE("MOS family matches generateMappedScale", "[mos_family]") {
+    MOSFamilyOptions options;
+    options.max_size = 9;
+    options.g_steps = 2;
+    options.n_nodes = 40;
+    options.root = 17;
+    options.base_freq = 220.0;
+    MOSFamily family = generateMOSFamily(options);
+    REQUIRE(family.n_nodes == 40);
+    REQUIRE(family.pitch.size() == family.size() * 40);
+
+    for (size_t i = 0; i < family.size(); i++) {
+        MOS mos = MOS::fromParams(family.a[i], family.b[i], family.mode[i], 1.0, family.generator[i]);
+        REQUIRE(family.L_fr[i] == mos.L_fr);
+        REQUIRE(family.s_fr[i] == mos.s_fr);
+        Scale scale = mos.generateMappedScale(mos.n, 0.0, 220.0, 40, 17);
+        const auto& nodes = scale.getNodes();
+        for (int j = 0; j < 40; j++) {
+            size_t k = i * 40 + j;
+            REQUIRE(family.coord_x[k] == nodes[j].natural_coord.x);
+            REQUIRE(family.coord_y[k] == nodes[j].natural_coord.y);
+            REQUIRE(family.tuning_x[k] == nodes[j].tuning_coord.x);
+            REQUIRE(family.tuning_y[k] == nodes[j].tuning_coord.y);
+            REQUIRE(family.pitch[k] == nodes[j].pitch);
+        }
+    }
+
+    SECTION("Fixed mapping steps") {
+        options.steps = 12;
+        options.offset = 0.25;
+        MOSFamily mapped = generateMOSFamily(options);
+        size_t i = mapped.size() / 2;
+        MOS mos = MOS::fromParams(mapped.a[i], mapped.b[i], mapped.mode[i], 1.0, mapped.generator[i]);
+        Scale scale = mos.generateMappedScale(12, 0.25, 220.0, 40, 17);
+        for (int j = 0; j < 40; j++) {
+            REQUIRE(mapped.coord_x[i * 40 + j] == scale.getNodes()[j].natural_coord.x);
+            REQUIRE(mapped.coord_y[i * 40 + j] == scale.getNodes()[j].natural_coord.y);
+            REQUIRE(mapped.pitch[i * 40 + j] == scale.getNodes()[j].pitch);
+        }
+    }
+}
+
+TEST_CASE("MOS family does not depend on the thread count", "[mos_family]") {
+    MOSFamilyOptions options;
+    options.max_size = 16;
+    options.g_steps = 3;
+    options.n_nodes = 64;
+    options.root = 30;
+    options.n_threads = 1;
+    MOSFamily serial = generateMOSFamily(options);
+    for (int threads : {2, 3, 8}) {
+        options.n_threads = threads;
+        MOSFamily parallel = generateMOSFamily(options);
+        REQUIRE(parallel.a == serial.a);
+        REQUIRE(parallel.b == serial.b);
+        REQUIRE(parallel.mode == serial.mode);
+        REQUIRE(parallel.generator == serial.generator);
+        REQUIRE(parallel.L_fr == serial.L_fr);
+        REQUIRE(parallel.s_fr == serial.s_fr);
+        REQUIRE(parallel.coord_x == serial.coord_x);
+        REQUIRE(parallel.coord_y == serial.coord_y);
+        REQUIRE(parallel.tuning_x == serial.tuning_x);
+        REQUIRE(parallel.tuning_y == serial.tuning_y);
+        REQUIRE(parallel.pitch == serial.pitch);
+    }
+}
+
+TEST_CASE("MOS family rejects a root outside its nodes", "[mos_family]") {
+    MOSFamilyOptions options;
+    options.max_size = 8;
+    options.n_nodes = 16;
+    for (int root : {-1, 16, 40}) {
+        options.root = root;
+        MOSFamily family = generateMOSFamily(options);
+        REQUIRE(family.size() == 0);
+        REQUIRE(family.n_nodes == 0);
+        REQUIRE(family.pitch.empty());
+    }
+
+    // Without nodes the root is unused
+    options.n_nodes = 0;
+    options.root = 40;
+    REQUIRE(generateMOSFamily(options).size() > 0);
+}
@@ -1,7 +1,11 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include "scalatrix/pitchset.hpp"
+#include "scalatrix/monzo.hpp"
+#include <algorithm>
+#include <climits>
 #include <cmath>
+#include <numeric>
 
 using namespace scalatrix;
 using Catch::Matchers::WithinAbs;
@@ -529,4 +533,270 @@ TEST_CASE("Pitch set integration", "[pitchset]") {
             REQUIRE_THAT(interval, WithinAbs(1.0/12, 1e-10));
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("ExactPitch interval algebra", "[pitchset]") {
+    SECTION("Parsing labels into structured pitches") {
+        ExactPitch ratio = ExactPitch::fromLabel("6:4", std::log2(1.5));
+        REQUIRE(ratio.isRatio());
+        REQUIRE(ratio.num == 3);
+        REQUIRE(ratio.den == 2);
+
+        ExactPitch et = ExactPitch::fromLabel("-7\\12", -7.0/12.0);
+        REQUIRE(et.isET());
+        REQUIRE(et.num == -7);
+        REQUIRE(et.den == 12);
+
+        REQUIRE(ExactPitch::fromLabel("invalid", 0.5).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::fromLabel("3:2:1", 0.5).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::fromLabel("", 0.0).label().empty());
+    }
+
+    SECTION("Ratio arithmetic without labels") {
+        ExactPitch fifth = ExactPitch::ratio(3, 2);
+        ExactPitch third = ExactPitch::ratio(5, 4);
+
+        ExactPitch seventh = fifth + third;
+        REQUIRE(seventh == ExactPitch::ratio(15, 8));
+        REQUIRE_THAT(seventh.log2fr, WithinAbs(std::log2(15.0/8.0), 1e-12));
+
+        REQUIRE((fifth - fifth) == ExactPitch::ratio(1, 1));
+        REQUIRE((-fifth) == ExactPitch::ratio(2, 3));
+        REQUIRE((fifth * 4) == ExactPitch::ratio(81, 16));
+        REQUIRE((-2 * fifth) == ExactPitch::ratio(4, 9));
+    }
+
+    SECTION("ET arithmetic") {
+        ExactPitch a = ExactPitch::et(2, 11);
+        ExactPitch b = ExactPitch::et(4, 11);
+        REQUIRE((a + b) == ExactPitch::et(6, 11));
+        REQUIRE_THAT((a + b).log2fr, WithinAbs(6.0/11.0, 1e-12));
+        REQUIRE((a + ExactPitch::et(1, 12)).kind == ExactPitch::NONE);
+        REQUIRE((ExactPitch::ratio(3, 2) + a).kind == ExactPitch::NONE);
+    }
+
+    SECTION("Labels are formatted on demand") {
+        char buf[32];
+        ExactPitch p = ExactPitch::ratio(125, 27);
+        REQUIRE(p.formatLabel(buf, sizeof(buf)) == 6);
+        REQUIRE(std::string(buf) == "125:27");
+        REQUIRE(ExactPitch::et(-3, 7).label() == "-3\\7");
+        REQUIRE(p.toPitchSetPitch().label == "125:27");
+    }
+
+    SECTION("Non-positive ratios are rejected") {
+        REQUIRE(ExactPitch::ratio(0, 1).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(-3, 2).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(3, -2).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(-3, -2).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(3, 0).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(LLONG_MIN, 1).kind == ExactPitch::NONE);
+        REQUIRE(ExactPitch::ratio(-3, 2).log2fr == 0.0);
+        REQUIRE(ExactPitch::fromLabel("-3:2", 0.5).kind == ExactPitch::NONE);
+    }
+
+    SECTION("Overflow yields an empty label instead of garbage") {
+        ExactPitch p = ExactPitch::ratio(3, 2) * 60;
+        REQUIRE(p.kind == ExactPitch::NONE);
+        REQUIRE(p.label().empty());
+        REQUIRE_THAT(p.log2fr, WithinAbs(60 * std::log2(1.5), 1e-9));
+
+        PitchSetPitch big = {"3:2", std::log2(1.5)};
+        REQUIRE((big * 60).label.empty());
+        REQUIRE((big * 39).label == "4052555153018976267:549755813888");
+    }
+
+    SECTION("Converting a whole pitch set") {
+        auto exact = toExactPitches(generateETPitchSet(12, 1.0));
+        REQUIRE(exact.size() == 13);
+        for (size_t i = 0; i < exact.size(); ++i) {
+            REQUIRE(exact[i] == ExactPitch::et(static_cast<long long>(i), 12));
+        }
+    }
+}
+
+TEST_CASE("Monzo prime-exponent algebra", "[pitchset][monzo]") {
+    MonzoBasis basis(generateDefaultPrimeList(4)); // 2, 3, 5, 7
+
+    SECTION("Factoring ratios over the basis") {
+        Monzo fifth;
+        REQUIRE(basis.fromRatio(3, 2, fifth));
+        REQUIRE(fifth.exps[0] == -1);
+        REQUIRE(fifth.exps[1] == 1);
+        REQUIRE(fifth.exps[2] == 0);
+        REQUIRE(basis.label(fifth) == "3:2");
+        REQUIRE_THAT(basis.log2fr(fifth), WithinAbs(std::log2(1.5), 1e-12));
+
+        Monzo untouched = fifth;
+        REQUIRE_FALSE(basis.fromRatio(11, 8, untouched));
+        REQUIRE(untouched == fifth);
+        REQUIRE_FALSE(basis.fromRatio(0, 1, untouched));
+
+        Monzo reduced;
+        REQUIRE(basis.fromRatio(6, 4, reduced));
+        REQUIRE(reduced == fifth);
+    }
+
+    SECTION("Multiplication and powers are exponent arithmetic") {
+        Monzo fifth, fourth;
+        REQUIRE(basis.fromRatio(3, 2, fifth));
+        REQUIRE(basis.fromRatio(4, 3, fourth));
+        REQUIRE((fifth + fourth) == basis.primeMonzo(0));
+        REQUIRE((fifth - fifth).isUnison());
+        REQUIRE(basis.label(-fifth) == "2:3");
+
+        Monzo comma = fifth * 4 - basis.primeMonzo(0) * 2;
+        Monzo expected;
+        REQUIRE(basis.fromRatio(81, 64, expected));
+        REQUIRE(comma == expected);
+
+        ExactPitch exact = ExactPitch::ratio(3, 2) * 4;
+        REQUIRE(basis.toExactPitch(fifth * 4).label() == exact.label());
+    }
+
+    SECTION("Huge powers stay exact and fall back to bracket notation") {
+        Monzo fifth;
+        REQUIRE(basis.fromRatio(3, 2, fifth));
+        Monzo big = 1000 * fifth;
+        REQUIRE(big.exps[0] == -1000);
+        REQUIRE(big.exps[1] == 1000);
+        REQUIRE_THAT(basis.log2fr(big), WithinAbs(1000 * std::log2(1.5), 1e-9));
+
+        long long num = 0, den = 0;
+        REQUIRE_FALSE(basis.toRatio(big, num, den));
+        REQUIRE(basis.label(big) == "[-1000 1000>");
+        REQUIRE(basis.toExactPitch(big).kind == ExactPitch::NONE);
+
+        REQUIRE((big - 999 * fifth) == fifth);
+    }
+
+    SECTION("Exponents saturate instead of wrapping") {
+        Monzo fifth;
+        REQUIRE(basis.fromRatio(3, 2, fifth));
+        Monzo huge = fifth * 2000000000;
+        REQUIRE(huge.exps[0] == -2000000000);
+        Monzo clamped = huge * 2;
+        REQUIRE(clamped.exps[0] == INT32_MIN);
+        REQUIRE(clamped.exps[1] == INT32_MAX);
+        REQUIRE((clamped + huge).exps[1] == INT32_MAX);
+        REQUIRE((clamped - huge).exps[0] == INT32_MIN + 2000000000);
+        REQUIRE((-clamped).exps[0] == INT32_MAX);
+    }
+
+    SECTION("Out-of-range primes and oversized bases are rejected") {
+        REQUIRE(basis.primeMonzo(-1).isUnison());
+        REQUIRE(basis.primeMonzo(4).isUnison());
+        REQUIRE(basis.primeMonzo(MONZO_MAX_PRIMES).isUnison());
+
+        PrimeList primes(MONZO_MAX_PRIMES, generateDefaultPrimeList(1)[0]);
+        REQUIRE(MonzoBasis(primes).size() == MONZO_MAX_PRIMES);
+        primes.push_back(primes[0]);
+        MonzoBasis oversized(primes);
+        REQUIRE(oversized.size() == 0);
+        Monzo m;
+        REQUIRE_FALSE(oversized.fromRatio(3, 2, m));
+    }
+
+    SECTION("Detuned primes flow into log2fr") {
+        PrimeList primes = generateDefaultPrimeList(3);
+        primes[1].log2fr = 1.58;
+        MonzoBasis detuned(primes);
+        Monzo fifth;
+        REQUIRE(detuned.fromRatio(3, 2, fifth));
+        REQUIRE_THAT(detuned.log2fr(fifth), WithinAbs(0.58, 1e-12));
+        PitchSetPitch p = detuned.toPitchSetPitch(fifth);
+        REQUIRE(p.label == "3:2");
+        REQUIRE_THAT(p.log2fr, WithinAbs(0.58, 1e-12));
+    }
+}
+
+// The original trial-division generator, kept as a reference for the enumerator
+static PitchSet referenceJIPitchSet(PrimeList primes, int max_numorden, double min_log2fr, double max_log2fr) {
+    std::vector<std::pair<int, double>> nums;
+    for (int i = 1; i < max_numorden; i++) {
+        int r = i;
+        double log2fr = 0.0;
+        for (auto p : primes) {
+            while (r % p.number == 0) {
+                r /= p.number;
+                log2fr += p.log2fr;
+            }
+        }
+        if (r == 1) nums.push_back({i, log2fr});
+    }
+    PitchSet pitchset;
+    for (auto num : nums) {
+        for (auto den : nums) {
+            if (std::gcd(num.first, den.first) > 1) continue;
+            double log2fr = num.second - den.second;
+            if (log2fr > min_log2fr - 1e-6 && log2fr < max_log2fr + 1e-6) {
+                pitchset.push_back({std::to_string(num.first) + ":" + std::to_string(den.first), log2fr});
+            }
+        }
+    }
+    std::sort(pitchset.begin(), pitchset.end(),
+        [](const PitchSetPitch& a, const PitchSetPitch& b) { return a.log2fr < b.log2fr; });
+    return pitchset;
+}
+
+TEST_CASE("Bounded JI enumeration", "[pitchset]") {
+    SECTION("Matches the trial-division generator") {
+        PrimeList detuned = generateDefaultPrimeList(4);
+        detuned[1].log2fr += 0.0013;
+        detuned[2].log2fr -= 0.0021;
+        struct Case { PrimeList primes; int limit; double lo, hi; };
+        std::vector<Case> cases = {
+            {generateDefaultPrimeList(3), 20, 0.0, 1.0},
+            {generateDefaultPrimeList(5), 240, 0.0, 1.0},
+            {generateDefaultPrimeList(8), 500, -1.0, 2.5},
+            {detuned, 300, 0.0, 1.0},
+            {generateDefaultPrimeList(4), 20000, 0.0, 1.0},
+        };
+        for (const auto& c : cases) {
+            PitchSet expected = referenceJIPitchSet(c.primes, c.limit, c.lo, c.hi);
+            PitchSet actual = generateJIPitchSet(c.primes, c.limit, c.lo, c.hi);
+            REQUIRE(actual.size() == expected.size());
+            for (size_t i = 0; i < actual.size(); i++) {
+                REQUIRE(actual[i].label == expected[i].label);
+                REQUIRE(actual[i].log2fr == expected[i].log2fr);
+            }
+        }
+    }
+
+    SECTION("Tenney height bound") {
+        PitchSet pitches = generateBoundedJIPitchSet(generateDefaultPrimeList(3), JIBound::tenneyHeight(30));
+        std::vector<std::string> labels;
+        for (const auto& p : pitches) labels.push_back(p.label);
+        REQUIRE(labels == std::vector<std::string>{
+            "1:1", "6:5", "5:4", "4:3", "3:2", "5:3", "2:1"});
+    }
+
+    SECTION("Odd limit bound allows any power of two") {
+        PitchSet pitches = generateBoundedJIPitchSet(generateDefaultPrimeList(3), JIBound::oddLimit(5), 0.0, 3.0);
+        std::vector<std::string> labels;
+        for (const auto& p : pitches) labels.push_back(p.label);
+        REQUIRE(labels == std::vector<std::string>{
+            "1:1", "6:5", "5:4", "4:3", "3:2", "8:5", "5:3",
+            "2:1", "12:5", "5:2", "8:3", "3:1", "16:5", "10:3",
+            "4:1", "24:5", "5:1", "16:3", "6:1", "32:5", "20:3", "8:1"});
+        for (const auto& p : pitches) {
+            ExactPitch e = ExactPitch::fromPitchSetPitch(p);
+            REQUIRE_THAT(p.log2fr, WithinAbs(std::log2(double(e.num) / e.den), 1e-12));
+        }
+    }
+
+    SECTION("Streaming scales to large limits") {
+        size_t count = 0;
+        long long max_den = 0;
+        enumerateJIPitches(generateDefaultPrimeList(4), JIBound::numDen(200000), 0.0, 1.0,
+            [&](long long num, long long den, double log2fr) {
+                ++count;
+                max_den = std::max(max_den, den);
+                REQUIRE(std::gcd(num, den) == 1);
+                REQUIRE(log2fr > -1e-6);
+                REQUIRE(log2fr < 1.0 + 1e-6);
+            });
+        REQUIRE(count > 1000);
+        REQUIRE(max_den < 200000);
+    }
+}
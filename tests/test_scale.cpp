@@ -4,6 +4,7 @@
 #include "scalatrix/params.hpp"
 #include "scalatrix/label_calculator.hpp"
 #include <cmath>
+#include <random>
 
 using namespace scalatrix;
 using Catch::Matchers::WithinAbs;
@@ -180,4 +181,169 @@ TEST_CASE("Scale retuning with affine transform", "[scale]") {
             REQUIRE(node.natural_coord.y <= 100);
         }
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Scale reuses the strip basis across recalcWithAffine", "[scale]") {
+    // Dragging g moves only the x row, as a generator drag does
+    auto tuning = [](double g) {
+        return affineFromThreeDots(
+            {0, 0}, {1, 0}, {0, 1},
+            {0, 0}, {g, 0.3}, {1.0 - g, -0.55}
+        );
+    };
+
+    Scale scale = Scale::fromAffine(tuning(0.585), 1.0, 64, 32);
+    REQUIRE(scale.getStripCache().misses() == 1);
+    REQUIRE(scale.getStripCache().hits() == 0);
+
+    SECTION("Small drags hit the cache and match a fresh scale") {
+        for (int i = 1; i <= 50; ++i) {
+            double g = 0.585 + i * 1e-4;
+            scale.recalcWithAffine(tuning(g), 64, 32);
+            Scale fresh = Scale::fromAffine(tuning(g), 1.0, 64, 32);
+            for (int n = 0; n < 64; ++n) {
+                REQUIRE(scale.getNodes()[n].natural_coord == fresh.getNodes()[n].natural_coord);
+            }
+        }
+        REQUIRE(scale.getStripCache().hits() == 50);
+        REQUIRE(scale.getStripCache().hitRate() > 0.98);
+    }
+
+    SECTION("Leaving the validity region falls back to the search") {
+        scale.getStripCache().resetCounters();
+        scale.recalcWithAffine(tuning(0.52), 64, 32);
+        Scale fresh = Scale::fromAffine(tuning(0.52), 1.0, 64, 32);
+        for (int n = 0; n < 64; ++n) {
+            REQUIRE(scale.getNodes()[n].natural_coord == fresh.getNodes()[n].natural_coord);
+        }
+        REQUIRE(scale.getStripCache().misses() + scale.getStripCache().hits() == 1);
+    }
+}
+
+namespace {
+
+// recalcWithAffine's original node loops, branching on the node heights
+std::vector<Vector2i> referenceStripPath(const AffineTransform& A, int N, int root) {
+    AffineTransform M = A;
+    M.tx = 0;
+    M.ty = 0;
+    auto [r, s] = findClosestWithinStrip(M);
+    Vector2d zr = M * r;
+    Vector2d zs = M * s;
+    std::vector<Vector2i> path(N);
+    Vector2i v(0, 0);
+    for (int n = root + 1; n < N; ++n) {
+        double y = (A * v).y;
+        if (0 <= y + zr.y && y + zr.y < 1) v += r;
+        else if (0 <= y + zs.y && y + zs.y < 1) v += s;
+        else v += r + s;
+        path[n] = v;
+    }
+    v = Vector2i(0, 0);
+    for (int n = root - 1; n >= 0; --n) {
+        double y = (A * v).y;
+        if (0 <= y - zr.y && y - zr.y < 1) v -= r;
+        else if (0 <= y - zs.y && y - zs.y < 1) v -= s;
+        else v -= r + s;
+        path[n] = v;
+    }
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("Strip step word", "[scale]") {
+    SECTION("Branchless walk matches the branching one") {
+        std::mt19937_64 rng(17);
+        std::uniform_real_distribution<double> gen(0.05, 0.95);
+        std::uniform_real_distribution<double> height(0.0, 1.0);
+        std::uniform_real_distribution<double> entry(-2.0, 2.0);
+        for (int i = 0; i < 2000; ++i) {
+            AffineTransform A;
+            if (i % 2 == 0) {
+                double g = gen(rng);
+                A = affineFromThreeDots({0, 0}, {1, 0}, {0, 1},
+                                        {0, 0}, {g, entry(rng)}, {1.0 - g, entry(rng)});
+            } else {
+                A = AffineTransform(entry(rng), entry(rng), entry(rng), entry(rng));
+                if (std::abs(A.a * A.d - A.b * A.c) < 1e-3) continue;
+            }
+            A.ty = height(rng);
+            int N = 97, root = 40;
+            Scale scale = Scale::fromAffine(A, 1.0, N, root);
+            auto expected = referenceStripPath(A, N, root);
+            for (int n = 0; n < N; ++n) {
+                REQUIRE(scale.getNodes()[n].natural_coord == expected[n]);
+            }
+        }
+    }
+
+    SECTION("The word reproduces the nodes") {
+        auto A = affineFromThreeDots({0, 0}, {1, 0}, {0, 1},
+                                     {0, 0}, {0.585, 0.3}, {0.415, -0.55});
+        Scale scale = Scale::fromAffine(A, 1.0, 64, 20);
+        const auto& word = scale.getStepWord();
+        auto [r, s] = scale.getStripBasis();
+        REQUIRE(word.size() == 63);
+        const auto& nodes = scale.getNodes();
+        for (size_t i = 0; i + 1 < nodes.size(); ++i) {
+            Vector2i step = nodes[i + 1].natural_coord;
+            step -= nodes[i].natural_coord;
+            Vector2i expected = word[i] == STRIP_STEP_R ? r : word[i] == STRIP_STEP_S ? s : r + s;
+            REQUIRE(step == expected);
+        }
+
+        // The free function walks the same path from the origin
+        auto forward = stripStepWord(A, 43);
+        for (size_t i = 0; i < forward.size(); ++i) {
+            REQUIRE(forward[i] == word[20 + i]);
+        }
+    }
+
+    SECTION("Consecutive heights stay in the strip") {
+        auto A = affineFromThreeDots({0, 0}, {1, 0}, {0, 1},
+                                     {0, 0}, {0.585, 0.3}, {0.415, -0.55});
+        A.ty = 0.25;
+        Scale scale = Scale::fromAffine(A, 1.0, 128, 60);
+        for (const auto& node : scale.getNodes()) {
+            // Steps are chosen on y + dy, so the recomputed height may round
+            REQUIRE(node.tuning_coord.y > -1e-9);
+            REQUIRE(node.tuning_coord.y < 1.0 + 1e-9);
+        }
+    }
+}
+
+TEST_CASE("ScaleColumns gathers node fields", "[scale][columns]") {
+    auto A = affineFromThreeDots({0, 0}, {1, 0}, {0, 1},
+                                 {0, 0}, {0.585, 0.3}, {0.415, -0.55});
+    Scale scale = Scale::fromAffine(A, 261.63, 128, 60);
+    ScaleColumns columns;
+    columns.update(scale);
+    REQUIRE(columns.size() == 128);
+    REQUIRE(columns.natural_coord.size() == 256);
+    REQUIRE(columns.tuning_coord.size() == 256);
+    const NodeVector& nodes = scale.getNodes();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        REQUIRE(columns.pitch[i] == nodes[i].pitch);
+        REQUIRE(columns.natural_coord[2 * i] == nodes[i].natural_coord.x);
+        REQUIRE(columns.natural_coord[2 * i + 1] == nodes[i].natural_coord.y);
+        REQUIRE(columns.tuning_coord[2 * i] == nodes[i].tuning_coord.x);
+        REQUIRE(columns.tuning_coord[2 * i + 1] == nodes[i].tuning_coord.y);
+    }
+
+    // Views taken now stay put through updates that do not grow the scale
+    const double* pitch = columns.pitch.data();
+    const int32_t* natural = columns.natural_coord.data();
+    scale.retuneWithAffine(affineFromThreeDots({0, 0}, {1, 0}, {0, 1},
+                                               {0, 0}, {0.58, 0.3}, {0.42, -0.55}));
+    columns.update(scale);
+    REQUIRE(columns.pitch.data() == pitch);
+    REQUIRE(columns.natural_coord.data() == natural);
+    REQUIRE(columns.pitch[61] == scale.getNodes()[61].pitch);
+
+    Scale small = Scale::fromAffine(A, 261.63, 12, 6);
+    columns.update(small);
+    REQUIRE(columns.size() == 12);
+    REQUIRE(columns.pitch.data() == pitch);
+    REQUIRE(columns.pitch[11] == small.getNodes()[11].pitch);
+}
@@ -0,0 +1,237 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scalatrix/c_api.h"
+#include "scalatrix/shared_tuning.hpp"
+
+#ifdef SCALATRIX_HAS_SHARED_MEMORY
+
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace scalatrix;
+
+namespace {
+
+std::string segmentName(const char* test) {
+    return "/scalatrix-test-" + std::to_string(getpid()) + "-" + test;
+}
+
+// Removes the segment however the test ends
+struct Unlinker {
+    std::string name;
+    ~Unlinker() { SharedTuningPublisher::unlink(name); }
+};
+
+// Table k of a run: its base frequency tells the reader which it is
+void generateTable(const MOS& mos, Scale& scale, uint32_t k) {
+    mos.generateMappedScaleInto(scale, 12, 0.0, 100.0 + k, 128, 60);
+}
+
+// Whether view is table seq whole, not pieces of two tables
+bool isWholeTable(const SnapshotView& view) {
+    const SnapshotHeader& h = view.header();
+    if (h.base_freq != 100.0 + h.seq || h.node_count != 128) return false;
+    for (int i = 0; i < view.size(); ++i) {
+        if (view.pitch(i) != h.base_freq * std::exp2(view.tuningCoord(i).x)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Readers see the tables published", "[shared_tuning]") {
+    Unlinker segment{segmentName("basic")};
+    SharedTuningReader reader;
+    REQUIRE_FALSE(reader.open(segment.name));
+
+    SharedTuningPublisher publisher;
+    REQUIRE(publisher.open(segment.name, 128));
+    REQUIRE(publisher.sequence() == 0);
+    REQUIRE(reader.open(segment.name));
+    REQUIRE_FALSE(reader.hasUpdate());
+    REQUIRE_FALSE(reader.read());
+    REQUIRE_FALSE(reader.view().valid());
+
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale;
+    generateTable(mos, scale, 1);
+    REQUIRE(publisher.publish(mos, scale));
+    REQUIRE(reader.hasUpdate());
+    REQUIRE(reader.read());
+    REQUIRE(reader.sequence() == 1);
+    REQUIRE(isWholeTable(reader.view()));
+    REQUIRE_FALSE(reader.read());
+
+    Scale copy;
+    REQUIRE(reader.view().applyTo(copy));
+    REQUIRE(copy.getNodes().size() == 128);
+    for (size_t i = 0; i < 128; ++i) {
+        REQUIRE(copy.getNodes()[i].pitch == scale.getNodes()[i].pitch);
+    }
+
+    // Readers skip straight to the latest table
+    for (uint32_t k = 2; k <= 5; ++k) {
+        generateTable(mos, scale, k);
+        REQUIRE(publisher.publish(mos, scale));
+    }
+    REQUIRE(reader.read());
+    REQUIRE(reader.sequence() == 5);
+    REQUIRE(isWholeTable(reader.view()));
+
+    // Too many nodes for the segment
+    Scale big = mos.generateMappedScale(12, 0.0, 100.0, 256, 60);
+    REQUIRE_FALSE(publisher.publish(mos, big));
+    REQUIRE(publisher.sequence() == 5);
+}
+
+TEST_CASE("A reopened segment carries on its sequence", "[shared_tuning]") {
+    Unlinker segment{segmentName("reopen")};
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale;
+    SharedTuningReader reader;
+    {
+        SharedTuningPublisher publisher;
+        REQUIRE(publisher.open(segment.name, 128));
+        generateTable(mos, scale, 1);
+        REQUIRE(publisher.publish(mos, scale));
+        REQUIRE(reader.open(segment.name));
+        REQUIRE(reader.read());
+    }
+    // The table outlives its publisher
+    REQUIRE(reader.view().valid());
+    REQUIRE_FALSE(reader.hasUpdate());
+
+    SharedTuningPublisher publisher;
+    REQUIRE(publisher.open(segment.name, 64, true));
+    REQUIRE(publisher.sequence() == 1);
+    generateTable(mos, scale, 2);
+    REQUIRE(publisher.publish(mos, scale));
+    REQUIRE(reader.read());
+    REQUIRE(reader.sequence() == 2);
+    REQUIRE(reader.view().isFloat32());
+}
+
+TEST_CASE("Readers follow a segment grown under them", "[shared_tuning]") {
+    Unlinker segment{segmentName("grow")};
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale;
+    SharedTuningReader reader;
+    {
+        SharedTuningPublisher publisher;
+        REQUIRE(publisher.open(segment.name, 128));
+        generateTable(mos, scale, 1);
+        REQUIRE(publisher.publish(mos, scale));
+        REQUIRE(reader.open(segment.name));
+        REQUIRE(reader.read());
+    }
+
+    // Too small for 512 nodes: the slots move
+    SharedTuningPublisher publisher;
+    REQUIRE(publisher.open(segment.name, 512));
+    REQUIRE(publisher.sequence() == 1);
+    REQUIRE_FALSE(reader.read());
+    REQUIRE(isWholeTable(reader.view()));
+
+    for (uint32_t k = 2; k <= 3; ++k) {
+        generateTable(mos, scale, k);
+        REQUIRE(publisher.publish(mos, scale));
+        REQUIRE(reader.hasUpdate());
+        REQUIRE(reader.read());
+        REQUIRE(reader.sequence() == k);
+        REQUIRE(isWholeTable(reader.view()));
+    }
+    Scale big = mos.generateMappedScale(12, 0.0, 100.0, 512, 60);
+    REQUIRE(publisher.publish(mos, big));
+    REQUIRE(reader.read());
+    REQUIRE(reader.view().header().node_count == 512);
+}
+
+TEST_CASE("Tables cross processes whole", "[shared_tuning][fork]") {
+    const uint32_t n_tables = 3000;
+    const int n_readers = 3;
+    Unlinker segment{segmentName("fork")};
+    SharedTuningPublisher publisher;
+    REQUIRE(publisher.open(segment.name, 128));
+
+    // Generated up front so that publishes come back to back
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    std::vector<Scale> tables(n_tables + 1);
+    for (uint32_t k = 1; k <= n_tables; ++k) generateTable(mos, tables[k], k);
+
+    std::vector<pid_t> children;
+    for (int r = 0; r < n_readers; ++r) {
+        pid_t pid = fork();
+        REQUIRE(pid >= 0);
+        if (pid == 0) {
+            // Catch2 is not fork-safe: report through the exit status
+            SharedTuningReader reader;
+            if (!reader.open(segment.name)) _exit(2);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(20);
+            uint32_t last = 0;
+            while (last < n_tables) {
+                if (std::chrono::steady_clock::now() > deadline) _exit(3);
+                if (!reader.read()) continue;
+                if (!isWholeTable(reader.view())) _exit(4);
+                if (reader.sequence() <= last) _exit(5);
+                last = reader.sequence();
+            }
+            _exit(0);
+        }
+        children.push_back(pid);
+    }
+
+    for (uint32_t k = 1; k <= n_tables; ++k) {
+        // Halfway, the slots move under the readers
+        if (k == n_tables / 2) REQUIRE(publisher.open(segment.name, 1024));
+        REQUIRE(publisher.publish(mos, tables[k]));
+    }
+    REQUIRE(publisher.sequence() == n_tables);
+
+    for (pid_t pid : children) {
+        int status = 0;
+        REQUIRE(waitpid(pid, &status, 0) == pid);
+        REQUIRE(WIFEXITED(status));
+        REQUIRE(WEXITSTATUS(status) == 0);
+    }
+}
+
+TEST_CASE("Shared tables through the C API", "[shared_tuning][c_api]") {
+    Unlinker segment{segmentName("c_api")};
+    REQUIRE(scalatrix_shared_reader_open(segment.name.c_str()) == nullptr);
+    scalatrix_shared_publisher_t* publisher = scalatrix_shared_publisher_open(segment.name.c_str(), 128, 0);
+    REQUIRE(publisher != nullptr);
+    scalatrix_shared_reader_t* reader = scalatrix_shared_reader_open(segment.name.c_str());
+    REQUIRE(reader != nullptr);
+
+    int size = -1;
+    REQUIRE(scalatrix_shared_reader_data(reader, &size) == nullptr);
+    REQUIRE(size == 0);
+    REQUIRE(scalatrix_shared_reader_read(reader) == 0);
+
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(3, 1, 0.58, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 128, 60);
+    REQUIRE(scalatrix_shared_publisher_publish(publisher, mos, scale) == 1);
+    REQUIRE(scalatrix_shared_reader_has_update(reader) == 1);
+    REQUIRE(scalatrix_shared_reader_read(reader) == 1);
+    REQUIRE(scalatrix_shared_reader_sequence(reader) == 1);
+    REQUIRE(scalatrix_shared_reader_data(reader, &size) != nullptr);
+    REQUIRE(size == scalatrix_snapshot_size(128, 0));
+
+    scalatrix_scale_t* copy = scalatrix_scale_new(0);
+    REQUIRE(scalatrix_shared_reader_apply(reader, copy) == 0);
+    REQUIRE(scalatrix_scale_node_count(copy) == 128);
+    REQUIRE(scalatrix_scale_base_freq(copy) == 261.63);
+
+    scalatrix_scale_free(copy);
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+    scalatrix_shared_reader_close(reader);
+    scalatrix_shared_publisher_close(publisher);
+    REQUIRE(scalatrix_shared_unlink(segment.name.c_str()) == 0);
+    REQUIRE(scalatrix_shared_unlink(segment.name.c_str()) == -1);
+}
+
+#endif
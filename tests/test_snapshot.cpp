@@ -0,0 +1,269 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scale_checks.hpp"
+#include "scalatrix/c_api.h"
+#include "scalatrix/snapshot.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace scalatrix;
+
+namespace {
+
+std::vector<uint8_t> snapshotOf(const MOS& mos, const Scale& scale, uint32_t seq, bool float32) {
+    std::vector<uint8_t> out(snapshotSize(scale.getNodes().size(), float32 ? SNAPSHOT_FLOAT32 : 0));
+    REQUIRE(writeSnapshot(mos, scale, seq, float32, out.data(), out.size()) == out.size());
+    return out;
+}
+
+// Little-endian, as snapshots are written
+void poke32(std::vector<uint8_t>& bytes, size_t offset, int32_t v) {
+    for (int i = 0; i < 4; ++i) bytes[offset + i] = uint8_t(uint32_t(v) >> (8 * i));
+}
+
+void pokeF64(std::vector<uint8_t>& bytes, size_t offset, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, 8);
+    for (int i = 0; i < 8; ++i) bytes[offset + i] = uint8_t(bits >> (8 * i));
+}
+
+} // namespace
+
+TEST_CASE("Full snapshots round-trip", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 128, 60);
+    std::vector<uint8_t> bytes = snapshotOf(mos, scale, 7, false);
+    REQUIRE(bytes.size() == SNAPSHOT_HEADER_SIZE + 128 * (4 + 4 + 8 + 8 + 8));
+
+    SnapshotView view(bytes.data(), bytes.size());
+    REQUIRE(view.valid());
+    REQUIRE_FALSE(view.isDelta());
+    REQUIRE_FALSE(view.isFloat32());
+    REQUIRE(view.byteSize() == bytes.size());
+    const SnapshotHeader& h = view.header();
+    REQUIRE(h.version == SNAPSHOT_VERSION);
+    REQUIRE(h.seq == 7);
+    REQUIRE(h.node_count == 128);
+    REQUIRE(h.root == 60);
+    REQUIRE(h.a == mos.a);
+    REQUIRE(h.b == mos.b);
+    REQUIRE(h.mode == mos.mode);
+    REQUIRE(h.depth == mos.depth);
+    REQUIRE(h.generator == mos.generator);
+    REQUIRE(h.base_freq == 261.63);
+
+    Scale copy(100.0, 4, 1);
+    REQUIRE(view.applyTo(copy));
+    requireSameNodes(copy, scale);
+
+    MOS rebuilt = view.mos();
+    REQUIRE(rebuilt.a == mos.a);
+    REQUIRE(rebuilt.b == mos.b);
+    requireSameNodes(rebuilt.generateMappedScale(12, 0.0, 261.63, 128, 60), scale);
+}
+
+TEST_CASE("Float32 snapshots round pitches to float", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 128, 60);
+    std::vector<uint8_t> bytes = snapshotOf(mos, scale, 1, true);
+    REQUIRE(bytes.size() == SNAPSHOT_HEADER_SIZE + 128 * 5 * 4);
+
+    SnapshotView view(bytes.data(), bytes.size());
+    REQUIRE(view.isFloat32());
+    for (int i = 0; i < view.size(); ++i) {
+        const Node& node = scale.getNodes()[i];
+        REQUIRE(view.index(i) == i);
+        REQUIRE(view.naturalCoord(i) == node.natural_coord);
+        REQUIRE(view.pitch(i) == static_cast<float>(node.pitch));
+        REQUIRE(view.tuningCoord(i).x == static_cast<float>(node.tuning_coord.x));
+    }
+}
+
+TEST_CASE("Deltas carry only changed nodes", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale before = mos.generateMappedScale(12, 0.0, 261.63, 128, 60);
+    Scale after = before;
+    after.getNodes()[10].pitch *= 1.01;
+    after.getNodes()[70].natural_coord = Vector2i(-3, 4);
+    size_t full = snapshotSize(128, 0);
+    std::vector<uint8_t> bytes(full);
+
+    size_t n = writeSnapshotDelta(mos, after, before, 2, 1, false, bytes.data(), bytes.size());
+    REQUIRE(n == snapshotSize(2, SNAPSHOT_DELTA));
+    SnapshotView view(bytes.data(), n);
+    REQUIRE(view.isDelta());
+    REQUIRE(view.header().base_seq == 1);
+    REQUIRE(view.size() == 2);
+    REQUIRE(view.index(0) == 10);
+    REQUIRE(view.index(1) == 70);
+    REQUIRE(view.pitch(0) == after.getNodes()[10].pitch);
+
+    Scale copy = before;
+    REQUIRE(view.applyTo(copy));
+    requireSameNodes(copy, after);
+
+    // A delta does not apply to a scale of another size
+    Scale other = mos.generateMappedScale(12, 0.0, 261.63, 64, 30);
+    REQUIRE_FALSE(view.applyTo(other));
+
+    // Identical scales give an empty delta; too small a buffer gives nothing
+    REQUIRE(writeSnapshotDelta(mos, before, before, 3, 2, true, bytes.data(), bytes.size()) ==
+            SNAPSHOT_HEADER_SIZE);
+    REQUIRE(writeSnapshotDelta(mos, after, before, 2, 1, false, bytes.data(), n - 1) == 0);
+}
+
+TEST_CASE("Deltas fall back to full snapshots", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale before = mos.generateMappedScale(12, 0.0, 261.63, 128, 60);
+    std::vector<uint8_t> bytes(snapshotSize(128, 0));
+
+    // Retuning moves every node
+    mos.adjustTuningG(3, 1, 0.59, 1.0);
+    Scale retuned = mos.generateMappedScale(12, 0.0, 261.63, 128, 60);
+    REQUIRE(writeSnapshotDelta(mos, retuned, before, 2, 1, false, bytes.data(), bytes.size()) ==
+            bytes.size());
+    REQUIRE_FALSE(SnapshotView(bytes.data(), bytes.size()).isDelta());
+
+    // Another root cannot be expressed as a delta
+    Scale moved = mos.generateMappedScale(12, 0.0, 261.63, 128, 61);
+    REQUIRE(writeSnapshotDelta(mos, moved, retuned, 3, 2, false, bytes.data(), bytes.size()) ==
+            bytes.size());
+    SnapshotView view(bytes.data(), bytes.size());
+    REQUIRE_FALSE(view.isDelta());
+    REQUIRE(view.header().root == 61);
+}
+
+TEST_CASE("Malformed snapshots are rejected", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 16, 8);
+    std::vector<uint8_t> bytes = snapshotOf(mos, scale, 1, true);
+    SnapshotView view;
+    REQUIRE(view.parse(bytes.data(), bytes.size()));
+    REQUIRE_FALSE(view.parse(bytes.data(), bytes.size() - 1));
+    REQUIRE_FALSE(view.valid());
+    REQUIRE_FALSE(view.parse(nullptr, 0));
+    REQUIRE_FALSE(view.parse(bytes.data(), 40));
+
+    std::vector<uint8_t> bad = bytes;
+    bad[0] = 'X';
+    REQUIRE_FALSE(view.parse(bad.data(), bad.size()));
+    bad = bytes;
+    bad[4] = 2; // version
+    REQUIRE_FALSE(view.parse(bad.data(), bad.size()));
+    bad = bytes;
+    bad[24] = 15; // record count of a full snapshot
+    REQUIRE_FALSE(view.parse(bad.data(), bad.size()));
+    bad = bytes;
+    bad[27] = 0x80; // record count past any buffer
+    REQUIRE_FALSE(view.parse(bad.data(), bad.size()));
+    for (int32_t root : {-1, 16, INT32_MAX}) {
+        bad = bytes;
+        poke32(bad, 28, root);
+        REQUIRE_FALSE(view.parse(bad.data(), bad.size()));
+    }
+    bad = bytes;
+    poke32(bad, 28, 15); // the last node
+    REQUIRE(view.parse(bad.data(), bad.size()));
+
+    // Trailing bytes are ignored
+    bytes.resize(bytes.size() + 13, 0xAA);
+    REQUIRE(view.parse(bytes.data(), bytes.size()));
+    REQUIRE(view.byteSize() == bytes.size() - 13);
+}
+
+TEST_CASE("Headers that no MOS could write are rejected", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 16, 8);
+    const std::vector<uint8_t> bytes = snapshotOf(mos, scale, 1, true);
+    SnapshotView view;
+    auto rejects = [&](const std::vector<uint8_t>& bad) {
+        return !view.parse(bad.data(), bad.size()) && !view.valid();
+    };
+
+    // a, b, mode, repetitions
+    REQUIRE(mos.repetitions == 1);
+    for (int32_t a : {0, -3, INT32_MAX}) {
+        std::vector<uint8_t> bad = bytes;
+        poke32(bad, 32, a);
+        REQUIRE(rejects(bad));
+    }
+    for (int32_t b : {0, -1}) {
+        std::vector<uint8_t> bad = bytes;
+        poke32(bad, 36, b);
+        REQUIRE(rejects(bad));
+    }
+    for (int32_t mode : {-1, mos.n, 100}) {
+        std::vector<uint8_t> bad = bytes;
+        poke32(bad, 40, mode);
+        REQUIRE(rejects(bad));
+    }
+    std::vector<uint8_t> bad = bytes;
+    poke32(bad, 44, 2);
+    REQUIRE(rejects(bad));
+
+    // equave, generator
+    for (double equave : {0.0, -1.0, std::nan(""), HUGE_VAL}) {
+        bad = bytes;
+        pokeF64(bad, 64, equave);
+        REQUIRE(rejects(bad));
+    }
+    for (double g : {-0.01, 1.01, std::nan("")}) {
+        bad = bytes;
+        pokeF64(bad, 72, g);
+        REQUIRE(rejects(bad));
+    }
+
+    // Every mode of a multi-period MOS still parses
+    MOS split = MOS::fromG(4, 2, 0.3, 2.0, 2);
+    for (int32_t mode = 0; mode < split.n; ++mode) {
+        bad = snapshotOf(split, split.generateMappedScale(12, 0.0, 261.63, 16, 8), 1, true);
+        poke32(bad, 40, mode);
+        REQUIRE(view.parse(bad.data(), bad.size()));
+        REQUIRE(view.mos().n == split.n);
+    }
+}
+
+TEST_CASE("Larger headers of later writers are skipped", "[snapshot]") {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    Scale scale = mos.generateMappedScale(12, 0.0, 261.63, 16, 8);
+    std::vector<uint8_t> bytes = snapshotOf(mos, scale, 1, false);
+    std::vector<uint8_t> grown(bytes.begin(), bytes.begin() + SNAPSHOT_HEADER_SIZE);
+    grown.resize(SNAPSHOT_HEADER_SIZE + 16, 0);
+    grown.insert(grown.end(), bytes.begin() + SNAPSHOT_HEADER_SIZE, bytes.end());
+    grown[8] = SNAPSHOT_HEADER_SIZE + 16;
+
+    SnapshotView view(grown.data(), grown.size());
+    REQUIRE(view.valid());
+    Scale copy;
+    REQUIRE(view.applyTo(copy));
+    requireSameNodes(copy, scale);
+}
+
+TEST_CASE("Snapshots through the C API", "[snapshot][c_api]") {
+    scalatrix_mos_t* mos = scalatrix_mos_from_g(3, 1, 0.58, 1.0, 1);
+    scalatrix_scale_t* scale = scalatrix_mos_generate_mapped_scale(mos, 12, 0.0, 261.63, 128, 60);
+    int size = scalatrix_snapshot_size(128, SCALATRIX_SNAPSHOT_FLOAT32);
+    REQUIRE(size == static_cast<int>(snapshotSize(128, SNAPSHOT_FLOAT32)));
+    REQUIRE(scalatrix_snapshot_size(-1, 0) == -1);
+
+    std::vector<unsigned char> bytes(size);
+    REQUIRE(scalatrix_snapshot_write(mos, scale, nullptr, 5, 0, 1, bytes.data(), size - 1) == -1);
+    REQUIRE(scalatrix_snapshot_write(mos, scale, nullptr, 5, 0, 1, bytes.data(), size) == size);
+    REQUIRE(scalatrix_snapshot_write(mos, scale, scale, 6, 5, 1, bytes.data(), size) ==
+            static_cast<int>(SNAPSHOT_HEADER_SIZE));
+
+    REQUIRE(scalatrix_snapshot_write(mos, scale, nullptr, 5, 0, 0, bytes.data(), size) == -1);
+    bytes.resize(scalatrix_snapshot_size(128, 0));
+    int n = scalatrix_snapshot_write(mos, scale, nullptr, 5, 0, 0, bytes.data(), bytes.size());
+    REQUIRE(n == static_cast<int>(bytes.size()));
+
+    scalatrix_scale_t* copy = scalatrix_scale_new(0);
+    REQUIRE(scalatrix_snapshot_apply(bytes.data(), n, copy) == 0);
+    requireSameNodes(*reinterpret_cast<const Scale*>(copy), *reinterpret_cast<const Scale*>(scale));
+    REQUIRE(scalatrix_snapshot_apply(bytes.data(), n - 1, copy) == -1);
+
+    scalatrix_scale_free(copy);
+    scalatrix_scale_free(scale);
+    scalatrix_mos_free(mos);
+}
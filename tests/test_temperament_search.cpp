@@ -0,0 +1,108 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/temperament_search.hpp"
+#include <cmath>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("Temperament evaluator closed form", "[temperament]") {
+    PitchSet target = generateJIPitchSet(generateDefaultPrimeList(3), 40, 0.0, 2.0);
+    PitchSetIndex index(target);
+
+    struct Pattern { int a, b, mode; };
+    std::vector<Pattern> patterns = {{5, 2, 1}, {2, 5, 3}, {4, 3, 0}, {6, 4, 2}, {7, 5, 6}, {1, 1, 0}};
+    for (const auto& p : patterns) {
+        // Build the reference inside the generator range, where the strip walk is valid
+        MOS probe = MOS::fromParams(p.a, p.b, p.mode, 1.0, 0.5);
+        TemperamentEvaluator range(probe, index);
+        double g_mid = 0.5 * (range.gMin() + range.gMax());
+        MOS reference = MOS::fromParams(p.a, p.b, p.mode, 1.0, g_mid);
+        TemperamentEvaluator eval(reference, index);
+        REQUIRE(eval.gMin() < eval.gMax());
+        REQUIRE(eval.size() == reference.base_scale.getNodes().size());
+
+        for (double t : {0.1, 0.37, 0.5, 0.81}) {
+            double g = eval.gMin() + t * (eval.gMax() - eval.gMin());
+            for (double e : {1.0, 0.993, 1.02}) {
+                MOS mos = MOS::fromParams(p.a, p.b, p.mode, e, g);
+                std::vector<double> x(eval.size());
+                eval.pitches(g, e, x.data());
+                const auto& nodes = mos.base_scale.getNodes();
+                for (size_t j = 0; j < nodes.size(); j++) {
+                    REQUIRE_THAT(x[j], WithinAbs(nodes[j].tuning_coord.x, 1e-9));
+                }
+
+                TemperingStats stats;
+                mos.base_scale.temperToPitchSet(index, &stats);
+                double max_cents = 0.0;
+                REQUIRE_THAT(eval.error(g, e, &max_cents), WithinAbs(stats.rms_cents, 1e-6));
+                REQUIRE_THAT(max_cents, WithinAbs(stats.max_cents, 1e-6));
+            }
+        }
+    }
+}
+
+TEST_CASE("Temperament search", "[temperament]") {
+    SECTION("Recovers an equal temperament exactly") {
+        TemperamentSearchOptions options;
+        options.min_size = 7;
+        options.max_size = 7;
+        auto results = searchTemperaments(generateETPitchSet(12, 1.0, 0.0, 1.0), options);
+        REQUIRE(results.size() == 6 * 7);
+        for (size_t i = 1; i < results.size(); i++) {
+            REQUIRE(results[i - 1].rms_cents <= results[i].rms_cents);
+        }
+        REQUIRE(results[0].rms_cents < 1e-3);
+        bool diatonic = false;
+        for (const auto& r : results) {
+            if (r.a == 5 && r.b == 2 && r.rms_cents < 1e-3) {
+                diatonic = true;
+                REQUIRE_THAT(r.generator, WithinAbs(7.0 / 12.0, 1e-5));
+            }
+        }
+        REQUIRE(diatonic);
+    }
+
+    SECTION("Finds meantone for 5-limit JI") {
+        PitchSet target = generateJIPitchSet(generateDefaultPrimeList(3), 10, 0.0, 1.0);
+        TemperamentSearchOptions options;
+        options.min_size = 7;
+        options.max_size = 7;
+        options.n_threads = 3;
+        auto results = searchTemperaments(target, options);
+        const TemperamentCandidate* best = nullptr;
+        for (const auto& r : results) {
+            if (r.a == 5 && r.b == 2 && r.mode == 1 && (!best || r.rms_cents < best->rms_cents)) best = &r;
+        }
+        REQUIRE(best != nullptr);
+        REQUIRE(best->generator > 0.575);
+        REQUIRE(best->generator < 0.59);
+
+        // Better than 12-EDO's fifth, which the grid could also have picked
+        MOS edo = MOS::fromParams(5, 2, 1, 1.0, 7.0 / 12.0);
+        PitchSetIndex index(target);
+        TemperamentEvaluator eval(edo, index);
+        REQUIRE(best->rms_cents <= eval.error(7.0 / 12.0, 1.0) + 1e-9);
+    }
+
+    SECTION("Equave stretch stays within bounds") {
+        TemperamentSearchOptions options;
+        options.min_size = 5;
+        options.max_size = 5;
+        options.min_equave = 0.99;
+        options.max_equave = 1.01;
+        auto results = searchTemperaments(generateETPitchSet(5, 1.004, 0.0, 1.1), options);
+        REQUIRE(!results.empty());
+        for (const auto& r : results) {
+            REQUIRE(r.equave >= 0.99);
+            REQUIRE(r.equave <= 1.01);
+        }
+        REQUIRE(results[0].rms_cents < 0.05);
+        REQUIRE_THAT(results[0].equave, WithinAbs(1.004, 1e-4));
+    }
+
+    SECTION("Empty target") {
+        REQUIRE(searchTemperaments(PitchSet{}).empty());
+    }
+}
@@ -0,0 +1,257 @@
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+#include "scalatrix/tempering.hpp"
+#include "scalatrix/mos.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace scalatrix;
+using Catch::Matchers::WithinAbs;
+
+// The original linear scan, kept as a reference for the indexed lookup
+static int linearClosest(const PitchSet& pitchset, double log2fr) {
+    int closest = -1;
+    double min_dist = 1e6;
+    for (size_t i = 0; i < pitchset.size(); i++) {
+        double dist = std::abs(pitchset[i].log2fr - log2fr);
+        if (dist < min_dist) {
+            min_dist = dist;
+            closest = static_cast<int>(i);
+        }
+    }
+    return closest;
+}
+
+static std::vector<Scale> presetScales() {
+    std::vector<Scale> scales;
+    for (int a = 1; a <= 7; a++) {
+        for (int b = 1; b <= 7; b++) {
+            for (int mode = 0; mode < a + b; mode += 2) {
+                double g = 0.35 + 0.01 * (a * 7 + b);
+                MOS mos = MOS::fromParams(a, b, mode, 1.0, g);
+                scales.push_back(mos.generateScaleFromMOS(261.63, 128, 60));
+            }
+        }
+    }
+    return scales;
+}
+
+TEST_CASE("PitchSetIndex matches the linear scan", "[tempering]") {
+    SECTION("Nearest pitch, including ties and duplicates") {
+        PitchSet pitchset = {
+            {"b", 0.5}, {"a", 0.25}, {"a2", 0.25}, {"c", 0.75}, {"z", 0.0}, {"nan", NAN}, {"b2", 0.5},
+        };
+        PitchSetIndex index(pitchset);
+        for (int i = -40; i <= 140; i++) {
+            double x = i / 100.0;
+            REQUIRE(index.closest(x) == linearClosest(pitchset, x));
+        }
+        // Exactly halfway resolves to whichever pitch comes first in the set
+        REQUIRE(index.closest(0.375) == linearClosest(pitchset, 0.375));
+        REQUIRE(index.closest(0.625) == linearClosest(pitchset, 0.625));
+        REQUIRE(index.closest(NAN) == -1);
+        REQUIRE(PitchSetIndex(PitchSet{}).closest(0.5) == -1);
+    }
+
+    SECTION("Whole JI and ET sets") {
+        std::vector<PitchSet> sets = {
+            generateETPitchSet(31, 1.0, -1.0, 3.0),
+            generateJIPitchSet(generateDefaultPrimeList(5), 120, -1.0, 3.0),
+        };
+        for (const auto& pitchset : sets) {
+            PitchSetIndex index(pitchset);
+            for (int i = 0; i < 5000; i++) {
+                double x = -1.5 + 5.0 * i / 4999.0;
+                REQUIRE(index.closest(x) == linearClosest(pitchset, x));
+            }
+        }
+    }
+}
+
+TEST_CASE("Tempering to a PitchSet follows edits to the set", "[tempering]") {
+    PitchSet pitchset = generateETPitchSet(12, 1.0, -6.0, 6.0);
+    REQUIRE(PitchSetIndex(pitchset).indexes(pitchset));
+
+    Scale scale = MOS::fromParams(5, 2, 1, 1.0, 0.585).generateScaleFromMOS(261.63, 128, 60);
+    Scale again = scale;
+    auto requireSameTempering = [&]() {
+        for (size_t i = 0; i < scale.getNodes().size(); i++) {
+            REQUIRE(scale.getNodes()[i].temperedPitch.label == again.getNodes()[i].temperedPitch.label);
+            REQUIRE(scale.getNodes()[i].pitch == again.getNodes()[i].pitch);
+        }
+    };
+    scale.temperToPitchSet(pitchset);
+    scale.temperToPitchSet(pitchset);
+    PitchSetIndex index(pitchset);
+    again.temperToPitchSet(index);
+    again.temperToPitchSet(index);
+    requireSameTempering();
+
+    // Edited in place at the same size and storage
+    const PitchSetPitch* storage = pitchset.data();
+    PitchSet edited = generateETPitchSet(19, 1.0, -6.0, 6.0);
+    edited.resize(pitchset.size());
+    std::copy(edited.begin(), edited.end(), pitchset.begin());
+    REQUIRE(pitchset.data() == storage);
+    REQUIRE_FALSE(index.indexes(pitchset));
+    scale.temperToPitchSet(pitchset);
+    again.temperToPitchSet(PitchSetIndex(pitchset));
+    requireSameTempering();
+    Scale before = again;
+    before.temperToPitchSet(index);
+    bool changed = false;
+    for (size_t i = 0; i < scale.getNodes().size(); i++) {
+        changed |= scale.getNodes()[i].pitch != before.getNodes()[i].pitch;
+    }
+    REQUIRE(changed);
+
+    // Resized, and another set
+    pitchset = generateETPitchSet(19, 1.0, -6.0, 6.0);
+    scale.temperToPitchSet(pitchset);
+    again.temperToPitchSet(PitchSetIndex(pitchset));
+    requireSameTempering();
+    PitchSet other = generateETPitchSet(17, 1.0, -6.0, 6.0);
+    scale.temperToPitchSet(other);
+    again.temperToPitchSet(PitchSetIndex(other));
+    requireSameTempering();
+}
+
+TEST_CASE("Bulk tempering", "[tempering]") {
+    PitchSet pitchset = generateJIPitchSet(generateDefaultPrimeList(4), 60, -6.0, 6.0);
+
+    SECTION("Same result as tempering each scale alone") {
+        std::vector<Scale> expected = presetScales();
+        for (auto& scale : expected) {
+            scale.temperToPitchSet(pitchset);
+        }
+        std::vector<Scale> scales = presetScales();
+        std::vector<TemperingStats> stats = temperScales(scales, pitchset, 4);
+        REQUIRE(stats.size() == scales.size());
+        for (size_t s = 0; s < scales.size(); s++) {
+            const auto& a = scales[s].getNodes();
+            const auto& b = expected[s].getNodes();
+            REQUIRE(a.size() == b.size());
+            for (size_t i = 0; i < a.size(); i++) {
+                REQUIRE(a[i].pitch == b[i].pitch);
+                REQUIRE(a[i].temperedPitch.label == b[i].temperedPitch.label);
+            }
+        }
+    }
+
+    SECTION("Per-scale error statistics") {
+        std::vector<Scale> scales = presetScales();
+        std::vector<Scale> originals = scales;
+        std::vector<TemperingStats> stats = temperScales(scales, PitchSetIndex(pitchset));
+        for (size_t s = 0; s < scales.size(); s++) {
+            double max_cents = 0.0, sum_sq = 0.0;
+            const auto& before = originals[s].getNodes();
+            const auto& after = scales[s].getNodes();
+            for (size_t i = 0; i < before.size(); i++) {
+                double cents = 1200.0 * std::log2(after[i].pitch / before[i].pitch);
+                max_cents = std::max(max_cents, std::abs(cents));
+                sum_sq += cents * cents;
+            }
+            REQUIRE(stats[s].n_nodes == static_cast<int>(before.size()));
+            REQUIRE_THAT(stats[s].max_cents, WithinAbs(max_cents, 1e-6));
+            REQUIRE_THAT(stats[s].rms_cents, WithinAbs(std::sqrt(sum_sq / before.size()), 1e-6));
+        }
+    }
+}
+
+TEST_CASE("parallelFor visits every item once", "[tempering]") {
+    for (int threads : {1, 2, 3, 8}) {
+        const size_t n = 10007;
+        std::vector<std::atomic<int>> visits(n);
+        std::atomic<int> max_worker{0};
+        std::atomic<bool> out_of_range{false};
+        parallelFor(n, 7, threads, [&](size_t begin, size_t end, int worker) {
+            if (end > n) out_of_range = true;
+            int seen = max_worker.load();
+            while (worker > seen && !max_worker.compare_exchange_weak(seen, worker)) {}
+            // Uneven work so stealing kicks in
+            volatile double sink = 0.0;
+            for (size_t i = begin; i < end; i++) {
+                for (size_t k = 0; k < (i % 97) * 50; k++) sink = sink + k;
+                visits[i]++;
+            }
+        });
+        REQUIRE_FALSE(out_of_range.load());
+        for (size_t i = 0; i < n; i++) {
+            REQUIRE(visits[i].load() == 1);
+        }
+        REQUIRE(max_worker.load() < parallelWorkerCount((n + 6) / 7, threads));
+    }
+}
+
+TEST_CASE("parallelFor passes on an exception from a body", "[tempering]") {
+    static std::atomic<int> threads_seen{0};
+    struct Seen { Seen() { threads_seen++; } };
+    // One lambda, so one thread_local per thread across both bodies
+    auto visit = [] {
+        static thread_local Seen seen;
+        (void)seen;
+    };
+    auto throwAt = [visit](size_t at) {
+        return [visit, at](size_t begin, size_t, int) {
+            visit();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            if (begin == at) throw std::runtime_error("chunk " + std::to_string(at));
+        };
+    };
+
+    // Whichever worker runs the throwing chunk, the calling thread's or not
+    for (size_t at : {size_t(0), size_t(40), size_t(63)}) {
+        REQUIRE_THROWS_WITH(parallelFor(64, 1, 4, throwAt(at)), "chunk " + std::to_string(at));
+    }
+    // The pool is free again afterwards, rather than left busy
+    for (int call = 0; call < 20; call++) {
+        parallelFor(64, 1, 4, [visit](size_t, size_t, int) {
+            visit();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        });
+    }
+    REQUIRE(threads_seen.load() <= parallelWorkerCount(64, 4));
+
+    // From threads of its own, while the pool runs the outer call
+    std::atomic<int> caught{0};
+    parallelFor(4, 1, 2, [&](size_t begin, size_t, int) {
+        try {
+            parallelFor(64, 1, 4, throwAt(begin + 10));
+        } catch (const std::runtime_error&) {
+            caught++;
+        }
+    });
+    REQUIRE(caught.load() == 4);
+}
+
+TEST_CASE("parallelFor reuses its threads across calls", "[tempering]") {
+    // Counts the threads that ever ran a body, even if the OS reuses their ids
+    static std::atomic<int> threads_seen{0};
+    struct Seen { Seen() { threads_seen++; } };
+
+    for (int call = 0; call < 50; call++) {
+        parallelFor(64, 1, 4, [&](size_t, size_t, int) {
+            static thread_local Seen seen;
+            (void)seen;
+            // Long enough that every worker gets to run a chunk
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        });
+    }
+    REQUIRE(threads_seen.load() <= parallelWorkerCount(64, 4));
+
+    SECTION("A body may call parallelFor itself") {
+        std::atomic<int> inner{0};
+        parallelFor(8, 1, 4, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; i++) {
+                parallelFor(16, 1, 2, [&](size_t b, size_t e, int) { inner += static_cast<int>(e - b); });
+            }
+        });
+        REQUIRE(inner.load() == 8 * 16);
+    }
+}
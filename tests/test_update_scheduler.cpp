@@ -0,0 +1,196 @@
+#include "catch2/catch_test_macros.hpp"
+#include "scale_checks.hpp"
+#include "scalatrix/update_scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace scalatrix;
+using namespace std::chrono;
+
+namespace {
+
+TuningUpdate tuning(double generator) {
+    TuningUpdate u;
+    u.depth = 3;
+    u.mode = 1;
+    u.generator = generator;
+    return u;
+}
+
+// What the scheduler should leave a target holding after applying u and m
+Scale expectedScale(const TuningUpdate& u, const ScaleMapping& m) {
+    MOS mos = MOS::fromG(3, 1, 0.58, 1.0);
+    mos.adjustTuningG(u.depth, u.mode, u.generator, u.equave, u.repetitions);
+    return mos.generateMappedScale(m.steps, m.offset, m.base_freq, m.n_nodes, m.root);
+}
+
+} // namespace
+
+TEST_CASE("Updates to a target merge until flushed", "[update_scheduler]") {
+    int calls = 0;
+    const Scale* seen = nullptr;
+    TuningUpdateScheduler scheduler(microseconds(5000), [&](int target, const MOS&, const Scale& scale) {
+        REQUIRE(target == 0);
+        ++calls;
+        seen = &scale;
+    });
+    REQUIRE(scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0)) == 0);
+    REQUIRE(calls == 0);
+
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(scheduler.post(0, tuning(0.55 + 0.0005 * i)));
+    }
+    REQUIRE(scheduler.flush() == 1);
+    REQUIRE(calls == 1);
+    REQUIRE(scheduler.flush() == 0);
+
+    UpdateSchedulerStats stats = scheduler.stats();
+    REQUIRE(stats.posted == 100);
+    REQUIRE(stats.merged == 99);
+    REQUIRE(stats.applied == 1);
+    REQUIRE(stats.frames == 1);
+    REQUIRE(stats.dropped == 0);
+    requireSameNodes(*seen, expectedScale(tuning(0.55 + 0.0005 * 99), ScaleMapping()));
+}
+
+TEST_CASE("Tuning and mapping updates apply together", "[update_scheduler]") {
+    std::vector<int> applied;
+    const Scale* seen[2] = {nullptr, nullptr};
+    TuningUpdateScheduler scheduler(microseconds(5000), [&](int target, const MOS&, const Scale& scale) {
+        applied.push_back(target);
+        seen[target] = &scale;
+    });
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+
+    ScaleMapping mapping;
+    mapping.steps = 7;
+    mapping.base_freq = 220.0;
+    mapping.n_nodes = 64;
+    mapping.root = 30;
+    scheduler.post(1, tuning(0.57));
+    scheduler.postMapping(1, mapping);
+    scheduler.post(0, tuning(0.59));
+    REQUIRE(scheduler.flush() == 2);
+    REQUIRE(applied == std::vector<int>{0, 1});
+    REQUIRE(scheduler.stats().merged == 0);
+    requireSameNodes(*seen[0], expectedScale(tuning(0.59), ScaleMapping()));
+    requireSameNodes(*seen[1], expectedScale(tuning(0.57), mapping));
+}
+
+TEST_CASE("Unknown targets and no-op updates are dropped", "[update_scheduler]") {
+    int calls = 0;
+    TuningUpdateScheduler scheduler(microseconds(5000), [&](int, const MOS&, const Scale&) { ++calls; });
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+
+    REQUIRE_FALSE(scheduler.post(1, tuning(0.57)));
+    REQUIRE_FALSE(scheduler.post(-1, tuning(0.57)));
+    REQUIRE_FALSE(scheduler.postMapping(5, ScaleMapping()));
+    REQUIRE(scheduler.stats().dropped == 3);
+    REQUIRE(scheduler.stats().posted == 0);
+
+    // The target already holds this tuning and mapping
+    scheduler.post(0, tuning(0.58));
+    scheduler.postMapping(0, ScaleMapping());
+    REQUIRE(scheduler.flush() == 0);
+    REQUIRE(calls == 0);
+    REQUIRE(scheduler.stats().dropped == 5);
+    REQUIRE(scheduler.stats().frames == 0);
+
+    scheduler.post(0, tuning(0.57));
+    REQUIRE(scheduler.flush() == 1);
+    scheduler.post(0, tuning(0.57));
+    REQUIRE(scheduler.flush() == 0);
+    REQUIRE(calls == 1);
+    REQUIRE(scheduler.stats().dropped == 6);
+}
+
+TEST_CASE("poll applies at most once per frame", "[update_scheduler]") {
+    TuningUpdateScheduler scheduler(milliseconds(50));
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+    REQUIRE(scheduler.poll() == 0);
+
+    scheduler.post(0, tuning(0.57));
+    REQUIRE(scheduler.poll() == 1);
+    scheduler.post(0, tuning(0.56));
+    REQUIRE(scheduler.poll() == 0);
+    std::this_thread::sleep_for(milliseconds(60));
+    scheduler.post(0, tuning(0.55));
+    REQUIRE(scheduler.poll() == 1);
+    REQUIRE(scheduler.stats().merged == 1);
+    REQUIRE(scheduler.stats().frames == 2);
+}
+
+TEST_CASE("Flushing from inside on_update leaves updates for the next pass", "[update_scheduler]") {
+    TuningUpdateScheduler* self = nullptr;
+    std::vector<int> nested;
+    TuningUpdateScheduler scheduler(microseconds(0), [&](int target, const MOS&, const Scale&) {
+        if (target != 0) return;
+        REQUIRE(self->post(1, tuning(0.57)));
+        nested.push_back(self->flush());
+        nested.push_back(self->poll());
+    });
+    self = &scheduler;
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+    scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+
+    scheduler.post(0, tuning(0.59));
+    REQUIRE(scheduler.flush() == 1);
+    REQUIRE(nested == std::vector<int>{0, 0});
+    REQUIRE(scheduler.flush() == 1);
+    REQUIRE(scheduler.stats().applied == 2);
+}
+
+#ifndef SCALATRIX_NO_THREADS
+TEST_CASE("Posting threads are coalesced by the scheduler's thread", "[update_scheduler][threads]") {
+    const int n_threads = 4, n_posts = 2000;
+    // Catch2 assertions are not thread-safe; count from the callback instead
+    std::atomic<int> calls{0}, bad{0};
+    TuningUpdateScheduler scheduler(milliseconds(2), [&](int, const MOS& mos, const Scale& scale) {
+        if (scale.getNodes().size() != 128 || mos.depth != 3) ++bad;
+        ++calls;
+    });
+    for (int i = 0; i < n_threads; ++i) {
+        scheduler.addTarget(MOS::fromG(3, 1, 0.58, 1.0));
+    }
+    REQUIRE(scheduler.start());
+    REQUIRE_FALSE(scheduler.start());
+    REQUIRE(scheduler.running());
+
+    auto begin = steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < n_posts; ++i) {
+                scheduler.post(t, tuning(0.55 + 0.00001 * i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    std::this_thread::sleep_for(milliseconds(20));
+    scheduler.stop();
+    auto elapsed = duration_cast<microseconds>(steady_clock::now() - begin);
+    REQUIRE_FALSE(scheduler.running());
+    scheduler.flush();
+
+    UpdateSchedulerStats stats = scheduler.stats();
+    REQUIRE(stats.posted == static_cast<uint64_t>(n_threads * n_posts));
+    REQUIRE(stats.applied == static_cast<uint64_t>(calls.load()));
+    REQUIRE(bad == 0);
+    REQUIRE(stats.applied + stats.merged == stats.posted);
+    // One pass per frame, plus the first and the final flush
+    REQUIRE(stats.frames <= static_cast<uint64_t>(elapsed / scheduler.frame()) + 2);
+    REQUIRE(stats.dropped == 0);
+
+    // Every target ends on its last update, so posting it again is a no-op
+    for (int t = 0; t < n_threads; ++t) {
+        scheduler.post(t, tuning(0.55 + 0.00001 * (n_posts - 1)));
+    }
+    REQUIRE(scheduler.flush() == 0);
+    REQUIRE(scheduler.stats().dropped == static_cast<uint64_t>(n_threads));
+}
+#endif